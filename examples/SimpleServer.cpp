@@ -116,9 +116,7 @@ int main() {
     //    router.addHandler({"GET"}, "/deposit/*", handlerFunction, {});
     //
 
-    const usub::server::protocols::http::param_constraint uuid{
-            R"([0-9a-f]{8}-[0-9a-f]{4}-[0-9a-f]{4}-[0-9a-f]{4}-[0-9a-f]{12})",
-            "Must be a valid UUID"};
+    const usub::server::protocols::http::param_constraint &uuid = usub::server::protocols::http::constraints::uuid;
     //
     //    router.addHandler({"GET"},
     //                      "/deposit/update/{id}/",//  last / is trailing
@@ -136,7 +136,7 @@ auto make_get_user_handler(usub::pg::PgPool& pool)
 {
     return [&pool](auto& req, auto& resp) -> Awaitable<void>
     {
-        std::string idraw = req.uri_params.contains("id") ? req.uri_params["id"] : "0";
+        std::string idraw = req.uri_params.contains("id") ? std::string(req.uri_params["id"]) : "0";
         int64_t id = 0;
         try { id = std::stoll(idraw); }
         catch (...)
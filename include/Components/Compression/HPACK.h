@@ -5,4 +5,270 @@
 #ifndef SERVER_HPACK_H
 #define SERVER_HPACK_H
 
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Protocols/HTTP/HeaderEnum.h"
+#include "utils/ParseError.h"
+
+namespace usub::server::protocols::http {
+    class Headers;
+}
+
+namespace usub::server::component {
+
+    /// SETTINGS_HEADER_TABLE_SIZE both HTTP/2 endpoints start with.
+    inline constexpr size_t HPACK_DEFAULT_TABLE_SIZE = 4096;
+    /// Entries of the HPACK static table (RFC 7541, Appendix A).
+    inline constexpr size_t HPACK_STATIC_TABLE_SIZE = 61;
+    /// Bytes a dynamic table entry costs on top of its name and value (RFC 7541, 4.1).
+    inline constexpr size_t HPACK_ENTRY_OVERHEAD = 32;
+
+    namespace hpack {
+        /**
+         * @brief Entry of the static table; @p header is the HeaderEnum of the name, empty for pseudo-headers
+         *        and the few names HeaderEnum does not know (accept-charset, vary, via).
+         */
+        struct StaticEntry {
+            std::string_view name;
+            std::string_view value;
+            std::optional<HeaderEnum> header;
+        };
+
+        /**
+         * @brief Appends @p value as an HPACK integer with a @p prefix_bits prefix; @p flags fills the bits above it.
+         */
+        void encodeInteger(std::string &out, uint8_t flags, uint8_t prefix_bits, uint64_t value);
+
+        /**
+         * @brief Reads an HPACK integer with a @p prefix_bits prefix at @p pos and advances it.
+         *
+         * @return false when the input ends inside the integer or the value does not fit 32 bits.
+         */
+        bool decodeInteger(std::string_view in, size_t &pos, uint8_t prefix_bits, uint64_t &value);
+
+        /**
+         * @brief Appends the Huffman-decoded @p in to @p out, false on invalid codes or padding.
+         *
+         * Decodes four bits per step through a precomputed state table.
+         */
+        bool huffmanDecode(std::string_view in, std::string &out);
+
+        /**
+         * @brief Bytes the Huffman coding of @p in takes.
+         */
+        size_t huffmanLength(std::string_view in);
+
+        /**
+         * @brief Appends the Huffman coding of @p in to @p out, padded with ones.
+         */
+        void huffmanEncode(std::string_view in, std::string &out);
+
+        /**
+         * @brief Appends @p in as a string literal, Huffman-coded when that is shorter.
+         *
+         * The length takes a @p prefix_bits prefix below the Huffman flag; @p flags fills the bits above that.
+         */
+        void encodeString(std::string &out, std::string_view in, uint8_t flags = 0x00, uint8_t prefix_bits = 7);
+
+        /**
+         * @brief Reads a string literal with a @p prefix_bits length prefix at @p pos into @p out and advances it.
+         *
+         * @return false when the input ends inside the string or its Huffman coding is invalid.
+         */
+        bool decodeString(std::string_view in, size_t &pos, uint8_t prefix_bits, std::string &out);
+
+        /**
+         * @brief The HeaderEnum of a lowercase field name, empty for pseudo-headers and unknown names.
+         */
+        std::optional<HeaderEnum> lookupHeader(std::string_view name);
+
+        /// How an encoder sends a field that is not in a table yet.
+        enum class Indexing {
+            INCREMENTAL,///< Added to the dynamic table.
+            WITHOUT,    ///< Sent as a literal, the value rarely repeats.
+            NEVER,      ///< Sent as a literal that intermediaries must not index either.
+        };
+
+        /**
+         * @brief Indexing for a field: values that change with every message are not indexed and credentials
+         *        never are, so they cannot be guessed from the compressed size (RFC 7541, 7.1.3).
+         */
+        Indexing indexing(std::optional<HeaderEnum> header, std::string_view name, std::string_view value);
+
+        /**
+         * @brief The static table entry @p index, 1-based.
+         */
+        const StaticEntry &staticEntry(size_t index);
+
+        /**
+         * @brief The first static table index with the name of @p header, 0 when the table does not have it.
+         */
+        size_t staticIndex(HeaderEnum header);
+
+        /**
+         * @brief The first static table index with the name @p name, 0 when the table does not have it.
+         */
+        size_t staticIndex(std::string_view name);
+
+        /**
+         * @brief The dynamic table of one side of a connection, bounded by its size in HPACK terms.
+         *
+         * Entries live in a ring of slots, newest first; every entry takes at least HPACK_ENTRY_OVERHEAD bytes,
+         * so the ring never needs more than max_capacity / HPACK_ENTRY_OVERHEAD slots. Inserting evicts the
+         * oldest entries and reuses their slots and string storage.
+         */
+        class DynamicTable {
+        public:
+            struct Entry {
+                std::string field;///< Name followed by value.
+                size_t name_size{0};
+                std::optional<HeaderEnum> header;
+
+                std::string_view name() const { return std::string_view(this->field).substr(0, this->name_size); }
+                std::string_view value() const { return std::string_view(this->field).substr(this->name_size); }
+            };
+
+            explicit DynamicTable(size_t max_capacity = HPACK_DEFAULT_TABLE_SIZE);
+
+            /**
+             * @brief The entry @p index places from the newest (0), nullptr past the oldest.
+             */
+            const Entry *at(size_t index) const;
+
+            /**
+             * @brief Adds an entry, evicting the oldest ones to make room; an entry larger than the table
+             *        empties it and is not added (RFC 7541, 4.4). @p name and @p value must not point into the table.
+             */
+            void insert(std::string_view name, std::string_view value, std::optional<HeaderEnum> header);
+
+            /**
+             * @brief Sets the size limit, evicting entries that no longer fit.
+             */
+            void setCapacity(size_t capacity);
+
+            /**
+             * @brief Sets the largest capacity the table may be given, which sizes the ring.
+             */
+            void setMaxCapacity(size_t max_capacity);
+
+            /**
+             * @brief Index of the newest entry with @p name and @p value; with only the name matching, the
+             *        newest entry with that name and @p exact false. -1 when no entry has the name.
+             */
+            ptrdiff_t find(std::string_view name, std::string_view value, bool &exact) const;
+
+            size_t size() const { return this->size_; }
+            size_t count() const { return this->count_; }
+            size_t capacity() const { return this->capacity_; }
+            size_t maxCapacity() const { return this->max_capacity_; }
+
+        private:
+            size_t slot(size_t index) const { return (this->head_ + this->slots_.size() - index) % this->slots_.size(); }
+            void evict(size_t capacity);
+
+            std::vector<Entry> slots_;
+            size_t head_{0};///< Slot of the newest entry.
+            size_t count_{0};
+            size_t size_{0};
+            size_t capacity_;
+            size_t max_capacity_;
+        };
+    }// namespace hpack
+
+    /**
+     * @brief Decodes HPACK header blocks (RFC 7541) of one HTTP/2 connection.
+     *
+     * Keeps the dynamic table the peer's encoder builds, so every block of the connection has to pass
+     * through the same decoder in the order it was received, including blocks of streams that are refused.
+     */
+    class HPACKDecoder {
+    public:
+        /// Receives every decoded field; the views are valid during the call only.
+        using FieldCallback = std::function<bool(std::string_view name, std::string_view value)>;
+
+        explicit HPACKDecoder(size_t max_table_size = HPACK_DEFAULT_TABLE_SIZE);
+
+        /**
+         * @brief Decodes a complete header block, calling @p field for every field in order.
+         *
+         * Stops when @p field returns false, which is not an error of the block itself; the dynamic table
+         * then misses the rest of the block, so the connection cannot go on decoding.
+         *
+         * @return A critical ParseError when the block is malformed (a COMPRESSION_ERROR in HTTP/2).
+         */
+        std::expected<void, usub::server::utils::error::ParseError> decode(std::string_view block, const FieldCallback &field);
+
+        /**
+         * @brief Decodes a complete request header block into @p headers.
+         *
+         * Pseudo-headers go to @p pseudo instead, and are dropped without it.
+         *
+         * @return A critical ParseError when the block is malformed; a field @p headers refuses is skipped.
+         */
+        std::expected<void, usub::server::utils::error::ParseError> decode(std::string_view block,
+                                                                           usub::server::protocols::http::Headers &headers,
+                                                                           const FieldCallback &pseudo = {});
+
+        /**
+         * @brief Sets the largest table size the peer may choose, the SETTINGS_HEADER_TABLE_SIZE sent to it.
+         */
+        void setMaxTableSize(size_t size);
+
+        size_t tableSize() const { return this->table_.size(); }
+
+    private:
+        template<class OnField>
+        std::expected<void, usub::server::utils::error::ParseError> decodeBlock(std::string_view block, OnField &&on_field);
+
+        hpack::DynamicTable table_;
+        std::string name_;
+        std::string value_;
+    };
+
+    /**
+     * @brief Encodes header blocks for one HTTP/2 connection.
+     *
+     * Fields found in the static or dynamic table are sent as an index. Other fields are added to the
+     * dynamic table when they are likely to repeat on the connection; values that change with every
+     * message (content-length, etag, ...) are sent without indexing and credentials never indexed, so
+     * intermediaries do not compress them either (RFC 7541, 7.1.3). Strings are Huffman-coded when shorter.
+     */
+    class HPACKEncoder {
+    public:
+        explicit HPACKEncoder(size_t max_table_size = HPACK_DEFAULT_TABLE_SIZE);
+
+        /**
+         * @brief Starts a header block in @p out, with the table size updates the peer is waiting for.
+         */
+        void begin(std::string &out);
+
+        /**
+         * @brief Appends one field; @p name must already be lowercase.
+         */
+        void encode(std::string &out, std::string_view name, std::string_view value);
+
+        /**
+         * @brief Applies the peer's SETTINGS_HEADER_TABLE_SIZE; the table uses at most the size given to the
+         *        constructor.
+         */
+        void setMaxTableSize(size_t size);
+
+        size_t tableSize() const { return this->table_.size(); }
+
+    private:
+        hpack::DynamicTable table_;
+        size_t limit_;           ///< Most the table may use, whatever the peer allows.
+        size_t smallest_update_; ///< Smallest size since the last block, announced before the final one.
+        bool size_update_{false};
+    };
+
+}// namespace usub::server::component
+
 #endif//SERVER_HPACK_H
@@ -5,4 +5,230 @@
 #ifndef SERVER_QPACK_H
 #define SERVER_QPACK_H
 
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <expected>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Components/Compression/HPACK.h"
+
+namespace usub::server::component {
+
+    /// Entries of the QPACK static table (RFC 9204, Appendix A).
+    inline constexpr size_t QPACK_STATIC_TABLE_SIZE = 99;
+
+    namespace qpack {
+        /**
+         * @brief The static table entry @p index, 0-based.
+         */
+        const hpack::StaticEntry &staticEntry(size_t index);
+
+        /**
+         * @brief Index of the static entry with @p name and @p value; with only the name matching, the first
+         *        entry with that name and @p exact false. -1 when the table does not have the name.
+         */
+        ptrdiff_t staticFind(std::string_view name, std::string_view value, bool &exact);
+
+        /**
+         * @brief The Required Insert Count as sent in a field section prefix (RFC 9204, 4.5.1.1).
+         *
+         * @p max_table_capacity is the decoder's SETTINGS_QPACK_MAX_TABLE_CAPACITY.
+         */
+        uint64_t encodeInsertCount(uint64_t required_insert_count, size_t max_table_capacity);
+
+        /**
+         * @brief Restores the Required Insert Count from its encoding, given the @p total_inserts the decoder has seen.
+         *
+         * @return false when no Required Insert Count produces @p encoded.
+         */
+        bool decodeInsertCount(uint64_t encoded, size_t max_table_capacity, uint64_t total_inserts, uint64_t &required_insert_count);
+    }// namespace qpack
+
+    /**
+     * @brief Decodes QPACK field sections (RFC 9204) of one HTTP/3 connection.
+     *
+     * The peer's encoder stream is fed in as it arrives, in pieces of any size, and builds the dynamic table.
+     * Field sections can be decoded in any order; one that references entries the encoder stream has not
+     * delivered yet blocks until they arrive. The decoder stream (acknowledgements back to the encoder) is
+     * collected into a byte buffer the caller sends.
+     */
+    class QPACKDecoder {
+    public:
+        /// Receives every decoded field; the views are valid during the call only.
+        using FieldCallback = HPACKDecoder::FieldCallback;
+
+        /**
+         * @param max_table_capacity The SETTINGS_QPACK_MAX_TABLE_CAPACITY sent to the peer.
+         * @param max_blocked_streams The SETTINGS_QPACK_BLOCKED_STREAMS sent to the peer.
+         */
+        explicit QPACKDecoder(size_t max_table_capacity = 0, size_t max_blocked_streams = 0);
+
+        /**
+         * @brief Processes bytes of the peer's encoder stream; an instruction may end in a later call.
+         *
+         * @return A critical ParseError on an invalid instruction (a QPACK_ENCODER_STREAM_ERROR in HTTP/3).
+         */
+        std::expected<void, usub::server::utils::error::ParseError> onEncoderStream(std::string_view data);
+
+        /**
+         * @brief Decodes the complete field section of @p stream_id, calling @p field for every field in order.
+         *
+         * Stops when @p field returns false.
+         *
+         * @return false when the section is blocked on the encoder stream: nothing was decoded, and the same
+         *         section has to be decoded again once unblockedStreams() lists the stream. A critical ParseError
+         *         when the section is malformed or one stream too many blocks (a QPACK_DECOMPRESSION_FAILED).
+         */
+        std::expected<bool, usub::server::utils::error::ParseError> decode(uint64_t stream_id, std::string_view section,
+                                                                           const FieldCallback &field);
+
+        /**
+         * @brief Decodes the complete request field section of @p stream_id into @p headers.
+         *
+         * Pseudo-headers go to @p pseudo instead, and are dropped without it. Blocking as in the callback overload.
+         */
+        std::expected<bool, usub::server::utils::error::ParseError> decode(uint64_t stream_id, std::string_view section,
+                                                                           usub::server::protocols::http::Headers &headers,
+                                                                           const FieldCallback &pseudo = {});
+
+        /**
+         * @brief Streams whose blocked section can be decoded now, each reported once.
+         */
+        std::vector<uint64_t> unblockedStreams();
+
+        /**
+         * @brief Forgets a stream that was reset or abandoned and tells the encoder.
+         */
+        void cancelStream(uint64_t stream_id);
+
+        /**
+         * @brief Takes the decoder stream bytes to send, with an Insert Count Increment for entries not yet
+         *        acknowledged by a section.
+         */
+        std::string takeDecoderStream();
+
+        size_t tableSize() const { return this->table_.size(); }
+        uint64_t insertCount() const { return this->insert_count_; }
+
+        /**
+         * @brief Streams whose section still waits for the encoder stream.
+         */
+        size_t blockedStreams() const;
+
+    private:
+        template<class OnField>
+        std::expected<bool, usub::server::utils::error::ParseError> decodeSection(uint64_t stream_id, std::string_view section,
+                                                                                  OnField &&on_field);
+
+        /// The entry with absolute index @p index, nullptr when it was never inserted or is evicted.
+        const hpack::DynamicTable::Entry *entry(uint64_t index) const;
+
+        hpack::DynamicTable table_;
+        size_t max_table_capacity_;
+        size_t max_blocked_streams_;
+        uint64_t insert_count_{0};
+        uint64_t known_received_count_{0};///< Inserts the encoder knows were received.
+        std::unordered_map<uint64_t, uint64_t> blocked_;///< Blocked stream to its Required Insert Count.
+        std::string encoder_input_;///< Start of an encoder stream instruction still incomplete.
+        std::string decoder_stream_;
+        std::string name_;
+        std::string value_;
+    };
+
+    /**
+     * @brief Encodes field sections for one HTTP/3 connection.
+     *
+     * Indexes fields like HPACKEncoder, with the entries inserted through the encoder stream, which the caller
+     * sends before the sections referencing them. A section references entries the decoder has not acknowledged
+     * only while fewer streams than the peer allows are blocked, and entries still referenced by unacknowledged
+     * sections are never evicted; a field that cannot be indexed under those limits goes out as a literal.
+     */
+    class QPACKEncoder {
+    public:
+        /**
+         * @param max_table_capacity The most the dynamic table may use, whatever the peer allows.
+         */
+        explicit QPACKEncoder(size_t max_table_capacity = HPACK_DEFAULT_TABLE_SIZE);
+
+        /**
+         * @brief Applies the peer's SETTINGS_QPACK_MAX_TABLE_CAPACITY and SETTINGS_QPACK_BLOCKED_STREAMS; the
+         *        dynamic table stays unused until then.
+         */
+        void setPeerSettings(size_t max_table_capacity, size_t max_blocked_streams);
+
+        /**
+         * @brief Starts the field section of @p stream_id.
+         */
+        void begin(uint64_t stream_id);
+
+        /**
+         * @brief Adds one field to the section; @p name must already be lowercase.
+         */
+        void encode(std::string_view name, std::string_view value);
+
+        /**
+         * @brief Appends the finished section, prefix first, to @p out.
+         */
+        void end(std::string &out);
+
+        /**
+         * @brief Processes bytes of the peer's decoder stream; an instruction may end in a later call.
+         *
+         * @return A critical ParseError on an invalid instruction (a QPACK_DECODER_STREAM_ERROR in HTTP/3).
+         */
+        std::expected<void, usub::server::utils::error::ParseError> onDecoderStream(std::string_view data);
+
+        /**
+         * @brief Takes the encoder stream bytes to send, before any section that may reference them.
+         */
+        std::string takeEncoderStream() { return std::exchange(this->encoder_stream_, {}); }
+
+        size_t tableSize() const { return this->table_.size(); }
+        uint64_t insertCount() const { return this->insert_count_; }
+
+        /**
+         * @brief Streams with a section referencing entries the decoder has not acknowledged yet.
+         */
+        size_t blockedStreams() const;
+
+    private:
+        struct Section {
+            uint64_t required_insert_count;
+            uint64_t min_reference;///< Oldest entry referenced.
+        };
+
+        bool isBlocked(uint64_t stream_id) const;
+
+        /// Records a reference to the entry with absolute index @p index in the current section, false when
+        /// that would block one stream too many.
+        bool reference(uint64_t index);
+
+        /// Entries an insert of @p entry_size bytes evicts, -1 when that would evict a referenced entry.
+        ptrdiff_t evictions(size_t entry_size) const;
+
+        void emitIndexed(uint64_t index);
+
+        hpack::DynamicTable table_;
+        size_t limit_;
+        size_t peer_max_capacity_{0};
+        size_t max_blocked_streams_{0};
+        uint64_t insert_count_{0};
+        uint64_t known_received_count_{0};
+        std::unordered_map<uint64_t, std::deque<Section>> unacknowledged_;
+        std::string encoder_stream_;
+        std::string decoder_input_;
+
+        uint64_t stream_id_{0};
+        uint64_t base_{0};
+        Section section_{0, UINT64_MAX};
+        std::string lines_;
+    };
+
+}// namespace usub::server::component
+
 #endif//SERVER_QPACK_H
@@ -3,6 +3,7 @@
 
 #include <algorithm>
 #include <cctype>
+#include <memory_resource>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -15,11 +16,24 @@ namespace usub::server::component::url {
     class QueryParams {
     private:
         std::string query_params_string_;
-        std::unordered_map<std::string, std::vector<std::string>> query_params_map_;
+        std::pmr::unordered_map<std::string, std::vector<std::string>> query_params_map_;
         using iterator = decltype(query_params_map_)::iterator;
         using const_iterator = decltype(query_params_map_)::const_iterator;
 
     public:
+        QueryParams() = default;
+        explicit QueryParams(std::pmr::memory_resource *resource);
+        QueryParams(const QueryParams &) = default;
+
+        /**
+         * @brief Moves the parameters of @p other into storage of the default resource, so parameters moved
+         *        out of an arena-backed request outlive the arena.
+         */
+        QueryParams(QueryParams &&other);
+
+        QueryParams &operator=(const QueryParams &) = default;
+        QueryParams &operator=(QueryParams &&) = default;
+
         void addQueryParam(std::string_view key, std::string_view value);
 
         std::string &string();
@@ -42,6 +56,16 @@ namespace usub::server::component::url {
 
         const_iterator cbegin() const;
         const_iterator cend() const;
+
+        /**
+         * @brief Removes all parameters, keeping the string capacity for the next request.
+         */
+        void clear();
+
+        /**
+         * @brief Removes all parameters and allocates further map storage from @p resource.
+         */
+        void setMemoryResource(std::pmr::memory_resource *resource);
     };
 }// namespace usub::server::component::url
 
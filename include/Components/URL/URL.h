@@ -61,6 +61,11 @@ namespace usub::server::component {
         std::string string() const;
         std::vector<std::string> &operator[](const std::string &key);
         const std::vector<std::string> &operator[](const std::string &key) const;
+
+        /**
+         * @brief Empties every component in place, so the next parse reuses the allocated capacity.
+         */
+        void clear();
     };
 
 }// namespace usub::server::component
@@ -0,0 +1,250 @@
+#pragma once
+#ifdef USE_IO_URING
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <system_error>
+#include <vector>
+
+#include <uvent/Uvent.h>
+#include <uvent/net/Socket.h>
+#include <uvent/tasks/Awaitable.h>
+
+#include "Protocols/HTTP/HTTP1.h"
+#include "server/Acceptor.h"
+#include "server/IoUring.h"
+#include "server/ListenSocket.h"
+#include "server/TimerWheel.h"
+
+/// Submission queue size of each thread's ring.
+static constexpr unsigned IO_URING_ENTRIES = 4096;
+/// Provided receive buffers per thread, IO_URING_BUFFER_COUNT * IO_URING_BUFFER_SIZE bytes in total.
+static constexpr uint16_t IO_URING_BUFFER_COUNT = 1024;
+static constexpr uint32_t IO_URING_BUFFER_SIZE = 16 * 1024;
+
+namespace usub::server {
+
+    /**
+     * @brief HTTP/1.x transport on io_uring, a drop-in stream handler for ServerImpl.
+     *
+     * Every uvent thread runs one ring with its own SO_REUSEPORT listener: a multishot accept takes new
+     * connections, a multishot receive per connection fills kernel-selected buffers from a shared provided
+     * buffer ring, and responses go out as SENDMSG (plus linked SPLICE chains for file bodies). Completions of
+     * all connections are reaped in one pass and their sends submitted with one io_uring_enter(), instead of
+     * an epoll wakeup plus a read and a write syscall per request. Requests run through the same HTTP1 state
+     * machine, pipelining and deadlines as PlainHTTPStreamHandler.
+     */
+    template<class TRouter>
+    class IoUringHTTPStreamHandler : public PlainHTTPStreamHandler<TRouter> {
+    public:
+        using RouterType = TRouter;
+
+        IoUringHTTPStreamHandler(std::shared_ptr<RouterType> router)
+            : PlainHTTPStreamHandler<TRouter>(std::move(router)) {}
+
+        /**
+         * @brief Runs the ring of the calling thread: accepts on @p listen_fd and drives all its connections.
+         *
+         * Must be spawned with co_spawn_static() on the thread @p thread_index; connection coroutines are
+         * pinned to the same thread.
+         */
+        usub::uvent::task::Awaitable<void> serve(int listen_fd, int thread_index) {
+            std::unique_ptr<net::IoUringLoop> loop;
+            try {
+                loop = std::make_unique<net::IoUringLoop>(IO_URING_ENTRIES, IO_URING_BUFFER_COUNT, IO_URING_BUFFER_SIZE);
+            } catch (const std::system_error &e) {
+                std::cerr << "io_uring on thread " << thread_index << ": " << e.what() << std::endl;
+                co_return;
+            }
+            // the reactor only learns about completions through the ring's eventfd
+            usub::uvent::net::TCPClientSocket events{loop->eventFd()};
+            usub::uvent::utils::DynamicBuffer counter;
+            loop->startAccept(listen_fd);
+
+            for (;;) {
+                for (int fd: loop->dispatch()) {
+                    usub::uvent::system::co_spawn_static(this->connection(*loop, loop->open(fd)), thread_index);
+                }
+                counter.clear();
+                if (co_await events.async_read(counter, sizeof(uint64_t)) < 0) {
+                    co_return;
+                }
+            }
+        }
+
+    protected:
+        usub::uvent::task::Awaitable<void> connection(net::IoUringLoop &loop, net::UringConnection &conn) {
+            using HTTP1Type = protocols::http::HTTP1<RouterType>;
+            using std::chrono::milliseconds;
+
+            // responses are written through the ring, HTTP1 only keeps this as an opaque handle
+            usub::uvent::net::TCPClientSocket unused_socket;
+            std::vector<std::unique_ptr<HTTP1Type>> pipeline;
+            pipeline.push_back(std::make_unique<HTTP1Type>(this->endpoint_handler_));
+            std::vector<iovec> segments;
+
+            net::TimerWheel &timers = net::TimerWheel::local();
+            net::Deadline deadline{conn.fd};
+            bool awaiting_headers = true;
+            auto headers_started = std::chrono::steady_clock::now();
+            timers.arm(deadline, milliseconds(this->timeouts_.header));
+
+            bool open = true;
+            while (open) {
+                co_await loop.received(conn);
+                if (conn.received.empty()) break;// end of stream
+                timers.cancel(deadline);
+
+                const auto [bid, len] = conn.received.front();
+                conn.received.pop_front();
+                std::string_view pending = loop.data(bid, len);
+
+                bool partial = false;
+                while (!pending.empty() && open) {
+                    size_t ready = 0;
+                    bool close_connection = false;
+                    while (!pending.empty() && ready < MAX_PIPELINE_DEPTH) {
+                        if (ready == pipeline.size()) {
+                            pipeline.push_back(std::make_unique<HTTP1Type>(this->endpoint_handler_));
+                        }
+                        HTTP1Type &http1 = *pipeline[ready];
+                        const size_t consumed = co_await http1.readCallback(pending, unused_socket);
+                        pending.remove_prefix(std::min(consumed, pending.size()));
+
+                        if (http1.getRequest().getState() < protocols::http::REQUEST_STATE::FINISHED) {
+                            partial = true;
+                            break;
+                        }
+                        ++ready;
+                        if (this->prepareClose(http1)) {
+                            close_connection = true;
+                            break;
+                        }
+                    }
+                    if (ready == 0) break;
+
+                    timers.arm(deadline, milliseconds(this->timeouts_.write));
+                    open = co_await this->writeResponses(loop, conn, pipeline, ready, segments) && !close_connection;
+                    timers.cancel(deadline);
+                    for (size_t i = 0; i < ready; ++i) {
+                        pipeline[i]->getResponse().clear();
+                    }
+                    std::rotate(pipeline.begin(), pipeline.begin() + ready, pipeline.end());
+                }
+                loop.recycle(bid);
+                if (!open) break;
+
+                if (!partial) {
+                    awaiting_headers = false;
+                    timers.arm(deadline, milliseconds(this->timeouts_.keep_alive));
+                } else if (pipeline[0]->getRequest().getState() < protocols::http::REQUEST_STATE::HEADERS_PARSED) {
+                    const auto now = std::chrono::steady_clock::now();
+                    if (!awaiting_headers) {
+                        awaiting_headers = true;
+                        headers_started = now;
+                    }
+                    if (this->timeouts_.header > 0) {
+                        const auto left = milliseconds(this->timeouts_.header) - std::chrono::duration_cast<milliseconds>(now - headers_started);
+                        timers.arm(deadline, std::max(left, milliseconds(1)));
+                    }
+                } else {
+                    awaiting_headers = false;
+                    timers.arm(deadline, milliseconds(this->timeouts_.body));
+                }
+            }
+            timers.cancel(deadline);
+            loop.finish(conn);
+            co_return;
+        }
+
+        /**
+         * @brief Writes the responses of pipeline[0, count) in order through the ring.
+         *
+         * Buffered responses are gathered into one SENDMSG; a file body is sent together with what was
+         * gathered before it as one linked chain.
+         */
+        static usub::uvent::task::Awaitable<bool> writeResponses(net::IoUringLoop &loop,
+                                                                 net::UringConnection &conn,
+                                                                 std::vector<std::unique_ptr<protocols::http::HTTP1<RouterType>>> &pipeline,
+                                                                 size_t count,
+                                                                 std::vector<iovec> &segments) {
+            protocols::http::FileRange file_range;
+            segments.clear();
+            for (size_t i = 0; i < count; ++i) {
+                auto &response = pipeline[i]->getResponse();
+                while (!response.isSent()) {
+                    response.pullSegments(segments, file_range);
+                    if (file_range.fd == -1) continue;
+
+                    if (!co_await loop.sendFile(conn, segments, file_range)) {
+                        co_return false;
+                    }
+                    if (!file_range.trailer.empty()) {
+                        segments.push_back({const_cast<char *>(file_range.trailer.data()), file_range.trailer.size()});
+                    }
+                }
+            }
+            if (!segments.empty() && !co_await loop.sendAll(conn, segments)) {
+                co_return false;
+            }
+            co_return true;
+        }
+    };
+
+    /**
+     * @brief Acceptor for IoUringHTTPStreamHandler: one ring and one SO_REUSEPORT listener per uvent thread.
+     *
+     * The listener's accept_mode is ignored, io_uring listeners are always sharded per thread.
+     */
+    template<class TRouter>
+    class Acceptor<IoUringHTTPStreamHandler<TRouter>> : public IoUringHTTPStreamHandler<TRouter> {
+    public:
+        Acceptor(std::shared_ptr<Uvent> uvent,
+                 std::shared_ptr<TRouter> router,
+                 configuration::ConfigReader &cfg,
+                 size_t listener_index)
+            : IoUringHTTPStreamHandler<TRouter>(std::move(router)), uvent_(std::move(uvent)), cfg_(cfg), listener_index_(listener_index) {
+            auto &listeners = cfg_.getListeners();
+            if (listener_index_ < listeners.size()) {
+                this->setTimeouts(listeners[listener_index_].timeouts);
+            }
+        }
+
+        usub::uvent::task::Awaitable<void> loop() {
+            co_return;
+        }
+
+        usub::uvent::task::Awaitable<void> loopShard(int thread_index) {
+            auto listeners = cfg_.getListeners();
+            if (listener_index_ >= listeners.size()) {
+                co_return;
+            }
+            const auto &listener = listeners[listener_index_];
+
+            int listen_fd;
+            try {
+                listen_fd = net::openReusePortListener(listener.ip_addr, listener.port, cfg_.getBacklog(), listener.ipv);
+            } catch (const std::system_error &e) {
+                std::cerr << "io_uring acceptor " << thread_index << " on port " << listener.port << ": " << e.what() << std::endl;
+                co_return;
+            }
+            co_await this->serve(listen_fd, thread_index);
+            ::close(listen_fd);
+        }
+
+        configuration::AcceptMode acceptMode() const {
+            return configuration::AcceptMode::REUSE_PORT;
+        }
+
+    private:
+        std::shared_ptr<usub::Uvent> uvent_;
+        configuration::ConfigReader &cfg_;
+        size_t listener_index_{0};
+    };
+
+}// namespace usub::server
+
+#endif// USE_IO_URING
@@ -1,199 +1,646 @@
 #pragma once
 #ifdef USE_OPEN_SSL
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
 #include <memory>
-#include <Uvent.h>
-#include "utils/ssl/SSLHelper.h"
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <uvent/Uvent.h>
+#include <uvent/net/Socket.h>
+#include <uvent/tasks/Awaitable.h>
 
 #include "Protocols/HTTP/HTTP1.h"
+#include "Protocols/HTTP/HTTP2.h"
+#include "server/Acceptor.h"
+#include "server/BufferPool.h"
+#include "server/TimerWheel.h"
+#include "server/VectoredWrite.h"
+#include "server/WorkerPool.h"
+#include "utils/ssl/CertificateTable.h"
+#include "utils/ssl/EarlyData.h"
+#include "utils/ssl/KTLS.h"
+#include "utils/ssl/OcspStapling.h"
+#include "utils/ssl/RecordSizing.h"
+#include "utils/ssl/SSLHelper.h"
+#include "utils/ssl/SessionResumption.h"
+#include "utils/ssl/SocketBIO.h"
 
+/// Ciphertext read per call, one full TLS record.
 static constexpr std::size_t NET_BUF_SIZE = 16 * 1024;
+/// Shortest secret accepted in a ticket_key_file.
+static constexpr std::size_t TICKET_SECRET_MIN_SIZE = 32;
 
-namespace usub::server{
+namespace usub::server {
 
+    /**
+     * @brief HTTP/1.1, and HTTP/2 when `[http2]` is enabled, over TLS; ALPN picks the protocol.
+     *
+     * OpenSSL reads and writes ciphertext directly on the socket through create_socket_bio() and
+     * create_ktls_socket_bio() BIOs; only when the socket has no data does the coroutine wait in a read into a
+     * pooled buffer, which OpenSSL then consumes in place. When OpenSSL and the kernel support it, transmit
+     * encryption moves into the kernel (kTLS) after the handshake: responses are written as plaintext with the
+     * same vectored write and sendfile(2) path as PlainHTTPStreamHandler. Otherwise they are encrypted with
+     * SSL_write in records sized by a usub::utils::ssl::RecordSizer. Received records are always decrypted by
+     * OpenSSL.
+     */
     template<class TRouter>
-    class TLSHTTPStreamHandler
-    {
+    class TLSHTTPStreamHandler : public PlainHTTPStreamHandler<TRouter> {
     public:
         using RouterType = TRouter;
 
         TLSHTTPStreamHandler(std::shared_ptr<RouterType> router)
-        : router_(std::move(router))
-        {
-            ctx_ =  usub::utils::ssl::create_http1_ctx("key.pem", "cert.pem");
-            static const unsigned char alpn_proto[] = { 8, 'h','t','t','p','/','1','.','1' };
-
-            SSL_CTX_set_alpn_select_cb(ctx_,
-              [](SSL* /*ssl*/,
-                 const unsigned char** out, unsigned char* outlen,
-                 const unsigned char* in, unsigned int inlen,
-                 void* /*arg*/) -> int
-              {
-                int sel = SSL_select_next_proto(
-                  const_cast<unsigned char**>(out), outlen,
-                  alpn_proto, sizeof(alpn_proto),
-                  in, inlen
-                );
-                if (sel == OPENSSL_NPN_NEGOTIATED) {
-                  return SSL_TLSEXT_ERR_OK;
+            : PlainHTTPStreamHandler<TRouter>(std::move(router)) {}
+
+        /**
+         * @brief Loads the listener's certificate and selects the `[[certs]]` entries by SNI.
+         *
+         * The per-domain contexts are built from @p certs once per handler and shared by the threads of its
+         * listener; a listener whose key/cert pair also appears in `[[certs]]` reuses that context.
+         */
+        void setCertificates(const configuration::ListenerConfig &listener,
+                             const std::vector<configuration::Certificate> &certs) {
+            certificates_ = std::make_shared<const usub::utils::ssl::CertificateTable>(certs, configureContext);
+            const usub::utils::ssl::CertificateTable &table = *certificates_;
+
+            const std::string key_file = listener.key_file.empty() ? "key.pem" : listener.key_file;
+            const std::string cert_file = listener.cert_file.empty() ? "cert.pem" : listener.cert_file;
+            SSL_CTX *ctx = table.context(key_file, cert_file);
+            if (ctx) {
+                SSL_CTX_up_ref(ctx);
+            } else {
+                ctx = usub::utils::ssl::CertificateTable::load(key_file, cert_file);
+                configureContext(ctx);
+            }
+            ctx_.reset(ctx, SSL_CTX_free);
+            cert_file_ = cert_file;
+            table.attach(ctx_.get());
+        }
+
+        /**
+         * @brief With `[http2] enabled`, offers h2 ahead of http/1.1 in ALPN on every context of the listener.
+         */
+        void setHTTP2(const configuration::HTTP2Config &config) {
+            PlainHTTPStreamHandler<TRouter>::setHTTP2(config);
+            if (!config.enabled || !ctx_) return;
+            static const unsigned char alpn_protos[] = {2, 'h', '2', 8, 'h', 't', 't', 'p', '/', '1', '.', '1'};
+            auto offer = [](SSL_CTX *ctx) { selectProtocol(ctx, alpn_protos); };
+            offer(ctx_.get());
+            if (certificates_) certificates_->forEach(offer);
+        }
+
+        /**
+         * @brief Enables session resumption through a session cache and ticket key ring built from @p config.
+         *
+         * All threads of the listener share the cache and key ring, so a client can resume on any uvent thread.
+         * With `early_data`, resumed TLS 1.3 clients may also send requests in their first flight; they are
+         * answered before the handshake completes for routes that accept early data (Route::acceptEarlyData()).
+         */
+        void setSessionResumption(const configuration::TLSSessionConfig &config) {
+            if (!ctx_) return;
+            if (config.session_cache_size > 0) {
+                session_cache_ = std::make_shared<usub::utils::ssl::SessionCache>(static_cast<size_t>(config.session_cache_size));
+            }
+            if (config.session_tickets) {
+                std::string secret;
+                if (!config.ticket_key_file.empty()) {
+                    std::ifstream file(config.ticket_key_file, std::ios::binary);
+                    secret.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+                    if (!file.good() && !file.eof()) {
+                        throw configuration::error::WrongConfig("Cannot read tls ticket_key_file: " + config.ticket_key_file);
+                    }
+                    if (secret.size() < TICKET_SECRET_MIN_SIZE) {
+                        throw configuration::error::WrongConfig("tls ticket_key_file must hold at least 32 bytes: " + config.ticket_key_file);
+                    }
                 }
-                return SSL_TLSEXT_ERR_NOACK;
-              },
-              nullptr
-            );
+                ticket_keys_ = std::make_shared<usub::utils::ssl::TicketKeyRing>(std::chrono::seconds(config.ticket_key_rotation), std::move(secret));
+            }
+            usub::utils::ssl::SessionCache *cache = session_cache_.get();
+            usub::utils::ssl::TicketKeyRing *keys = ticket_keys_.get();
+            // early data is only sent on resumption, which needs the cache or tickets
+            if (config.early_data && (cache || keys)) {
+                replay_window_ = std::make_shared<usub::utils::ssl::ReplayWindow>(std::chrono::seconds(config.early_data_replay_window));
+            }
+            usub::utils::ssl::ReplayWindow *replay = replay_window_.get();
 
+            auto enable = [&](SSL_CTX *ctx) {
+                SSL_CTX_set_timeout(ctx, config.session_timeout);
+                if (cache) {
+                    cache->attach(ctx);
+                } else {
+                    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+                }
+                if (keys) {
+                    keys->attach(ctx);
+                } else {
+                    SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+                }
+                if (replay) {
+                    // OpenSSL's own protection makes sessions single-use in its internal cache, which the shared
+                    // cache replaces; the replay window checks the ClientHellos instead
+                    SSL_CTX_set_options(ctx, SSL_OP_NO_ANTI_REPLAY);
+                    SSL_CTX_set_max_early_data(ctx, static_cast<uint32_t>(config.early_data_size));
+                    SSL_CTX_set_recv_max_early_data(ctx, static_cast<uint32_t>(config.early_data_size));
+                    replay->attach(ctx);
+                }
+            };
+            enable(ctx_.get());
+            // after an SNI switch OpenSSL keeps the callbacks of ctx_ but they find their state in the selected context
+            if (certificates_) certificates_->forEach(enable);
+            early_data_ = replay != nullptr;
+        }
+
+        /**
+         * @brief Moves handshake steps to a worker pool when `handshake_workers` is set.
+         *
+         * Signing and key exchange then run on the pool while the connection coroutine waits, so a burst
+         * of new connections does not stall requests on established ones. The pool is shared by all
+         * threads of the listener.
+         */
+        void setHandshakeOffload(const configuration::TLSHandshakeConfig &config) {
+            if (config.workers <= 0) return;
+            handshake_pool_ = std::make_shared<net::WorkerPool>(static_cast<size_t>(config.workers), static_cast<size_t>(config.queue));
+        }
+
+        /**
+         * @brief Sets the record size policy of the connections encrypted with SSL_write.
+         */
+        void setRecordSizing(const configuration::TLSRecordConfig &config) {
+            records_ = config;
+        }
+
+        /**
+         * @brief Staples OCSP responses when `ocsp_stapling` is set, through a stapler owned by the handler.
+         *
+         * Every `[[certs]]` entry with an `ocsp_file`, an `ocsp_responder` or an OCSP URL in its certificate
+         * gets its responses refreshed in the background; the listener's own certificate only with the URL.
+         *
+         * @throws configuration::error::WrongConfig when an entry with `ocsp_file` or `ocsp_responder` has
+         *         no issuer certificate in its chain file.
+         */
+        void setOcspStapling(const configuration::TLSOcspConfig &config,
+                             const std::vector<configuration::Certificate> &certs) {
+            if (!config.ocsp_stapling || !ctx_) return;
+            ocsp_stapler_ = std::make_shared<usub::utils::ssl::OcspStapler>(std::chrono::seconds(config.ocsp_refresh),
+                                                                            std::chrono::seconds(config.ocsp_retry),
+                                                                            std::chrono::seconds(config.ocsp_timeout));
+            usub::utils::ssl::OcspStapler &stapler = *ocsp_stapler_;
+            if (certificates_) {
+                for (const auto &cert: certs) {
+                    SSL_CTX *ctx = certificates_->context(cert.key_file, cert.cert_file);
+                    const bool configured = !cert.ocsp_file.empty() || !cert.ocsp_responder.empty();
+                    if (ctx && !stapler.add(ctx, cert.cert_file, cert.ocsp_file, cert.ocsp_responder) && configured) {
+                        throw configuration::error::WrongConfig("Cannot staple OCSP for " + cert.cert_file +
+                                                                ": the chain file must include the issuer");
+                    }
+                }
+            }
+            stapler.add(ctx_.get(), cert_file_, {}, {});
         }
 
         usub::uvent::task::Awaitable<void>
-        clientCoroutine(usub::uvent::net::TCPClientSocket socket)
-        {
-            SSL* ssl = usub::utils::ssl::create_ssl(ctx_);
-            if (!ssl) { 
-                socket->shutdown();
+        clientCoroutine(usub::uvent::net::TCPClientSocket socket) {
+            SSL *ssl = usub::utils::ssl::create_ssl(ctx_.get());
+            if (!ssl) {
+                socket.shutdown();
                 co_return;
             }
+            const int fd = socket.get_raw_header()->fd;
 
-            BIO* in_bio  = BIO_new(BIO_s_mem());
-            BIO* out_bio = BIO_new(BIO_s_mem());
-            BIO_set_mem_eof_return(in_bio,  -1);
-            BIO_set_mem_eof_return(out_bio, -1);
+            BIO *rbio = usub::utils::ssl::create_socket_bio(fd);
+            BIO *wbio = usub::utils::ssl::create_ktls_socket_bio(fd);
+            if (!rbio || !wbio) {
+                BIO_free(rbio);
+                BIO_free(wbio);
+                SSL_free(ssl);
+                socket.shutdown();
+                co_return;
+            }
             SSL_set_accept_state(ssl);
-            SSL_set_bio(ssl, in_bio, out_bio);
-
-            // I/O
-            usub::uvent::utils::DynamicBuffer net_buffer;
-            net_buffer.reserve(NET_BUF_SIZE);
-            std::vector<char> ssl_buffer(NET_BUF_SIZE);
-
-            // handshake
-            bool handshake_done = false;
-            while (!handshake_done) {
-                net_buffer.clear();
-
-                ssize_t rd = co_await socket->async_read(net_buffer, NET_BUF_SIZE);
-                if (rd <= 0) {
-                    SSL_free(ssl);
-                    co_return;
-                }
-                BIO_write(in_bio, net_buffer.data(), int(rd));
-
-                for (;;) {
-                    int rc  = SSL_do_handshake(ssl);
-                    int err = SSL_get_error(ssl, rc);
-
-                    while (BIO_pending(out_bio) > 0) {
-                        int n = BIO_read(out_bio, ssl_buffer.data(), int(NET_BUF_SIZE));
-                        if (n > 0) {
-                            co_await socket->async_write((uint8_t*)ssl_buffer.data(), n);
-                        }
-                    }
+            SSL_set_bio(ssl, rbio, wbio);
+            // ciphertext received while OpenSSL waited, lent to the BIO until the next SSL_ERROR_WANT_READ
+            net::BufferLease input;
+
+            net::TimerWheel &timers = net::TimerWheel::local();
+            net::Deadline deadline{fd};
+            timers.arm(deadline, std::chrono::milliseconds(this->timeouts_.header));
+
+            std::string early_data;
+            const Handshake state = co_await handshake(socket, ssl, input, handshake_pool_.get(), early_data_ ? &early_data : nullptr);
+            if (state != Handshake::FAILED) {
+                const std::string_view protocol = selectedProtocol(ssl);
+                if (protocol == "h2") {
+                    co_await this->serveHTTP2(socket, ssl, input, timers, deadline, std::move(early_data), state == Handshake::EARLY);
+                } else if (protocol == "http/1.1") {
+                    co_await this->serve(socket, ssl, input, timers, deadline, std::move(early_data), state == Handshake::EARLY);
+                }
+            }
+            timers.cancel(deadline);
+
+            if (SSL_is_init_finished(ssl)) {
+                SSL_shutdown(ssl);
+                co_await flush(socket, ssl);
+            }
+            SSL_free(ssl);
+            socket.shutdown();
+            co_return;
+        }
+
+    private:
+        enum class Handshake {
+            FAILED,
+            DONE, ///< The handshake completed.
+            EARLY,///< Early data was read and the client's Finished has not arrived yet.
+        };
+
+        /**
+         * @brief Answers the requests of one connection.
+         *
+         * With @p reading_early the handshake is still waiting for the client's Finished and @p plaintext holds
+         * the early data read so far. Until the handshake completes, only requests for routes accepting early
+         * data are answered; the first other request and everything after it are held and parsed again once
+         * the client has proven it is not replaying a recorded ClientHello.
+         */
+        usub::uvent::task::Awaitable<void> serve(usub::uvent::net::TCPClientSocket &socket, SSL *ssl, net::BufferLease &input,
+                                                 net::TimerWheel &timers, net::Deadline &deadline,
+                                                 std::string plaintext, bool reading_early) {
+            using HTTP1Type = protocols::http::HTTP1<RouterType>;
+            using std::chrono::milliseconds;
+
+            // a single exchange, kept in the shape writeResponses() takes
+            std::vector<std::unique_ptr<HTTP1Type>> exchange;
+            exchange.push_back(std::make_unique<HTTP1Type>(this->endpoint_handler_));
+            HTTP1Type &http1 = *exchange.front();
+
+            const bool ktls = usub::utils::ssl::ktls_send_enabled(ssl);
+            usub::utils::ssl::RecordSizer records(static_cast<size_t>(records_.record_size),
+                                                  static_cast<uint64_t>(records_.record_boost_bytes),
+                                                  milliseconds(records_.record_boost_time),
+                                                  milliseconds(records_.record_idle_reset));
+            // received before the handshake completed and not fed to the parser yet
+            std::string held;
+            // bytes of an early request still arriving, held as well should its route turn out to need the handshake
+            std::string early_request;
+            std::vector<iovec> segments;
+            bool answered = false;
+
+            // the first records may have arrived together with the client's Finished and already sit in OpenSSL
+            for (bool first = true;; first = false) {
+                if (!first) {
+                    if (!co_await receive(socket, ssl, input)) break;
+                    timers.cancel(deadline);
+                }
+
+                const bool peer_closed = !co_await decrypt(socket, ssl, plaintext, reading_early);
+                // records OpenSSL produced while reading (session tickets, key updates, alerts)
+                if (!co_await flush(socket, ssl)) break;
+
+                const bool verified = SSL_is_init_finished(ssl);
+                if (!verified && (!reading_early || !held.empty())) {
+                    // a request waits for the handshake, or early data ended and the client's Finished is still due
+                    held.append(plaintext);
+                    plaintext.clear();
+                    if (peer_closed) break;
+                    timers.arm(deadline, milliseconds(this->timeouts_.header));
+                    continue;
+                }
+                if (verified && !held.empty()) {
+                    held.append(plaintext);
+                    plaintext.swap(held);
+                    held.clear();
+                }
+                if (verified) early_request.clear();
+                http1.setEarlyData(!verified);
 
-                    if (rc == 1) {
-                        handshake_done = true;
+                std::string_view pending = plaintext;
+                bool close_connection = peer_closed;
+                bool partial = false;
+                while (!pending.empty()) {
+                    const char *request = pending.data();
+                    const size_t consumed = co_await http1.readCallback(pending, socket);
+                    if (http1.deferred()) {
+                        early_request.append(request, plaintext.data() + plaintext.size() - request);
+                        held.swap(early_request);
+                        early_request.clear();
+                        partial = true;
                         break;
                     }
-                    if (err == SSL_ERROR_WANT_READ) {
+                    pending.remove_prefix(std::min(consumed, pending.size()));
+                    if (http1.getRequest().getState() < protocols::http::REQUEST_STATE::FINISHED) {
+                        if (!verified) early_request.append(request, plaintext.data() + plaintext.size() - request);
+                        partial = true;
                         break;
                     }
-                    if (err == SSL_ERROR_WANT_WRITE) {
-                        continue;
+                    early_request.clear();
+                    const bool last = this->prepareClose(http1);
+
+                    timers.arm(deadline, milliseconds(this->timeouts_.write));
+                    const bool written = ktls ? co_await this->writeResponses(socket, exchange, 1, segments)
+                                              : co_await writeEncrypted(socket, ssl, http1.getResponse(), records, reading_early);
+                    timers.cancel(deadline);
+                    http1.getResponse().clear();
+                    answered = true;
+                    if (!written || last) {
+                        close_connection = true;
+                        break;
                     }
+                }
+                plaintext.clear();
+                if (close_connection) break;
 
-                    SSL_free(ssl);
-                    co_return;
+                if (!partial && answered) {
+                    timers.arm(deadline, milliseconds(this->timeouts_.keep_alive));
+                } else if (http1.getRequest().getState() < protocols::http::REQUEST_STATE::HEADERS_PARSED) {
+                    timers.arm(deadline, milliseconds(this->timeouts_.header));
+                } else {
+                    timers.arm(deadline, milliseconds(this->timeouts_.body));
                 }
             }
+            co_return;
+        }
 
-            // alpn
-            const unsigned char* sel = nullptr;
-            unsigned int sel_len = 0;
-            SSL_get0_alpn_selected(ssl, &sel, &sel_len);
+        /**
+         * @brief Serves an HTTP/2 connection, see serve() for @p plaintext and @p reading_early.
+         *
+         * Early data is held until the handshake completes, HTTP/2 requests are not answered as 0.5-RTT data.
+         */
+        usub::uvent::task::Awaitable<void> serveHTTP2(usub::uvent::net::TCPClientSocket &socket, SSL *ssl, net::BufferLease &input,
+                                                      net::TimerWheel &timers, net::Deadline &deadline,
+                                                      std::string plaintext, bool reading_early) {
+            using std::chrono::milliseconds;
+            const bool ktls = usub::utils::ssl::ktls_send_enabled(ssl);
+            usub::utils::ssl::RecordSizer records(static_cast<size_t>(records_.record_size),
+                                                  static_cast<uint64_t>(records_.record_boost_bytes),
+                                                  milliseconds(records_.record_boost_time),
+                                                  milliseconds(records_.record_idle_reset));
+            net::Deadline write_deadline(deadline.fd());
+            std::vector<iovec> segments;
+            protocols::http::HTTP2<RouterType> http2(this->endpoint_handler_, this->http2_, [&](std::string_view frames) {
+                return this->writeHTTP2(socket, ssl, frames, ktls, records, segments, http2, timers, deadline, write_deadline);
+            });
 
-            if (sel_len != 8 || std::memcmp(sel, "http/1.1", 8) != 0) {
+            for (bool first = true;; first = false) {
+                if (!first) {
+                    if (!co_await receive(socket, ssl, input)) break;
+                    timers.cancel(deadline);
+                }
+                // OpenSSL may add records of its own while reading, not while a handler's flush writes
+                co_await http2.writes();
+                const bool peer_closed = !co_await decrypt(socket, ssl, plaintext, reading_early);
+                if (!SSL_is_init_finished(ssl)) {
+                    if (!co_await flush(socket, ssl) || peer_closed) break;
+                    timers.arm(deadline, milliseconds(this->timeouts_.header));
+                    continue;
+                }
 
-                SSL_shutdown(ssl);
-                SSL_free(ssl);
-                socket->shutdown();
-                co_return;
+                bool open = true;
+                if (!plaintext.empty()) {
+                    open = http2.readCallback(plaintext);
+                    plaintext.clear();
+                }
+                // everything produced goes out, then DATA frames as long as flow control allows
+                if (!co_await http2.flush() || !open || peer_closed || http2.finished()) break;
+                this->armHTTP2Read(http2, timers, deadline);
             }
+            // handlers still running refer to the connection, their responses are dropped
+            co_await http2.drain();
+            timers.cancel(deadline);
+            co_return;
+        }
 
-            // http
-            protocols::http::HTTP1 http1{router_};
-            auto& request  = http1.getRequest();
-            auto& response = http1.getResponse();
-
-            bool should_cleanup = false;
-
-            while (true) {
-                net_buffer.clear();
-                ssize_t rd = co_await socket->async_read(net_buffer, NET_BUF_SIZE);
-                if (rd <= 0) { 
-                    should_cleanup = true;
-                    break;
-                }
-                BIO_write(in_bio, net_buffer.data(), int(net_buffer.size()));
-
-                // Handshake или decrypt
-                while (true)
-                {
-                    int ret = SSL_is_init_finished(ssl)
-                              ? ::SSL_read(ssl, ssl_buffer.data(), NET_BUF_SIZE)
-                              : ::SSL_do_handshake(ssl);
-                    if (ret > 0)
-                    {
-                        std::string request_string{ ssl_buffer.data(), ssl_buffer.data()+ssl_buffer.size()};
-                        http1.readCallbackSync(request_string, socket);
-                    }
-                    else
-                    {
-                        int err = SSL_get_error(ssl, ret);
-                        if (err == SSL_ERROR_WANT_READ) {
-                            break;
-                        }
-                        if (err == SSL_ERROR_WANT_WRITE) {
-                            while (BIO_pending(out_bio) > 0)
-                            {
-                                int n = BIO_read(out_bio, ssl_buffer.data(), NET_BUF_SIZE);
-                                if (n > 0) {
-                                    co_await socket->async_write((uint8_t *) ssl_buffer.data(), std::size_t(n));
-                                }
-                            }
-                            continue;
-                        }
-                        should_cleanup = true;
-                        break;
+        /**
+         * @brief The HTTP2 writer of a TLS connection: encrypts and writes @p frames, along with the records
+         *        OpenSSL buffered itself, then re-arms the read deadline.
+         */
+        usub::uvent::task::Awaitable<bool> writeHTTP2(usub::uvent::net::TCPClientSocket &socket, SSL *ssl, std::string_view frames,
+                                                      bool ktls, usub::utils::ssl::RecordSizer &records,
+                                                      std::vector<iovec> &segments,
+                                                      const protocols::http::HTTP2<RouterType> &http2,
+                                                      net::TimerWheel &timers, net::Deadline &deadline,
+                                                      net::Deadline &write_deadline) {
+            timers.arm(write_deadline, std::chrono::milliseconds(this->timeouts_.write));
+            bool written = true;
+            if (ktls) {
+                segments.assign(1, iovec{const_cast<char *>(frames.data()), frames.size()});
+                written = co_await flush(socket, ssl) &&
+                          (frames.empty() || co_await net::async_writev(socket, segments) == static_cast<ssize_t>(frames.size()));
+            } else {
+                records.begin(usub::utils::ssl::RecordSizer::Clock::now());
+                written = co_await writeRecords(socket, ssl, frames, records, false);
+                records.end();
+            }
+            timers.cancel(write_deadline);
+            if (!written) {
+                // wakes the read as well
+                socket.shutdown();
+                co_return false;
+            }
+            this->armHTTP2Read(http2, timers, deadline);
+            co_return true;
+        }
+
+        static void configureContext(SSL_CTX *ctx) {
+            usub::utils::ssl::enable_ktls(ctx);
+            static const unsigned char alpn_protos[] = {8, 'h', 't', 't', 'p', '/', '1', '.', '1'};
+            selectProtocol(ctx, alpn_protos);
+        }
+
+        /**
+         * @brief Lets ALPN pick the first of @p protos (wire format, in order of preference) the client offers.
+         */
+        template<size_t N>
+        static void selectProtocol(SSL_CTX *ctx, const unsigned char (&protos)[N]) {
+            SSL_CTX_set_alpn_select_cb(ctx, [](SSL * /*ssl*/, const unsigned char **out, unsigned char *outlen, const unsigned char *in, unsigned int inlen, void *arg) -> int {
+                int sel = SSL_select_next_proto(
+                        const_cast<unsigned char **>(out), outlen,
+                        static_cast<const unsigned char *>(arg), N,
+                        in, inlen);
+                if (sel == OPENSSL_NPN_NEGOTIATED) {
+                    return SSL_TLSEXT_ERR_OK;
+                }
+                return SSL_TLSEXT_ERR_NOACK; }, const_cast<unsigned char *>(protos));
+        }
+
+        /**
+         * @brief Runs the handshake; with @p early_data, accepted early data is read into it on the way.
+         *
+         * Returns EARLY as soon as early data was read and the handshake waits for the client's Finished,
+         * so the early requests can be answered a round trip sooner.
+         */
+        static usub::uvent::task::Awaitable<Handshake> handshake(usub::uvent::net::TCPClientSocket &socket, SSL *ssl,
+                                                                 net::BufferLease &input, net::WorkerPool *pool,
+                                                                 std::string *early_data) {
+            std::optional<net::WorkerChannel> channel;
+            bool reading_early = early_data != nullptr;
+            for (;;) {
+                int rc = 0;
+                int err = 0;
+                // SSL_get_error() reads the error queue of the thread that ran the step
+                auto step = [&] {
+                    ERR_clear_error();
+                    if (reading_early) {
+                        // a full handshake, or a client without early data, gets FINISH once the server's flight is out
+                        const size_t used = early_data->size();
+                        size_t size = 0;
+                        early_data->resize(used + NET_BUF_SIZE);
+                        rc = SSL_read_early_data(ssl, early_data->data() + used, NET_BUF_SIZE, &size);
+                        early_data->resize(used + size);
+                        err = rc == SSL_READ_EARLY_DATA_ERROR ? SSL_get_error(ssl, 0) : SSL_ERROR_NONE;
+                    } else {
+                        rc = SSL_do_handshake(ssl);
+                        err = SSL_get_error(ssl, rc);
                     }
+                };
+                if (pool) {
+                    if (!channel) channel.emplace();
+                    co_await channel->run(*pool, step);
+                } else {
+                    step();
                 }
-                if (should_cleanup) {
-                    break;
+                if (!co_await flush(socket, ssl)) co_return Handshake::FAILED;
+                if (reading_early) {
+                    if (rc == SSL_READ_EARLY_DATA_SUCCESS) continue;
+                    if (rc == SSL_READ_EARLY_DATA_FINISH) {
+                        reading_early = false;
+                        continue;
+                    }
+                    if (err == SSL_ERROR_WANT_READ && !early_data->empty()) co_return Handshake::EARLY;
+                } else if (rc == 1) {
+                    co_return Handshake::DONE;
                 }
+                if (err == SSL_ERROR_WANT_WRITE) continue;
+                if (err != SSL_ERROR_WANT_READ) co_return Handshake::FAILED;
+                if (!co_await receive(socket, ssl, input)) co_return Handshake::FAILED;
+            }
+        }
 
-                while (!response.isSent() && request.getState() >= protocols::http::REQUEST_STATE::FINISHED)
-                {
-                    const std::string out = response.pull();
-                    SSL_write(ssl, out.data(), int(out.size()));
-                }
-                response.clear();
+        static std::string_view selectedProtocol(SSL *ssl) {
+            const unsigned char *sel = nullptr;
+            unsigned int sel_len = 0;
+            SSL_get0_alpn_selected(ssl, &sel, &sel_len);
+            return {reinterpret_cast<const char *>(sel), sel_len};
+        }
 
-                while (BIO_pending(out_bio) > 0)
-                {
-                    int n = BIO_read(out_bio, ssl_buffer.data(), NET_BUF_SIZE);
-                    if (n > 0) {
-                        co_await socket->async_write((uint8_t *) ssl_buffer.data(), std::size_t(n));
+        /**
+         * @brief Appends what OpenSSL can decrypt without waiting for the socket to @p plaintext.
+         *
+         * With @p reading_early, early data is read until the client ends it; it is cleared once it has.
+         *
+         * @return false when the peer closed the connection or it failed.
+         */
+        static usub::uvent::task::Awaitable<bool> decrypt(usub::uvent::net::TCPClientSocket &socket, SSL *ssl,
+                                                          std::string &plaintext, bool &reading_early) {
+            for (;;) {
+                const size_t used = plaintext.size();
+                plaintext.resize(used + NET_BUF_SIZE);
+                int n = 0;
+                if (reading_early) {
+                    size_t size = 0;
+                    const int rc = SSL_read_early_data(ssl, plaintext.data() + used, NET_BUF_SIZE, &size);
+                    plaintext.resize(used + size);
+                    if (rc == SSL_READ_EARLY_DATA_SUCCESS) continue;
+                    if (rc == SSL_READ_EARLY_DATA_FINISH) {
+                        // SSL_read completes the handshake from here
+                        reading_early = false;
+                        continue;
                     }
+                } else {
+                    n = SSL_read(ssl, plaintext.data() + used, static_cast<int>(NET_BUF_SIZE));
+                    plaintext.resize(used + static_cast<size_t>(std::max(n, 0)));
+                    if (n > 0) continue;
                 }
+
+                const int err = SSL_get_error(ssl, n);
+                if (err == SSL_ERROR_WANT_READ) co_return true;
+                if (err == SSL_ERROR_WANT_WRITE && co_await flush(socket, ssl)) continue;
+                co_return false;
             }
+        }
 
-            SSL_shutdown(ssl);
-            SSL_free(ssl);
-            socket->shutdown();
-            co_return;
+        /**
+         * @brief Waits for ciphertext after SSL_ERROR_WANT_READ and lends it to OpenSSL without copying.
+         *
+         * OpenSSL consumed the previous batch before asking for more, so @p input can be reused.
+         */
+        static usub::uvent::task::Awaitable<bool> receive(usub::uvent::net::TCPClientSocket &socket, SSL *ssl,
+                                                          net::BufferLease &input) {
+            if (!input) input = net::BufferPool::local().acquire(NET_BUF_SIZE);
+            auto &buffer = input.buffer();
+            buffer.clear();
+            const ssize_t rdsz = co_await socket.async_read(buffer, input.capacity());
+            if (rdsz <= 0) co_return false;
+            usub::utils::ssl::socket_bio_set_input(SSL_get_rbio(ssl), reinterpret_cast<const char *>(buffer.data()),
+                                                   static_cast<size_t>(rdsz));
+            co_return true;
         }
 
-    private:
-        std::shared_ptr<RouterType> router_;
-        SSL_CTX* ctx_{nullptr};
+        /**
+         * @brief Writes the ciphertext the socket BIO could not send right away.
+         */
+        static usub::uvent::task::Awaitable<bool> flush(usub::uvent::net::TCPClientSocket &socket, SSL *ssl) {
+            std::string &output = usub::utils::ssl::socket_bio_output(SSL_get_wbio(ssl));
+            if (output.empty()) co_return true;
+
+            std::vector<iovec> iov{{output.data(), output.size()}};
+            const ssize_t expected = static_cast<ssize_t>(output.size());
+            const ssize_t written = co_await net::async_writev(socket, iov);
+            output.clear();
+            co_return written == expected;
+        }
+
+        /**
+         * @brief Encrypts @p response into records of the size @p records asks for, one SSL_write per record.
+         *
+         * With @p early the client's Finished has not arrived yet and the records are sent as 0.5-RTT data.
+         */
+        static usub::uvent::task::Awaitable<bool> writeEncrypted(usub::uvent::net::TCPClientSocket &socket, SSL *ssl,
+                                                                 protocols::http::Response &response,
+                                                                 usub::utils::ssl::RecordSizer &records, bool early) {
+            records.begin(usub::utils::ssl::RecordSizer::Clock::now());
+            bool written = true;
+            while (written && !response.isSent()) {
+                const std::string out = response.pull();
+                written = co_await writeRecords(socket, ssl, out, records, early);
+            }
+            records.end();
+            co_return written;
+        }
+
+        /**
+         * @brief Encrypts @p out, one SSL_write per record of the size @p records asks for, and writes it.
+         */
+        static usub::uvent::task::Awaitable<bool> writeRecords(usub::uvent::net::TCPClientSocket &socket, SSL *ssl,
+                                                               std::string_view out,
+                                                               usub::utils::ssl::RecordSizer &records, bool early) {
+            for (size_t offset = 0; offset < out.size();) {
+                const size_t size = std::min(out.size() - offset, records.next());
+                size_t done = 0;
+                const int rc = early ? SSL_write_early_data(ssl, out.data() + offset, size, &done)
+                                     : SSL_write_ex(ssl, out.data() + offset, size, &done);
+                if (rc != 1) co_return false;
+                records.sent(size);
+                offset += size;
+            }
+            co_return co_await flush(socket, ssl);
+        }
+
+        // the contexts point at this state, so it is declared first and outlives them
+        std::shared_ptr<usub::utils::ssl::SessionCache> session_cache_;
+        std::shared_ptr<usub::utils::ssl::TicketKeyRing> ticket_keys_;
+        std::shared_ptr<usub::utils::ssl::ReplayWindow> replay_window_;
+        std::shared_ptr<usub::utils::ssl::OcspStapler> ocsp_stapler_;
+        std::shared_ptr<const usub::utils::ssl::CertificateTable> certificates_;
+        std::shared_ptr<SSL_CTX> ctx_;
+        std::string cert_file_;
+        std::shared_ptr<net::WorkerPool> handshake_pool_;
+        configuration::TLSRecordConfig records_;
+        bool early_data_{false};
     };
 
-} // namespace usub::modules::stream
-#endif // USE_OPEN_SSL
\ No newline at end of file
+}// namespace usub::server
+#endif// USE_OPEN_SSL
@@ -10,6 +10,7 @@
 #include <unordered_map>
 
 
+#include "Protocols/HTTP/RouteAutomaton.h"
 #include "Protocols/HTTP/RouterCommon.h"
       
 namespace usub::server::protocols::http {
@@ -33,6 +34,21 @@ namespace usub::server::protocols::http {
       */
       std::vector<Route> routes_;
 
+      /**
+      * @brief The regex source of each route in `routes_`, which the automaton is built from.
+      */
+      std::vector<std::string> route_patterns_;
+
+      /**
+      * @brief All regex routes in one automaton, the id of a pattern being its index in `routes_`.
+      *
+      * Built by `freeze()`. Routes whose pattern the automaton does not support are listed in
+      * `fallback_routes_` and still matched with their `std::regex`.
+      */
+      RouteAutomaton automaton_;
+      std::vector<uint32_t> fallback_routes_;
+      bool frozen_{false};
+
       /**
       * @brief Maps HTTP error codes to their corresponding handler functions.
       *
@@ -90,7 +106,7 @@ namespace usub::server::protocols::http {
       * @details Converts path patterns with parameters enclosed in `{}` into regex patterns.
       * Extracts the names of these parameters for later use in request handling.
       */
-      void parsePathPattern(const std::string &pathPattern, std::regex &outRegex, std::vector<std::string> &outParamNames) const;
+      void parsePathPattern(const std::string &pathPattern, std::regex &outRegex, std::vector<std::string> &outParamNames, std::string &outSource) const;
       
       size_t findMatchingBrace(const std::string &pathPattern, size_t start) const;
 
@@ -202,6 +218,16 @@ namespace usub::server::protocols::http {
       */
       std::optional<std::pair<Route *, bool>> match(Request &request);
 
+      /**
+      * @brief Compiles the regex routes into one automaton, so `match()` finds the route in a single pass.
+      *
+      * The first route registered that matches and allows the method still wins. The server freezes its
+      * router before it starts; adding a route afterwards unfreezes it until the next call.
+      */
+      void freeze();
+
+      bool frozen() const { return this->frozen_; }
+
       void addErrorHandler(const std::string &error_code, std::function<FunctionType> function);
       void executeErrorChain(Request &request, Response &response);
 
@@ -1,7 +1,9 @@
 #ifndef HTTP1_H
 #define HTTP1_H
 
+#include <memory_resource>
 #include <string>
+#include <string_view>
 
 #include <uvent/net/Socket.h>
 #include <uvent/tasks/Awaitable.h>
@@ -18,6 +20,8 @@ namespace usub::server::protocols::http {
         Response response_{};
         std::shared_ptr<RouterType> endpoint_handler_{};
         Route *matched_route_{nullptr};
+        bool early_data_{false};
+        bool deferred_{false};
 
     public:
         HTTP1() = default;
@@ -31,27 +35,75 @@ namespace usub::server::protocols::http {
             return *this;
         }
 
+        /**
+         * @brief Resets the exchange and allocates request/response storage from @p resource.
+         *
+         * Connections owning an arena call this on every exchange before releasing the arena.
+         */
+        HTTP1 &setMemoryResource(std::pmr::memory_resource *resource) {
+            this->request_.setMemoryResource(resource);
+            this->response_.setMemoryResource(resource);
+            this->matched_route_ = {};
+            return *this;
+        }
+
+        /**
+         * @brief Marks the bytes fed from now on as TLS 1.3 early data.
+         *
+         * Requests for routes without Route::accept_early_data are then not handled but deferred, see deferred().
+         */
+        HTTP1 &setEarlyData(bool early) {
+            this->early_data_ = early;
+            this->deferred_ = false;
+            return *this;
+        }
+
+        /**
+         * @brief Whether the last readCallback() stopped at a request that must wait for the handshake.
+         *
+         * The request was reset; the caller feeds it again from its first byte once the data is no longer early.
+         */
+        bool deferred() const {
+            return this->deferred_;
+        }
+
         // Response ErrorPageHandler(Request &request);
 
-        // Unsecure
-        usub::uvent::task::Awaitable<void> readCallback(const std::string &data, usub::uvent::net::TCPClientSocket &socket) {
+        /**
+         * @brief Feeds received bytes into the request parser and runs middlewares/handler as states are reached.
+         *
+         * @param data View over the received bytes. It is parsed in place, so a connection can pass a view of its
+         *             read buffer without copying it into a string; it must stay valid until the call completes.
+         * @return Number of bytes of @p data that belong to this request. When the request reached FINISHED and
+         *         less than data.size() was consumed, the rest is the start of the next pipelined request.
+         *         0 with deferred() set when the request arrived as early data for a route that does not accept it.
+         */
+        usub::uvent::task::Awaitable<size_t> readCallback(std::string_view data, usub::uvent::net::TCPClientSocket &socket) {
 #ifdef UVENT_DEBUG
             spdlog::info("Entering readCallback");
 #endif
             std::optional<std::pair<Route *, bool>> match{};
-            std::string::const_iterator c{};
+            const char *c{nullptr};
+            const char *const end = data.data() + data.size();
+            auto consumed = [&]() -> size_t { return c ? static_cast<size_t>(c - data.data()) : data.size(); };
 
             // auto parser = this->request_.parseHTTP1_X_yield(data);
             // bool ret{false};
         retry_parse:
-            if (c == data.end()) co_return;
+            if (c == end) co_return data.size();
             // if (ret) co_return;
             c = this->request_.parseHTTP1_X(data, c);
             // ret = co_await parser;
-            // if (this->request_.getState() < STATE::HEADERS_PARSED) co_return;
+            if (this->request_.getState() < REQUEST_STATE::PRE_HEADERS) co_return consumed();// request line is incomplete, wait for more data
 
             if (!this->matched_route_) {
                 match = this->endpoint_handler_->match(this->request_);
+                if (this->early_data_ && !(match && match->second && match->first->accept_early_data)) {
+                    // nothing ran yet, the request is parsed again after the handshake
+                    this->request_.clear();
+                    this->deferred_ = true;
+                    co_return 0;
+                }
                 this->response_.setHTTPVersion(this->request_.getHTTPVersion());
                 this->response_.setSocket(&socket);
                 if (match) {
@@ -59,7 +111,8 @@ namespace usub::server::protocols::http {
                     if (!methodAllowed) {// this->ErrorPageHandler(this->request_);
                         this->request_.setState(REQUEST_STATE::METHOD_NOT_ALLOWED);
                         this->response_.setStatus(405);
-                        co_return;
+                        this->response_.addHeader("Allow", route->allowed_methods.allowHeader());
+                        co_return consumed();
                     }
                     this->response_.addHeader("Server", "usub");
                     this->response_.setRoute(route);
@@ -68,7 +121,7 @@ namespace usub::server::protocols::http {
                     this->request_.setState(REQUEST_STATE::NOT_FOUND);
                     this->response_.setStatus(404);
                     // this->ErrorPageHandler(this->request_)
-                    co_return;
+                    co_return consumed();
                 }
             }
 
@@ -79,13 +132,13 @@ namespace usub::server::protocols::http {
                     middleware_rv = this->endpoint_handler_->getMiddlewareChain().execute(MiddlewarePhase::SETTINGS, this->request_, this->response_);
                     if (!middleware_rv) {
                         this->request_.setState(REQUEST_STATE::BAD_REQUEST);
-                        co_return;
+                        co_return consumed();
                     }
 
                     middleware_rv = this->matched_route_->middleware_chain.execute(MiddlewarePhase::SETTINGS, this->request_, this->response_);
                     if (!middleware_rv) {
                         this->request_.setState(REQUEST_STATE::BAD_REQUEST);
-                        co_return;
+                        co_return consumed();
                     }
 
                     goto retry_parse;
@@ -93,12 +146,12 @@ namespace usub::server::protocols::http {
                     middleware_rv = this->endpoint_handler_->getMiddlewareChain().execute(MiddlewarePhase::HEADER, this->request_, this->response_);
                     if (!middleware_rv) {
                         this->request_.setState(REQUEST_STATE::BAD_REQUEST);
-                        co_return;
+                        co_return consumed();
                     }
                     middleware_rv = this->matched_route_->middleware_chain.execute(MiddlewarePhase::HEADER, this->request_, this->response_);
                     if (!middleware_rv) {
                         this->request_.setState(REQUEST_STATE::BAD_REQUEST);
-                        co_return;
+                        co_return consumed();
                     }
 
                     goto retry_parse;
@@ -106,22 +159,22 @@ namespace usub::server::protocols::http {
                     middleware_rv = this->endpoint_handler_->getMiddlewareChain().execute(MiddlewarePhase::BODY, this->request_, this->response_);
                     if (!middleware_rv) {
                         this->request_.setState(REQUEST_STATE::BAD_REQUEST);
-                        co_return;
+                        co_return consumed();
                     }
                     middleware_rv = this->matched_route_->middleware_chain.execute(MiddlewarePhase::BODY, this->request_, this->response_);
                     if (!middleware_rv) {
                         this->request_.setState(REQUEST_STATE::BAD_REQUEST);
-                        co_return;
+                        co_return consumed();
                     }
 
                     goto retry_parse;
                 case REQUEST_STATE::FINISHED:
 
-                    co_await this->matched_route_->handler(this->request_, this->response_);
+                    co_await this->matched_route_->invoke(this->request_, this->response_);
                     middleware_rv = this->endpoint_handler_->getMiddlewareChain().execute(MiddlewarePhase::RESPONSE, this->request_, this->response_);
                     if (!middleware_rv) {
                         this->request_.setState(REQUEST_STATE::BAD_REQUEST);
-                        co_return;
+                        co_return consumed();
                     }
 
                     if (!this->response_.isSent()) {
@@ -130,25 +183,28 @@ namespace usub::server::protocols::http {
                     this->matched_route_ = {};
                     if (!middleware_rv || this->response_.isSent()) {
                         this->request_.setState(REQUEST_STATE::BAD_REQUEST);
-                        co_return;
+                        co_return consumed();
                     }
                     break;
                 default:
-                    this->matched_route_ = {};
+                    // keep the route while the request is still arriving, the next read continues it
+                    if (this->request_.getState() > REQUEST_STATE::FINISHED) {
+                        this->matched_route_ = {};
+                    }
                     break;
             }
-            co_return;
+            co_return consumed();
         }
 
-        void readCallbackSync(const std::string &data, usub::uvent::net::TCPClientSocket &socket) {
+        void readCallbackSync(std::string_view data, usub::uvent::net::TCPClientSocket &socket) {
 #ifdef UVENT_DEBUG
             spdlog::info("Entering readCallback");
 #endif
             std::optional<std::pair<Route *, bool>> match{};
-            std::string::const_iterator c{};
+            const char *c{nullptr};
 
         retry_parse:
-            if (c == data.end()) return;
+            if (c == data.data() + data.size()) return;
             c = this->request_.parseHTTP1_X(data, c);
 
             // if (this->request_.getState() < STATE::HEADERS_PARSED) co_return;
@@ -162,6 +218,7 @@ namespace usub::server::protocols::http {
                     this->response_.addHeader("Server", "usub");
                     this->response_.setRoute(route);
                     if (!methodAllowed) {// this->ErrorPageHandler(this->request_);
+                        this->response_.addHeader("Allow", route->allowed_methods.allowHeader());
                         return;
                     }
                     this->matched_route_ = route;
@@ -196,7 +253,7 @@ namespace usub::server::protocols::http {
                     goto retry_parse;
                 case REQUEST_STATE::FINISHED:
 
-                    this->matched_route_->handler(this->request_, this->response_);
+                    this->matched_route_->invoke(this->request_, this->response_);
                     if (!this->response_.isSent()) {
                         middleware_rv = this->matched_route_->middleware_chain.execute(MiddlewarePhase::RESPONSE, this->request_, this->response_);
                     }
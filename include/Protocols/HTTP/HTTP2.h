@@ -0,0 +1,1035 @@
+#ifndef HTTP2_H
+#define HTTP2_H
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <coroutine>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <uvent/Uvent.h>
+#include <uvent/tasks/Awaitable.h>
+
+#include "Components/Compression/HPACK.h"
+#include "Protocols/HTTP/EndpointHandler.h"
+#include "Protocols/HTTP/Message.h"
+#include "utils/configuration/ConfigReader.h"
+
+namespace usub::server::protocols::http {
+
+    namespace http2 {
+        /// What a client sends first, followed by its SETTINGS frame.
+        inline constexpr std::string_view PREFACE = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+        inline constexpr size_t FRAME_HEADER_SIZE = 9;
+        inline constexpr uint32_t DEFAULT_WINDOW_SIZE = 65535;
+        inline constexpr int64_t MAX_WINDOW_SIZE = 0x7fffffff;
+        inline constexpr uint32_t DEFAULT_FRAME_SIZE = 16384;
+        inline constexpr uint32_t MAX_FRAME_SIZE = 16777215;
+        /// Output gathered before the caller gets to write it, more DATA is produced by pullData() afterwards.
+        inline constexpr size_t OUTPUT_BUDGET = 64 * 1024;
+        /// A header block spread over CONTINUATION frames may grow to this multiple of max_header_list_size, which
+        /// leaves room for fields HPACK encodes larger than their counted size.
+        inline constexpr size_t HEADER_BLOCK_FACTOR = 2;
+        /// Client resets of open streams allowed beyond the responses sent, past it the connection ends with
+        /// ENHANCE_YOUR_CALM so opening and resetting streams cannot keep starting handlers.
+        inline constexpr int64_t RESET_BUDGET = 32;
+
+        enum class FrameType : uint8_t {
+            DATA = 0x0,
+            HEADERS = 0x1,
+            PRIORITY = 0x2,
+            RST_STREAM = 0x3,
+            SETTINGS = 0x4,
+            PUSH_PROMISE = 0x5,
+            PING = 0x6,
+            GOAWAY = 0x7,
+            WINDOW_UPDATE = 0x8,
+            CONTINUATION = 0x9,
+        };
+
+        enum Flags : uint8_t {
+            END_STREAM = 0x1,
+            ACK = 0x1,
+            END_HEADERS = 0x4,
+            PADDED = 0x8,
+            PRIORITY = 0x20,
+        };
+
+        enum class Setting : uint16_t {
+            HEADER_TABLE_SIZE = 0x1,
+            ENABLE_PUSH = 0x2,
+            MAX_CONCURRENT_STREAMS = 0x3,
+            INITIAL_WINDOW_SIZE = 0x4,
+            MAX_FRAME_SIZE = 0x5,
+            MAX_HEADER_LIST_SIZE = 0x6,
+        };
+
+        enum class ErrorCode : uint32_t {
+            NO_ERROR = 0x0,
+            PROTOCOL_ERROR = 0x1,
+            INTERNAL_ERROR = 0x2,
+            FLOW_CONTROL_ERROR = 0x3,
+            SETTINGS_TIMEOUT = 0x4,
+            STREAM_CLOSED = 0x5,
+            FRAME_SIZE_ERROR = 0x6,
+            REFUSED_STREAM = 0x7,
+            CANCEL = 0x8,
+            COMPRESSION_ERROR = 0x9,
+            CONNECT_ERROR = 0xa,
+            ENHANCE_YOUR_CALM = 0xb,
+            INADEQUATE_SECURITY = 0xc,
+            HTTP_1_1_REQUIRED = 0xd,
+        };
+
+        /// First bytes that tell the preface from an HTTP/1.x request: no method starts with `PRI`, but `POST`, `PUT`
+        /// and `PATCH` share its first letters.
+        inline constexpr size_t PREFACE_DECISION = 3;
+
+        /**
+         * @brief Whether the first bytes of a connection start the client preface, i.e. prior-knowledge h2c.
+         *
+         * False while fewer than PREFACE_DECISION bytes arrived, see mayBePreface().
+         */
+        inline bool isPreface(std::string_view data) {
+            const size_t n = std::min(data.size(), PREFACE.size());
+            return n >= PREFACE_DECISION && data.substr(0, n) == PREFACE.substr(0, n);
+        }
+
+        /**
+         * @brief Whether the first bytes of a connection are too few to tell, the caller should read more first.
+         */
+        inline bool mayBePreface(std::string_view data) {
+            return data.size() < PREFACE_DECISION && PREFACE.starts_with(data);
+        }
+
+        inline uint32_t readUint32(const char *p) {
+            return (static_cast<uint32_t>(static_cast<uint8_t>(p[0])) << 24) | (static_cast<uint32_t>(static_cast<uint8_t>(p[1])) << 16) |
+                   (static_cast<uint32_t>(static_cast<uint8_t>(p[2])) << 8) | static_cast<uint32_t>(static_cast<uint8_t>(p[3]));
+        }
+
+        inline void appendUint32(std::string &out, uint32_t value) {
+            const char bytes[4] = {static_cast<char>(value >> 24), static_cast<char>(value >> 16), static_cast<char>(value >> 8),
+                                   static_cast<char>(value)};
+            out.append(bytes, sizeof(bytes));
+        }
+
+        inline void appendFrameHeader(std::string &out, size_t length, FrameType type, uint8_t flags, uint32_t stream_id) {
+            const char header[5] = {static_cast<char>(length >> 16), static_cast<char>(length >> 8), static_cast<char>(length),
+                                    static_cast<char>(type), static_cast<char>(flags)};
+            out.append(header, sizeof(header));
+            appendUint32(out, stream_id & 0x7fffffff);
+        }
+    }// namespace http2
+
+    /**
+     * @brief HTTP/2 (RFC 9113) server side of one connection, routing every stream like an HTTP1 exchange.
+     *
+     * Transport-agnostic: the stream handler feeds received bytes (starting with the client preface) to
+     * readCallback() and calls flush(), which hands the frames to the Writer it provided. Every stream has its
+     * own Request/Response pair and runs the same middlewares and handler as an HTTP/1 request, in a coroutine
+     * of its own: a slow handler neither delays the answers to PING and WINDOW_UPDATE nor the other streams.
+     * Finished handlers queue their stream, the next flush sends its HEADERS; responses are interleaved frame
+     * by frame, so a large body, or one waiting for the client's window, does not hold back the others. The
+     * coroutines share the connection's state without locking; before it goes away the connection waits in
+     * drain().
+     *
+     * Server push and the deprecated priority scheme are not implemented; PRIORITY frames are ignored.
+     */
+    template<class RouterType = usub::server::protocols::http::HTTPEndpointHandler>
+    class HTTP2 {
+    public:
+        /**
+         * @brief Writes all of the frames it is given to the connection, false once that failed.
+         *
+         * Called by one flush at a time, with nothing else writing to the connection meanwhile.
+         */
+        using Writer = std::function<usub::uvent::task::Awaitable<bool>(std::string_view)>;
+
+        HTTP2(std::shared_ptr<RouterType> endpoint_handler, const configuration::HTTP2Config &config, Writer writer)
+            : endpoint_handler_(std::move(endpoint_handler)), config_(config), writer_(std::move(writer)),
+              decoder_(component::HPACK_DEFAULT_TABLE_SIZE) {
+            // our SETTINGS first, then the connection window beyond the fixed initial 65535
+            std::string settings;
+            auto add_setting = [&](http2::Setting id, uint32_t value) {
+                settings.push_back(static_cast<char>(static_cast<uint16_t>(id) >> 8));
+                settings.push_back(static_cast<char>(static_cast<uint16_t>(id)));
+                http2::appendUint32(settings, value);
+            };
+            add_setting(http2::Setting::MAX_CONCURRENT_STREAMS, static_cast<uint32_t>(config_.max_concurrent_streams));
+            add_setting(http2::Setting::INITIAL_WINDOW_SIZE, static_cast<uint32_t>(config_.initial_window_size));
+            add_setting(http2::Setting::MAX_FRAME_SIZE, static_cast<uint32_t>(config_.max_frame_size));
+            add_setting(http2::Setting::MAX_HEADER_LIST_SIZE, static_cast<uint32_t>(config_.max_header_list_size));
+            http2::appendFrameHeader(this->output_, settings.size(), http2::FrameType::SETTINGS, 0, 0);
+            this->output_.append(settings);
+
+            this->recv_window_ = http2::DEFAULT_WINDOW_SIZE;
+            if (static_cast<int64_t>(config_.connection_window_size) > this->recv_window_) {
+                this->sendWindowUpdate(0, static_cast<uint32_t>(config_.connection_window_size - this->recv_window_));
+                this->recv_window_ = config_.connection_window_size;
+            }
+        }
+
+        HTTP2(const HTTP2 &) = delete;
+        HTTP2 &operator=(const HTTP2 &) = delete;
+
+        /**
+         * @brief Processes received bytes, then starts the handlers of the streams they completed.
+         *
+         * Frames split across reads are kept until they are complete. What the frames call for, and the answers
+         * of requests refused without a handler, go out with the next flush().
+         *
+         * @return false after a connection error: the pending frames end with a GOAWAY and the connection
+         *         should be closed once they are flushed.
+         */
+        bool readCallback(std::string_view data) {
+            if (this->failed_) return false;
+            if (!this->input_.empty()) {
+                this->input_.append(data);
+                data = this->input_;
+            }
+            const size_t consumed = this->processFrames(data);
+            if (this->input_.empty()) {
+                this->input_.assign(data.substr(consumed));
+            } else {
+                this->input_.erase(0, consumed);
+            }
+
+            // the handlers start once all frames of the read are processed, window updates included
+            for (size_t i = 0; i < this->ready_.size(); ++i) {
+                const auto it = this->streams_.find(this->ready_[i]);
+                if (it == this->streams_.end()) continue;
+                Stream &stream = *it->second;
+                if (stream.responded || stream.running) continue;
+                if (stream.error_status) {
+                    if (stream.response.getStatus() != stream.error_status) stream.response.setStatus(stream.error_status);
+                    this->sendHeaders(stream);
+                } else {
+                    stream.running = true;
+                    ++this->running_;
+                    usub::uvent::system::co_spawn(this->run(it->second));
+                }
+            }
+            this->ready_.clear();
+            return !this->failed_;
+        }
+
+        /**
+         * @brief Writes the pending frames, the HEADERS of finished handlers, then DATA frames while flow control
+         *        allows.
+         *
+         * A flush called while another one writes returns right away, what it would have written goes out with
+         * the running one.
+         *
+         * @return false once a write failed.
+         */
+        usub::uvent::task::Awaitable<bool> flush() {
+            if (this->writing_) co_return !this->write_failed_;
+            this->writing_ = true;
+            // the writer is called at least once, it may have buffered bytes of its own to send
+            bool first = true;
+            while (!this->write_failed_) {
+                if (!this->failed_ && !this->closing_) {
+                    this->respondCompleted();
+                    this->pullData();
+                }
+                if (!first && this->output_.empty()) break;
+                first = false;
+                // frames added while this batch is written go into output_, and out with the next one
+                this->batch_.swap(this->output_);
+                if (!co_await this->writer_(this->batch_)) this->write_failed_ = true;
+                this->batch_.clear();
+            }
+            this->writing_ = false;
+            const bool ok = !this->write_failed_;
+            this->wake();
+            co_return ok;
+        }
+
+        /**
+         * @brief Awaits the moment nobody writes or, after drain(), also no handler runs.
+         */
+        struct Quiet {
+            HTTP2 &http2;
+            bool await_ready() const noexcept { return http2.quiet(); }
+            void await_suspend(std::coroutine_handle<> handle) noexcept { http2.waiter_ = handle; }
+            void await_resume() const noexcept {}
+        };
+
+        /**
+         * @brief Waits until no flush is writing, for transports that must not touch the connection meanwhile.
+         */
+        Quiet writes() {
+            return Quiet{*this};
+        }
+
+        /**
+         * @brief Stops writing further responses and waits for the running handlers and flush to end; the object
+         *        may be destroyed once this resumes.
+         */
+        Quiet drain() {
+            this->closing_ = true;
+            return Quiet{*this};
+        }
+
+        /**
+         * @brief Whether a flush is writing.
+         */
+        bool writing() const {
+            return this->writing_;
+        }
+
+        /**
+         * @brief Whether a handler has not finished yet, its client may then be silent.
+         */
+        bool running() const {
+            return this->running_ > 0;
+        }
+
+        /**
+         * @brief Whether the connection is done: after a connection error or a failed write, or a GOAWAY from
+         *        the client once its streams are answered.
+         */
+        bool finished() const {
+            return this->failed_ || this->write_failed_ || (this->peer_goaway_ && this->streams_.empty());
+        }
+
+        /**
+         * @brief Whether no stream is open, i.e. the connection is idle between requests.
+         */
+        bool idle() const {
+            return this->streams_.empty();
+        }
+
+    private:
+        struct Stream {
+            explicit Stream(uint32_t stream_id) : id(stream_id) {}
+
+            uint32_t id;
+            Request request;
+            Response response;
+            Route *route{nullptr};
+            int64_t send_window{0};
+            int64_t recv_window{0};
+            size_t header_list_size{0};
+            size_t body_size{0};
+            bool remote_closed{false};///< END_STREAM received.
+            bool responded{false};    ///< The response's HEADERS are out, DATA may follow.
+            bool queued{false};       ///< In sending_.
+            bool pseudo_done{false};  ///< A regular field was seen, pseudo-headers may no longer follow.
+            bool malformed{false};
+            bool running{false};     ///< Its handler coroutine was started.
+            bool detached{false};    ///< Removed from streams_ while its handler runs, counted in detached_.
+            uint16_t error_status{0};///< Answer without running the handler.
+        };
+
+        /**
+         * @brief Appends DATA frames of the pending responses to output_ while flow control and the budget allow.
+         *
+         * Streams take turns one frame at a time.
+         *
+         * @return Whether anything was added.
+         */
+        bool pullData() {
+            const size_t start = this->output_.size();
+            size_t turns = this->sending_.size();
+            while (turns > 0 && this->send_window_ > 0 && this->output_.size() < http2::OUTPUT_BUDGET) {
+                const uint32_t id = this->sending_.front();
+                this->sending_.pop_front();
+                --turns;
+                const auto it = this->streams_.find(id);
+                if (it == this->streams_.end()) continue;
+                Stream &stream = *it->second;
+                if (stream.send_window <= 0) {
+                    // waits for a WINDOW_UPDATE of its own
+                    stream.queued = false;
+                    continue;
+                }
+
+                const size_t limit = static_cast<size_t>(std::min<int64_t>({stream.send_window, this->send_window_, this->peer_max_frame_size_}));
+                const size_t header_at = this->output_.size();
+                http2::appendFrameHeader(this->output_, 0, http2::FrameType::DATA, 0, id);
+                const size_t size = stream.response.pullBody(this->output_, limit);
+                const bool last = stream.response.remainingBody() == 0 || (size == 0 && limit > 0);
+                // fill in the length and END_STREAM now that the size is known
+                this->output_[header_at] = static_cast<char>(size >> 16);
+                this->output_[header_at + 1] = static_cast<char>(size >> 8);
+                this->output_[header_at + 2] = static_cast<char>(size);
+                if (last) this->output_[header_at + 4] = static_cast<char>(http2::END_STREAM);
+                stream.send_window -= static_cast<int64_t>(size);
+                this->send_window_ -= static_cast<int64_t>(size);
+
+                if (last) {
+                    stream.queued = false;
+                    this->closeLocal(stream);
+                } else {
+                    this->sending_.push_back(id);
+                    ++turns;
+                }
+            }
+            return this->output_.size() > start;
+        }
+
+        size_t processFrames(std::string_view data) {
+            size_t pos = 0;
+            if (this->preface_left_ > 0) {
+                const size_t offset = http2::PREFACE.size() - this->preface_left_;
+                const size_t n = std::min(this->preface_left_, data.size());
+                if (data.substr(0, n) != http2::PREFACE.substr(offset, n)) {
+                    this->connectionError(http2::ErrorCode::PROTOCOL_ERROR);
+                    return data.size();
+                }
+                this->preface_left_ -= n;
+                pos = n;
+            }
+            while (!this->failed_ && data.size() - pos >= http2::FRAME_HEADER_SIZE) {
+                const char *header = data.data() + pos;
+                const size_t length = (static_cast<size_t>(static_cast<uint8_t>(header[0])) << 16) |
+                                      (static_cast<size_t>(static_cast<uint8_t>(header[1])) << 8) | static_cast<uint8_t>(header[2]);
+                if (length > static_cast<size_t>(this->config_.max_frame_size)) {
+                    this->connectionError(http2::ErrorCode::FRAME_SIZE_ERROR);
+                    return data.size();
+                }
+                if (data.size() - pos - http2::FRAME_HEADER_SIZE < length) break;// the rest arrives with the next read
+
+                const auto type = static_cast<http2::FrameType>(header[3]);
+                const auto flags = static_cast<uint8_t>(header[4]);
+                const uint32_t stream_id = http2::readUint32(header + 5) & 0x7fffffff;
+                const std::string_view payload = data.substr(pos + http2::FRAME_HEADER_SIZE, length);
+                pos += http2::FRAME_HEADER_SIZE + length;
+
+                if (!this->settings_received_ && type != http2::FrameType::SETTINGS) {
+                    // the preface ends with the client's SETTINGS
+                    this->connectionError(http2::ErrorCode::PROTOCOL_ERROR);
+                    break;
+                }
+                if (this->continuation_stream_ != 0 && (type != http2::FrameType::CONTINUATION || stream_id != this->continuation_stream_)) {
+                    this->connectionError(http2::ErrorCode::PROTOCOL_ERROR);
+                    break;
+                }
+                this->processFrame(type, flags, stream_id, payload);
+            }
+            return this->failed_ ? data.size() : pos;
+        }
+
+        void processFrame(http2::FrameType type, uint8_t flags, uint32_t stream_id, std::string_view payload) {
+            switch (type) {
+                case http2::FrameType::DATA:
+                    this->onData(flags, stream_id, payload);
+                    break;
+                case http2::FrameType::HEADERS:
+                    this->onHeaders(flags, stream_id, payload);
+                    break;
+                case http2::FrameType::CONTINUATION:
+                    if (this->continuation_stream_ == 0) {
+                        this->connectionError(http2::ErrorCode::PROTOCOL_ERROR);
+                        break;
+                    }
+                    if (this->header_block_.size() + payload.size() > this->maxHeaderBlock()) {
+                        // the block is never decoded, so the request can not be answered with 431
+                        this->connectionError(http2::ErrorCode::ENHANCE_YOUR_CALM);
+                        break;
+                    }
+                    this->header_block_.append(payload);
+                    if (flags & http2::END_HEADERS) {
+                        this->continuation_stream_ = 0;
+                        this->onHeaderBlock(stream_id, this->header_flags_);
+                    }
+                    break;
+                case http2::FrameType::PRIORITY:
+                    if (stream_id == 0) {
+                        this->connectionError(http2::ErrorCode::PROTOCOL_ERROR);
+                    } else if (payload.size() != 5) {
+                        this->resetStream(stream_id, http2::ErrorCode::FRAME_SIZE_ERROR);
+                    }
+                    break;
+                case http2::FrameType::RST_STREAM:
+                    if (stream_id == 0 || stream_id > this->last_stream_id_) {
+                        this->connectionError(http2::ErrorCode::PROTOCOL_ERROR);
+                    } else if (payload.size() != 4) {
+                        this->connectionError(http2::ErrorCode::FRAME_SIZE_ERROR);
+                    } else if (this->streams_.contains(stream_id)) {
+                        if (--this->reset_credit_ < 0) {
+                            this->connectionError(http2::ErrorCode::ENHANCE_YOUR_CALM);
+                            break;
+                        }
+                        this->eraseStream(stream_id);
+                    }
+                    break;
+                case http2::FrameType::SETTINGS:
+                    this->onSettings(flags, stream_id, payload);
+                    break;
+                case http2::FrameType::PUSH_PROMISE:
+                    // clients cannot push
+                    this->connectionError(http2::ErrorCode::PROTOCOL_ERROR);
+                    break;
+                case http2::FrameType::PING:
+                    if (stream_id != 0) {
+                        this->connectionError(http2::ErrorCode::PROTOCOL_ERROR);
+                    } else if (payload.size() != 8) {
+                        this->connectionError(http2::ErrorCode::FRAME_SIZE_ERROR);
+                    } else if (!(flags & http2::ACK)) {
+                        http2::appendFrameHeader(this->output_, 8, http2::FrameType::PING, http2::ACK, 0);
+                        this->output_.append(payload);
+                    }
+                    break;
+                case http2::FrameType::GOAWAY:
+                    if (stream_id != 0) {
+                        this->connectionError(http2::ErrorCode::PROTOCOL_ERROR);
+                    } else {
+                        this->peer_goaway_ = true;
+                    }
+                    break;
+                case http2::FrameType::WINDOW_UPDATE:
+                    this->onWindowUpdate(stream_id, payload);
+                    break;
+                default:
+                    // unknown frame types are ignored
+                    break;
+            }
+        }
+
+        /**
+         * @brief Largest header block assembled from HEADERS and CONTINUATION frames; one frame always fits.
+         */
+        size_t maxHeaderBlock() const {
+            return std::max(http2::HEADER_BLOCK_FACTOR * static_cast<size_t>(this->config_.max_header_list_size),
+                            static_cast<size_t>(this->config_.max_frame_size));
+        }
+
+        /**
+         * @brief Removes padding from a DATA or HEADERS payload, false when the padding is longer than the payload.
+         */
+        static bool stripPadding(uint8_t flags, std::string_view &payload) {
+            if (!(flags & http2::PADDED)) return true;
+            if (payload.empty()) return false;
+            const size_t padding = static_cast<uint8_t>(payload[0]);
+            if (padding >= payload.size()) return false;
+            payload = payload.substr(1, payload.size() - 1 - padding);
+            return true;
+        }
+
+        void onData(uint8_t flags, uint32_t stream_id, std::string_view payload) {
+            if (stream_id == 0) {
+                this->connectionError(http2::ErrorCode::PROTOCOL_ERROR);
+                return;
+            }
+            // the whole frame counts against the windows, padding included
+            const auto length = static_cast<int64_t>(payload.size());
+            if (length > this->recv_window_) {
+                this->connectionError(http2::ErrorCode::FLOW_CONTROL_ERROR);
+                return;
+            }
+            this->recv_window_ -= length;
+            if (this->recv_window_ <= this->config_.connection_window_size / 2) {
+                this->sendWindowUpdate(0, static_cast<uint32_t>(this->config_.connection_window_size - this->recv_window_));
+                this->recv_window_ = this->config_.connection_window_size;
+            }
+
+            const auto it = this->streams_.find(stream_id);
+            if (it == this->streams_.end() || it->second->remote_closed) {
+                if (stream_id > this->last_stream_id_) {
+                    this->connectionError(http2::ErrorCode::PROTOCOL_ERROR);
+                } else {
+                    this->resetStream(stream_id, http2::ErrorCode::STREAM_CLOSED);
+                }
+                return;
+            }
+            Stream &stream = *it->second;
+            if (length > stream.recv_window) {
+                this->resetStream(stream_id, http2::ErrorCode::FLOW_CONTROL_ERROR);
+                return;
+            }
+            stream.recv_window -= length;
+            if (!stripPadding(flags, payload)) {
+                this->connectionError(http2::ErrorCode::PROTOCOL_ERROR);
+                return;
+            }
+
+            if (!stream.error_status) {
+                stream.body_size += payload.size();
+                if (stream.body_size > static_cast<size_t>(this->config_.max_body_size)) {
+                    stream.error_status = 413;
+                    stream.request.setState(REQUEST_STATE::BAD_REQUEST);
+                    this->ready_.push_back(stream_id);
+                } else {
+                    stream.request.appendBody(payload);
+                }
+            }
+            if (flags & http2::END_STREAM) {
+                this->onRemoteClosed(stream);
+            } else if (stream.recv_window <= this->config_.initial_window_size / 2) {
+                this->sendWindowUpdate(stream_id, static_cast<uint32_t>(this->config_.initial_window_size - stream.recv_window));
+                stream.recv_window = this->config_.initial_window_size;
+            }
+        }
+
+        void onHeaders(uint8_t flags, uint32_t stream_id, std::string_view payload) {
+            if (stream_id == 0 || !(stream_id & 1)) {
+                this->connectionError(http2::ErrorCode::PROTOCOL_ERROR);
+                return;
+            }
+            if (!stripPadding(flags, payload)) {
+                this->connectionError(http2::ErrorCode::PROTOCOL_ERROR);
+                return;
+            }
+            if (flags & http2::PRIORITY) {
+                if (payload.size() < 5) {
+                    this->connectionError(http2::ErrorCode::FRAME_SIZE_ERROR);
+                    return;
+                }
+                payload.remove_prefix(5);
+            }
+            this->header_block_.assign(payload);
+            if (flags & http2::END_HEADERS) {
+                this->onHeaderBlock(stream_id, flags);
+            } else {
+                this->continuation_stream_ = stream_id;
+                this->header_flags_ = flags;
+            }
+        }
+
+        /**
+         * @brief Handles a complete header block: a new request, or the trailers of an open one.
+         */
+        void onHeaderBlock(uint32_t stream_id, uint8_t flags) {
+            const bool end_stream = flags & http2::END_STREAM;
+            if (stream_id <= this->last_stream_id_) {
+                const auto it = this->streams_.find(stream_id);
+                if (it == this->streams_.end() || it->second->remote_closed) {
+                    this->connectionError(http2::ErrorCode::STREAM_CLOSED);
+                    return;
+                }
+                // trailers: decoded to keep the table in sync, end the request body
+                Stream &stream = *it->second;
+                const auto decoded = this->decoder_.decode(this->header_block_, [&](std::string_view name, std::string_view value) {
+                    if (name.starts_with(':')) stream.malformed = true;
+                    stream.header_list_size += name.size() + value.size() + component::HPACK_ENTRY_OVERHEAD;
+                    return true;
+                });
+                if (!decoded) {
+                    this->connectionError(http2::ErrorCode::COMPRESSION_ERROR);
+                    return;
+                }
+                if (!end_stream || stream.malformed) {
+                    this->resetStream(stream_id, http2::ErrorCode::PROTOCOL_ERROR);
+                    return;
+                }
+                this->onRemoteClosed(stream);
+                return;
+            }
+
+            this->last_stream_id_ = stream_id;
+            if (this->streams_.size() + this->detached_ >= static_cast<size_t>(this->config_.max_concurrent_streams) ||
+                this->peer_goaway_) {
+                const auto decoded = this->decoder_.decode(this->header_block_, [](std::string_view, std::string_view) { return true; });
+                if (!decoded) {
+                    this->connectionError(http2::ErrorCode::COMPRESSION_ERROR);
+                    return;
+                }
+                this->resetStream(stream_id, http2::ErrorCode::REFUSED_STREAM);
+                return;
+            }
+
+            auto owned = std::make_shared<Stream>(stream_id);
+            Stream &stream = *owned;
+            stream.send_window = this->peer_initial_window_;
+            stream.recv_window = this->config_.initial_window_size;
+            std::string_view scheme;
+            std::string authority;
+            std::string path;
+            const auto decoded = this->decoder_.decode(this->header_block_, [&](std::string_view name, std::string_view value) {
+                stream.header_list_size += name.size() + value.size() + component::HPACK_ENTRY_OVERHEAD;
+                if (stream.header_list_size > static_cast<size_t>(this->config_.max_header_list_size)) {
+                    stream.error_status = 431;
+                    return true;
+                }
+                if (name.empty() || std::any_of(name.begin(), name.end(), [](char c) { return c >= 'A' && c <= 'Z'; })) {
+                    stream.malformed = true;
+                    return true;
+                }
+                if (name.front() == ':') {
+                    if (stream.pseudo_done) stream.malformed = true;
+                    if (name == ":method" && stream.request.getRequestMethod().empty()) {
+                        stream.request.setRequestMethod(std::string(value));
+                    } else if (name == ":path" && path.empty()) {
+                        path.assign(value);
+                    } else if (name == ":scheme" && scheme.empty()) {
+                        scheme = value == "https" ? "https" : "http";
+                    } else if (name == ":authority" && authority.empty()) {
+                        authority.assign(value);
+                    } else {
+                        stream.malformed = true;
+                    }
+                    return true;
+                }
+                stream.pseudo_done = true;
+                // connection-specific fields do not exist in HTTP/2
+                if (name == "connection" || name == "keep-alive" || name == "proxy-connection" || name == "transfer-encoding" ||
+                    name == "upgrade" || (name == "te" && value != "trailers")) {
+                    stream.malformed = true;
+                    return true;
+                }
+                stream.request.addHeader(name, value);
+                return true;
+            });
+            if (!decoded) {
+                this->connectionError(http2::ErrorCode::COMPRESSION_ERROR);
+                return;
+            }
+            if (stream.request.getRequestMethod().empty() || path.empty() || scheme.empty() || !stream.request.setTarget(path)) {
+                stream.malformed = true;
+            }
+            if (stream.malformed) {
+                this->resetStream(stream_id, http2::ErrorCode::PROTOCOL_ERROR);
+                return;
+            }
+            if (!authority.empty() && !stream.request.getHeaders().contains(component::HeaderEnum::Host)) {
+                stream.request.addHeader("host", authority);
+            }
+            stream.request.setHTTPVersion(VERSION::HTTP_2_0);
+            stream.response.setHTTPVersion(VERSION::HTTP_2_0);
+            this->streams_.emplace(stream_id, std::move(owned));
+
+            if (!stream.error_status) this->route(stream);
+            if (stream.error_status) {
+                stream.request.setState(REQUEST_STATE::BAD_REQUEST);
+                this->ready_.push_back(stream_id);
+            } else {
+                stream.request.setState(end_stream ? REQUEST_STATE::FINISHED : REQUEST_STATE::DATA_FRAGMENT);
+            }
+            if (end_stream) this->onRemoteClosed(stream);
+        }
+
+        /**
+         * @brief Matches the route and runs the SETTINGS and HEADER middlewares, as HTTP1 does once headers are parsed.
+         */
+        void route(Stream &stream) {
+            const auto match = this->endpoint_handler_->match(stream.request);
+            if (!match) {
+                stream.error_status = 404;
+                return;
+            }
+            auto &[route, method_allowed] = *match;
+            if (!method_allowed) {
+                stream.error_status = 405;
+                stream.response.addHeader("Allow", route->allowed_methods.allowHeader());
+                return;
+            }
+            stream.route = route;
+            stream.response.addHeader("Server", "usub");
+            stream.response.setRoute(route);
+            for (const auto phase: {MiddlewarePhase::SETTINGS, MiddlewarePhase::HEADER}) {
+                if (!this->endpoint_handler_->getMiddlewareChain().execute(phase, stream.request, stream.response) ||
+                    !route->middleware_chain.execute(phase, stream.request, stream.response)) {
+                    // the middleware chose the status, like a rejected HTTP/1 request
+                    const uint16_t status = stream.response.getStatus();
+                    stream.error_status = status ? status : 400;
+                    return;
+                }
+            }
+        }
+
+        void onRemoteClosed(Stream &stream) {
+            stream.remote_closed = true;
+            if (stream.error_status) return;// already queued
+            stream.request.setState(REQUEST_STATE::FINISHED);
+            this->ready_.push_back(stream.id);
+        }
+
+        /**
+         * @brief Runs the handler of a complete request, then queues the stream for its HEADERS and flushes.
+         *
+         * Holds the stream, which a RST_STREAM may remove from streams_ meanwhile, and counts as running until
+         * its last statement: drain() resumes the connection from here, which may then destroy this object.
+         */
+        usub::uvent::task::Awaitable<void> run(std::shared_ptr<Stream> stream) {
+            Request &request = stream->request;
+            Response &response = stream->response;
+            bool ok = true;
+            if (stream->body_size > 0) {
+                ok = this->endpoint_handler_->getMiddlewareChain().execute(MiddlewarePhase::BODY, request, response) &&
+                     stream->route->middleware_chain.execute(MiddlewarePhase::BODY, request, response);
+            }
+            if (ok) {
+                co_await stream->route->invoke(request, response);
+                if (this->endpoint_handler_->getMiddlewareChain().execute(MiddlewarePhase::RESPONSE, request, response)) {
+                    stream->route->middleware_chain.execute(MiddlewarePhase::RESPONSE, request, response);
+                }
+            }
+            if (!this->closing_) {
+                this->completed_.push_back(stream);
+                co_await this->flush();
+            }
+            if (stream->detached) --this->detached_;
+            --this->running_;
+            this->wake();
+        }
+
+        /**
+         * @brief Sends the HEADERS of the streams whose handlers finished, in the order they did.
+         */
+        void respondCompleted() {
+            while (!this->completed_.empty()) {
+                const std::shared_ptr<Stream> stream = std::move(this->completed_.front());
+                this->completed_.pop_front();
+                // a stream reset while its handler ran is not answered
+                const auto it = this->streams_.find(stream->id);
+                if (it != this->streams_.end() && it->second == stream && !stream->responded) this->sendHeaders(*stream);
+            }
+        }
+
+        bool quiet() const {
+            return !this->writing_ && (!this->closing_ || this->running_ == 0);
+        }
+
+        /**
+         * @brief Resumes the coroutine waiting in writes() or drain() once that is over; must be the last thing
+         *        the caller does with this object.
+         */
+        void wake() {
+            if (this->waiter_ && this->quiet()) std::exchange(this->waiter_, {}).resume();
+        }
+
+        void sendHeaders(Stream &stream) {
+            Response &response = stream.response;
+            const uint16_t status = response.getStatus();
+            const bool has_body = response.remainingBody() > 0 && stream.request.getMethod() != Method::HEAD &&
+                                  status != 204 && status != 304;
+
+            std::string &block = this->encoded_block_;
+            block.clear();
+            this->encoder_.begin(block);
+            this->encoder_.encode(block, ":status", std::to_string(status));
+            for (const auto &[name, values]: response.getHeaders()) {
+                std::string lower(name);
+                std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+                if (lower == "connection" || lower == "keep-alive" || lower == "proxy-connection" || lower == "transfer-encoding" ||
+                    lower == "upgrade") {
+                    continue;
+                }
+                if (lower == "set-cookie") {
+                    for (const auto &value: values) this->encoder_.encode(block, lower, value);
+                    continue;
+                }
+                std::string joined;
+                for (const auto &value: values) {
+                    if (!joined.empty()) joined.append(", ");
+                    joined.append(value);
+                }
+                this->encoder_.encode(block, lower, joined);
+            }
+
+            // HEADERS, then CONTINUATION frames for what does not fit the peer's frame size
+            const size_t frame_size = static_cast<size_t>(this->peer_max_frame_size_);
+            size_t offset = 0;
+            bool first = true;
+            do {
+                const size_t size = std::min(block.size() - offset, frame_size);
+                const bool end_headers = offset + size == block.size();
+                uint8_t flags = end_headers ? http2::END_HEADERS : 0;
+                if (first && !has_body) flags |= http2::END_STREAM;
+                http2::appendFrameHeader(this->output_, size, first ? http2::FrameType::HEADERS : http2::FrameType::CONTINUATION, flags,
+                                         stream.id);
+                this->output_.append(block, offset, size);
+                offset += size;
+                first = false;
+            } while (offset < block.size());
+
+            stream.responded = true;
+            this->reset_credit_ = std::min(this->reset_credit_ + 1, http2::RESET_BUDGET);
+            if (has_body) {
+                stream.queued = true;
+                this->sending_.push_back(stream.id);
+            } else {
+                response.setSent();
+                this->closeLocal(stream);
+            }
+        }
+
+        /**
+         * @brief The response ended the stream; a request still arriving is cut off with NO_ERROR.
+         */
+        void closeLocal(Stream &stream) {
+            const uint32_t id = stream.id;
+            if (!stream.remote_closed) {
+                http2::appendFrameHeader(this->output_, 4, http2::FrameType::RST_STREAM, 0, id);
+                http2::appendUint32(this->output_, static_cast<uint32_t>(http2::ErrorCode::NO_ERROR));
+            }
+            this->eraseStream(id);
+        }
+
+        void onSettings(uint8_t flags, uint32_t stream_id, std::string_view payload) {
+            if (stream_id != 0) {
+                this->connectionError(http2::ErrorCode::PROTOCOL_ERROR);
+                return;
+            }
+            if (flags & http2::ACK) {
+                if (!payload.empty()) this->connectionError(http2::ErrorCode::FRAME_SIZE_ERROR);
+                return;
+            }
+            if (payload.size() % 6 != 0) {
+                this->connectionError(http2::ErrorCode::FRAME_SIZE_ERROR);
+                return;
+            }
+            for (size_t pos = 0; pos < payload.size(); pos += 6) {
+                const auto id = static_cast<http2::Setting>((static_cast<uint8_t>(payload[pos]) << 8) | static_cast<uint8_t>(payload[pos + 1]));
+                const uint32_t value = http2::readUint32(payload.data() + pos + 2);
+                switch (id) {
+                    case http2::Setting::HEADER_TABLE_SIZE:
+                        this->encoder_.setMaxTableSize(value);
+                        break;
+                    case http2::Setting::ENABLE_PUSH:
+                        if (value > 1) {
+                            this->connectionError(http2::ErrorCode::PROTOCOL_ERROR);
+                            return;
+                        }
+                        break;
+                    case http2::Setting::INITIAL_WINDOW_SIZE: {
+                        if (value > http2::MAX_WINDOW_SIZE) {
+                            this->connectionError(http2::ErrorCode::FLOW_CONTROL_ERROR);
+                            return;
+                        }
+                        // applies to the windows of open streams as well
+                        const int64_t delta = static_cast<int64_t>(value) - this->peer_initial_window_;
+                        this->peer_initial_window_ = value;
+                        for (auto &[id, stream]: this->streams_) {
+                            stream->send_window += delta;
+                            if (stream->send_window > http2::MAX_WINDOW_SIZE) {
+                                this->connectionError(http2::ErrorCode::FLOW_CONTROL_ERROR);
+                                return;
+                            }
+                            this->requeue(*stream);
+                        }
+                        break;
+                    }
+                    case http2::Setting::MAX_FRAME_SIZE:
+                        if (value < http2::DEFAULT_FRAME_SIZE || value > http2::MAX_FRAME_SIZE) {
+                            this->connectionError(http2::ErrorCode::PROTOCOL_ERROR);
+                            return;
+                        }
+                        this->peer_max_frame_size_ = value;
+                        break;
+                    default:
+                        // MAX_CONCURRENT_STREAMS only limits pushes, MAX_HEADER_LIST_SIZE is advisory
+                        break;
+                }
+            }
+            this->settings_received_ = true;
+            http2::appendFrameHeader(this->output_, 0, http2::FrameType::SETTINGS, http2::ACK, 0);
+        }
+
+        void onWindowUpdate(uint32_t stream_id, std::string_view payload) {
+            if (payload.size() != 4) {
+                this->connectionError(http2::ErrorCode::FRAME_SIZE_ERROR);
+                return;
+            }
+            const uint32_t increment = http2::readUint32(payload.data()) & 0x7fffffff;
+            if (stream_id == 0) {
+                if (increment == 0 || this->send_window_ + increment > http2::MAX_WINDOW_SIZE) {
+                    this->connectionError(increment == 0 ? http2::ErrorCode::PROTOCOL_ERROR : http2::ErrorCode::FLOW_CONTROL_ERROR);
+                    return;
+                }
+                this->send_window_ += increment;
+                return;
+            }
+            const auto it = this->streams_.find(stream_id);
+            if (it == this->streams_.end()) return;// closed streams may still receive updates
+            Stream &stream = *it->second;
+            if (increment == 0 || stream.send_window + increment > http2::MAX_WINDOW_SIZE) {
+                this->resetStream(stream_id, increment == 0 ? http2::ErrorCode::PROTOCOL_ERROR : http2::ErrorCode::FLOW_CONTROL_ERROR);
+                return;
+            }
+            stream.send_window += increment;
+            this->requeue(stream);
+        }
+
+        /**
+         * @brief Puts a stream whose response waits for window back into the send rotation.
+         */
+        void requeue(Stream &stream) {
+            if (stream.responded && !stream.queued && stream.send_window > 0 && !stream.response.isSent()) {
+                stream.queued = true;
+                this->sending_.push_back(stream.id);
+            }
+        }
+
+        void sendWindowUpdate(uint32_t stream_id, uint32_t increment) {
+            http2::appendFrameHeader(this->output_, 4, http2::FrameType::WINDOW_UPDATE, 0, stream_id);
+            http2::appendUint32(this->output_, increment);
+        }
+
+        void resetStream(uint32_t stream_id, http2::ErrorCode code) {
+            http2::appendFrameHeader(this->output_, 4, http2::FrameType::RST_STREAM, 0, stream_id);
+            http2::appendUint32(this->output_, static_cast<uint32_t>(code));
+            this->eraseStream(stream_id);
+        }
+
+        /**
+         * @brief Forgets a stream; a handler still running for it keeps counting against max_concurrent_streams.
+         */
+        void eraseStream(uint32_t stream_id) {
+            const auto it = this->streams_.find(stream_id);
+            if (it == this->streams_.end()) return;
+            if (it->second->running) {
+                it->second->detached = true;
+                ++this->detached_;
+            }
+            this->streams_.erase(it);
+        }
+
+        void connectionError(http2::ErrorCode code) {
+            if (this->failed_) return;
+            http2::appendFrameHeader(this->output_, 8, http2::FrameType::GOAWAY, 0, 0);
+            http2::appendUint32(this->output_, this->last_stream_id_);
+            http2::appendUint32(this->output_, static_cast<uint32_t>(code));
+            this->failed_ = true;
+        }
+
+        std::shared_ptr<RouterType> endpoint_handler_;
+        configuration::HTTP2Config config_;
+        Writer writer_;
+        component::HPACKDecoder decoder_;
+        component::HPACKEncoder encoder_;
+
+        std::unordered_map<uint32_t, std::shared_ptr<Stream>> streams_;
+        std::vector<uint32_t> ready_;  ///< Streams whose request is complete, in order.
+        std::deque<uint32_t> sending_; ///< Streams with DATA to send and window to send it.
+        std::deque<std::shared_ptr<Stream>> completed_;///< Streams whose handler finished, waiting for a flush.
+        size_t running_{0};                            ///< Handler coroutines not finished yet.
+        size_t detached_{0};                           ///< Of those, the ones whose stream was already removed.
+        int64_t reset_credit_{http2::RESET_BUDGET};    ///< Client resets left, see http2::RESET_BUDGET.
+        std::coroutine_handle<> waiter_{};             ///< Connection coroutine in writes() or drain().
+
+        std::string input_;         ///< Start of a frame that did not arrive completely.
+        std::string output_;
+        std::string batch_;         ///< Frames being written by flush(), swapped with output_.
+        std::string header_block_;  ///< Header block being assembled from CONTINUATION frames.
+        std::string encoded_block_; ///< Scratch for the response header block being encoded.
+        size_t preface_left_{http2::PREFACE.size()};
+        uint32_t continuation_stream_{0};
+        uint8_t header_flags_{0};
+        uint32_t last_stream_id_{0};
+
+        int64_t send_window_{http2::DEFAULT_WINDOW_SIZE};
+        int64_t recv_window_{http2::DEFAULT_WINDOW_SIZE};
+        int64_t peer_initial_window_{http2::DEFAULT_WINDOW_SIZE};
+        int64_t peer_max_frame_size_{http2::DEFAULT_FRAME_SIZE};
+        bool settings_received_{false};
+        bool peer_goaway_{false};
+        bool failed_{false};
+        bool writing_{false};
+        bool write_failed_{false};
+        bool closing_{false};
+    };
+
+}// namespace usub::server::protocols::http
+
+#endif// HTTP2_H
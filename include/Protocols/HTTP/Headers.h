@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstring>
+#include <memory_resource>
 #include <set>
 #include <sstream>
 #include <string>
@@ -97,14 +98,39 @@ namespace usub::server {
 
         class Headers /* : public component::Headers */ {
         private:
-            std::unordered_map<usub::server::component::HeaderEnum, std::vector<std::string>> known_headers_map_;
-            std::unordered_map<std::string, std::vector<std::string>, usub::utils::CaseInsensitiveHash, usub::utils::CaseInsensitiveEqual> unknown_headers_map_;
+            using known_map_type = std::pmr::unordered_map<usub::server::component::HeaderEnum, std::vector<std::string>>;
+            using unknown_map_type = std::pmr::unordered_map<std::string, std::vector<std::string>, usub::utils::CaseInsensitiveHash, usub::utils::CaseInsensitiveEqual>;
+
+            known_map_type known_headers_map_;
+            unknown_map_type unknown_headers_map_;
 
         public:
             Headers() = default;
+            explicit Headers(std::pmr::memory_resource *resource);
+            Headers(const Headers &) = default;
+
+            /**
+             * @brief Moves the headers of @p other into storage of the default resource.
+             *
+             * Headers moved out of a request whose maps live in a connection arena must not point into that
+             * arena, which is released once the exchange is answered; their entries are then moved one by one.
+             */
+            Headers(Headers &&other);
             ~Headers() = default;
 
+            Headers &operator=(const Headers &) = default;
+            Headers &operator=(Headers &&) = default;
+
             Headers &clear();
+
+            /**
+             * @brief Drops all headers and allocates further map storage from @p resource.
+             *
+             * Used by connections that own an arena: the maps must be rebound before the arena is released,
+             * so no node outlives the memory it was allocated from. Copies and headers moved out always use
+             * the default resource.
+             */
+            Headers &setMemoryResource(std::pmr::memory_resource *resource);
             Headers &erase(std::string_view key_view);
 
             template<bool IgnoreCase = false>
@@ -1614,33 +1640,50 @@ namespace usub::server {
                 }
             }
 
-            // template<typename T>
-            const std::string string() const {
-
-                std::string rv{};
-                rv.reserve(8192);
+            /**
+             * @brief Appends the wire form of all headers (`name: v1, v2\r\n` per field) to @p out.
+             *
+             * Writes straight into the caller's buffer, so a response head can be built in one reused string
+             * without the temporaries string() creates.
+             */
+            void serialize(std::string &out) const {
                 for (const auto &header: this->known_headers_map_) {
+                    const char *name = usub::server::component::header_enum_to_string_lower[(size_t) header.first];
                     if (header.first != usub::server::component::HeaderEnum::Set_Cookie) [[likely]] {
-                        rv += std::string(usub::server::component::header_enum_to_string_lower[(size_t) header.first]) + ": ";
+                        out.append(name);
+                        out.append(": ");
                         for (const auto &value: header.second) {
-                            rv += value + ", ";
+                            out.append(value);
+                            out.append(", ");
                         }
-                        rv[rv.size() - 2] = '\r';
-                        rv[rv.size() - 1] = '\n';
+                        out[out.size() - 2] = '\r';
+                        out[out.size() - 1] = '\n';
                     } else [[unlikely]] {
                         for (const auto &value: header.second) {
-                            rv += std::string(usub::server::component::header_enum_to_string_lower[(size_t) header.first]) + ": " + value + "\r\n";
+                            out.append(name);
+                            out.append(": ");
+                            out.append(value);
+                            out.append("\r\n");
                         }
                     }
                 }
                 for (const auto &header: this->unknown_headers_map_) {
-                    rv += header.first + ": ";
+                    out.append(header.first);
+                    out.append(": ");
                     for (const auto &value: header.second) {
-                        rv += value + ", ";
+                        out.append(value);
+                        out.append(", ");
                     }
-                    rv[rv.size() - 2] = '\r';
-                    rv[rv.size() - 1] = '\n';
+                    out[out.size() - 2] = '\r';
+                    out[out.size() - 1] = '\n';
                 }
+            }
+
+            // template<typename T>
+            const std::string string() const {
+                std::string rv{};
+                rv.reserve(8192);
+                this->serialize(rv);
                 return rv;
             }
 
@@ -1654,10 +1697,10 @@ namespace usub::server {
                                    End };
 
                 Iterator(
-                        std::unordered_map<usub::server::component::HeaderEnum, std::vector<std::string>>::const_iterator k_it,
-                        std::unordered_map<usub::server::component::HeaderEnum, std::vector<std::string>>::const_iterator k_end,
-                        std::unordered_map<std::string, std::vector<std::string>>::const_iterator u_it,
-                        std::unordered_map<std::string, std::vector<std::string>>::const_iterator u_end)
+                        known_map_type::const_iterator k_it,
+                        known_map_type::const_iterator k_end,
+                        unknown_map_type::const_iterator u_it,
+                        unknown_map_type::const_iterator u_end)
                     : known_it_(k_it), known_end_(k_end), unknown_it_(u_it), unknown_end_(u_end) {
                     if (known_it_ != known_end_) {
                         phase_ = Phase::Known;
@@ -1670,10 +1713,10 @@ namespace usub::server {
 
                 Iterator(
                         Phase phase,
-                        std::unordered_map<usub::server::component::HeaderEnum, std::vector<std::string>>::const_iterator k_it,
-                        std::unordered_map<usub::server::component::HeaderEnum, std::vector<std::string>>::const_iterator k_end,
-                        std::unordered_map<std::string, std::vector<std::string>>::const_iterator u_it,
-                        std::unordered_map<std::string, std::vector<std::string>>::const_iterator u_end)
+                        known_map_type::const_iterator k_it,
+                        known_map_type::const_iterator k_end,
+                        unknown_map_type::const_iterator u_it,
+                        unknown_map_type::const_iterator u_end)
                     : known_it_(k_it), known_end_(k_end), unknown_it_(u_it), unknown_end_(u_end), phase_(phase) {}
 
                 Iterator &operator++() {
@@ -1730,10 +1773,10 @@ namespace usub::server {
                 }
 
             private:
-                std::unordered_map<usub::server::component::HeaderEnum, std::vector<std::string>>::const_iterator known_it_;
-                std::unordered_map<usub::server::component::HeaderEnum, std::vector<std::string>>::const_iterator known_end_;
-                std::unordered_map<std::string, std::vector<std::string>>::const_iterator unknown_it_;
-                std::unordered_map<std::string, std::vector<std::string>>::const_iterator unknown_end_;
+                known_map_type::const_iterator known_it_;
+                known_map_type::const_iterator known_end_;
+                unknown_map_type::const_iterator unknown_it_;
+                unknown_map_type::const_iterator unknown_end_;
                 Phase phase_;
             };
 
@@ -7,6 +7,8 @@
 #include <fstream>
 #include <iostream>
 #include <map>
+#include <memory_resource>
+#include <sys/uio.h>
 #include <unordered_map>
 #include <uvent/net/Socket.h>
 #include <uvent/system/SystemContext.h>
@@ -21,6 +23,8 @@
 // #include "Components/Headers/Headers.h"
 #include "Components/URL/URL.h"
 #include "Protocols/HTTP/Headers.h"
+#include "Protocols/HTTP/Methods.h"
+#include "Protocols/HTTP/UriParams.h"
 #include "utils/HTTPUtils/HTTPUtils.h"
 #include "utils/utils.h"
 #include "uvent/tasks/Awaitable.h"
@@ -136,6 +140,16 @@ namespace usub::server::protocols::http {
     };
 
 
+    /**
+     * @brief A part of a file-backed response body that is sent by the kernel (sendfile) rather than read into memory.
+     */
+    struct FileRange {
+        int fd{-1};                ///< File to send from, -1 when there is nothing to send.
+        off_t offset{0};           ///< Position in the file.
+        size_t size{0};            ///< Number of bytes to send.
+        std::string_view trailer{};///< Bytes to write after the range (chunk CRLF / last-chunk), may be empty.
+    };
+
     /**
      * @brief Reserved for future use for now those vars are in separate vars in a class, which inflates it
      */
@@ -267,6 +281,14 @@ namespace usub::server::protocols::http {
          */
         std::string method_token_{};
 
+        /**
+         * @brief `method_token_` interned, valid while `method_interned_` is set.
+         *
+         * @details Interned once the request line's method is parsed; routers compare it instead of the token.
+         */
+        Method method_{Method::UNKNOWN};
+        bool method_interned_{};
+
         /**
          * @brief URL object containing the path and query parameters.
          *
@@ -297,13 +319,15 @@ namespace usub::server::protocols::http {
 
     public:
         /**
-         * @brief Map storing URI parameters extracted from the route.
+         * @brief URI parameters extracted from the route.
          *
          * @details Parameters defined within `{}` brackets in the route (handler), similar to Spring Boot.
+         * Values are views into the URL, valid until the URL changes or the request is cleared.
          * 
          * @see addHandler()
+         * @see UriParams
          */
-        std::unordered_map<std::string, std::string> uri_params;
+        UriParams uri_params;
         mutable std::any user_data;
 
     public:
@@ -373,8 +397,16 @@ namespace usub::server::protocols::http {
         std::string &getRequestMethod();
         const std::string &getRequestMethod() const;
 
+        /**
+         * @brief Retrieves the interned HTTP method of the request.
+         *
+         * @return Method The method, UNKNOWN when no route names it.
+         */
+        Method getMethod();
+
         Request &setRequestMethod(const std::string &method) {
             this->method_token_ = method;
+            this->method_interned_ = false;
             return *this;
         }
 
@@ -401,6 +433,20 @@ namespace usub::server::protocols::http {
          */
         void setUri(const std::string &uri);
 
+        /**
+         * @brief Sets the path and query parameters from an origin-form target (`/path?key=value&...`).
+         *
+         * For protocols that receive the target in one piece, such as the HTTP/2 `:path` pseudo-header.
+         *
+         * @return false when @p target is not in origin form.
+         */
+        bool setTarget(std::string_view target);
+
+        /**
+         * @brief Appends a received part of the body, leaving the headers as they are.
+         */
+        Request &appendBody(std::string_view data);
+
         /**
          * @brief Sets the request body and optional content type.
          *
@@ -531,6 +577,24 @@ namespace usub::server::protocols::http {
          *  
          */
         [[maybe_unused]] std::string::const_iterator parseHTTP1_X(const std::string &request, std::string::const_iterator start_pos = {});
+
+        /**
+         * @brief Parses any HTTP/1.X request directly from a caller-owned buffer.
+         *
+         * @param request View over the received bytes, typically the connection's read buffer.
+         * @param start_pos Position inside @p request to resume from, or nullptr to start at its beginning.
+         * @return const char* Pointer to the parsing position inside @p request, nullptr if nothing was parsed.
+         *
+         * Same state machine as the `std::string` overload, which forwards here. The caller does not need to
+         * copy the read buffer into a string first: tokens are located in place and each run of bytes
+         * (method, path, query, header name/value, body) is appended to the request with a single copy.
+         * A token that is split across two reads is simply appended to in two steps.
+         * Once the state reaches FINISHED the returned pointer is one past the end of the message, so the
+         * remaining bytes (a pipelined request) can be handed to the next call.
+         *
+         * @warning @p request only has to stay valid for the duration of the call, nothing keeps a reference to it.
+         */
+        const char *parseHTTP1_X(std::string_view request, const char *start_pos = nullptr);
         usub::uvent::task::Awaitable<bool> parseHTTP1_X_yield(const std::string &request);
 
         /**
@@ -566,9 +630,18 @@ namespace usub::server::protocols::http {
 
         /**
          * @brief Clears the request data and resets its state.
+         *
+         * Strings keep their capacity, so a keep-alive connection stops allocating once it has seen its largest request.
          */
         void clear();
 
+        /**
+         * @brief Clears the request and allocates its header and query parameter maps from @p resource from now on.
+         *
+         * Call it again with the same resource before that resource is released.
+         */
+        void setMemoryResource(std::pmr::memory_resource *resource);
+
         std::string string();
 
         /**
@@ -634,6 +707,20 @@ namespace usub::server::protocols::http {
          */
         Route *matched_route_{nullptr};
 
+        /**
+         * @brief Storage for the segments pullSegments() hands out by reference.
+         *
+         * @details Kept as members so their capacity is reused between responses on the same connection.
+         */
+        std::string head_{};
+        std::string chunk_head_{};
+        std::string file_chunk_{};
+
+        /**
+         * @brief Appends the status line and header block to @p iov once per response.
+         */
+        void pullHead(std::vector<iovec> &iov);
+
     public:
         /**
          * @brief Default constructor.
@@ -744,8 +831,53 @@ namespace usub::server::protocols::http {
 
         Response &setContentLength();
 
+        /**
+         * @brief Body bytes pullBody() has not produced yet.
+         */
+        size_t remainingBody() const;
+
+        /**
+         * @brief Appends up to @p max bytes of the body to @p out, without HTTP/1.x framing.
+         *
+         * For framed protocols (HTTP/2) that send the head separately; file bodies are read with pread().
+         * Marks the response as sent once the whole body was produced.
+         *
+         * @return Bytes appended, 0 at the end of the body or when the file cannot be read.
+         */
+        size_t pullBody(std::string &out, size_t max);
+
+        /**
+         * @brief Produces the next part of the response as a single string.
+         *
+         * @return std::string The bytes to write. Joins the segments of pullSegments().
+         */
         std::string pull();
 
+        /**
+         * @brief Produces the next part of the response as a list of buffers for a vectored write.
+         *
+         * Appends to @p iov: the status line and headers (serialized once into a reused buffer), chunk
+         * framing, and the body itself, referenced in place rather than copied.
+         * Advances the send state exactly like pull().
+         *
+         * @param iov Destination list, appended to.
+         * @warning The entries point into this response and stay valid until the next pullSegments()/pull(),
+         * clear() or any modification of the body.
+         */
+        void pullSegments(std::vector<iovec> &iov);
+
+        /**
+         * @brief Same as pullSegments(iov), but leaves file bodies (setFile()) to the kernel.
+         *
+         * For a file body @p file receives the range to send with sendfile(2) and @p iov only gets what has to go
+         * before it (the header block and chunk-size line); nothing is read from the file. Without chunked encoding
+         * the whole remaining file is one range; with it, one chunk of up to max_write_size_ bytes per call.
+         * For other bodies @p file is left with fd == -1 and the call behaves like pullSegments(iov).
+         *
+         * Write order is: @p iov, then the file range, then @p file.trailer.
+         */
+        void pullSegments(std::vector<iovec> &iov, FileRange &file);
+
         /**
          * @brief Converts the response to a string representation.
          *
@@ -765,6 +897,13 @@ namespace usub::server::protocols::http {
          */
         void clear();
 
+        /**
+         * @brief Clears the response and allocates its header maps from @p resource from now on.
+         *
+         * Call it again with the same resource before that resource is released.
+         */
+        void setMemoryResource(std::pmr::memory_resource *resource);
+
         /**
          * @brief Get numeric status code for the response.
          *
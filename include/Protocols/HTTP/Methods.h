@@ -0,0 +1,147 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace usub::server::protocols::http {
+
+    /**
+     * @enum Method
+     * @brief Interned HTTP method tokens.
+     *
+     * The standard methods have fixed values. Extension methods (WebDAV's PROPFIND, for instance) get the values
+     * between PATCH and UNKNOWN when a route first names them, see methods::intern(). A request whose method no
+     * route names is UNKNOWN.
+     */
+    enum class Method : uint8_t {
+        GET,
+        HEAD,
+        POST,
+        PUT,
+        DELETE,
+        CONNECT,
+        OPTIONS,
+        TRACE,
+        PATCH,
+        UNKNOWN = 63,
+    };
+
+    namespace methods {
+        inline constexpr std::array<std::string_view, 9> standard_methods{
+                "GET", "HEAD", "POST", "PUT", "DELETE", "CONNECT", "OPTIONS", "TRACE", "PATCH"};
+
+        /// Extension methods that can be interned next to the standard ones.
+        inline constexpr size_t max_extensions = static_cast<size_t>(Method::UNKNOWN) - standard_methods.size();
+
+        /**
+         * @brief The standard method @p token names, UNKNOWN for any other token.
+         */
+        constexpr Method standard(std::string_view token) {
+            switch (token.size()) {
+                case 3:
+                    if (token == "GET") return Method::GET;
+                    if (token == "PUT") return Method::PUT;
+                    break;
+                case 4:
+                    if (token == "POST") return Method::POST;
+                    if (token == "HEAD") return Method::HEAD;
+                    break;
+                case 5:
+                    if (token == "PATCH") return Method::PATCH;
+                    if (token == "TRACE") return Method::TRACE;
+                    break;
+                case 6:
+                    if (token == "DELETE") return Method::DELETE;
+                    break;
+                case 7:
+                    if (token == "OPTIONS") return Method::OPTIONS;
+                    if (token == "CONNECT") return Method::CONNECT;
+                    break;
+            }
+            return Method::UNKNOWN;
+        }
+
+        /**
+         * @brief The method @p token names, UNKNOWN when it is neither standard nor interned.
+         *
+         * Never adds to the extension table, so the tokens of requests can not fill it.
+         */
+        Method lookup(std::string_view token);
+
+        /**
+         * @brief The method @p token names, adding it to the extension table when it is new.
+         *
+         * Called when routes are added, before the server runs.
+         *
+         * @throws std::runtime_error When the extension table is full.
+         */
+        Method intern(std::string_view token);
+
+        /**
+         * @brief The token of @p method, empty for UNKNOWN.
+         */
+        std::string_view name(Method method);
+    }// namespace methods
+
+    /**
+     * @class MethodSet
+     * @brief A set of interned methods, one bit per method.
+     */
+    class MethodSet {
+    public:
+        constexpr MethodSet() = default;
+
+        constexpr explicit MethodSet(uint64_t mask) : mask_(mask) {}
+
+        /**
+         * @brief Every method, UNKNOWN included.
+         */
+        static constexpr MethodSet all() { return MethodSet(~uint64_t{0}); }
+
+        /**
+         * @brief The standard methods of a comma-separated list such as "GET,HEAD".
+         *
+         * @throws std::invalid_argument On a method that is not standard; in a constant expression this is a
+         *         compile error.
+         */
+        static constexpr MethodSet parse(std::string_view list) {
+            MethodSet set;
+            while (!list.empty()) {
+                size_t comma = 0;
+                while (comma < list.size() && list[comma] != ',') ++comma;
+                const Method method = methods::standard(list.substr(0, comma));
+                if (method == Method::UNKNOWN) throw std::invalid_argument("Unknown method in method list, use \"*\" for any method");
+                set.add(method);
+                list.remove_prefix(comma < list.size() ? comma + 1 : comma);
+            }
+            return set;
+        }
+
+        constexpr MethodSet &add(Method method) {
+            this->mask_ |= bit(method);
+            return *this;
+        }
+
+        constexpr bool contains(Method method) const { return this->mask_ & bit(method); }
+
+        constexpr bool empty() const { return !this->mask_; }
+
+        constexpr uint64_t mask() const { return this->mask_; }
+
+        constexpr bool operator==(const MethodSet &) const = default;
+
+        /**
+         * @brief The value of an `Allow` header listing the methods, e.g. "GET, HEAD".
+         */
+        std::string allowHeader() const;
+
+    private:
+        static constexpr uint64_t bit(Method method) { return uint64_t{1} << static_cast<uint8_t>(method); }
+
+        uint64_t mask_{0};
+    };
+
+}// namespace usub::server::protocols::http
@@ -0,0 +1,163 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace usub::server::protocols::http {
+
+    /// What checks a path parameter: a native matcher, or a regex for any other pattern.
+    enum class ParamKind : uint8_t {
+        REGEX, ///< The pattern, through std::regex.
+        ANY,   ///< Any segment.
+        INT,   ///< Digits with an optional leading '-'.
+        UINT,  ///< Digits.
+        UUID,  ///< 8-4-4-4-12 hex digits, either case.
+        HEX,   ///< Hex digits, either case.
+        SLUG,  ///< Letters, digits, '-' and '_'.
+        ONE_OF,///< One of the literals.
+        LENGTH,///< Any segment of min_length to max_length characters.
+    };
+
+    /**
+     * @brief Constraint on a path parameter.
+     *
+     * @p pattern is the equivalent regex, used by the regex router and in route dumps; @p kind selects the
+     * native matcher the radix router runs instead. A constraint made of a pattern only is still matched
+     * natively when the pattern is one the constraints below use.
+     */
+    struct param_constraint {
+        std::string pattern;
+        std::string description;
+        ParamKind kind = ParamKind::REGEX;
+        std::vector<std::string> literals{};///< For ONE_OF.
+        size_t min_length = 0;              ///< For LENGTH.
+        size_t max_length = SIZE_MAX;       ///< For LENGTH.
+    };
+
+    const param_constraint default_constraint{
+            R"([^/]+)",
+            "Encountered an error...",
+            ParamKind::ANY};
+
+    namespace constraints {
+        constexpr bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+        constexpr bool isHexDigit(char c) {
+            return isDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+        }
+
+        constexpr bool isUint(std::string_view value) {
+            if (value.empty()) return false;
+            for (char c: value) {
+                if (!isDigit(c)) return false;
+            }
+            return true;
+        }
+
+        constexpr bool isInt(std::string_view value) {
+            if (!value.empty() && value.front() == '-') value.remove_prefix(1);
+            return isUint(value);
+        }
+
+        constexpr bool isHex(std::string_view value) {
+            if (value.empty()) return false;
+            for (char c: value) {
+                if (!isHexDigit(c)) return false;
+            }
+            return true;
+        }
+
+        constexpr bool isUuid(std::string_view value) {
+            if (value.size() != 36) return false;
+            for (size_t i = 0; i < value.size(); ++i) {
+                const bool dash = i == 8 || i == 13 || i == 18 || i == 23;
+                if (dash ? value[i] != '-' : !isHexDigit(value[i])) return false;
+            }
+            return true;
+        }
+
+        constexpr bool isSlug(std::string_view value) {
+            if (value.empty()) return false;
+            for (char c: value) {
+                const bool letter = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+                if (!letter && !isDigit(c) && c != '-' && c != '_') return false;
+            }
+            return true;
+        }
+
+        inline const param_constraint integer{R"(-?[0-9]+)", "Must be an integer", ParamKind::INT};
+        inline const param_constraint unsigned_integer{R"([0-9]+)", "Must be a non-negative integer", ParamKind::UINT};
+        inline const param_constraint uuid{R"([0-9a-fA-F]{8}-[0-9a-fA-F]{4}-[0-9a-fA-F]{4}-[0-9a-fA-F]{4}-[0-9a-fA-F]{12})",
+                                           "Must be a valid UUID", ParamKind::UUID};
+        inline const param_constraint hex{R"([0-9a-fA-F]+)", "Must be hexadecimal", ParamKind::HEX};
+        inline const param_constraint slug{R"([-a-zA-Z0-9_]+)", "Must be a slug", ParamKind::SLUG};
+
+        /**
+         * @brief A parameter equal to one of @p literals.
+         */
+        param_constraint one_of(std::initializer_list<std::string_view> literals);
+
+        /**
+         * @brief A parameter of @p min_length to @p max_length characters.
+         */
+        param_constraint length(size_t min_length, size_t max_length);
+
+        /**
+         * @brief The constraint a path pattern names after the colon, as in {id:int}: int, uint, uuid, hex or
+         *        slug; nullptr for anything else, which is a regex.
+         */
+        const param_constraint *named(std::string_view type);
+    }// namespace constraints
+
+    /**
+     * @brief A param_constraint prepared for matching: the native check it selects, std::regex only when the
+     *        pattern has none.
+     */
+    class ParamMatcher {
+    public:
+        ParamMatcher() = default;
+
+        explicit ParamMatcher(const param_constraint &constraint);
+
+        bool operator()(std::string_view segment) const {
+            switch (this->kind_) {
+                case ParamKind::ANY:
+                    return !segment.empty();
+                case ParamKind::INT:
+                    return constraints::isInt(segment);
+                case ParamKind::UINT:
+                    return constraints::isUint(segment);
+                case ParamKind::UUID:
+                    return constraints::isUuid(segment);
+                case ParamKind::HEX:
+                    return constraints::isHex(segment);
+                case ParamKind::SLUG:
+                    return constraints::isSlug(segment);
+                case ParamKind::ONE_OF:
+                    return this->isLiteral(segment);
+                case ParamKind::LENGTH:
+                    return segment.size() >= this->min_length_ && segment.size() <= this->max_length_;
+                case ParamKind::REGEX:
+                    break;
+            }
+            return this->regex_ && std::regex_match(segment.begin(), segment.end(), *this->regex_);
+        }
+
+        ParamKind kind() const { return this->kind_; }
+
+    private:
+        bool isLiteral(std::string_view segment) const;
+
+        ParamKind kind_{ParamKind::ANY};
+        std::vector<std::string> literals_;///< Sorted.
+        size_t min_length_{0};
+        size_t max_length_{SIZE_MAX};
+        std::optional<std::regex> regex_;
+    };
+
+}// namespace usub::server::protocols::http
@@ -1,4 +1,6 @@
 #pragma once
+#include <algorithm>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <optional>
@@ -6,10 +8,12 @@
 #include <set>
 #include <stack>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
 
+#include "Protocols/HTTP/ParamConstraints.h"
 #include "Protocols/HTTP/RouterCommon.h"
 
 namespace usub::server::protocols::http {
@@ -17,17 +21,16 @@ namespace usub::server::protocols::http {
 
     struct ParamEdge;
 
-    struct param_constraint {
-        std::string pattern;
-        std::string description;
-    };
-    const param_constraint default_constraint{
-            R"([^/]+)",
-            "Encountered an error..."};
     const std::unordered_map<std::string_view, const param_constraint *> no_constraints{};
 
+    /// Lets string-keyed maps be searched with a std::string_view without building a key.
+    struct TransparentStringHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view key) const { return std::hash<std::string_view>{}(key); }
+    };
+
     struct RadixNode {
-        std::unordered_map<std::string, std::unique_ptr<RadixNode>> literal;// литеральные дети
+        std::unordered_map<std::string, std::unique_ptr<RadixNode>, TransparentStringHash, std::equal_to<>> literal;// литеральные дети
         std::vector<ParamEdge> param;                                       // регексовые
         std::unique_ptr<RadixNode> wildcard;                                // *
         std::string wildcard_name;                                          // имя
@@ -37,7 +40,7 @@ namespace usub::server::protocols::http {
 
     struct ParamEdge {
         std::string name;               // имя параметра (id:)
-        std::optional<std::regex> regex;// пусто -> [^/]+
+        ParamMatcher matcher;           // нативная проверка, regex только для прочих паттернов
         std::unique_ptr<RadixNode> child;
         std::optional<param_constraint> constraint;
     };
@@ -64,6 +67,17 @@ namespace usub::server::protocols::http {
 
         std::optional<std::pair<Route *, bool>> match(Request &request, std::string *error_description = nullptr);
 
+        /**
+         * @brief Packs the route tree into flat arrays that match() walks without allocating.
+         *
+         * Each node's literal edges become a sorted slice searched by binary search, and the path is walked in
+         * place. The server freezes its router before it starts; adding a route afterwards unfreezes it until
+         * the next call.
+         */
+        void freeze();
+
+        bool frozen() const { return this->frozen_; }
+
         MiddlewareChain &addMiddleware(MiddlewarePhase phase, std::function<MiddlewareFunctionType> middleware);
 
         MiddlewareChain &getMiddlewareChain();
@@ -75,7 +89,34 @@ namespace usub::server::protocols::http {
         std::string dump() const;
 
     private:
+        static constexpr uint32_t NO_NODE = UINT32_MAX;
+
+        struct FlatNode {
+            uint32_t literals_begin{0};
+            uint32_t literals_end{0};
+            uint32_t params_begin{0};
+            uint32_t params_end{0};
+            uint32_t wildcard{NO_NODE};
+            std::string_view wildcard_name;
+            Route *route{nullptr};
+            bool trailing_slash{false};
+        };
+
+        struct FlatLiteral {
+            std::string_view label;
+            uint32_t child;
+        };
+
+        struct FlatParam {
+            const ParamEdge *edge;
+            uint32_t child;
+        };
+
         std::unique_ptr<RadixNode> root_;
+        bool frozen_{false};
+        std::vector<FlatNode> nodes_;      ///< Root first.
+        std::vector<FlatLiteral> literals_;///< Per node, sorted by label.
+        std::vector<FlatParam> params_;
         std::vector<Route> routes_;
         std::unordered_map<std::string, std::function<FunctionType>> error_page_handlers_;
         MiddlewareChain middleware_chain_;
@@ -99,26 +140,27 @@ namespace usub::server::protocols::http {
 
         bool containsCapturingGroup(const std::string &regex) const;
 
-        std::vector<std::string> splitPath(const std::string &path);
-
         std::vector<Segment> parseSegments(const std::string &pattern, std::vector<std::string> &param_names) const;
 
         void applyConstraints(std::vector<Segment> &segs, const std::unordered_map<std::string_view, const param_constraint *> &constraints);
 
         void insert(RadixNode *node, const std::vector<Segment> &segs, std::size_t idx, std::unique_ptr<Route> &route, bool has_trailing_slash);
 
+        uint32_t flatten(const RadixNode *node);
+
         bool matchDFS(RadixNode *node,
-                      const std::vector<std::string> &segs,
-                      std::size_t idx,
+                      std::string_view path,
+                      std::size_t pos,
                       Request &req,
                       Route *&out,
                       std::string *last_error);
 
-        bool matchIter(RadixNode *node,
-                       const std::vector<std::string> &segs,
+        bool matchFlat(uint32_t node,
+                       std::string_view path,
+                       std::size_t pos,
                        Request &req,
                        Route *&out,
-                       std::string *last_error = nullptr);
+                       std::string *last_error) const;
 
         void printNode(const RadixNode *node,
                        std::ostringstream &buf,
@@ -0,0 +1,115 @@
+#pragma once
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace usub::server::protocols::http {
+
+    /**
+     * @class RouteAutomaton
+     * @brief All regex route patterns compiled into one automaton, matched in a single pass over the path.
+     *
+     * Every pattern becomes a branch of one NFA program. compile() turns the program into a DFA over byte
+     * classes, so matching a path is one table lookup per byte and tells which patterns match the whole path;
+     * the captures of the chosen one are then read by a Pike VM run over that pattern alone. When the DFA would
+     * take more than MAX_DFA_STATES states, the NFA is simulated directly instead.
+     *
+     * Patterns use the ECMAScript subset routes need: literals, '.', classes, the \\d \\w \\s escapes, groups,
+     * alternation and greedy or lazy quantifiers, with '^' and '$' only at the ends. add() refuses anything
+     * else (backreferences, lookarounds, \\b) so the caller can keep std::regex for that pattern.
+     *
+     * Matching does not change the automaton and can run on several threads at once.
+     */
+    class RouteAutomaton {
+    public:
+        static constexpr size_t MAX_DFA_STATES = 4096;
+        static constexpr size_t NO_OFFSET = SIZE_MAX;
+
+        /**
+         * @brief Adds @p pattern as pattern number @p id; ids must increase with every call.
+         *
+         * @return false when the pattern uses syntax the automaton does not support; nothing is added then.
+         */
+        bool add(std::string_view pattern, uint32_t id);
+
+        /**
+         * @brief Builds the DFA; patterns added afterwards need another call.
+         */
+        void compile();
+
+        /**
+         * @brief Ids of the patterns matching all of @p input, in increasing order.
+         *
+         * The span is valid until the next call on the same thread.
+         */
+        std::span<const uint32_t> matches(std::string_view input) const;
+
+        /**
+         * @brief Start and end offsets of the capturing groups of pattern @p id in @p input, two per group;
+         *        NO_OFFSET for a group that took no part in the match.
+         *
+         * Groups get the offsets std::regex_match would give them. @p offsets is valid until the next call on
+         * the same thread.
+         *
+         * @return false when the pattern does not match @p input.
+         */
+        bool captures(uint32_t id, std::string_view input, std::span<const size_t> &offsets) const;
+
+        /**
+         * @brief Capturing groups of pattern @p id.
+         */
+        size_t groups(uint32_t id) const;
+
+        bool empty() const { return this->patterns_.empty(); }
+        bool hasDfa() const { return !this->dfa_.empty(); }
+        size_t dfaStates() const { return this->accepts_.size(); }
+
+    private:
+        struct Inst {
+            enum Op : uint8_t {
+                BYTE, ///< Consumes a byte of set @p arg.
+                SPLIT,///< Continues at @p out, then at @p out1.
+                SAVE, ///< Records the position in capture slot @p arg.
+                MATCH,///< Pattern @p arg matched.
+            } op;
+            uint32_t out{0};
+            uint32_t out1{0};
+            uint32_t arg{0};
+        };
+
+        struct Pattern {
+            uint32_t id;
+            uint32_t start;///< First instruction.
+            size_t groups;
+        };
+
+        struct Node;
+        class Parser;
+
+        uint32_t addSet(const std::bitset<256> &set);
+        uint32_t emit(Inst inst);
+        uint32_t emit(const Node &node, uint32_t next);
+        const Pattern *find(uint32_t id) const;
+
+        /// Adds the BYTE and MATCH instructions reachable from @p pc to @p states, once each.
+        void closure(uint32_t pc, std::vector<uint32_t> &states, std::vector<uint32_t> &marks, uint32_t mark) const;
+
+        std::span<const uint32_t> simulate(std::string_view input) const;
+
+        std::vector<Inst> program_;
+        std::vector<std::bitset<256>> sets_;
+        std::unordered_map<std::bitset<256>, uint32_t> set_index_;
+        std::vector<Pattern> patterns_;
+
+        std::vector<uint8_t> classes_;   ///< Byte to byte class; bytes of one class are in the same sets.
+        size_t class_count_{0};
+        std::vector<int32_t> dfa_;       ///< State * class_count_ + class to the next state, -1 for none.
+        std::vector<std::vector<uint32_t>> accepts_;///< Patterns a state matches, in increasing order.
+    };
+
+}// namespace usub::server::protocols::http
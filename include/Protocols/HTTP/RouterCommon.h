@@ -6,6 +6,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "Protocols/HTTP/Methods.h"
 #include "Protocols/HTTP/Middlewares.h"
 
 namespace usub::server::protocols::http {
@@ -43,9 +44,9 @@ namespace usub::server::protocols::http {
         bool accept_all_methods{};
 
         /**
-         * @brief Set of allowed HTTP method tokens (e.g., GET, POST) for this route.
+         * @brief Set of allowed HTTP methods (e.g., GET, POST) for this route; every method when `accept_all_methods` is set.
          */
-        std::set<std::string> allowed_method_tokenns{};
+        MethodSet allowed_methods{};
 
         /**
          * @brief Regular expression used to match the request path.
@@ -74,6 +75,21 @@ namespace usub::server::protocols::http {
          */
         std::function<FunctionType> handler{};
 
+        /**
+         * @brief Handler called directly instead of `handler`, for routes whose handler is known at compile time.
+         *
+         * @see StaticRouter
+         */
+        FunctionType *function{};
+
+        /**
+         * @brief Whether requests arriving as TLS 1.3 early data (0-RTT) are handled before the handshake completes.
+         *
+         * Early data can be replayed by an attacker, so only routes whose requests are safe to run twice
+         * (typically idempotent GETs) should opt in. Other requests wait for the handshake to complete.
+         */
+        bool accept_early_data{};
+
         /**
          * @brief Constructs a `Route` with the specified parameters.
          *
@@ -92,6 +108,21 @@ namespace usub::server::protocols::http {
               std::function<FunctionType> handler,
               bool accept_all = false);
 
+        /**
+         * @brief Constructs a `Route` from already interned methods.
+         *
+         * @param methods Allowed HTTP methods.
+         * @param regex Regular expression to match the request path.
+         * @param params Vector of parameter names extracted from the path pattern.
+         * @param handler Handler function to process matched requests.
+         * @param accept_all Whether the route accepts all method tokens.
+         */
+        Route(MethodSet methods,
+              const std::regex regex,
+              const std::vector<std::string> &params,
+              std::function<FunctionType> handler,
+              bool accept_all = false);
+
         /**
          * @brief Default constructor.
          *
@@ -110,5 +141,27 @@ namespace usub::server::protocols::http {
          * @see MiddlewareFunctionType
          */
         Route &addMiddleware(MiddlewarePhase phase, std::function<MiddlewareFunctionType> middleware);
+
+        /**
+         * @brief Lets requests for this route be handled from TLS 1.3 early data.
+         *
+         * @param accept Whether early data is accepted.
+         * @return Route& Reference to the current `Route` object for chaining.
+         *
+         * @see accept_early_data
+         */
+        Route &acceptEarlyData(bool accept = true);
+
+        /**
+         * @brief Whether the route accepts @p method.
+         */
+        bool allows(Method method) const { return this->allowed_methods.contains(method); }
+
+        /**
+         * @brief Calls the route's handler.
+         */
+        uvent::task::Awaitable<void> invoke(Request &request, Response &response) const {
+            return this->function ? this->function(request, response) : this->handler(request, response);
+        }
     };
 }// namespace usub::server::protocols::http
@@ -0,0 +1,324 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Protocols/HTTP/Message.h"
+#include "Protocols/HTTP/ParamConstraints.h"
+#include "Protocols/HTTP/RouterCommon.h"
+
+namespace usub::server::protocols::http {
+
+    /**
+     * @brief A string literal usable as a template argument.
+     */
+    template<size_t N>
+    struct FixedString {
+        char value[N]{};
+
+        constexpr FixedString(const char (&str)[N]) { std::copy_n(str, N, this->value); }
+
+        constexpr std::string_view view() const { return {this->value, N - 1}; }
+    };
+
+    namespace static_routing {
+        /// Position of @p c in @p text from @p from, the size when missing; a plain loop that every compiler can
+        /// evaluate on template argument strings.
+        constexpr size_t find(std::string_view text, char c, size_t from = 0) {
+            while (from < text.size() && text[from] != c) ++from;
+            return std::min(from, text.size());
+        }
+
+        enum class SegmentKind : uint8_t {
+            LITERAL,
+            PARAM,
+            WILDCARD,
+        };
+
+        struct Segment {
+            SegmentKind kind{SegmentKind::LITERAL};
+            std::string_view text;///< The literal, or the parameter name.
+            ParamKind type{ParamKind::ANY};
+        };
+
+        /**
+         * @brief Reads the next non-empty segment of @p path at @p pos into @p segment and moves @p pos past it.
+         */
+        constexpr bool nextSegment(std::string_view path, size_t &pos, std::string_view &segment) {
+            while (pos < path.size() && path[pos] == '/') ++pos;
+            if (pos == path.size()) return false;
+            const size_t end = find(path, '/', pos);
+            segment = path.substr(pos, end - pos);
+            pos = end;
+            return true;
+        }
+
+        constexpr size_t countSegments(std::string_view pattern) {
+            size_t count = 0;
+            size_t pos = 0;
+            std::string_view segment;
+            while (nextSegment(pattern, pos, segment)) ++count;
+            return count;
+        }
+
+        constexpr ParamKind typeOf(std::string_view type) {
+            if (type.empty()) return ParamKind::ANY;
+            if (type == "int") return ParamKind::INT;
+            if (type == "uint") return ParamKind::UINT;
+            if (type == "uuid") return ParamKind::UUID;
+            if (type == "hex") return ParamKind::HEX;
+            if (type == "slug") return ParamKind::SLUG;
+            throw std::invalid_argument("Static routes take int, uint, uuid, hex or slug parameters, regexes need RadixRouter");
+        }
+
+        template<size_t N>
+        struct ParsedPath {
+            std::array<Segment, N> segments{};
+            bool trailing_slash{false};
+            bool wildcard{false};
+        };
+
+        /**
+         * @brief Splits a pattern such as "/users/{id:int}/files", optionally ending in a `*` wildcard segment,
+         *        into segments, at compile time.
+         */
+        template<size_t N>
+        constexpr ParsedPath<N> parsePath(std::string_view pattern) {
+            ParsedPath<N> parsed;
+            parsed.trailing_slash = !pattern.empty() && pattern.back() == '/';
+            size_t pos = 0;
+            std::string_view text;
+            for (size_t i = 0; nextSegment(pattern, pos, text); ++i) {
+                Segment &segment = parsed.segments[i];
+                if (parsed.wildcard) throw std::invalid_argument("'*' has to be the last segment of a static route");
+                if (text == "*") {
+                    segment.kind = SegmentKind::WILDCARD;
+                    segment.text = "*";
+                    parsed.wildcard = true;
+                } else if (text.size() >= 2 && text.front() == '{' && text.back() == '}') {
+                    const std::string_view body = text.substr(1, text.size() - 2);
+                    const size_t colon = find(body, ':');
+                    segment.kind = SegmentKind::PARAM;
+                    segment.text = body.substr(0, colon);
+                    segment.type = typeOf(body.substr(std::min(colon + 1, body.size())));
+                    if (segment.text.empty()) throw std::invalid_argument("Empty parameter name in static route");
+                } else {
+                    if (find(text, '{') != text.size() || find(text, '}') != text.size()) throw std::invalid_argument("Parameters must take a whole segment");
+                    segment.text = text;
+                }
+            }
+            return parsed;
+        }
+
+        template<ParamKind Type>
+        constexpr bool accepts(std::string_view segment) {
+            if constexpr (Type == ParamKind::INT) return constraints::isInt(segment);
+            else if constexpr (Type == ParamKind::UINT) return constraints::isUint(segment);
+            else if constexpr (Type == ParamKind::UUID) return constraints::isUuid(segment);
+            else if constexpr (Type == ParamKind::HEX) return constraints::isHex(segment);
+            else if constexpr (Type == ParamKind::SLUG) return constraints::isSlug(segment);
+            else return true;// segments are never empty
+        }
+    }// namespace static_routing
+
+    /**
+     * @brief A route of a StaticRouter: the methods ("GET", "GET,HEAD" or "*"), the path pattern and the handler.
+     *
+     * Patterns are those of RadixRouter without regexes: literal segments, {name} for any segment, {name:type}
+     * with a type of int, uint, uuid, hex or slug, and a final '*' taking the rest of the path.
+     */
+    template<FixedString Methods, FixedString Path, auto Function>
+    struct StaticRoute {
+        static_assert(std::is_convertible_v<decltype(Function), FunctionType *>,
+                      "A static route handler must be a function Awaitable<void>(Request &, Response &)");
+
+        static constexpr std::string_view methods = Methods.view();
+        static constexpr std::string_view path = Path.view();
+        static constexpr bool all_methods = methods == "*";
+        static constexpr MethodSet allowed_methods = all_methods ? MethodSet::all() : MethodSet::parse(methods);
+        static constexpr FunctionType *function = Function;
+        static constexpr auto parsed = static_routing::parsePath<static_routing::countSegments(Path.view())>(Path.view());
+
+        /**
+         * @brief Matches @p url, appending the parameters to @p params; they are partly appended on a mismatch.
+         */
+        static bool matchPath(std::string_view url, UriParams &params) {
+            size_t pos = 0;
+            return matchSegments(url, pos, params, std::make_index_sequence<parsed.segments.size()>{});
+        }
+
+    private:
+        template<size_t... Is>
+        static bool matchSegments(std::string_view url, size_t &pos, UriParams &params, std::index_sequence<Is...>) {
+            if (!(matchSegment<Is>(url, pos, params) && ...)) return false;
+            if constexpr (parsed.wildcard) {
+                return true;// a wildcard ignores the trailing slash
+            } else {
+                std::string_view rest;
+                if (static_routing::nextSegment(url, pos, rest)) return false;
+                return parsed.trailing_slash == (!url.empty() && url.back() == '/');
+            }
+        }
+
+        template<size_t I>
+        static bool matchSegment(std::string_view url, size_t &pos, UriParams &params) {
+            constexpr static_routing::Segment segment = parsed.segments[I];
+            std::string_view current;
+            if (!static_routing::nextSegment(url, pos, current)) return false;
+
+            if constexpr (segment.kind == static_routing::SegmentKind::LITERAL) {
+                return current == segment.text;
+            } else if constexpr (segment.kind == static_routing::SegmentKind::PARAM) {
+                if (!static_routing::accepts<segment.type>(current)) return false;
+                params.push(segment.text, current);
+                return true;
+            } else {
+                std::string_view tail = url.substr(current.data() - url.data());
+                while (!tail.empty() && tail.back() == '/') tail.remove_suffix(1);
+                params.push(segment.text, tail);
+                pos = url.size();
+                return true;
+            }
+        }
+    };
+
+    /**
+     * @class StaticRouter
+     * @brief A router whose routes are fixed at compile time, usable as the RouterType of ServerImpl.
+     *
+     * @code
+     * using Router = StaticRouter<StaticRoute<"GET", "/users/{id:int}", &getUser>,
+     *                             StaticRoute<"GET,HEAD", "/static/{name:slug}", &serveFile>>;
+     * usub::server::ServerImpl<Router, PlainHTTPStreamHandler> server("config.toml");
+     * @endcode
+     *
+     * Every route is matched by code generated for its pattern: literal comparisons and typed parameter checks
+     * unrolled segment by segment, with no route structure to walk at runtime. Routes are tried in the order
+     * given and the first one matching the path and the method wins. Handlers are called through a plain
+     * function pointer. Middlewares are added as with the other routers, per route through route().
+     */
+    template<class... Routes>
+    class StaticRouter {
+    public:
+        StaticRouter() : routes_{makeRoute<Routes>()...} {}
+
+        /**
+         * @brief Matches @p request as the other routers do; no error description is produced.
+         */
+        std::optional<std::pair<Route *, bool>> match(Request &request,
+                                                      [[maybe_unused]] std::string *error_description = nullptr) {
+            const std::string_view url = request.getURL();
+            const Method method = request.getMethod();
+            request.uri_params.clear();
+
+            Route *path_match = nullptr;
+            std::optional<std::pair<Route *, bool>> result;
+            this->matchRoutes(url, method, request.uri_params, path_match, result, std::index_sequence_for<Routes...>{});
+            if (result) return result;
+            if (path_match) return std::make_pair(path_match, false);// Route found but method not allowed
+            return std::nullopt;
+        }
+
+        /**
+         * @brief The route at @p I in the list, to add middlewares to.
+         */
+        template<size_t I>
+        Route &route() {
+            static_assert(I < sizeof...(Routes), "No such static route");
+            return this->routes_[I];
+        }
+
+        /**
+         * @brief The first route with the pattern @p Path, to add middlewares to.
+         */
+        template<FixedString Path>
+        Route &route() {
+            constexpr size_t index = indexOf(Path.view());
+            static_assert(index < sizeof...(Routes), "No static route with this path");
+            return this->routes_[index];
+        }
+
+        MiddlewareChain &addMiddleware(MiddlewarePhase phase, std::function<MiddlewareFunctionType> middleware) {
+            if (phase == MiddlewarePhase::HEADER) {
+                this->middleware_chain_.addMiddleware(phase, std::move(middleware));
+            } else {
+                std::cerr << "Non header global middlewares are not supported yet" << std::endl;
+            }
+            return this->middleware_chain_;
+        }
+
+        MiddlewareChain &getMiddlewareChain() { return this->middleware_chain_; }
+
+        void addErrorHandler(const std::string &error_code, std::function<FunctionType> function) {
+            this->error_page_handlers_.emplace(error_code, std::move(function));
+        }
+
+        void executeErrorChain(Request &request, Response &response) {
+            if (this->error_page_handlers_.contains("Log")) {
+                this->error_page_handlers_.at("Log")(request, response);
+            }
+            std::string error = std::to_string((uint16_t) request.getState());
+            if (this->error_page_handlers_.contains(error)) {
+                this->error_page_handlers_.at(error)(request, response);
+            }
+        }
+
+    private:
+        template<class R>
+        static Route makeRoute() {
+            std::vector<std::string> param_names;
+            for (const static_routing::Segment &segment: R::parsed.segments) {
+                if (segment.kind != static_routing::SegmentKind::LITERAL) param_names.emplace_back(segment.text);
+            }
+            Route route(R::allowed_methods, std::regex{}, param_names, nullptr, R::all_methods);
+            route.function = R::function;
+            return route;
+        }
+
+        static constexpr size_t indexOf(std::string_view path) {
+            constexpr std::array<std::string_view, sizeof...(Routes)> paths{Routes::path...};
+            for (size_t i = 0; i < paths.size(); ++i) {
+                if (paths[i] == path) return i;
+            }
+            return paths.size();
+        }
+
+        template<size_t... Is>
+        void matchRoutes(std::string_view url, Method method, UriParams &params, Route *&path_match,
+                         std::optional<std::pair<Route *, bool>> &result, std::index_sequence<Is...>) {
+            (this->tryRoute<Routes, Is>(url, method, params, path_match, result) || ...);
+        }
+
+        template<class R, size_t I>
+        bool tryRoute(std::string_view url, Method method, UriParams &params, Route *&path_match,
+                      std::optional<std::pair<Route *, bool>> &result) {
+            if (!R::matchPath(url, params)) {
+                params.clear();
+                return false;
+            }
+            if (R::allowed_methods.contains(method)) {
+                result = std::make_pair(&this->routes_[I], true);
+                return true;
+            }
+            if (!path_match) path_match = &this->routes_[I];
+            params.clear();
+            return false;
+        }
+
+        std::array<Route, sizeof...(Routes)> routes_;
+        std::unordered_map<std::string, std::function<FunctionType>> error_page_handlers_;
+        MiddlewareChain middleware_chain_;
+    };
+
+}// namespace usub::server::protocols::http
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace usub::server::protocols::http {
+
+    /**
+     * @class UriParams
+     * @brief Parameters a route captured from the request path, in path order.
+     *
+     * Names are views into the route and values views into the request URL, so matching a route copies no
+     * strings; the views are valid until the URL is changed or the request is cleared. Up to INLINE_CAPACITY
+     * parameters are kept without allocating. A name captured twice resolves to its last value.
+     */
+    class UriParams {
+    public:
+        using value_type = std::pair<std::string_view, std::string_view>;
+        using const_iterator = const value_type *;
+
+        static constexpr size_t INLINE_CAPACITY = 8;
+
+        /**
+         * @brief Appends a parameter.
+         */
+        void push(std::string_view name, std::string_view value) {
+            if (!this->spilled_ && this->size_ == INLINE_CAPACITY) {
+                this->overflow_.assign(this->inline_.begin(), this->inline_.end());
+                this->spilled_ = true;
+            }
+            if (this->spilled_) {
+                this->overflow_.emplace_back(name, value);
+            } else {
+                this->inline_[this->size_] = {name, value};
+            }
+            ++this->size_;
+        }
+
+        /**
+         * @brief Drops the parameters pushed after the first @p size, for a router backtracking.
+         */
+        void truncate(size_t size) {
+            if (size >= this->size_) return;
+            if (this->spilled_) this->overflow_.resize(size);
+            this->size_ = size;
+        }
+
+        void clear() {
+            this->overflow_.clear();
+            this->spilled_ = false;
+            this->size_ = 0;
+        }
+
+        /**
+         * @brief The parameter named @p name, nullptr when the route has none.
+         */
+        const value_type *find(std::string_view name) const {
+            for (size_t i = this->size_; i > 0; --i) {
+                if (this->data()[i - 1].first == name) return &this->data()[i - 1];
+            }
+            return nullptr;
+        }
+
+        bool contains(std::string_view name) const { return this->find(name) != nullptr; }
+
+        /**
+         * @brief The value of @p name, empty when the route has no such parameter.
+         */
+        std::string_view operator[](std::string_view name) const {
+            const value_type *param = this->find(name);
+            return param ? param->second : std::string_view{};
+        }
+
+        /**
+         * @brief The value of @p name.
+         *
+         * @throws std::out_of_range when the route has no such parameter.
+         */
+        std::string_view at(std::string_view name) const {
+            const value_type *param = this->find(name);
+            if (!param) throw std::out_of_range("No uri parameter: " + std::string(name));
+            return param->second;
+        }
+
+        size_t size() const { return this->size_; }
+        bool empty() const { return this->size_ == 0; }
+
+        const_iterator begin() const { return this->data(); }
+        const_iterator end() const { return this->data() + this->size_; }
+
+    private:
+        const value_type *data() const { return this->spilled_ ? this->overflow_.data() : this->inline_.data(); }
+
+        std::array<value_type, INLINE_CAPACITY> inline_{};
+        std::vector<value_type> overflow_;
+        size_t size_{0};
+        bool spilled_{false};
+    };
+
+}// namespace usub::server::protocols::http
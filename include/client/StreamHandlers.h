@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
 #include <expected>
@@ -13,6 +14,11 @@
 #include <uvent/tasks/Awaitable.h>
 #include <uvent/utils/buffer/DynamicBuffer.h>
 
+#ifdef USE_OPEN_SSL
+#include "server/BufferPool.h"
+#include "utils/ssl/SocketBIO.h"
+#endif// USE_OPEN_SSL
+
 namespace usub::client {
 
     static constexpr std::size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
@@ -127,6 +133,7 @@ namespace usub::client {
 
         SSL_CTX *ctx_{nullptr};
         SSL *ssl_{nullptr};
+        usub::server::net::BufferLease input_;///< Ciphertext lent to the socket BIO until it asks for more.
 
         bool shutdown_called_{false};
 
@@ -157,11 +164,8 @@ namespace usub::client {
                 co_return std::unexpected(make_err(HttpClientError::TlsSslCreateFailed, "SSL_new failed: " + openssl_last_error_string()));
             }
 
-            BIO *rbio = BIO_new(BIO_s_mem());
-            BIO *wbio = BIO_new(BIO_s_mem());
-            if (!rbio || !wbio) {
-                if (rbio) BIO_free(rbio);
-                if (wbio) BIO_free(wbio);
+            BIO *bio = usub::utils::ssl::create_socket_bio(get_fd());
+            if (!bio) {
                 SSL_free(ssl_);
                 SSL_CTX_free(ctx_);
                 ssl_ = nullptr;
@@ -169,7 +173,7 @@ namespace usub::client {
                 co_return std::unexpected(make_err(HttpClientError::TlsBioCreateFailed, "BIO_new failed"));
             }
 
-            SSL_set_bio(ssl_, rbio, wbio);
+            SSL_set_bio(ssl_, bio, bio);
             SSL_set_connect_state(ssl_);
 
             if (!host_.empty()) (void) SSL_set_tlsext_host_name(ssl_, host_.c_str());
@@ -320,22 +324,16 @@ namespace usub::client {
         usub::uvent::task::Awaitable<HttpExpected<void>> flush_wbio() {
             if (!ssl_) co_return std::unexpected(make_err(HttpClientError::InternalError, "flush_wbio: ssl null"));
 
-            BIO *wbio = SSL_get_wbio(ssl_);
-            if (!wbio) co_return {};
-
-            std::vector<uint8_t> tmp(CHUNK);
-
-            for (;;) {
-                const size_t pending = BIO_ctrl_pending(wbio);
-                if (pending == 0) break;
-
-                const int to_read = (pending < CHUNK) ? static_cast<int>(pending) : static_cast<int>(CHUNK);
-                const int n = BIO_read(wbio, tmp.data(), to_read);
-                if (n <= 0) break;
-
-                const ssize_t wr = co_await socket_.async_write(tmp.data(), static_cast<std::size_t>(n));
+            // only what the socket BIO could not send directly is left here
+            std::string &output = usub::utils::ssl::socket_bio_output(SSL_get_wbio(ssl_));
+            std::size_t sent = 0;
+            while (sent < output.size()) {
+                auto *data = reinterpret_cast<uint8_t *>(output.data()) + sent;
+                const ssize_t wr = co_await socket_.async_write(data, output.size() - sent);
                 if (wr <= 0) co_return std::unexpected(make_err(HttpClientError::WriteFailed, "tls flush_wbio socket write failed"));
+                sent += static_cast<std::size_t>(wr);
             }
+            output.clear();
 
             co_return {};
         }
@@ -343,21 +341,19 @@ namespace usub::client {
         usub::uvent::task::Awaitable<HttpExpected<void>> read_into_rbio(std::size_t max_chunk) {
             if (!ssl_) co_return std::unexpected(make_err(HttpClientError::InternalError, "read_into_rbio: ssl null"));
 
-            usub::uvent::utils::DynamicBuffer buf;
-            buf.reserve(max_chunk);
+            // OpenSSL asked for more, so it has consumed what it was lent before
+            if (!input_) input_ = usub::server::net::BufferPool::local().acquire(max_chunk);
+            auto &buf = input_.buffer();
             buf.clear();
 
-            const ssize_t rd = co_await socket_.async_read(buf, max_chunk);
+            const ssize_t rd = co_await socket_.async_read(buf, std::min(max_chunk, input_.capacity()));
             if (rd < 0) co_return std::unexpected(make_err(HttpClientError::ReadFailed, "tls read_into_rbio socket read failed"));
             if (rd == 0) co_return std::unexpected(make_err(HttpClientError::ReadFailed, "tls read_into_rbio eof"));
 
             BIO *rbio = SSL_get_rbio(ssl_);
             if (!rbio) co_return std::unexpected(make_err(HttpClientError::InternalError, "tls read_into_rbio: no rbio"));
 
-            const int written = BIO_write(rbio, buf.data(), static_cast<int>(rd));
-            if (written <= 0)
-                co_return std::unexpected(make_err(HttpClientError::ReadFailed, "BIO_write(rbio) failed: " + openssl_last_error_string()));
-
+            usub::utils::ssl::socket_bio_set_input(rbio, reinterpret_cast<const char *>(buf.data()), static_cast<std::size_t>(rd));
             co_return {};
         }
     };
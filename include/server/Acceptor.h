@@ -1,7 +1,13 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <coroutine>
+#include <iostream>
 #include <memory>
+#include <memory_resource>
+#include <system_error>
 
 #include <utils/configuration/ConfigReader.h>
 #include <uvent/Uvent.h>
@@ -11,9 +17,23 @@
 
 #include "Protocols/HTTP/EndpointHandler.h"
 #include "Protocols/HTTP/HTTP1.h"
+#include "Protocols/HTTP/HTTP2.h"
 #include "Protocols/HTTP/Message.h"
+#include "server/BufferPool.h"
+#include "server/ListenSocket.h"
+#include "server/SendFile.h"
+#include "server/TimerWheel.h"
+#include "server/VectoredWrite.h"
 
+/// Largest single read of a connection, the biggest net::BufferPool size class.
 static constexpr std::size_t MAX_READ_SIZE = 64 * 1024;
+static_assert(usub::server::net::BufferPool::SIZE_CLASSES.back() == MAX_READ_SIZE);
+/// Upper bound of pipelined requests answered with one coalesced write, later ones wait for the next batch.
+static constexpr std::size_t MAX_PIPELINE_DEPTH = 16;
+#if defined(UNET_CONNECTION_ARENA) && UNET_CONNECTION_ARENA
+/// Inline block of the per-connection arena, enough for the header and query maps of a typical request batch.
+static constexpr std::size_t CONNECTION_ARENA_SIZE = 16 * 1024;
+#endif
 
 
 namespace usub::server {
@@ -27,87 +47,336 @@ namespace usub::server {
         PlainHTTPStreamHandler(std::shared_ptr<RouterType> router)
             : endpoint_handler_(std::move(router)) {}
 
+        void setTimeouts(const configuration::ConnectionTimeouts &timeouts) {
+            this->timeouts_ = timeouts;
+        }
+
+        void setHTTP2(const configuration::HTTP2Config &config) {
+            this->http2_ = config;
+        }
+
         usub::uvent::task::Awaitable<void>
         clientCoroutine(usub::uvent::net::TCPClientSocket socket)//co_spawn(handle(socket))
         {
 #ifdef UVENT_DEBUG
             spdlog::info("Entered {}: {}", __PRETTY_FUNCTION__, static_cast<void *>(this));
 #endif
-            protocols::http::HTTP1 http1{endpoint_handler_};
-
-            auto &request = http1.getRequest();
-            auto &response = http1.getResponse();
-            auto &request_headers = request.getHeaders();
-            auto &response_headers = response.getHeaders();
-
-            usub::uvent::utils::DynamicBuffer buffer;
-            buffer.reserve(MAX_READ_SIZE);
+            using HTTP1Type = protocols::http::HTTP1<RouterType>;
+
+#if defined(UNET_CONNECTION_ARENA) && UNET_CONNECTION_ARENA
+            // Request/response maps of this connection are carved out of one arena and dropped wholesale
+            // whenever no request is half-parsed, instead of freeing every node at the end of each request.
+            // The exchange's own strings (method, path, body) are not: exchanges are recycled and keep their
+            // capacity, so they stop allocating once the connection has seen its largest request. Headers and
+            // query parameters a handler moves or copies out are rebuilt on the default resource.
+            // Declared before the pipeline so it outlives the exchanges allocating from it.
+            std::array<std::byte, CONNECTION_ARENA_SIZE> arena_block;
+            std::pmr::monotonic_buffer_resource arena{arena_block.data(), arena_block.size()};
+#endif
+            // One HTTP1 exchange per pipelined request. pipeline[0] is always the oldest unanswered one,
+            // finished exchanges are recycled to the back once their responses are written.
+            std::vector<std::unique_ptr<HTTP1Type>> pipeline;
+#if defined(UNET_CONNECTION_ARENA) && UNET_CONNECTION_ARENA
+            auto make_exchange = [&]() {
+                auto http1 = std::make_unique<HTTP1Type>(endpoint_handler_);
+                http1->setMemoryResource(&arena);
+                return http1;
+            };
+#else
+            auto make_exchange = [&]() { return std::make_unique<HTTP1Type>(endpoint_handler_); };
+#endif
+            pipeline.push_back(make_exchange());
+
+            // The read buffer is leased per read and returned once its bytes are handled, so an idle keep-alive
+            // connection only holds a buffer of the size its recent reads needed.
+            net::BufferPool &buffers = net::BufferPool::local();
+            net::ReadSizer read_sizer;
+            std::vector<iovec> segments;
+
+            using std::chrono::milliseconds;
+            net::TimerWheel &timers = net::TimerWheel::local();
+            net::Deadline deadline{socket.get_raw_header()->fd};
+            // the header deadline covers the whole request head, so it is not re-armed while headers trickle in
+            bool awaiting_headers = true;
+            auto headers_started = std::chrono::steady_clock::now();
+            timers.arm(deadline, milliseconds(this->timeouts_.header));
+            bool first_read = true;
+            // the first bytes, kept while they are too few to tell h2c from HTTP/1.x
+            std::string first_bytes;
 
             while (true) {
-                buffer.clear();
+                net::BufferLease lease = buffers.acquire(read_sizer.next());
+                auto &buffer = lease.buffer();
 
-                ssize_t rdsz = co_await socket.async_read(buffer, MAX_READ_SIZE);
+                ssize_t rdsz = co_await socket.async_read(buffer, lease.capacity());
 
                 if (rdsz <= 0) {
                     break;
                 }
-                socket.set_timeout_ms(20000);
+                read_sizer.observe(lease.capacity(), static_cast<size_t>(rdsz));
+                // handlers may take as long as they need, only reads and writes are bounded
+                timers.cancel(deadline);
 #ifdef UVENT_DEBUG
                 spdlog::info("Read size: {}", rdsz);
 #endif
-                std::string request_string{buffer.data(), buffer.data() + buffer.size()};
-                // http1.readCallbackSync(request_string, socket);
-                co_await http1.readCallback(request_string, socket);
-
-                const bool conn_close_resp = response_headers.containsValue(component::HeaderEnum::Connection, "close");
-                const bool conn_close_req = response_headers.containsValue(component::HeaderEnum::Connection, "close");
-                if (conn_close_req && !conn_close_resp) {
-                    response.addHeader("Connection", "close");
+                // parsed in place, the buffer is not reused until readCallback is done with it
+                std::string_view pending{reinterpret_cast<const char *>(buffer.data()), buffer.size()};
+                if (first_read && this->http2_.enabled) {
+                    if (!first_bytes.empty()) {
+                        first_bytes.append(pending);
+                        pending = first_bytes;
+                    }
+                    if (protocols::http::http2::mayBePreface(pending)) {
+                        // a lone `P` may still be a POST, the request is parsed once it is told apart
+                        if (first_bytes.empty()) first_bytes.assign(pending);
+                        if (this->timeouts_.header > 0) {
+                            const auto left = milliseconds(this->timeouts_.header) -
+                                              std::chrono::duration_cast<milliseconds>(std::chrono::steady_clock::now() - headers_started);
+                            timers.arm(deadline, std::max(left, milliseconds(1)));
+                        }
+                        continue;
+                    }
+                    if (protocols::http::http2::isPreface(pending)) {
+                        // prior-knowledge h2c, the connection speaks HTTP/2 from its first byte
+                        co_await this->serveHTTP2(socket, pending, timers, deadline);
+                        co_return;
+                    }
+                }
+                first_read = false;
+
+                bool close_connection = false;
+                bool partial = false;
+                while (!pending.empty() && !close_connection) {
+                    // parse and handle every complete request in this read, in order
+                    size_t ready = 0;
+                    while (!pending.empty() && ready < MAX_PIPELINE_DEPTH) {
+                        if (ready == pipeline.size()) {
+                            pipeline.push_back(make_exchange());
+                        }
+                        HTTP1Type &http1 = *pipeline[ready];
+                        const size_t consumed = co_await http1.readCallback(pending, socket);
+                        pending.remove_prefix(std::min(consumed, pending.size()));
+
+                        if (http1.getRequest().getState() < protocols::http::REQUEST_STATE::FINISHED) {
+                            partial = true;
+                            break;// incomplete, continues with the next read
+                        }
+                        ++ready;
+                        if (this->prepareClose(http1)) {
+                            close_connection = true;
+                            break;
+                        }
+                    }
+                    if (ready == 0) break;
+
+                    // all responses of the batch go out in order, coalesced into as few writes as possible
+                    timers.arm(deadline, milliseconds(this->timeouts_.write));
+                    const bool write_ok = co_await this->writeResponses(socket, pipeline, ready, segments);
+                    timers.cancel(deadline);
+                    if (!write_ok) {
+                        socket.shutdown();
+                        co_return;
+                    }
+                    if (close_connection) {
+#ifdef UVENT_DEBUG
+                        spdlog::info("Closing connection after pipelined batch of {}", ready);
+#endif
+                        socket.shutdown();
+                        co_return;
+                    }
+                    for (size_t i = 0; i < ready; ++i) {
+                        pipeline[i]->getResponse().clear();
+                    }
+                    std::rotate(pipeline.begin(), pipeline.begin() + ready, pipeline.end());
                 }
+#if defined(UNET_CONNECTION_ARENA) && UNET_CONNECTION_ARENA
+                if (!partial) {
+                    // every exchange is answered, nothing refers to the arena once the maps are rebound
+                    for (auto &http1: pipeline) {
+                        http1->setMemoryResource(&arena);
+                    }
+                    arena.release();
+                }
+#endif
 
-                while (!response.isSent() && request.getState() >= protocols::http::REQUEST_STATE::FINISHED) {
-                    const std::string responseString = response.pull();
+                if (!partial) {
+                    awaiting_headers = false;
+                    timers.arm(deadline, milliseconds(this->timeouts_.keep_alive));
+                } else if (pipeline[0]->getRequest().getState() < protocols::http::REQUEST_STATE::HEADERS_PARSED) {
+                    const auto now = std::chrono::steady_clock::now();
+                    if (!awaiting_headers) {
+                        awaiting_headers = true;
+                        headers_started = now;
+                    }
+                    if (this->timeouts_.header > 0) {
+                        const auto left = milliseconds(this->timeouts_.header) - std::chrono::duration_cast<milliseconds>(now - headers_started);
+                        timers.arm(deadline, std::max(left, milliseconds(1)));
+                    }
+                } else {
+                    awaiting_headers = false;
+                    timers.arm(deadline, milliseconds(this->timeouts_.body));
+                }
+            }
+            co_return;
+        }
 
+    protected:
+        /**
+         * @brief Serves an HTTP/2 connection until either side ends it; @p received holds the first bytes read.
+         */
+        usub::uvent::task::Awaitable<void> serveHTTP2(usub::uvent::net::TCPClientSocket &socket,
+                                                      std::string_view received,
+                                                      net::TimerWheel &timers,
+                                                      net::Deadline &deadline) {
+            net::Deadline write_deadline(deadline.fd());
+            std::vector<iovec> segments;
+            protocols::http::HTTP2<RouterType> http2(this->endpoint_handler_, this->http2_, [&](std::string_view frames) {
+                return this->writeHTTP2(socket, frames, segments, http2, timers, deadline, write_deadline);
+            });
+            net::BufferPool &buffers = net::BufferPool::local();
+            net::ReadSizer read_sizer;
+
+            bool open = http2.readCallback(received);
+            // everything produced goes out, then DATA frames as long as flow control allows
+            while (co_await http2.flush() && open && !http2.finished()) {
+                this->armHTTP2Read(http2, timers, deadline);
+                net::BufferLease lease = buffers.acquire(read_sizer.next());
+                auto &buffer = lease.buffer();
+                ssize_t rdsz = co_await socket.async_read(buffer, lease.capacity());
+                if (rdsz <= 0) break;
+                read_sizer.observe(lease.capacity(), static_cast<size_t>(rdsz));
+                timers.cancel(deadline);
+                open = http2.readCallback({reinterpret_cast<const char *>(buffer.data()), buffer.size()});
+            }
+            // handlers still running refer to the connection, their responses are dropped
+            co_await http2.drain();
+            timers.cancel(deadline);
+            socket.shutdown();
+            co_return;
+        }
 
-                    ssize_t wrsz = co_await socket.async_write((uint8_t *) responseString.data(), responseString.size());
+        /**
+         * @brief The HTTP2 writer of a connection: writes @p frames, then re-arms the read deadline.
+         */
+        usub::uvent::task::Awaitable<bool> writeHTTP2(usub::uvent::net::TCPClientSocket &socket, std::string_view frames,
+                                                      std::vector<iovec> &segments,
+                                                      const protocols::http::HTTP2<RouterType> &http2,
+                                                      net::TimerWheel &timers, net::Deadline &deadline,
+                                                      net::Deadline &write_deadline) {
+            if (frames.empty()) co_return true;
+            segments.assign(1, iovec{const_cast<char *>(frames.data()), frames.size()});
+            timers.arm(write_deadline, std::chrono::milliseconds(this->timeouts_.write));
+            const ssize_t written = co_await net::async_writev(socket, segments);
+            timers.cancel(write_deadline);
+            if (written != static_cast<ssize_t>(frames.size())) {
+                // wakes the read as well
+                socket.shutdown();
+                co_return false;
+            }
+            this->armHTTP2Read(http2, timers, deadline);
+            co_return true;
+        }
 
-                    if (wrsz <= 0) {
+        /**
+         * @brief Arms the read deadline of an HTTP/2 connection; none while a handler runs, as the client then
+         *        waits for the server.
+         */
+        void armHTTP2Read(const protocols::http::HTTP2<RouterType> &http2, net::TimerWheel &timers, net::Deadline &deadline) const {
+            if (http2.running()) {
+                timers.cancel(deadline);
+            } else {
+                timers.arm(deadline, std::chrono::milliseconds(http2.idle() ? this->timeouts_.keep_alive : this->timeouts_.body));
+            }
+        }
 
-                        break;
-                    }
-#ifdef UVENT_DEBUG
-                    spdlog::info("Write size: {}", wrsz);
-#endif
-                }
+        /**
+         * @brief Decides whether the connection ends after this exchange, and marks the response accordingly.
+         */
+        static bool prepareClose(protocols::http::HTTP1<RouterType> &http1) {
+            auto &request = http1.getRequest();
+            auto &response = http1.getResponse();
+            auto &request_headers = request.getHeaders();
+            auto &response_headers = response.getHeaders();
 
-                bool has_bad_request = request.getState() >= usub::server::protocols::http::REQUEST_STATE::BAD_REQUEST;
-                bool hasError = request.getState() == usub::server::protocols::http::REQUEST_STATE::ERROR;
-                bool http10_no_keep_alive = request.getHTTPVersion() == usub::server::protocols::http::VERSION::HTTP_1_0 &&
-                                            !request_headers.containsValue(usub::server::component::HeaderEnum::Connection, "keep-alive");
+            const bool conn_close_resp = response_headers.containsValue(component::HeaderEnum::Connection, "close");
+            const bool conn_close_req = request_headers.containsValue(component::HeaderEnum::Connection, "close");
+            if (conn_close_req && !conn_close_resp) {
+                response.addHeader("Connection", "close");
+            }
 
-                if (response.isSent() && (has_bad_request || hasError || conn_close_resp || conn_close_req || http10_no_keep_alive)) {
+            bool has_bad_request = request.getState() >= usub::server::protocols::http::REQUEST_STATE::BAD_REQUEST;
+            bool hasError = request.getState() == usub::server::protocols::http::REQUEST_STATE::ERROR;
+            bool http10_no_keep_alive = request.getHTTPVersion() == usub::server::protocols::http::VERSION::HTTP_1_0 &&
+                                        !request_headers.containsValue(usub::server::component::HeaderEnum::Connection, "keep-alive");
 #ifdef UVENT_DEBUG
-                    if (has_bad_request)
-                        spdlog::info("Closing connection: request state is BAD_REQUEST or worse (state = {})", static_cast<int>(request.getState()));
-                    else if (hasError)
-                        spdlog::info("Closing connection: request state is ERROR");
-                    else if (conn_close_resp)
-                        spdlog::info("Closing connection: response had 'Connection: close'");
-                    else if (conn_close_req)
-                        spdlog::info("Closing connection: request had 'Connection: close'");
-                    else if (http10_no_keep_alive)
-                        spdlog::info("Closing connection: HTTP/1.0 and no 'Connection: keep-alive'");
+            if (has_bad_request)
+                spdlog::info("Closing connection: request state is BAD_REQUEST or worse (state = {})", static_cast<int>(request.getState()));
+            else if (hasError)
+                spdlog::info("Closing connection: request state is ERROR");
+            else if (conn_close_resp)
+                spdlog::info("Closing connection: response had 'Connection: close'");
+            else if (conn_close_req)
+                spdlog::info("Closing connection: request had 'Connection: close'");
+            else if (http10_no_keep_alive)
+                spdlog::info("Closing connection: HTTP/1.0 and no 'Connection: keep-alive'");
 #endif
-                    socket.shutdown();
-                    co_return;
+            return has_bad_request || hasError || conn_close_resp || conn_close_req || http10_no_keep_alive;
+        }
+
+        /**
+         * @brief Writes the responses of pipeline[0, count) in request order.
+         *
+         * Buffered responses are gathered into one iovec list and written with a single vectored write;
+         * a file body flushes what was gathered before it and is then sent with sendfile.
+         */
+        static usub::uvent::task::Awaitable<bool> writeResponses(usub::uvent::net::TCPClientSocket &socket,
+                                                                 std::vector<std::unique_ptr<protocols::http::HTTP1<RouterType>>> &pipeline,
+                                                                 size_t count,
+                                                                 std::vector<iovec> &segments) {
+            protocols::http::FileRange file_range;
+            segments.clear();
+            for (size_t i = 0; i < count; ++i) {
+                auto &response = pipeline[i]->getResponse();
+                while (!response.isSent()) {
+                    response.pullSegments(segments, file_range);
+                    if (file_range.fd == -1) continue;
+
+                    // the head must be out in full before the file follows it
+                    if (!co_await writeSegments(socket, segments)) {
+                        co_return false;
+                    }
+                    segments.clear();
+                    if (file_range.size > 0) {
+                        ssize_t sent = co_await net::async_sendfile(socket, file_range.fd, file_range.offset, file_range.size);
+                        if (sent != static_cast<ssize_t>(file_range.size)) {
+                            // body is short of its announced length, the connection can't be reused
+                            co_return false;
+                        }
+                    }
+                    if (!file_range.trailer.empty()) {
+                        segments.push_back({const_cast<char *>(file_range.trailer.data()), file_range.trailer.size()});
+                    }
                 }
-                response.clear();
             }
-            co_return;
+            if (!segments.empty() && !co_await writeSegments(socket, segments)) {
+                co_return false;
+            }
+            co_return true;
+        }
+
+        /**
+         * @brief Writes all of @p segments; async_writev() reports a write that failed midway as the bytes it got out.
+         */
+        static usub::uvent::task::Awaitable<bool> writeSegments(usub::uvent::net::TCPClientSocket &socket, std::vector<iovec> &segments) {
+            ssize_t expected = 0;
+            for (const iovec &segment: segments) expected += static_cast<ssize_t>(segment.iov_len);
+            co_return co_await net::async_writev(socket, segments) == expected;
         }
 
     protected:
         std::shared_ptr<RouterType> endpoint_handler_;
+        configuration::ConnectionTimeouts timeouts_{};
+        configuration::HTTP2Config http2_{};
     };
 
     // Temporary FIX!!!! TODO!
@@ -162,6 +431,36 @@ namespace usub::server {
                  configuration::ConfigReader &cfg,
                  size_t listener_index)
             : StreamHandler(std::move(router)), uvent_(std::move(uvent)), cfg_(cfg), listener_index_(listener_index) {
+            if constexpr (requires(StreamHandler &handler) { handler.setTimeouts(configuration::ConnectionTimeouts{}); }) {
+                auto &listeners = cfg_.getListeners();
+                if (listener_index_ < listeners.size()) {
+                    this->setTimeouts(listeners[listener_index_].timeouts);
+                }
+            }
+            if constexpr (requires(StreamHandler &handler) { handler.setCertificates(configuration::ListenerConfig{}, std::vector<configuration::Certificate>{}); }) {
+                auto &listeners = cfg_.getListeners();
+                if (listener_index_ < listeners.size()) {
+                    const bool has_certs = cfg_.getResult().contains("certs");
+                    this->setCertificates(listeners[listener_index_], has_certs ? cfg_.getCerts() : std::vector<configuration::Certificate>{});
+                }
+            }
+            // after the certificates, TLS handlers offer h2 through their contexts' ALPN
+            if constexpr (requires(StreamHandler &handler) { handler.setHTTP2(configuration::HTTP2Config{}); }) {
+                this->setHTTP2(cfg_.getHTTP2());
+            }
+            if constexpr (requires(StreamHandler &handler) { handler.setSessionResumption(configuration::TLSSessionConfig{}); }) {
+                this->setSessionResumption(cfg_.getTLSSessions());
+            }
+            if constexpr (requires(StreamHandler &handler) { handler.setHandshakeOffload(configuration::TLSHandshakeConfig{}); }) {
+                this->setHandshakeOffload(cfg_.getTLSHandshakes());
+            }
+            if constexpr (requires(StreamHandler &handler) { handler.setRecordSizing(configuration::TLSRecordConfig{}); }) {
+                this->setRecordSizing(cfg_.getTLSRecords());
+            }
+            if constexpr (requires(StreamHandler &handler) { handler.setOcspStapling(configuration::TLSOcspConfig{}, std::vector<configuration::Certificate>{}); }) {
+                const bool has_certs = cfg_.getResult().contains("certs");
+                this->setOcspStapling(cfg_.getTLSOcsp(), has_certs ? cfg_.getCerts() : std::vector<configuration::Certificate>{});
+            }
             // Ничего не создаём здесь — переносим создание server_socket_ в loop().
         }
 
@@ -200,10 +499,67 @@ namespace usub::server {
                 if (soc) {
                     usub::uvent::system::co_spawn(this->clientCoroutine(std::move(soc.value())));
                 }
+                this->drainPending(server_socket_->get_raw_header()->fd, listener.accept_batch - 1);
             }
         }
 
+        /**
+         * @brief Per-thread accept loop for AcceptMode::REUSE_PORT listeners.
+         *
+         * Opens this thread's own SO_REUSEPORT socket, so the kernel spreads new connections
+         * across threads and accepted clients stay on the thread that accepted them.
+         * Must be spawned with co_spawn_static() on the thread @p thread_index.
+         */
+        usub::uvent::task::Awaitable<void> loopShard(int thread_index) {
+            auto listeners = cfg_.getListeners();
+            if (listener_index_ >= listeners.size()) {
+                co_return;
+            }
+            const auto &listener = listeners[listener_index_];
+            usub::uvent::settings::timeout_duration_ms = listener.timeout;
+
+            int listen_fd;
+            try {
+                listen_fd = net::openReusePortListener(listener.ip_addr, listener.port, cfg_.getBacklog(), listener.ipv);
+            } catch (const std::system_error &e) {
+                std::cerr << "Acceptor shard " << thread_index << " on port " << listener.port << ": " << e.what() << std::endl;
+                co_return;
+            }
+            usub::uvent::net::TCPServerSocket server_socket{listen_fd};
+
+            for (;;) {
+                auto soc = co_await server_socket.async_accept();
+#ifdef UVENT_DEBUG
+                spdlog::info("{} shard {}", __PRETTY_FUNCTION__, thread_index);
+#endif
+                if (soc) {
+                    usub::uvent::system::co_spawn(this->clientCoroutine(std::move(soc.value())));
+                }
+                this->drainPending(listen_fd, listener.accept_batch - 1);
+            }
+        }
+
+        configuration::AcceptMode acceptMode() const {
+            auto &listeners = cfg_.getListeners();
+            if (listener_index_ >= listeners.size()) return configuration::AcceptMode::SINGLE;
+            return listeners[listener_index_].accept_mode;
+        }
+
     private:
+        /**
+         * @brief Accepts up to @p budget connections that are already queued, without suspending.
+         *
+         * One readiness wakeup usually covers several queued connections during reconnect
+         * storms; taking them here saves a trip through the reactor per connection.
+         */
+        void drainPending(int listen_fd, int budget) {
+            for (; budget > 0; --budget) {
+                const int fd = net::tryAccept(listen_fd);
+                if (fd < 0) break;
+                usub::uvent::system::co_spawn(this->clientCoroutine(usub::uvent::net::TCPClientSocket{fd}));
+            }
+        }
+
         std::shared_ptr<usub::Uvent> uvent_;
         configuration::ConfigReader &cfg_;
         size_t listener_index_{0};
@@ -0,0 +1,110 @@
+#ifndef USUB_SERVER_BUFFER_POOL_H
+#define USUB_SERVER_BUFFER_POOL_H
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <uvent/utils/buffer/DynamicBuffer.h>
+
+namespace usub::server::net {
+
+    class BufferPool;
+
+    /**
+     * @brief Receive buffer borrowed from a BufferPool, handed back when the lease is destroyed or reset.
+     */
+    class BufferLease {
+    public:
+        BufferLease() = default;
+        BufferLease(BufferLease &&other) noexcept;
+        BufferLease &operator=(BufferLease &&other) noexcept;
+        ~BufferLease();
+
+        BufferLease(const BufferLease &) = delete;
+        BufferLease &operator=(const BufferLease &) = delete;
+
+        usub::uvent::utils::DynamicBuffer &buffer() { return *this->buffer_; }
+
+        /**
+         * @brief Size class of the buffer, the most a single read into it should request.
+         */
+        size_t capacity() const { return this->capacity_; }
+
+        explicit operator bool() const { return this->buffer_ != nullptr; }
+
+        void reset();
+
+    private:
+        friend class BufferPool;
+
+        BufferLease(BufferPool *pool, size_t size_class, std::unique_ptr<usub::uvent::utils::DynamicBuffer> buffer, size_t capacity)
+            : pool_(pool), size_class_(size_class), capacity_(capacity), buffer_(std::move(buffer)) {}
+
+        BufferPool *pool_{nullptr};
+        size_t size_class_{0};
+        size_t capacity_{0};
+        std::unique_ptr<usub::uvent::utils::DynamicBuffer> buffer_;
+    };
+
+    /**
+     * @brief Per-thread cache of receive buffers in a few size classes.
+     *
+     * Connections lease a buffer for one read and the processing of its bytes, then return it, so memory
+     * follows the traffic instead of the number of open connections. Each class keeps at most
+     * MAX_CACHED_BYTES of free buffers, the rest is freed on return. Not thread safe: a lease must be
+     * returned on the thread it was taken on.
+     */
+    class BufferPool {
+    public:
+        static constexpr std::array<size_t, 4> SIZE_CLASSES{4 * 1024, 16 * 1024, 32 * 1024, 64 * 1024};
+        static constexpr size_t MAX_CACHED_BYTES = 4 * 1024 * 1024;
+
+        BufferPool() = default;
+        BufferPool(const BufferPool &) = delete;
+        BufferPool &operator=(const BufferPool &) = delete;
+
+        /**
+         * @brief Leases a buffer of the smallest class that holds @p size bytes (the largest class if none does).
+         */
+        BufferLease acquire(size_t size);
+
+        /**
+         * @brief Free buffers currently cached in class @p size_class.
+         */
+        size_t cached(size_t size_class) const { return this->free_[size_class].size(); }
+
+        /**
+         * @brief The pool of the calling thread.
+         */
+        static BufferPool &local();
+
+    private:
+        friend class BufferLease;
+
+        void release(size_t size_class, std::unique_ptr<usub::uvent::utils::DynamicBuffer> buffer);
+
+        std::array<std::vector<std::unique_ptr<usub::uvent::utils::DynamicBuffer>>, SIZE_CLASSES.size()> free_{};
+    };
+
+    /**
+     * @brief Picks the next read size of a connection from the sizes of its previous reads.
+     *
+     * Starts at the smallest pool class. A read that fills its buffer doubles the next request, since more
+     * data is likely queued; smaller reads let it decay back, so a connection that went quiet after a large
+     * upload waits for its next request with a small buffer.
+     */
+    class ReadSizer {
+    public:
+        size_t next() const { return this->expected_; }
+
+        void observe(size_t requested, size_t received);
+
+    private:
+        size_t expected_{BufferPool::SIZE_CLASSES.front()};
+    };
+
+}// namespace usub::server::net
+
+#endif//USUB_SERVER_BUFFER_POOL_H
@@ -0,0 +1,316 @@
+#ifndef USUB_SERVER_IO_URING_H
+#define USUB_SERVER_IO_URING_H
+
+#include <array>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <linux/io_uring.h>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <utility>
+#include <vector>
+
+#include <uvent/tasks/Awaitable.h>
+
+#include "Protocols/HTTP/Message.h"
+
+namespace usub::server::net {
+
+    /**
+     * @brief Minimal io_uring instance driven through the raw syscalls, without liburing.
+     *
+     * Exposes what the io_uring stream handler needs: SQE allocation and submission, completion reaping,
+     * and eventfd notification so the uvent reactor can wait for completions.
+     * Single issuer: all calls must come from the thread that owns the ring.
+     */
+    class IoUring {
+    public:
+        /**
+         * @param entries Submission queue size, rounded up to a power of two by the kernel.
+         * @throws std::system_error if the kernel refuses to set up the ring.
+         */
+        explicit IoUring(unsigned entries);
+        ~IoUring();
+
+        IoUring(const IoUring &) = delete;
+        IoUring &operator=(const IoUring &) = delete;
+
+        /**
+         * @brief Returns a zeroed SQE to fill, submitting queued ones first when the queue is full.
+         *
+         * @return nullptr if the kernel did not take the queued SQEs either (completion queue overflow).
+         */
+        io_uring_sqe *sqe();
+
+        /**
+         * @brief Reserves @p count consecutive zeroed SQEs into @p out, for a linked chain.
+         *
+         * Queued SQEs are submitted before the reservation when there is not room for all of them, never while it
+         * is made, so a chain reaches the kernel only after every one of its SQEs has been filled.
+         *
+         * @return false, with nothing reserved, if the kernel did not free enough slots.
+         */
+        bool sqes(io_uring_sqe **out, unsigned count);
+
+        /**
+         * @brief Hands every queued SQE to the kernel without waiting.
+         *
+         * @return Number of SQEs submitted, or -errno.
+         */
+        int submit();
+
+        /**
+         * @brief Calls @p fn for every posted completion and frees their slots.
+         *
+         * @return Number of completions seen.
+         */
+        template<class F>
+        unsigned forEachCompletion(F &&fn) {
+            unsigned head = *this->cq_head_;
+            unsigned seen = 0;
+            while (head != __atomic_load_n(this->cq_tail_, __ATOMIC_ACQUIRE)) {
+                fn(this->cqes_[head & *this->cq_mask_]);
+                ++head;
+                ++seen;
+            }
+            __atomic_store_n(this->cq_head_, head, __ATOMIC_RELEASE);
+            return seen;
+        }
+
+        /**
+         * @brief Makes the kernel signal @p event_fd whenever a completion is posted.
+         */
+        void registerEventFd(int event_fd);
+
+        int fd() const { return this->fd_; }
+
+    private:
+        void unmap();
+
+        int fd_{-1};
+        void *sq_ptr_{nullptr};
+        size_t sq_size_{0};
+        void *cq_ptr_{nullptr};
+        size_t cq_size_{0};
+        io_uring_sqe *sqes_{nullptr};
+        size_t sqes_size_{0};
+
+        unsigned *sq_head_{nullptr};
+        unsigned *sq_tail_{nullptr};
+        unsigned *sq_mask_{nullptr};
+        unsigned *sq_array_{nullptr};
+        unsigned sq_entries_{0};
+        unsigned sqe_tail_{0};
+
+        unsigned *cq_head_{nullptr};
+        unsigned *cq_tail_{nullptr};
+        unsigned *cq_mask_{nullptr};
+        io_uring_cqe *cqes_{nullptr};
+    };
+
+    /**
+     * @brief Ring of kernel-selected receive buffers (IORING_REGISTER_PBUF_RING).
+     *
+     * Receives submitted with its group id take a buffer only when data arrives, so idle connections
+     * hold no receive memory at all. Consumers hand buffers back with recycle() once parsed.
+     */
+    class ProvidedBuffers {
+    public:
+        /**
+         * @param count Number of buffers, a power of two up to 32768.
+         * @throws std::system_error if the kernel does not support provided buffer rings.
+         */
+        ProvidedBuffers(IoUring &ring, uint16_t group, uint16_t count, uint32_t buffer_size);
+        ~ProvidedBuffers();
+
+        ProvidedBuffers(const ProvidedBuffers &) = delete;
+        ProvidedBuffers &operator=(const ProvidedBuffers &) = delete;
+
+        uint16_t group() const { return this->group_; }
+
+        uint32_t bufferSize() const { return this->buffer_size_; }
+
+        char *data(uint16_t bid) { return this->memory_ + size_t{bid} * this->buffer_size_; }
+
+        void recycle(uint16_t bid);
+
+    private:
+        IoUring &ring_;
+        io_uring_buf_ring *buf_ring_{nullptr};
+        size_t ring_size_{0};
+        char *memory_{nullptr};
+        uint16_t group_;
+        uint16_t count_;
+        uint32_t buffer_size_;
+        uint16_t tail_{0};
+    };
+
+    void prepMultishotAccept(io_uring_sqe *sqe, int listen_fd, uint64_t user_data);
+
+    void prepRecvMultishot(io_uring_sqe *sqe, int fd, uint16_t buffer_group, uint64_t user_data);
+
+    void prepSendmsg(io_uring_sqe *sqe, int fd, const msghdr *msg, uint64_t user_data);
+
+    /**
+     * @param off_in Offset in @p fd_in, or -1 when it is a pipe.
+     */
+    void prepSplice(io_uring_sqe *sqe, int fd_in, int64_t off_in, int fd_out, uint32_t len, uint64_t user_data);
+
+    /**
+     * @brief Cancels every request targeting @p fd.
+     */
+    void prepCancelFd(io_uring_sqe *sqe, int fd, uint64_t user_data);
+
+    /**
+     * @brief State of one connection served by an IoUringLoop, owned by the loop.
+     *
+     * It outlives the connection coroutine until every request the kernel still holds for it has completed,
+     * since completions carry its address.
+     */
+    struct alignas(16) UringConnection {
+        int fd{-1};
+        std::coroutine_handle<> waiter{};
+        bool waiting_op{false};
+
+        /// Received chunks as (provided buffer id, length), in arrival order.
+        std::deque<std::pair<uint16_t, uint32_t>> received;
+        bool eof{false};
+        bool recv_armed{false};
+        bool finished{false};
+        unsigned inflight{0};
+
+        /// Results of the current send chain, one per linked SQE.
+        std::array<int, 3> results{};
+        unsigned ops_left{0};
+        msghdr msg{};
+
+        int pipe_r{-1};
+        int pipe_w{-1};
+        size_t pipe_size{0};
+        size_t in_pipe{0};
+    };
+
+    /**
+     * @brief Per-thread io_uring event loop: multishot accept, multishot receive into provided buffers, and sends.
+     *
+     * The loop's driver coroutine waits on an eventfd registered with the ring through the uvent reactor, reaps
+     * all completions in one pass, resumes the connection coroutines they concern and submits whatever those
+     * queued with a single io_uring_enter(). Connection coroutines must run on the loop's thread.
+     */
+    class IoUringLoop {
+    public:
+        IoUringLoop(unsigned entries, uint16_t buffer_count, uint32_t buffer_size);
+        ~IoUringLoop();
+
+        IoUringLoop(const IoUringLoop &) = delete;
+        IoUringLoop &operator=(const IoUringLoop &) = delete;
+
+        int eventFd() const { return this->event_fd_; }
+
+        /**
+         * @brief Starts a multishot accept on @p listen_fd; accepted descriptors are returned by dispatch().
+         */
+        void startAccept(int listen_fd);
+
+        /**
+         * @brief Handles every posted completion, resumes the connections they woke and submits new SQEs.
+         *
+         * @return Descriptors accepted since the last call.
+         */
+        const std::vector<int> &dispatch();
+
+        /**
+         * @brief Registers a freshly accepted socket and starts receiving on it.
+         */
+        UringConnection &open(int fd);
+
+        /**
+         * @brief Marks the connection's coroutine as done; its state is freed once the kernel released it.
+         */
+        void finish(UringConnection &conn);
+
+        std::string_view data(uint16_t bid, uint32_t len) { return {this->buffers_.data(bid), len}; }
+
+        void recycle(uint16_t bid);
+
+        struct RecvAwaiter {
+            UringConnection &conn;
+            bool await_ready() const noexcept { return !conn.received.empty() || conn.eof; }
+            void await_suspend(std::coroutine_handle<> handle) noexcept {
+                conn.waiting_op = false;
+                conn.waiter = handle;
+            }
+            void await_resume() const noexcept {}
+        };
+
+        /**
+         * @brief Suspends until the connection has received data or reached end of stream.
+         */
+        RecvAwaiter received(UringConnection &conn) { return RecvAwaiter{conn}; }
+
+        /**
+         * @brief Sends all of @p segments with SENDMSG, resubmitting the rest after short sends.
+         *
+         * @return false if the connection failed.
+         */
+        usub::uvent::task::Awaitable<bool> sendAll(UringConnection &conn, std::vector<iovec> &segments);
+
+        /**
+         * @brief Sends @p segments followed by @p range of a file as one linked chain:
+         *        SENDMSG -> SPLICE(file -> pipe) -> SPLICE(pipe -> socket), repeated per pipe-sized chunk.
+         *
+         * @return false if the connection failed or the file ended early.
+         */
+        usub::uvent::task::Awaitable<bool> sendFile(UringConnection &conn, std::vector<iovec> &segments, protocols::http::FileRange range);
+
+    private:
+        struct OpAwaiter {
+            UringConnection &conn;
+            bool await_ready() const noexcept { return conn.ops_left == 0; }
+            void await_suspend(std::coroutine_handle<> handle) noexcept {
+                conn.waiting_op = true;
+                conn.waiter = handle;
+            }
+            void await_resume() const noexcept {}
+        };
+
+        enum Tag : uint64_t {
+            ACCEPT = 1,
+            RECV = 2,
+            OP = 3,// OP + index of the SQE in its chain
+            CANCEL = 7,
+        };
+        static constexpr uint64_t TAG_MASK = 0xF;
+
+        void handle(const io_uring_cqe &cqe);
+        void armAccept();
+        void armRecv(UringConnection &conn);
+        void cancelRecv(UringConnection &conn);
+        void wake(UringConnection &conn);
+        void release(UringConnection &conn);
+        void flush();
+        bool ensurePipe(UringConnection &conn);
+        bool opSqes(UringConnection &conn, io_uring_sqe **sqes, unsigned count);
+
+        IoUring ring_;
+        ProvidedBuffers buffers_;
+        int event_fd_{-1};
+        int listen_fd_{-1};
+        /// Whether a multishot accept is queued or running; re-armed by dispatch() when the ring had no room.
+        bool accept_armed_{false};
+        bool dispatching_{false};
+        std::vector<int> accepted_;
+        std::vector<std::coroutine_handle<>> runnable_;
+        std::vector<UringConnection *> starved_;
+        /// Connections whose receive found the ring full, armed by dispatch() after its submit.
+        std::vector<UringConnection *> unarmed_;
+        /// Finished connections whose receive could not be cancelled for the same reason, cancelled by dispatch().
+        std::vector<UringConnection *> uncancelled_;
+    };
+
+}// namespace usub::server::net
+
+#endif//USUB_SERVER_IO_URING_H
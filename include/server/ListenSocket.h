@@ -0,0 +1,36 @@
+#ifndef USUB_SERVER_LISTEN_SOCKET_H
+#define USUB_SERVER_LISTEN_SOCKET_H
+
+#include <cstddef>
+#include <string>
+
+namespace usub::server::net {
+
+    /**
+     * @brief Opens a non-blocking listening TCP socket with SO_REUSEPORT set.
+     *
+     * Every call binds a new socket to the same address, so the kernel load-balances
+     * incoming connections across all of them. Used to give each uvent worker thread
+     * its own accept queue.
+     *
+     * @param ip_addr Address to bind to.
+     * @param port    TCP port to bind to.
+     * @param backlog Listen backlog passed to the OS.
+     * @param ipv     0 for IPv4, 1 for IPv6 (same encoding as ListenerConfig::ipv).
+     * @return The listening file descriptor.
+     * @throws std::system_error if the socket cannot be created, bound or put into listening state.
+     */
+    int openReusePortListener(const std::string &ip_addr, int port, int backlog, int ipv);
+
+    /**
+     * @brief Accepts a single pending connection without waiting.
+     *
+     * @param listen_fd Listening socket descriptor.
+     * @return The accepted non-blocking descriptor, or -1 when the accept queue is empty
+     *         (or on any other accept error).
+     */
+    int tryAccept(int listen_fd);
+
+}// namespace usub::server::net
+
+#endif//USUB_SERVER_LISTEN_SOCKET_H
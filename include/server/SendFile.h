@@ -0,0 +1,29 @@
+#ifndef USUB_SERVER_SEND_FILE_H
+#define USUB_SERVER_SEND_FILE_H
+
+#include <cstddef>
+#include <sys/types.h>
+
+#include <uvent/net/Socket.h>
+#include <uvent/tasks/Awaitable.h>
+
+namespace usub::server::net {
+
+    /**
+     * @brief Sends a file range to the socket with sendfile(2), without copying it through user space.
+     *
+     * Runs sendfile until the range is done. When the socket send buffer is full, one page of the range is
+     * pushed through the socket's async_write(), which suspends the coroutine until the socket is writable
+     * again, so other connections on the thread keep running while a large file drains.
+     *
+     * @param socket Connected client socket.
+     * @param in_fd  File to read from; its file offset is not used or changed.
+     * @param offset Position in @p in_fd to start from.
+     * @param count  Number of bytes to send.
+     * @return Bytes sent, or -1 if the connection failed before anything was sent.
+     */
+    usub::uvent::task::Awaitable<ssize_t> async_sendfile(usub::uvent::net::TCPClientSocket &socket, int in_fd, off_t offset, size_t count);
+
+}// namespace usub::server::net
+
+#endif//USUB_SERVER_SEND_FILE_H
@@ -0,0 +1,122 @@
+#ifndef USUB_SERVER_TIMER_WHEEL_H
+#define USUB_SERVER_TIMER_WHEEL_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include <uvent/tasks/Awaitable.h>
+
+namespace usub::server::net {
+
+    class TimerWheel;
+
+    /**
+     * @brief Intrusive list hook shared by deadlines and the wheel's slot heads.
+     */
+    struct TimerLink {
+        TimerLink *prev{this};
+        TimerLink *next{this};
+    };
+
+    /**
+     * @brief Connection deadline, owned by the connection and linked into the wheel of its thread while armed.
+     *
+     * When it expires the wheel shuts the socket down, which completes the connection's pending read or write
+     * with an error so the connection coroutine ends through its normal path. The deadline unlinks itself
+     * when destroyed.
+     */
+    class Deadline : private TimerLink {
+    public:
+        explicit Deadline(int fd) : fd_(fd) {}
+        ~Deadline();
+
+        Deadline(const Deadline &) = delete;
+        Deadline &operator=(const Deadline &) = delete;
+
+        bool armed() const { return this->wheel_ != nullptr; }
+
+        int fd() const { return this->fd_; }
+
+    private:
+        friend class TimerWheel;
+
+        TimerWheel *wheel_{nullptr};
+        uint64_t expires_{0};
+        int fd_;
+    };
+
+    /**
+     * @brief Hierarchical timer wheel holding the connection deadlines of one uvent thread.
+     *
+     * Four levels of 256, 64, 64 and 64 slots with a TICK resolution; arming, re-arming and cancelling
+     * only relink the deadline into a slot list, so they are O(1) and never touch the reactor. Deadlines
+     * further out than the last level are clamped to it (about 77 days with the default tick).
+     * Not thread safe: a deadline must be armed and cancelled on the thread that owns the wheel.
+     */
+    class TimerWheel {
+    public:
+        static constexpr std::chrono::milliseconds TICK{100};
+
+        TimerWheel();
+        ~TimerWheel();
+
+        TimerWheel(const TimerWheel &) = delete;
+        TimerWheel &operator=(const TimerWheel &) = delete;
+
+        /**
+         * @brief Arms @p deadline to fire @p timeout from now, replacing any earlier arming.
+         *
+         * @param timeout Rounded up to whole ticks; zero or negative cancels the deadline instead.
+         */
+        void arm(Deadline &deadline, std::chrono::milliseconds timeout);
+
+        void cancel(Deadline &deadline);
+
+        /**
+         * @brief Expires every deadline due at @p now.
+         *
+         * @return Number of deadlines that expired.
+         */
+        size_t advance(std::chrono::steady_clock::time_point now);
+
+        /**
+         * @brief Number of armed deadlines.
+         */
+        size_t size() const { return this->size_; }
+
+        /**
+         * @brief The wheel of the calling thread.
+         */
+        static TimerWheel &local();
+
+    private:
+        static constexpr unsigned ROOT_BITS = 8;
+        static constexpr unsigned LEVEL_BITS = 6;
+        static constexpr unsigned LEVELS = 4;
+        static constexpr size_t ROOT_SIZE = size_t{1} << ROOT_BITS;
+        static constexpr size_t LEVEL_SIZE = size_t{1} << LEVEL_BITS;
+        static constexpr uint64_t MAX_TICKS = (uint64_t{1} << (ROOT_BITS + (LEVELS - 1) * LEVEL_BITS)) - 1;
+
+        void link(Deadline &deadline);
+        static void unlink(Deadline &deadline);
+        void cascade(unsigned level);
+
+        std::array<TimerLink, ROOT_SIZE> root_{};
+        std::array<std::array<TimerLink, LEVEL_SIZE>, LEVELS - 1> levels_{};
+        std::chrono::steady_clock::time_point origin_;
+        uint64_t now_tick_{0};
+        size_t size_{0};
+    };
+
+    /**
+     * @brief Drives the wheel of the thread it runs on, expiring deadlines every TimerWheel::TICK.
+     *
+     * Spawned once per uvent thread with co_spawn_static().
+     */
+    usub::uvent::task::Awaitable<void> runTimerWheel();
+
+}// namespace usub::server::net
+
+#endif//USUB_SERVER_TIMER_WHEEL_H
@@ -0,0 +1,27 @@
+#ifndef USUB_SERVER_VECTORED_WRITE_H
+#define USUB_SERVER_VECTORED_WRITE_H
+
+#include <sys/uio.h>
+#include <vector>
+
+#include <uvent/net/Socket.h>
+#include <uvent/tasks/Awaitable.h>
+
+namespace usub::server::net {
+
+    /**
+     * @brief Writes a list of buffers to the socket, preferring a single writev(2) call.
+     *
+     * Gathers all segments into as few syscalls as the kernel accepts. When the socket send buffer is full
+     * the remainder of the current segment goes through the socket's own async_write(), which waits for
+     * writability, and gathering resumes afterwards.
+     *
+     * @param socket Connected client socket.
+     * @param iov    Segments to write. Consumed in place: entries are advanced as bytes are written.
+     * @return Total bytes written, or -1 if the connection failed before anything was written.
+     */
+    usub::uvent::task::Awaitable<ssize_t> async_writev(usub::uvent::net::TCPClientSocket &socket, std::vector<iovec> &iov);
+
+}// namespace usub::server::net
+
+#endif//USUB_SERVER_VECTORED_WRITE_H
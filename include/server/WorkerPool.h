@@ -0,0 +1,83 @@
+#ifndef USUB_SERVER_WORKER_POOL_H
+#define USUB_SERVER_WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include <uvent/net/Socket.h>
+#include <uvent/tasks/Awaitable.h>
+
+namespace usub::server::net {
+
+    /**
+     * @brief Fixed set of threads for CPU-heavy jobs that should not run on the uvent threads.
+     *
+     * The queue is bounded: trySubmit() refuses a job once @c capacity jobs are waiting, and the caller
+     * decides what to do instead (typically run it inline).
+     */
+    class WorkerPool {
+    public:
+        WorkerPool(size_t threads, size_t capacity);
+        ~WorkerPool();
+
+        WorkerPool(const WorkerPool &) = delete;
+        WorkerPool &operator=(const WorkerPool &) = delete;
+
+        bool trySubmit(std::function<void()> job);
+
+        /**
+         * @brief Jobs refused because the queue was full.
+         */
+        uint64_t rejected() const { return this->rejected_.load(std::memory_order_relaxed); }
+
+    private:
+        void run();
+
+        std::mutex mutex_;
+        std::condition_variable ready_;
+        std::deque<std::function<void()>> queue_;
+        size_t capacity_;
+        bool stopping_{false};
+        std::atomic<uint64_t> rejected_{0};
+        std::vector<std::thread> threads_;
+    };
+
+    /**
+     * @brief Lets one coroutine wait for jobs it hands to a WorkerPool without blocking its uvent thread.
+     *
+     * Owns an eventfd registered with the reactor through a uvent socket; the worker signals it when the
+     * job is done. One job at a time.
+     */
+    class WorkerChannel {
+    public:
+        WorkerChannel();
+
+        WorkerChannel(const WorkerChannel &) = delete;
+        WorkerChannel &operator=(const WorkerChannel &) = delete;
+
+        explicit operator bool() const { return this->fd_ >= 0; }
+
+        /**
+         * @brief Runs @p job on @p pool and resumes when it has finished.
+         *
+         * Runs it inline when the channel has no eventfd or the pool's queue is full. @p job may reference
+         * the caller's frame: the coroutine does not resume before the job is done.
+         */
+        usub::uvent::task::Awaitable<void> run(WorkerPool &pool, std::function<void()> job);
+
+    private:
+        int fd_{-1};
+        std::optional<usub::uvent::net::TCPClientSocket> events_;
+    };
+
+}// namespace usub::server::net
+
+#endif// USUB_SERVER_WORKER_POOL_H
@@ -8,6 +8,7 @@
 
 #include "Protocols/HTTP/EndpointHandler.h"
 #include "Protocols/HTTP/RadixRouter.h"
+#include "Protocols/HTTP/StaticRouter.h"
 #include "server/Acceptor.h"
 
 namespace usub::server {
@@ -31,11 +32,13 @@ namespace usub::server {
 
         ServerImpl(const std::string &config_path)
             : config_(config_path), endpoint_handler_(std::make_shared<RouterType>()), uvent_(std::make_shared<usub::Uvent>(int(config_.getThreads()))), acceptors_(createAcceptors(std::make_index_sequence<sizeof...(StreamHandlerTemplates)>{})) {
+            spawnTimerWheels();
             spawnAcceptors();
         }
 
         ServerImpl(std::shared_ptr<usub::Uvent> ext_uvent)
             : config_(), endpoint_handler_(std::make_shared<RouterType>()), uvent_(std::move(ext_uvent)), acceptors_(createAcceptors(std::make_index_sequence<sizeof...(StreamHandlerTemplates)>{})) {
+            spawnTimerWheels();
             spawnAcceptors();
         }
 
@@ -114,6 +117,9 @@ namespace usub::server {
                 }
             }
             std::cout << ", Version: 1.0.0." << std::endl;
+            if constexpr (requires(RouterType &router) { router.freeze(); }) {
+                this->endpoint_handler_->freeze();// routes are final, match without allocating from here on
+            }
             this->uvent_->run();
         }
 
@@ -123,14 +129,42 @@ namespace usub::server {
 
         void spawnAcceptors() {
             std::apply([&](auto &...a) {
-                (usub::uvent::system::co_spawn(a.loop()), ...);
+                (spawnAcceptor(a), ...);
             },
                        acceptors_);
         }
 
+        /**
+         * @brief Starts the per-thread timer wheel that enforces connection deadlines.
+         */
+        void spawnTimerWheels() {
+            this->uvent_->for_each_thread([&](int idx, usub::uvent::thread::ThreadLocalStorage *) {
+                usub::uvent::system::co_spawn_static(net::runTimerWheel(), idx);
+            });
+        }
+
+        template<class AcceptorType>
+        void spawnAcceptor(AcceptorType &acceptor) {
+            if (acceptor.acceptMode() == configuration::AcceptMode::REUSE_PORT) {
+                // one SO_REUSEPORT socket per worker, each pinned to its own thread
+                this->uvent_->for_each_thread([&](int idx, usub::uvent::thread::ThreadLocalStorage *) {
+                    usub::uvent::system::co_spawn_static(acceptor.loopShard(idx), idx);
+                });
+            } else {
+                usub::uvent::system::co_spawn(acceptor.loop());
+            }
+        }
+
         std::shared_ptr<usub::Uvent> &getUvent() {
             return uvent_;
         }
+
+        /**
+         * @brief The router, for routes added to it directly, like the middlewares of a StaticRouter route.
+         */
+        RouterType &getRouter() {
+            return *this->endpoint_handler_;
+        }
     };
 
     using Server = usub::server::ServerImpl<protocols::http::HTTPEndpointHandler, PlainHTTPStreamHandler>;
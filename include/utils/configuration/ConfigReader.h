@@ -30,10 +30,85 @@ namespace usub::server {
             std::string domain;
             std::string key_file;
             std::string cert_file;
+            std::string ocsp_file;     ///< DER OCSP response to staple, reloaded on every refresh.
+            std::string ocsp_responder;///< Responder URL overriding the one in the certificate.
 
             friend std::ostream &operator<<(std::ostream &os, const Certificate &certificate);
         };
 
+        /**
+         * @brief How a listener distributes new connections across worker threads.
+         */
+        enum class AcceptMode {
+            SINGLE,    ///< One listening socket and one accept coroutine for the whole listener.
+            REUSE_PORT,///< One SO_REUSEPORT socket per uvent thread, each accepting on its own thread.
+        };
+
+        /**
+         * @brief Per-connection deadlines in milliseconds, 0 disables one.
+         */
+        struct ConnectionTimeouts {
+            int keep_alive = 20000;///< Idle time allowed between two requests on a keep-alive connection.
+            int header = 10000;    ///< Time allowed for a request line and headers to arrive, counted from their first byte.
+            int body = 20000;      ///< Inactivity allowed while a request body is arriving.
+            int write = 20000;     ///< Time allowed to write one batch of responses.
+        };
+
+        /**
+         * @brief TLS session resumption shared by all TLS listeners, the `[tls]` table.
+         */
+        struct TLSSessionConfig {
+            int session_cache_size = 20480;    ///< Sessions kept in the shared server-side cache, 0 disables it.
+            int session_timeout = 3600;        ///< Seconds a session can be resumed after its full handshake.
+            bool session_tickets = true;       ///< Issue stateless session tickets.
+            int ticket_key_rotation = 3600;    ///< Seconds between ticket key rotations.
+            std::string ticket_key_file;       ///< Secret the ticket keys are derived from, empty for random keys.
+            bool early_data = false;           ///< Accept TLS 1.3 early data on resumed sessions, for routes that opt in.
+            int early_data_size = 16384;       ///< Most early data a client may send.
+            int early_data_replay_window = 10; ///< Seconds a ClientHello with early data is remembered to refuse replays.
+        };
+
+        /**
+         * @brief Where TLS handshakes run, from the `[tls]` table.
+         */
+        struct TLSHandshakeConfig {
+            int workers = 0;   ///< Threads running handshake steps off the uvent threads, 0 runs them inline.
+            int queue = 1024;  ///< Handshake steps allowed to wait for a worker; beyond that they run inline.
+        };
+
+        /**
+         * @brief Size of the TLS records responses are encrypted into, from the `[tls]` table.
+         */
+        struct TLSRecordConfig {
+            int record_size = 1369;             ///< Record payload on a new or idle connection, 0 always sends 16 KiB records.
+            int record_boost_bytes = 1048576;   ///< Bytes sent in small records before switching to 16 KiB records.
+            int record_boost_time = 1000;       ///< Milliseconds after which the switch happens regardless of bytes, 0 disables it.
+            int record_idle_reset = 1000;       ///< Milliseconds without a response after which records are small again, 0 disables it.
+        };
+
+        /**
+         * @brief OCSP stapling of the `[[certs]]` certificates, from the `[tls]` table.
+         */
+        struct TLSOcspConfig {
+            bool ocsp_stapling = false;///< Staple OCSP responses to handshakes.
+            int ocsp_refresh = 3600;   ///< Longest time in seconds between two fetches of a response.
+            int ocsp_retry = 60;       ///< Seconds to wait after a failed fetch.
+            int ocsp_timeout = 10;     ///< Seconds a responder may take per send or receive.
+        };
+
+        /**
+         * @brief HTTP/2 shared by all listeners, the `[http2]` table.
+         */
+        struct HTTP2Config {
+            bool enabled = false;                 ///< Offer h2 through ALPN on TLS listeners and accept prior-knowledge h2c on plain ones.
+            int max_concurrent_streams = 100;     ///< Streams a client may have open at once; more are refused.
+            int initial_window_size = 65535;      ///< Bytes of request body a client may send per stream before being acknowledged.
+            int connection_window_size = 1048576; ///< The same for all streams of a connection together.
+            int max_frame_size = 16384;           ///< Largest frame payload accepted.
+            int max_header_list_size = 16384;     ///< Largest request header list accepted, counted as in SETTINGS_MAX_HEADER_LIST_SIZE.
+            int max_body_size = 1048576;          ///< Largest request body; a larger one is answered with 413.
+        };
+
         struct ListenerConfig {
             std::string ip_addr = "0.0.0.0";
             int port = 8080;
@@ -42,6 +117,9 @@ namespace usub::server {
             int ipv = 0;
             std::string key_file;
             std::string cert_file;
+            AcceptMode accept_mode = AcceptMode::SINGLE;
+            int accept_batch = 16;
+            ConnectionTimeouts timeouts;
 
             std::string getKeyFilePath();
             std::string getPemFilePath();
@@ -75,10 +153,25 @@ namespace usub::server {
 
             std::vector<ListenerConfig>& getListeners();
 
+            TLSSessionConfig &getTLSSessions();
+
+            TLSHandshakeConfig &getTLSHandshakes();
+
+            TLSRecordConfig &getTLSRecords();
+
+            TLSOcspConfig &getTLSOcsp();
+
+            HTTP2Config &getHTTP2();
+
         private:
             toml::parse_result res;
             std::vector<Certificate> certs;
             std::vector<ListenerConfig> listeners_;
+            TLSSessionConfig tls_sessions_;
+            TLSHandshakeConfig tls_handshakes_;
+            TLSRecordConfig tls_records_;
+            TLSOcspConfig tls_ocsp_;
+            HTTP2Config http2_;
         };
 
     };// namespace configuration
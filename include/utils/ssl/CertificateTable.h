@@ -0,0 +1,156 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <openssl/err.h>
+#include <openssl/sha.h>
+#include <openssl/ssl.h>
+
+#include "utils/configuration/ConfigReader.h"
+
+namespace usub::utils::ssl {
+
+    /**
+     * @brief Server SSL_CTX per certificate, built once at startup and selected by SNI during the handshake.
+     *
+     * Every distinct key/cert pair of the `[[certs]]` table gets one context, however many domains point
+     * to it. Domains are matched case-insensitively, first exactly and then as a `*.` wildcard covering
+     * one leftmost label. The table is immutable after construction, so handshakes on any thread read it
+     * without synchronization.
+     */
+    class CertificateTable {
+    public:
+        /// Applied to every context after its certificate is loaded (ALPN, options, ...).
+        using Configure = std::function<void(SSL_CTX *)>;
+
+        /**
+         * @throws configuration::error::WrongConfig when a key or certificate cannot be loaded.
+         */
+        CertificateTable(const std::vector<server::configuration::Certificate> &certs, const Configure &configure) {
+            for (const auto &cert: certs) {
+                SSL_CTX *ctx = context(cert.key_file, cert.cert_file);
+                if (!ctx) {
+                    ctx = load(cert.key_file, cert.cert_file);
+                    if (configure) configure(ctx);
+                    contexts_.emplace(std::make_pair(cert.key_file, cert.cert_file), ctx);
+                }
+                std::string domain = normalize(cert.domain);
+                if (domain.starts_with("*.")) {
+                    wildcard_.emplace(domain.substr(2), ctx);
+                } else if (!domain.empty()) {
+                    exact_.emplace(std::move(domain), ctx);
+                }
+            }
+        }
+
+        CertificateTable(const CertificateTable &) = delete;
+        CertificateTable &operator=(const CertificateTable &) = delete;
+
+        ~CertificateTable() {
+            for (auto &[files, ctx]: contexts_) {
+                SSL_CTX_free(ctx);
+            }
+        }
+
+        /**
+         * @brief Loads a server context for one key/cert pair, the certificate file may hold a chain.
+         *
+         * The session id context is derived from the certificate path, so a session is only resumed
+         * with the certificate it was established with.
+         */
+        static SSL_CTX *load(const std::string &key_file, const std::string &cert_file) {
+            SSL_CTX *ctx = SSL_CTX_new(TLS_server_method());
+            if (!ctx) throw server::configuration::error::WrongConfig("Could not create SSL_CTX: " + lastError());
+            if (SSL_CTX_use_certificate_chain_file(ctx, cert_file.c_str()) != 1 ||
+                SSL_CTX_use_PrivateKey_file(ctx, key_file.c_str(), SSL_FILETYPE_PEM) != 1 ||
+                SSL_CTX_check_private_key(ctx) != 1) {
+                SSL_CTX_free(ctx);
+                throw server::configuration::error::WrongConfig("Could not load " + cert_file + " / " + key_file + ": " + lastError());
+            }
+            unsigned char session_context[SHA256_DIGEST_LENGTH];
+            SHA256(reinterpret_cast<const unsigned char *>(cert_file.data()), cert_file.size(), session_context);
+            SSL_CTX_set_session_id_context(ctx, session_context, sizeof(session_context));
+            return ctx;
+        }
+
+        /**
+         * @brief The context built for @p key_file and @p cert_file, nullptr if no `[[certs]]` entry uses them.
+         */
+        SSL_CTX *context(const std::string &key_file, const std::string &cert_file) const {
+            const auto it = contexts_.find(std::make_pair(key_file, cert_file));
+            return it == contexts_.end() ? nullptr : it->second;
+        }
+
+        /**
+         * @brief The context for an SNI @p server_name, nullptr when no domain matches.
+         */
+        SSL_CTX *find(std::string_view server_name) const {
+            const std::string name = normalize(server_name);
+            if (const auto it = exact_.find(name); it != exact_.end()) return it->second;
+            const size_t dot = name.find('.');
+            if (dot == std::string::npos) return nullptr;
+            const auto it = wildcard_.find(name.substr(dot + 1));
+            return it == wildcard_.end() ? nullptr : it->second;
+        }
+
+        /**
+         * @brief Installs the SNI callback on @p ctx, the context connections are created with.
+         *
+         * Clients without SNI or with an unknown name keep @p ctx and its certificate.
+         */
+        void attach(SSL_CTX *ctx) const {
+            SSL_CTX_set_tlsext_servername_callback(ctx, onServerName);
+            SSL_CTX_set_tlsext_servername_arg(ctx, const_cast<CertificateTable *>(this));
+        }
+
+        /**
+         * @brief Calls @p fn for every context, meant for setup at startup before the first handshake.
+         */
+        void forEach(const Configure &fn) const {
+            for (const auto &[files, ctx]: contexts_) {
+                fn(ctx);
+            }
+        }
+
+        size_t size() const {
+            return contexts_.size();
+        }
+
+    private:
+        static std::string normalize(std::string_view name) {
+            if (name.ends_with('.')) name.remove_suffix(1);
+            std::string lower(name);
+            std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+            return lower;
+        }
+
+        static std::string lastError() {
+            char buf[256];
+            ERR_error_string_n(ERR_get_error(), buf, sizeof(buf));
+            return buf;
+        }
+
+        static int onServerName(SSL *ssl, int * /*alert*/, void *arg) {
+            const char *name = SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name);
+            if (!name) return SSL_TLSEXT_ERR_OK;
+            SSL_CTX *ctx = static_cast<const CertificateTable *>(arg)->find(name);
+            if (ctx && ctx != SSL_get_SSL_CTX(ssl)) {
+                SSL_set_SSL_CTX(ssl, ctx);
+            }
+            return SSL_TLSEXT_ERR_OK;
+        }
+
+        std::map<std::pair<std::string, std::string>, SSL_CTX *> contexts_;
+        std::unordered_map<std::string, SSL_CTX *> exact_;
+        std::unordered_map<std::string, SSL_CTX *> wildcard_;
+    };
+
+}// namespace usub::utils::ssl
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <unordered_set>
+
+#include <openssl/ssl.h>
+
+namespace usub::utils::ssl {
+
+    /// Independent slices of the replay window, selected by the low bits of the ClientHello random.
+    inline constexpr size_t REPLAY_WINDOW_SHARDS = 16;
+    /// ClientHellos remembered per shard and window; beyond that early data is refused until the window turns.
+    inline constexpr size_t REPLAY_WINDOW_SHARD_CAPACITY = 16384;
+
+    /**
+     * @brief Remembers the ClientHellos that carried accepted early data, so a replayed one is refused.
+     *
+     * OpenSSL only accepts early data when the ticket age the client reports matches the server's view
+     * within 10 seconds, so a recorded ClientHello can be replayed for about that long. Every ClientHello
+     * random is kept for one to two @c window periods; a second one with the same random falls back to a
+     * full round trip instead of running its early data again. When a shard is full, early data is refused
+     * rather than accepted unchecked.
+     *
+     * The window is per listener: listeners and servers sharing ticket keys do not see each other's ClientHellos.
+     */
+    class ReplayWindow {
+    public:
+        explicit ReplayWindow(std::chrono::seconds window) : window_(window.count() > 0 ? window : std::chrono::seconds(1)) {}
+
+        ReplayWindow(const ReplayWindow &) = delete;
+        ReplayWindow &operator=(const ReplayWindow &) = delete;
+
+        /**
+         * @brief Installs the early data check on @p ctx.
+         */
+        void attach(SSL_CTX *ctx) {
+            SSL_CTX_set_allow_early_data_cb(ctx, onAllowEarlyData, this);
+        }
+
+        /**
+         * @brief Records @p random at @p now, false when it was already seen within the window or the shard is full.
+         */
+        bool firstSeen(const unsigned char (&random)[SSL3_RANDOM_SIZE],
+                       std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now()) {
+            uint64_t key;
+            std::memcpy(&key, random, sizeof(key));
+            const uint64_t generation = static_cast<uint64_t>(now.time_since_epoch() / this->window_);
+
+            Shard &shard = this->shards_[key % REPLAY_WINDOW_SHARDS];
+            std::lock_guard lock(shard.mutex);
+            if (shard.generation != generation) {
+                if (shard.generation + 1 == generation) {
+                    shard.previous.swap(shard.current);
+                } else {
+                    shard.previous.clear();
+                }
+                shard.current.clear();
+                shard.generation = generation;
+            }
+            if (shard.current.size() >= REPLAY_WINDOW_SHARD_CAPACITY) return false;
+            if (shard.previous.contains(key)) return false;
+            return shard.current.insert(key).second;
+        }
+
+    private:
+        struct Shard {
+            std::mutex mutex;
+            uint64_t generation{0};
+            std::unordered_set<uint64_t> current;
+            std::unordered_set<uint64_t> previous;
+        };
+
+        static int onAllowEarlyData(SSL *ssl, void *arg) {
+            unsigned char random[SSL3_RANDOM_SIZE];
+            SSL_get_client_random(ssl, random, sizeof(random));
+            return static_cast<ReplayWindow *>(arg)->firstSeen(random) ? 1 : 0;
+        }
+
+        std::chrono::seconds window_;
+        std::array<Shard, REPLAY_WINDOW_SHARDS> shards_{};
+    };
+
+}// namespace usub::utils::ssl
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <openssl/bio.h>
+#include <openssl/ssl.h>
+
+/**
+ * Kernel TLS needs OpenSSL to hand the record layer over to the socket it writes to. OpenSSL does that itself on a
+ * socket BIO, through the write BIO of create_ktls_socket_bio(); UNET_KTLS is defined when kTLS was not configured
+ * out of OpenSSL, everywhere else TLS records are encrypted by OpenSSL in user space.
+ */
+#if !defined(OPENSSL_NO_KTLS) && defined(SSL_OP_ENABLE_KTLS)
+#define UNET_KTLS
+#endif
+
+namespace usub::utils::ssl {
+
+    /**
+     * @brief Lets OpenSSL move record encryption of @p ctx's connections into the kernel, when built with kTLS.
+     *
+     * Takes effect only once the kernel "tls" module is loaded; without UNET_KTLS this does nothing.
+     */
+    inline void enable_ktls([[maybe_unused]] SSL_CTX *ctx) {
+#ifdef UNET_KTLS
+        SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+#endif
+    }
+
+    /**
+     * @brief Whether records sent through @p ssl are encrypted by the kernel.
+     */
+    inline bool ktls_send_enabled([[maybe_unused]] SSL *ssl) {
+#ifdef UNET_KTLS
+        return BIO_get_ktls_send(SSL_get_wbio(ssl));
+#else
+        return false;
+#endif
+    }
+
+}// namespace usub::utils::ssl
@@ -0,0 +1,369 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <thread>
+#include <vector>
+
+#include <openssl/bio.h>
+#include <openssl/ocsp.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <openssl/x509v3.h>
+
+namespace usub::utils::ssl {
+
+    /**
+     * @brief What a fetcher gets to obtain the OCSP response of one certificate.
+     */
+    struct OcspRequest {
+        std::string cert_file;///< Certificate the response is for.
+        std::string file;     ///< `ocsp_file` of its `[[certs]]` entry, empty if none.
+        std::string responder;///< `ocsp_responder` of the entry, otherwise the OCSP URL in the certificate.
+        std::string der;      ///< DER-encoded OCSPRequest for the certificate.
+    };
+
+    /// Returns a DER-encoded OCSP response, std::nullopt when none could be obtained. Runs on the refresh thread.
+    using OcspFetcher = std::function<std::optional<std::string>(const OcspRequest &)>;
+
+    namespace detail {
+        inline std::optional<std::string> read_ocsp_file(const std::string &path) {
+            std::ifstream file(path, std::ios::binary);
+            if (!file) return std::nullopt;
+            std::string der(std::istreambuf_iterator<char>(file), {});
+            if (der.empty()) return std::nullopt;
+            return der;
+        }
+
+        /**
+         * @brief Posts @p der to an `http://` responder, with @p timeout for each socket operation after connecting.
+         */
+        inline std::optional<std::string> post_ocsp_request(const std::string &url, const std::string &der,
+                                                            std::chrono::seconds timeout) {
+            char *host = nullptr;
+            char *port = nullptr;
+            char *path = nullptr;
+            int use_ssl = 0;
+            if (!OCSP_parse_url(url.c_str(), &host, &port, &path, &use_ssl)) return std::nullopt;
+
+            std::optional<std::string> result;
+            const unsigned char *p = reinterpret_cast<const unsigned char *>(der.data());
+            OCSP_REQUEST *request = d2i_OCSP_REQUEST(nullptr, &p, static_cast<long>(der.size()));
+            BIO *bio = use_ssl ? nullptr : BIO_new_connect(host);
+            if (request && bio) {
+                BIO_set_conn_port(bio, port);
+                if (BIO_do_connect(bio) > 0) {
+                    int fd = -1;
+                    BIO_get_fd(bio, &fd);
+                    const timeval tv{static_cast<time_t>(timeout.count()), 0};
+                    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+                    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+                    if (OCSP_RESPONSE *response = OCSP_sendreq_bio(bio, path, request)) {
+                        unsigned char *out = nullptr;
+                        const int len = i2d_OCSP_RESPONSE(response, &out);
+                        if (len > 0) result.emplace(reinterpret_cast<const char *>(out), static_cast<size_t>(len));
+                        OPENSSL_free(out);
+                        OCSP_RESPONSE_free(response);
+                    }
+                }
+            }
+            BIO_free_all(bio);
+            OCSP_REQUEST_free(request);
+            OPENSSL_free(host);
+            OPENSSL_free(port);
+            OPENSSL_free(path);
+            return result;
+        }
+
+        inline std::chrono::system_clock::time_point to_time_point(const ASN1_GENERALIZEDTIME *time) {
+            std::tm tm{};
+            ASN1_TIME_to_tm(time, &tm);
+            return std::chrono::system_clock::from_time_t(timegm(&tm));
+        }
+    }// namespace detail
+
+    /**
+     * @brief The default fetcher: reads `file` when set, otherwise posts the request to `responder` over HTTP.
+     */
+    inline std::optional<std::string> fetch_ocsp_response(const OcspRequest &request, std::chrono::seconds timeout) {
+        if (!request.file.empty()) return detail::read_ocsp_file(request.file);
+        if (!request.responder.empty()) return detail::post_ocsp_request(request.responder, request.der, timeout);
+        return std::nullopt;
+    }
+
+    /**
+     * @brief Staples OCSP responses to the handshakes of the certificates added to it.
+     *
+     * Every certificate keeps its last good response. A background thread obtains them through the fetcher,
+     * checks that they are signed by the certificate's issuer, report it as good and are current, and fetches
+     * again halfway through their validity, or after @c retry when a fetch fails; a response that runs out
+     * without a replacement is dropped. The status callback only copies the current response, so handshakes
+     * never wait for a responder: without a response the handshake simply goes on unstapled.
+     *
+     * The issuer is taken from the certificate chain file, which therefore has to include it.
+     */
+    class OcspStapler {
+    public:
+        struct Stats {
+            uint64_t stapled = 0; ///< Handshakes that asked for a response and got one.
+            uint64_t missing = 0; ///< Handshakes that asked for a response while none was valid.
+            uint64_t refreshed = 0;///< Responses fetched and accepted.
+            uint64_t failed = 0;  ///< Fetches that returned nothing or an unusable response.
+        };
+
+        /**
+         * @param refresh longest time between two fetches of a certificate's response.
+         * @param retry wait after a failed fetch.
+         * @param timeout socket timeout of the default fetcher.
+         */
+        OcspStapler(std::chrono::seconds refresh, std::chrono::seconds retry, std::chrono::seconds timeout)
+            : refresh_(refresh), retry_(retry), fetcher_([timeout](const OcspRequest &request) {
+                  return fetch_ocsp_response(request, timeout);
+              }) {}
+
+        OcspStapler(const OcspStapler &) = delete;
+        OcspStapler &operator=(const OcspStapler &) = delete;
+
+        ~OcspStapler() {
+            {
+                std::lock_guard lock(this->mutex_);
+                this->stopping_ = true;
+            }
+            this->wake_.notify_all();
+            if (this->thread_.joinable()) this->thread_.join();
+            for (auto &entry: this->entries_) {
+                OCSP_CERTID_free(entry->id);
+                X509_free(entry->issuer);
+            }
+        }
+
+        /**
+         * @brief Replaces the fetcher, e.g. to read responses from another source or a local stand-in responder.
+         */
+        void setFetcher(OcspFetcher fetcher) {
+            std::lock_guard lock(this->mutex_);
+            this->fetcher_ = std::move(fetcher);
+        }
+
+        /**
+         * @brief Staples responses for the certificate of @p ctx; adding a context twice has no effect.
+         *
+         * A response from @p file is loaded right away, responders are asked from the background thread.
+         *
+         * @return false when the certificate or its issuer could not be found in @p ctx, or there is neither
+         *         a file nor a responder to get responses from.
+         */
+        bool add(SSL_CTX *ctx, const std::string &cert_file, const std::string &file, const std::string &responder) {
+            std::unique_lock lock(this->mutex_);
+            for (const auto &entry: this->entries_) {
+                if (entry->ctx == ctx) return true;
+            }
+            auto entry = std::make_unique<Entry>();
+            if (!describe(ctx, *entry)) return false;
+            entry->ctx = ctx;
+            entry->request.cert_file = cert_file;
+            entry->request.file = file;
+            if (!responder.empty()) entry->request.responder = responder;
+            if (entry->request.file.empty() && entry->request.responder.empty()) {
+                OCSP_CERTID_free(entry->id);
+                X509_free(entry->issuer);
+                return false;
+            }
+
+            Entry &added = *this->entries_.emplace_back(std::move(entry));
+            SSL_CTX_set_tlsext_status_cb(ctx, onStatus);
+            SSL_CTX_set_tlsext_status_arg(ctx, &added);
+            if (!file.empty()) this->refresh(added, lock);
+
+            this->added_ = true;
+            if (!this->thread_.joinable()) this->thread_ = std::thread([this] { this->run(); });
+            lock.unlock();
+            this->wake_.notify_all();
+            return true;
+        }
+
+        Stats stats() const {
+            return Stats{this->stapled_.load(std::memory_order_relaxed), this->missing_.load(std::memory_order_relaxed),
+                         this->refreshed_.load(std::memory_order_relaxed), this->failed_.load(std::memory_order_relaxed)};
+        }
+
+    private:
+        using Clock = std::chrono::system_clock;
+
+        struct Entry {
+            SSL_CTX *ctx{nullptr};
+            OCSP_CERTID *id{nullptr};
+            X509 *issuer{nullptr};
+            OcspRequest request;
+            std::atomic<std::shared_ptr<const std::string>> response;
+            OcspStapler *owner{nullptr};
+            Clock::time_point expires{};   ///< nextUpdate of the current response.
+            Clock::time_point refresh_at{};///< Next fetch, the epoch for as soon as possible.
+        };
+
+        /**
+         * @brief Fills in the certificate id, issuer, request and the certificate's own responder URL.
+         */
+        bool describe(SSL_CTX *ctx, Entry &entry) {
+            X509 *cert = SSL_CTX_get0_certificate(ctx);
+            STACK_OF(X509) *chain = nullptr;
+            if (!cert || SSL_CTX_get0_chain_certs(ctx, &chain) != 1) return false;
+            for (int i = 0; i < sk_X509_num(chain); ++i) {
+                X509 *candidate = sk_X509_value(chain, i);
+                if (X509_check_issued(candidate, cert) == X509_V_OK) {
+                    entry.issuer = candidate;
+                    break;
+                }
+            }
+            if (!entry.issuer) return false;
+            X509_up_ref(entry.issuer);
+            entry.id = OCSP_cert_to_id(nullptr, cert, entry.issuer);
+            entry.owner = this;
+
+            OCSP_REQUEST *request = OCSP_REQUEST_new();
+            OCSP_CERTID *id = entry.id ? OCSP_CERTID_dup(entry.id) : nullptr;
+            if (request && id && OCSP_request_add0_id(request, id)) {
+                unsigned char *der = nullptr;
+                const int len = i2d_OCSP_REQUEST(request, &der);
+                if (len > 0) entry.request.der.assign(reinterpret_cast<const char *>(der), static_cast<size_t>(len));
+                OPENSSL_free(der);
+            } else {
+                OCSP_CERTID_free(id);
+            }
+            OCSP_REQUEST_free(request);
+
+            STACK_OF(OPENSSL_STRING) *urls = X509_get1_ocsp(cert);
+            if (sk_OPENSSL_STRING_num(urls) > 0) entry.request.responder = sk_OPENSSL_STRING_value(urls, 0);
+            X509_email_free(urls);
+            return entry.id != nullptr;
+        }
+
+        /**
+         * @brief Checks @p der against @p entry, returns the response's nextUpdate (or now + refresh) if usable.
+         */
+        std::optional<Clock::time_point> validate(const Entry &entry, const std::string &der) const {
+            const unsigned char *p = reinterpret_cast<const unsigned char *>(der.data());
+            OCSP_RESPONSE *response = d2i_OCSP_RESPONSE(nullptr, &p, static_cast<long>(der.size()));
+            if (!response) return std::nullopt;
+            OCSP_BASICRESP *basic = OCSP_response_status(response) == OCSP_RESPONSE_STATUS_SUCCESSFUL
+                                            ? OCSP_response_get1_basic(response)
+                                            : nullptr;
+            std::optional<Clock::time_point> expires;
+            if (basic) {
+                // signed by the issuer itself, or by a responder certificate the issuer delegated to
+                STACK_OF(X509) *issuers = sk_X509_new_null();
+                sk_X509_push(issuers, entry.issuer);
+                X509_STORE *store = X509_STORE_new();
+                X509_STORE_add_cert(store, entry.issuer);
+                X509_STORE_set_flags(store, X509_V_FLAG_PARTIAL_CHAIN);
+
+                int status = -1;
+                int reason = 0;
+                ASN1_GENERALIZEDTIME *revoked = nullptr;
+                ASN1_GENERALIZEDTIME *this_update = nullptr;
+                ASN1_GENERALIZEDTIME *next_update = nullptr;
+                if (OCSP_basic_verify(basic, issuers, store, OCSP_TRUSTOTHER) > 0 &&
+                    OCSP_resp_find_status(basic, entry.id, &status, &reason, &revoked, &this_update, &next_update) &&
+                    status == V_OCSP_CERTSTATUS_GOOD && OCSP_check_validity(this_update, next_update, 300, -1)) {
+                    expires = next_update ? detail::to_time_point(next_update) : Clock::now() + this->refresh_;
+                }
+                X509_STORE_free(store);
+                sk_X509_free(issuers);
+                OCSP_BASICRESP_free(basic);
+            }
+            OCSP_RESPONSE_free(response);
+            return expires;
+        }
+
+        /**
+         * @brief Fetches and installs a response for @p entry, with @p lock released during the fetch.
+         */
+        void refresh(Entry &entry, std::unique_lock<std::mutex> &lock) {
+            const OcspFetcher fetcher = this->fetcher_;
+            const OcspRequest request = entry.request;
+            lock.unlock();
+            const std::optional<std::string> der = fetcher ? fetcher(request) : std::nullopt;
+            const std::optional<Clock::time_point> expires = der ? this->validate(entry, *der) : std::nullopt;
+            lock.lock();
+
+            const auto now = Clock::now();
+            if (expires) {
+                entry.response.store(std::make_shared<const std::string>(*der), std::memory_order_release);
+                entry.expires = *expires;
+                // halfway to nextUpdate, so a few failed attempts still leave time before the response runs out
+                entry.refresh_at = std::clamp(now + (*expires - now) / 2, now + this->retry_, now + this->refresh_);
+                this->refreshed_.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                entry.refresh_at = now + this->retry_;
+                this->failed_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        void run() {
+            std::unique_lock lock(this->mutex_);
+            while (!this->stopping_) {
+                this->added_ = false;
+                auto next = Clock::time_point::max();
+                for (size_t i = 0; i < this->entries_.size() && !this->stopping_; ++i) {
+                    Entry &entry = *this->entries_[i];
+                    if (entry.refresh_at <= Clock::now()) this->refresh(entry, lock);
+                    if (entry.expires != Clock::time_point{} && entry.expires <= Clock::now()) {
+                        entry.response.store(nullptr, std::memory_order_release);
+                        entry.expires = {};
+                    }
+                    next = std::min(next, entry.refresh_at);
+                }
+                this->wake_.wait_until(lock, next, [&] {
+                    return this->stopping_ || this->added_ || Clock::now() >= next;
+                });
+            }
+        }
+
+        static int onStatus(SSL *ssl, void *arg) {
+            auto *entry = static_cast<Entry *>(arg);
+            const std::shared_ptr<const std::string> response = entry->response.load(std::memory_order_acquire);
+            if (!response) {
+                entry->owner->missing_.fetch_add(1, std::memory_order_relaxed);
+                return SSL_TLSEXT_ERR_NOACK;
+            }
+            // OpenSSL takes ownership of the copy
+            auto *copy = static_cast<unsigned char *>(OPENSSL_malloc(response->size()));
+            if (!copy) return SSL_TLSEXT_ERR_NOACK;
+            std::memcpy(copy, response->data(), response->size());
+            SSL_set_tlsext_status_ocsp_resp(ssl, copy, static_cast<long>(response->size()));
+            entry->owner->stapled_.fetch_add(1, std::memory_order_relaxed);
+            return SSL_TLSEXT_ERR_OK;
+        }
+
+        std::chrono::seconds refresh_;
+        std::chrono::seconds retry_;
+        OcspFetcher fetcher_;
+
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        bool stopping_{false};
+        bool added_{false};
+        std::vector<std::unique_ptr<Entry>> entries_;
+        std::thread thread_;
+
+        std::atomic<uint64_t> stapled_{0};
+        std::atomic<uint64_t> missing_{0};
+        std::atomic<uint64_t> refreshed_{0};
+        std::atomic<uint64_t> failed_{0};
+    };
+
+}// namespace usub::utils::ssl
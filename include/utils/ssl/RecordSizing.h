@@ -0,0 +1,143 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace usub::utils::ssl {
+
+    /// Largest plaintext a TLS record carries.
+    inline constexpr size_t MAX_RECORD_SIZE = 16 * 1024;
+    /// Smallest record size accepted by OpenSSL's SSL_set_max_send_fragment.
+    inline constexpr size_t MIN_RECORD_SIZE = 512;
+
+    /**
+     * @brief Records written by every RecordSizer of the process.
+     */
+    struct RecordStats {
+        uint64_t small_records = 0;///< Records cut to the initial size.
+        uint64_t full_records = 0; ///< Records of up to MAX_RECORD_SIZE.
+        uint64_t boosts = 0;       ///< Switches from small to full records.
+        uint64_t idle_resets = 0;  ///< Connections sent back to small records after being idle.
+    };
+
+    namespace detail {
+        struct RecordCounters {
+            std::atomic<uint64_t> small_records{0};
+            std::atomic<uint64_t> full_records{0};
+            std::atomic<uint64_t> boosts{0};
+            std::atomic<uint64_t> idle_resets{0};
+        };
+
+        inline RecordCounters &record_counters() {
+            static RecordCounters counters;
+            return counters;
+        }
+    }// namespace detail
+
+    inline RecordStats record_stats() {
+        const auto &counters = detail::record_counters();
+        return RecordStats{counters.small_records.load(std::memory_order_relaxed),
+                           counters.full_records.load(std::memory_order_relaxed),
+                           counters.boosts.load(std::memory_order_relaxed),
+                           counters.idle_resets.load(std::memory_order_relaxed)};
+    }
+
+    /**
+     * @brief Chooses the size of the TLS records a connection's responses are cut into.
+     *
+     * A new connection, or one idle for longer than @c idle_reset, sends records that fit one packet, so
+     * the client can decrypt the first bytes without waiting for a whole 16 KiB record to arrive over a
+     * congestion window that is still small. Once @c boost_bytes have been sent that way, or @c boost_time
+     * has passed, it switches to full records to keep bulk transfers cheap. An initial size of 0 always
+     * sends full records.
+     *
+     * Counters are kept per connection and added to record_stats() by end().
+     */
+    class RecordSizer {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        RecordSizer() = default;
+
+        RecordSizer(size_t initial_size, uint64_t boost_bytes, std::chrono::milliseconds boost_time,
+                    std::chrono::milliseconds idle_reset)
+            : initial_size_(initial_size == 0 ? MAX_RECORD_SIZE : std::clamp(initial_size, MIN_RECORD_SIZE, MAX_RECORD_SIZE)),
+              boost_bytes_(boost_bytes), boost_time_(boost_time), idle_reset_(idle_reset),
+              boosted_(initial_size_ == MAX_RECORD_SIZE) {}
+
+        /**
+         * @brief Starts writing a response at @p now.
+         */
+        void begin(Clock::time_point now) {
+            if (this->initial_size_ == MAX_RECORD_SIZE) return;
+            const bool fresh = this->last_write_ == Clock::time_point{};
+            if (fresh || (this->idle_reset_.count() > 0 && now - this->last_write_ > this->idle_reset_)) {
+                if (!fresh && this->boosted_) ++this->idle_resets_;
+                this->boosted_ = false;
+                this->window_start_ = now;
+                this->window_bytes_ = 0;
+            }
+            if (!this->boosted_ && this->boost_time_.count() > 0 && now - this->window_start_ >= this->boost_time_) {
+                this->boost();
+            }
+            this->last_write_ = now;
+        }
+
+        /**
+         * @brief Plaintext bytes to put into the next record.
+         */
+        size_t next() const {
+            return this->boosted_ ? MAX_RECORD_SIZE : this->initial_size_;
+        }
+
+        /**
+         * @brief Records that one record with @p bytes of plaintext was written.
+         */
+        void sent(size_t bytes) {
+            if (!this->boosted_) {
+                ++this->small_records_;
+                this->window_bytes_ += bytes;
+                if (this->window_bytes_ >= this->boost_bytes_) this->boost();
+            } else {
+                ++this->full_records_;
+            }
+        }
+
+        /**
+         * @brief Publishes the counters gathered since the last call.
+         */
+        void end() {
+            auto &counters = detail::record_counters();
+            if (this->small_records_) counters.small_records.fetch_add(this->small_records_, std::memory_order_relaxed);
+            if (this->full_records_) counters.full_records.fetch_add(this->full_records_, std::memory_order_relaxed);
+            if (this->boosts_) counters.boosts.fetch_add(this->boosts_, std::memory_order_relaxed);
+            if (this->idle_resets_) counters.idle_resets.fetch_add(this->idle_resets_, std::memory_order_relaxed);
+            this->small_records_ = this->full_records_ = this->boosts_ = this->idle_resets_ = 0;
+        }
+
+    private:
+        void boost() {
+            this->boosted_ = true;
+            ++this->boosts_;
+        }
+
+        size_t initial_size_{MAX_RECORD_SIZE};
+        uint64_t boost_bytes_{0};
+        std::chrono::milliseconds boost_time_{0};
+        std::chrono::milliseconds idle_reset_{0};
+
+        bool boosted_{true};
+        Clock::time_point window_start_{};
+        Clock::time_point last_write_{};
+        uint64_t window_bytes_{0};
+
+        uint32_t small_records_{0};
+        uint32_t full_records_{0};
+        uint32_t boosts_{0};
+        uint32_t idle_resets_{0};
+    };
+
+}// namespace usub::utils::ssl
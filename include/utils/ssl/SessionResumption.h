@@ -0,0 +1,457 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+#include <openssl/ssl.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#endif
+
+namespace usub::utils::ssl {
+
+    /// Bytes of one session cache entry; sessions whose DER encoding does not fit are not cached.
+    inline constexpr size_t SESSION_CACHE_ENTRY_BYTES = 512;
+    /// Independent slices of the session cache, selected by the low bits of the session id hash.
+    inline constexpr size_t SESSION_CACHE_SHARDS = 16;
+    /// Slots a session id may occupy inside its shard.
+    inline constexpr size_t SESSION_CACHE_WAYS = 4;
+
+    namespace detail {
+        /**
+         * @brief Fixed-size record guarded by a sequence counter, shared between threads without locks.
+         *
+         * Neither side waits: a writer that finds another write in progress gives up, and a reader that
+         * overlaps a write reports a miss. Both are acceptable for caches, where a miss costs a full handshake.
+         */
+        template<size_t Bytes>
+        class SeqRecord {
+            static_assert(Bytes % sizeof(uint64_t) == 0);
+            static constexpr size_t WORDS = Bytes / sizeof(uint64_t);
+
+        public:
+            bool tryStore(const void *data) {
+                uint64_t seq = seq_.load(std::memory_order_relaxed);
+                if ((seq & 1) || !seq_.compare_exchange_strong(seq, seq + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+                    return false;
+                }
+                std::atomic_thread_fence(std::memory_order_release);
+                uint64_t words[WORDS];
+                std::memcpy(words, data, Bytes);
+                for (size_t i = 0; i < WORDS; ++i) {
+                    words_[i].store(words[i], std::memory_order_relaxed);
+                }
+                seq_.store(seq + 2, std::memory_order_release);
+                return true;
+            }
+
+            bool tryLoad(void *out) const {
+                const uint64_t before = seq_.load(std::memory_order_acquire);
+                if (before & 1) return false;
+                uint64_t words[WORDS];
+                for (size_t i = 0; i < WORDS; ++i) {
+                    words[i] = words_[i].load(std::memory_order_relaxed);
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (seq_.load(std::memory_order_relaxed) != before) return false;
+                std::memcpy(out, words, Bytes);
+                return true;
+            }
+
+        private:
+            std::atomic<uint64_t> seq_{0};
+            std::array<std::atomic<uint64_t>, WORDS> words_{};
+        };
+
+        inline int session_cache_index() {
+            static const int index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+            return index;
+        }
+
+        inline int ticket_keys_index() {
+            static const int index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+            return index;
+        }
+    }// namespace detail
+
+    /**
+     * @brief Server-side TLS session cache shared by all threads, replacing OpenSSL's per-SSL_CTX locked cache.
+     *
+     * Holds sessions resumed by id: TLS 1.2 clients without ticket support, and TLS 1.3 when stateless
+     * tickets are disabled. The table is split into SESSION_CACHE_SHARDS shards of SESSION_CACHE_WAYS-way
+     * buckets; every slot is a SeqRecord, so lookups and inserts from any uvent thread never take a lock.
+     * A full bucket evicts the entry closest to expiry.
+     */
+    class SessionCache {
+    public:
+        struct Stats {
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            uint64_t stores = 0;
+        };
+
+        /**
+         * @param capacity approximate number of sessions kept, about SESSION_CACHE_ENTRY_BYTES each.
+         */
+        explicit SessionCache(size_t capacity) {
+            const size_t per_bucket = SESSION_CACHE_SHARDS * SESSION_CACHE_WAYS;
+            buckets_ = std::max<size_t>(1, (capacity + per_bucket - 1) / per_bucket);
+            for (auto &shard: shards_) {
+                shard.slots = std::make_unique<Slot[]>(buckets_ * SESSION_CACHE_WAYS);
+            }
+        }
+
+        /**
+         * @brief Makes @p ctx store and look up server sessions here instead of in its internal cache.
+         */
+        void attach(SSL_CTX *ctx) {
+            SSL_CTX_set_ex_data(ctx, detail::session_cache_index(), this);
+            SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL);
+            SSL_CTX_sess_set_new_cb(ctx, onNew);
+            SSL_CTX_sess_set_get_cb(ctx, onGet);
+            SSL_CTX_sess_set_remove_cb(ctx, onRemove);
+        }
+
+        bool store(SSL_SESSION *session) {
+            unsigned int id_len = 0;
+            const unsigned char *id = SSL_SESSION_get_id(session, &id_len);
+            const int der_len = i2d_SSL_SESSION(session, nullptr);
+            if (id_len == 0 || id_len > SSL_MAX_SSL_SESSION_ID_LENGTH || der_len <= 0 ||
+                static_cast<size_t>(der_len) > sizeof(Entry::der)) {
+                return false;
+            }
+            Entry entry{};
+            entry.expires = static_cast<int64_t>(SSL_SESSION_get_time(session)) + SSL_SESSION_get_timeout(session);
+            entry.der_len = static_cast<uint16_t>(der_len);
+            entry.id_len = static_cast<uint8_t>(id_len);
+            std::memcpy(entry.id, id, id_len);
+            unsigned char *der = entry.der;
+            i2d_SSL_SESSION(session, &der);
+
+            const uint64_t hash = hashOf(id, id_len);
+            Shard &shard = shardOf(hash);
+            Slot *bucket = bucketOf(shard, hash);
+            const int64_t now = std::time(nullptr);
+            Slot *victim = &bucket[0];
+            for (size_t i = 0; i < SESSION_CACHE_WAYS; ++i) {
+                Slot &slot = bucket[i];
+                const int64_t expires = slot.expires.load(std::memory_order_relaxed);
+                if (slot.hash.load(std::memory_order_relaxed) == hash || expires <= now) {
+                    victim = &slot;
+                    break;
+                }
+                if (expires < victim->expires.load(std::memory_order_relaxed)) victim = &slot;
+            }
+
+            victim->hash.store(0, std::memory_order_relaxed);
+            if (!victim->record.tryStore(&entry)) return false;
+            victim->expires.store(entry.expires, std::memory_order_relaxed);
+            victim->hash.store(hash, std::memory_order_release);
+            shard.stores.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        SSL_SESSION *find(const unsigned char *id, size_t id_len) {
+            const uint64_t hash = hashOf(id, id_len);
+            Shard &shard = shardOf(hash);
+            Slot *bucket = bucketOf(shard, hash);
+            const int64_t now = std::time(nullptr);
+            for (size_t i = 0; i < SESSION_CACHE_WAYS; ++i) {
+                Slot &slot = bucket[i];
+                if (slot.hash.load(std::memory_order_acquire) != hash) continue;
+                Entry entry;
+                if (!slot.record.tryLoad(&entry) || !matches(entry, id, id_len) || entry.expires <= now) continue;
+
+                const unsigned char *der = entry.der;
+                SSL_SESSION *session = d2i_SSL_SESSION(nullptr, &der, entry.der_len);
+                if (session) {
+                    shard.hits.fetch_add(1, std::memory_order_relaxed);
+                    return session;
+                }
+            }
+            shard.misses.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        void erase(const unsigned char *id, size_t id_len) {
+            uint64_t hash = hashOf(id, id_len);
+            Slot *bucket = bucketOf(shardOf(hash), hash);
+            for (size_t i = 0; i < SESSION_CACHE_WAYS; ++i) {
+                Slot &slot = bucket[i];
+                Entry entry;
+                if (slot.hash.load(std::memory_order_acquire) == hash && slot.record.tryLoad(&entry) && matches(entry, id, id_len)) {
+                    slot.hash.compare_exchange_strong(hash, 0, std::memory_order_relaxed);
+                    return;
+                }
+            }
+        }
+
+        Stats stats() const {
+            Stats total;
+            for (const auto &shard: shards_) {
+                total.hits += shard.hits.load(std::memory_order_relaxed);
+                total.misses += shard.misses.load(std::memory_order_relaxed);
+                total.stores += shard.stores.load(std::memory_order_relaxed);
+            }
+            return total;
+        }
+
+    private:
+        struct Entry {
+            int64_t expires;
+            uint16_t der_len;
+            uint8_t id_len;
+            unsigned char id[SSL_MAX_SSL_SESSION_ID_LENGTH];
+            unsigned char der[SESSION_CACHE_ENTRY_BYTES - sizeof(int64_t) - sizeof(uint16_t) - sizeof(uint8_t) - SSL_MAX_SSL_SESSION_ID_LENGTH];
+        };
+        static_assert(sizeof(Entry) == SESSION_CACHE_ENTRY_BYTES);
+
+        struct alignas(64) Slot {
+            std::atomic<uint64_t> hash{0};///< Hash of the stored id, 0 while empty or being rewritten.
+            std::atomic<int64_t> expires{0};
+            detail::SeqRecord<sizeof(Entry)> record;
+        };
+
+        struct alignas(64) Shard {
+            std::unique_ptr<Slot[]> slots;
+            std::atomic<uint64_t> hits{0};
+            std::atomic<uint64_t> misses{0};
+            std::atomic<uint64_t> stores{0};
+        };
+
+        static uint64_t hashOf(const unsigned char *id, size_t id_len) {
+            const uint64_t hash = std::hash<std::string_view>{}({reinterpret_cast<const char *>(id), id_len});
+            return hash ? hash : 1;
+        }
+
+        static bool matches(const Entry &entry, const unsigned char *id, size_t id_len) {
+            return entry.id_len == id_len && std::memcmp(entry.id, id, id_len) == 0;
+        }
+
+        Shard &shardOf(uint64_t hash) {
+            return shards_[hash % SESSION_CACHE_SHARDS];
+        }
+
+        Slot *bucketOf(Shard &shard, uint64_t hash) const {
+            return &shard.slots[(hash / SESSION_CACHE_SHARDS) % buckets_ * SESSION_CACHE_WAYS];
+        }
+
+        static SessionCache *from(SSL_CTX *ctx) {
+            return static_cast<SessionCache *>(SSL_CTX_get_ex_data(ctx, detail::session_cache_index()));
+        }
+
+        static int onNew(SSL *ssl, SSL_SESSION *session) {
+            from(SSL_get_SSL_CTX(ssl))->store(session);
+            return 0;// the session was copied, OpenSSL keeps its reference
+        }
+
+        static SSL_SESSION *onGet(SSL *ssl, const unsigned char *id, int id_len, int *copy) {
+            *copy = 0;// the returned session is a fresh object owned by OpenSSL
+            return from(SSL_get_SSL_CTX(ssl))->find(id, static_cast<size_t>(id_len));
+        }
+
+        static void onRemove(SSL_CTX *ctx, SSL_SESSION *session) {
+            unsigned int id_len = 0;
+            const unsigned char *id = SSL_SESSION_get_id(session, &id_len);
+            from(ctx)->erase(id, id_len);
+        }
+
+        std::array<Shard, SESSION_CACHE_SHARDS> shards_;
+        size_t buckets_{1};
+    };
+
+    /**
+     * @brief Session ticket keys shared by all threads and rotated every @c rotation.
+     *
+     * Keys belong to generations of wall-clock time (unix time / rotation). New tickets are encrypted with
+     * the current generation's key; tickets of the previous generation are still accepted and reissued, so
+     * a ticket stays usable for one to two rotation periods. Without a secret, every generation gets fresh
+     * random keys on the first handshake that notices the rotation is due. With a shared secret the keys are
+     * derived from it, so every process and host configured with the same secret accepts the others' tickets.
+     */
+    class TicketKeyRing {
+    public:
+        /**
+         * @param secret empty for random keys, otherwise at least 32 bytes of key material.
+         */
+        explicit TicketKeyRing(std::chrono::seconds rotation, std::string secret = {})
+            : rotation_(std::max<int64_t>(1, rotation.count())), secret_(std::move(secret)) {
+            const uint64_t generation = generationAt(std::time(nullptr));
+            if (!secret_.empty() && generation > 0) {
+                publish(generation - 1);
+            }
+            publish(generation);
+            current_.store(generation, std::memory_order_release);
+            claimed_.store(generation, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Makes @p ctx encrypt and decrypt its session tickets with this ring.
+         *
+         * Needs OpenSSL 3; with older versions OpenSSL keeps its own per-context ticket keys.
+         */
+        void attach(SSL_CTX *ctx) {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+            SSL_CTX_set_ex_data(ctx, detail::ticket_keys_index(), this);
+            SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx, onTicketKey);
+#else
+            (void) ctx;
+#endif
+        }
+
+        struct Key {
+            uint64_t generation;
+            unsigned char name[16];
+            unsigned char aes[32];
+            unsigned char hmac[32];
+        };
+
+        /**
+         * @brief The key new tickets are encrypted with at unix time @p now, rotating first when it is due.
+         *
+         * @return false when the key could not be read or created; no ticket is issued then.
+         */
+        bool current(Key &key, int64_t now = std::time(nullptr)) {
+            return load(advance(now), key);
+        }
+
+        /**
+         * @brief The key named @p name at unix time @p now, of the current or the previous generation.
+         *
+         * @param renew Set when the key is the previous generation's, so the ticket should be reissued.
+         * @return false for an unknown or expired key, the client then runs a full handshake.
+         */
+        bool find(const unsigned char *name, Key &key, bool &renew, int64_t now = std::time(nullptr)) {
+            const uint64_t current = advance(now);
+            for (uint64_t generation: {current, current - 1}) {
+                if (load(generation, key) && CRYPTO_memcmp(key.name, name, sizeof(key.name)) == 0) {
+                    renew = generation != current;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    private:
+
+        uint64_t generationAt(int64_t now) const {
+            return static_cast<uint64_t>(now) / static_cast<uint64_t>(rotation_);
+        }
+
+        detail::SeqRecord<sizeof(Key)> &slotOf(uint64_t generation) {
+            return ring_[generation % ring_.size()];
+        }
+
+        bool publish(uint64_t generation) {
+            Key key{};
+            key.generation = generation;
+            if (secret_.empty()) {
+                if (RAND_bytes(key.name, sizeof(key.name)) <= 0 || RAND_bytes(key.aes, sizeof(key.aes)) <= 0 ||
+                    RAND_bytes(key.hmac, sizeof(key.hmac)) <= 0) {
+                    return false;
+                }
+            } else if (!derive(generation, 'n', key.name, sizeof(key.name)) || !derive(generation, 'a', key.aes, sizeof(key.aes)) ||
+                       !derive(generation, 'h', key.hmac, sizeof(key.hmac))) {
+                return false;
+            }
+            const bool stored = slotOf(generation).tryStore(&key);
+            OPENSSL_cleanse(&key, sizeof(key));
+            return stored;
+        }
+
+        bool derive(uint64_t generation, char label, unsigned char *out, size_t len) const {
+            unsigned char input[sizeof("unet ticket key") + sizeof(generation)];
+            std::memcpy(input, "unet ticket key", sizeof("unet ticket key") - 1);
+            input[sizeof("unet ticket key") - 1] = static_cast<unsigned char>(label);
+            for (size_t i = 0; i < sizeof(generation); ++i) {
+                input[sizeof("unet ticket key") + i] = static_cast<unsigned char>(generation >> (8 * (sizeof(generation) - 1 - i)));
+            }
+            unsigned char digest[EVP_MAX_MD_SIZE];
+            unsigned int digest_len = 0;
+            if (!HMAC(EVP_sha256(), secret_.data(), static_cast<int>(secret_.size()), input, sizeof(input), digest, &digest_len) ||
+                digest_len < len) {
+                return false;
+            }
+            std::memcpy(out, digest, len);
+            OPENSSL_cleanse(digest, sizeof(digest));
+            return true;
+        }
+
+        /**
+         * @brief The current generation, rotating first when the schedule says so.
+         */
+        uint64_t advance(int64_t now) {
+            uint64_t generation = current_.load(std::memory_order_acquire);
+            const uint64_t due = generationAt(now);
+            uint64_t claimed = claimed_.load(std::memory_order_relaxed);
+            // exactly one thread writes the next key; the others keep using the current one until it is published
+            if (due > generation && claimed < due && claimed_.compare_exchange_strong(claimed, due, std::memory_order_acq_rel)) {
+                if (publish(due)) {
+                    current_.store(due, std::memory_order_release);
+                    generation = due;
+                } else {
+                    claimed_.store(generation, std::memory_order_relaxed);
+                }
+            }
+            return generation;
+        }
+
+        bool load(uint64_t generation, Key &key) {
+            return slotOf(generation).tryLoad(&key) && key.generation == generation;
+        }
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+        static int onTicketKey(SSL *ssl, unsigned char *key_name, unsigned char *iv, EVP_CIPHER_CTX *cipher,
+                               EVP_MAC_CTX *mac, int enc) {
+            auto *ring = static_cast<TicketKeyRing *>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), detail::ticket_keys_index()));
+            Key key;
+            int result = 1;
+            if (enc) {
+                if (!ring->current(key)) return 0;// no ticket this time
+                std::memcpy(key_name, key.name, sizeof(key.name));
+                if (RAND_bytes(iv, EVP_CIPHER_get_iv_length(EVP_aes_256_cbc())) <= 0 ||
+                    !EVP_EncryptInit_ex(cipher, EVP_aes_256_cbc(), nullptr, key.aes, iv)) {
+                    result = -1;
+                }
+            } else {
+                bool renew = false;
+                if (!ring->find(key_name, key, renew)) return 0;// unknown or expired key, full handshake
+                if (!EVP_DecryptInit_ex(cipher, EVP_aes_256_cbc(), nullptr, key.aes, iv)) {
+                    result = -1;
+                } else if (renew) {
+                    result = 2;
+                }
+            }
+            if (result > 0) {
+                OSSL_PARAM params[] = {
+                        OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, key.hmac, sizeof(key.hmac)),
+                        OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, const_cast<char *>("SHA256"), 0),
+                        OSSL_PARAM_construct_end()};
+                if (!EVP_MAC_CTX_set_params(mac, params)) result = -1;
+            }
+            OPENSSL_cleanse(&key, sizeof(key));
+            return result;
+        }
+#endif
+
+        int64_t rotation_;
+        std::string secret_;
+        std::array<detail::SeqRecord<sizeof(Key)>, 3> ring_;
+        std::atomic<uint64_t> current_{0};
+        std::atomic<uint64_t> claimed_{0};
+    };
+
+}// namespace usub::utils::ssl
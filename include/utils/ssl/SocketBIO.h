@@ -0,0 +1,194 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <sys/socket.h>
+
+#include <openssl/bio.h>
+#include <openssl/ssl.h>
+
+namespace usub::utils::ssl {
+
+    /**
+     * @brief State behind a BIO created by create_socket_bio() or create_ktls_socket_bio().
+     */
+    struct SocketBioState {
+        int fd{-1};
+        BIO *socket{nullptr};   ///< OpenSSL socket BIO on fd of a create_ktls_socket_bio(), for kernel TLS.
+        std::string output;     ///< Ciphertext the socket did not take yet.
+        const char *input{nullptr};///< Ciphertext the caller received while OpenSSL waited, not owned.
+        size_t input_size{0};
+    };
+
+    namespace detail {
+        inline bool ktls_send_active(const SocketBioState *state) {
+            return state->socket && BIO_get_ktls_send(state->socket);
+        }
+
+        /**
+         * @brief Sends as much of @p data as the socket takes without blocking, returns the bytes sent.
+         */
+        inline size_t socket_bio_send(int fd, const char *data, size_t size) {
+            size_t written = 0;
+            while (written < size) {
+                const ssize_t n = ::send(fd, data + written, size - written, MSG_NOSIGNAL);
+                if (n > 0) {
+                    written += static_cast<size_t>(n);
+                } else if (n < 0 && errno == EINTR) {
+                    continue;
+                } else {
+                    break;
+                }
+            }
+            return written;
+        }
+
+        inline bool socket_bio_drain(SocketBioState *state) {
+            state->output.erase(0, socket_bio_send(state->fd, state->output.data(), state->output.size()));
+            return state->output.empty();
+        }
+
+        inline int socket_bio_write(BIO *bio, const char *data, int len) {
+            auto *state = static_cast<SocketBioState *>(BIO_get_data(bio));
+            BIO_clear_retry_flags(bio);
+            if (ktls_send_active(state)) {
+                // the kernel encrypts, OpenSSL hands over plaintext records
+                const int n = BIO_write(state->socket, data, len);
+                if (n <= 0 && BIO_should_retry(state->socket)) BIO_set_retry_write(bio);
+                return n;
+            }
+            // straight from OpenSSL's record buffer; only what the socket refuses is kept, in order
+            const size_t size = static_cast<size_t>(len);
+            const size_t sent = state->output.empty() ? socket_bio_send(state->fd, data, size) : 0;
+            state->output.append(data + sent, size - sent);
+            return len;
+        }
+
+        inline int socket_bio_read(BIO *bio, char *out, int len) {
+            auto *state = static_cast<SocketBioState *>(BIO_get_data(bio));
+            BIO_clear_retry_flags(bio);
+            if (state->input_size > 0) {
+                const size_t n = std::min(state->input_size, static_cast<size_t>(len));
+                std::memcpy(out, state->input, n);
+                state->input += n;
+                state->input_size -= n;
+                return static_cast<int>(n);
+            }
+            for (;;) {
+                // straight into OpenSSL's record buffer
+                const ssize_t n = ::recv(state->fd, out, static_cast<size_t>(len), 0);
+                if (n >= 0) return static_cast<int>(n);
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) BIO_set_retry_read(bio);
+                return -1;
+            }
+        }
+
+        inline long socket_bio_ctrl(BIO *bio, int cmd, long num, void *ptr) {
+            auto *state = static_cast<SocketBioState *>(BIO_get_data(bio));
+            switch (cmd) {
+                case BIO_CTRL_FLUSH:
+                    // end of a handshake flight, and the precondition OpenSSL checks before enabling kernel TLS
+                    if (ktls_send_active(state) || socket_bio_drain(state)) return 1;
+                    BIO_set_retry_write(bio);
+                    return 0;
+                case BIO_CTRL_WPENDING:
+                    return static_cast<long>(state->output.size());
+                case BIO_CTRL_PENDING:
+                    return static_cast<long>(state->input_size);
+                default:
+                    // kernel TLS controls among them, which OpenSSL's socket BIO carries out on the fd
+                    return state->socket ? BIO_ctrl(state->socket, cmd, num, ptr) : 0;
+            }
+        }
+
+        inline int socket_bio_create(BIO *bio) {
+            BIO_set_data(bio, new SocketBioState());
+            BIO_set_init(bio, 1);
+            return 1;
+        }
+
+        inline int socket_bio_destroy(BIO *bio) {
+            auto *state = static_cast<SocketBioState *>(BIO_get_data(bio));
+            if (state) {
+                if (state->socket) BIO_free(state->socket);
+                delete state;
+            }
+            BIO_set_data(bio, nullptr);
+            return 1;
+        }
+
+        inline BIO_METHOD *socket_bio_method() {
+            static BIO_METHOD *method = [] {
+                BIO_METHOD *m = BIO_meth_new(BIO_get_new_index() | BIO_TYPE_SOURCE_SINK, "unet socket");
+                BIO_meth_set_write(m, socket_bio_write);
+                BIO_meth_set_read(m, socket_bio_read);
+                BIO_meth_set_ctrl(m, socket_bio_ctrl);
+                BIO_meth_set_create(m, socket_bio_create);
+                BIO_meth_set_destroy(m, socket_bio_destroy);
+                return m;
+            }();
+            return method;
+        }
+    }// namespace detail
+
+    /**
+     * @brief Creates a BIO that moves ciphertext between OpenSSL's record buffers and the non-blocking socket @p fd.
+     *
+     * Use it as both rbio and wbio. Reads go straight from the socket into OpenSSL; when the socket has
+     * nothing, the read fails with the retry flag (SSL_ERROR_WANT_READ), the caller waits for data with a
+     * coroutine read and lends it through socket_bio_set_input(). Writes go straight to the socket; what it
+     * does not take is kept for the caller to write from socket_bio_output() (SSL_ERROR_WANT_WRITE on flush).
+     * The BIO does not own @p fd.
+     */
+    inline BIO *create_socket_bio(int fd) {
+        BIO *bio = BIO_new(detail::socket_bio_method());
+        if (!bio) return nullptr;
+        static_cast<SocketBioState *>(BIO_get_data(bio))->fd = fd;
+        return bio;
+    }
+
+    /**
+     * @brief Creates the wbio of a connection that may move transmit encryption into the kernel; the rbio is a
+     *        create_socket_bio() on the same @p fd.
+     *
+     * Writes like create_socket_bio(), and passes the controls it does not handle to an OpenSSL socket BIO on
+     * @p fd. In UNET_KTLS builds, when the SSL_CTX has SSL_OP_ENABLE_KTLS and the kernel accepts the keys (the
+     * "tls" ULP is loaded), OpenSSL switches that socket to kernel TLS during the handshake and
+     * ktls_send_enabled() turns true: from then on plaintext written to the socket, including sendfile(2), goes
+     * out encrypted. The rbio refuses the same request for received records, which OpenSSL keeps decrypting.
+     */
+    inline BIO *create_ktls_socket_bio(int fd) {
+        BIO *bio = create_socket_bio(fd);
+        if (!bio) return nullptr;
+        auto *state = static_cast<SocketBioState *>(BIO_get_data(bio));
+        // BIO_new_socket also enables the TLS ULP on the socket, which kernel TLS needs before the keys
+        state->socket = BIO_new_socket(fd, BIO_NOCLOSE);
+        if (!state->socket) {
+            BIO_free(bio);
+            return nullptr;
+        }
+        return bio;
+    }
+
+    /**
+     * @brief Ciphertext buffered in a create_socket_bio() BIO, to be written and then erased by the caller.
+     */
+    inline std::string &socket_bio_output(BIO *bio) {
+        return static_cast<SocketBioState *>(BIO_get_data(bio))->output;
+    }
+
+    /**
+     * @brief Lends @p size received bytes at @p data to the BIO, read by OpenSSL before the socket again.
+     *
+     * The memory must stay valid until OpenSSL consumed it, that is until the next SSL_ERROR_WANT_READ.
+     */
+    inline void socket_bio_set_input(BIO *bio, const char *data, size_t size) {
+        auto *state = static_cast<SocketBioState *>(BIO_get_data(bio));
+        state->input = data;
+        state->input_size = size;
+    }
+
+}// namespace usub::utils::ssl
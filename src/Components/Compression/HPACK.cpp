@@ -1,3 +1,621 @@
 //
 // Created by kirill on 12/22/24.
 //
+
+#include "Components/Compression/HPACK.h"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include "Protocols/HTTP/Headers.h"
+#include "Protocols/HTTP/header_lookup.h"
+
+namespace usub::server::component {
+
+    namespace {
+        const std::array<hpack::StaticEntry, HPACK_STATIC_TABLE_SIZE> STATIC_TABLE{{
+                {":authority", "", std::nullopt},
+                {":method", "GET", std::nullopt},
+                {":method", "POST", std::nullopt},
+                {":path", "/", std::nullopt},
+                {":path", "/index.html", std::nullopt},
+                {":scheme", "http", std::nullopt},
+                {":scheme", "https", std::nullopt},
+                {":status", "200", std::nullopt},
+                {":status", "204", std::nullopt},
+                {":status", "206", std::nullopt},
+                {":status", "304", std::nullopt},
+                {":status", "400", std::nullopt},
+                {":status", "404", std::nullopt},
+                {":status", "500", std::nullopt},
+                {"accept-charset", "", std::nullopt},
+                {"accept-encoding", "gzip, deflate", HeaderEnum::Accept_Encoding},
+                {"accept-language", "", HeaderEnum::Accept_Language},
+                {"accept-ranges", "", HeaderEnum::Accept_Ranges},
+                {"accept", "", HeaderEnum::Accept},
+                {"access-control-allow-origin", "", HeaderEnum::Access_Control_Allow_Origin},
+                {"age", "", HeaderEnum::Age},
+                {"allow", "", HeaderEnum::Allow},
+                {"authorization", "", HeaderEnum::Authorization},
+                {"cache-control", "", HeaderEnum::Cache_Control},
+                {"content-disposition", "", HeaderEnum::Content_Disposition},
+                {"content-encoding", "", HeaderEnum::Content_Encoding},
+                {"content-language", "", HeaderEnum::Content_Language},
+                {"content-length", "", HeaderEnum::Content_Length},
+                {"content-location", "", HeaderEnum::Content_Location},
+                {"content-range", "", HeaderEnum::Content_Range},
+                {"content-type", "", HeaderEnum::Content_Type},
+                {"cookie", "", HeaderEnum::Cookie},
+                {"date", "", HeaderEnum::Date},
+                {"etag", "", HeaderEnum::Etag},
+                {"expect", "", HeaderEnum::Expect},
+                {"expires", "", HeaderEnum::Expires},
+                {"from", "", HeaderEnum::From},
+                {"host", "", HeaderEnum::Host},
+                {"if-match", "", HeaderEnum::If_Match},
+                {"if-modified-since", "", HeaderEnum::If_Modified_Since},
+                {"if-none-match", "", HeaderEnum::If_None_Match},
+                {"if-range", "", HeaderEnum::If_Range},
+                {"if-unmodified-since", "", HeaderEnum::If_Unmodified_Since},
+                {"last-modified", "", HeaderEnum::Last_Modified},
+                {"link", "", HeaderEnum::Link},
+                {"location", "", HeaderEnum::Location},
+                {"max-forwards", "", HeaderEnum::Max_Forwards},
+                {"proxy-authenticate", "", HeaderEnum::Proxy_Authenticate},
+                {"proxy-authorization", "", HeaderEnum::Proxy_Authorization},
+                {"range", "", HeaderEnum::Range},
+                {"referer", "", HeaderEnum::Referer},
+                {"refresh", "", HeaderEnum::Refresh},
+                {"retry-after", "", HeaderEnum::Retry_After},
+                {"server", "", HeaderEnum::Server},
+                {"set-cookie", "", HeaderEnum::Set_Cookie},
+                {"strict-transport-security", "", HeaderEnum::Strict_Transport_Security},
+                {"transfer-encoding", "", HeaderEnum::Transfer_Encoding},
+                {"user-agent", "", HeaderEnum::User_Agent},
+                {"vary", "", std::nullopt},
+                {"via", "", std::nullopt},
+                {"www-authenticate", "", HeaderEnum::WWW_Authenticate},
+        }};
+
+        struct HuffmanCode {
+            uint32_t code;
+            uint8_t bits;
+        };
+
+        /// Canonical codes of RFC 7541, Appendix B; symbol 256 is EOS.
+        constexpr std::array<HuffmanCode, 257> HUFFMAN_CODES{{
+            {0x00001ff8, 13}, {0x007fffd8, 23}, {0x0fffffe2, 28}, {0x0fffffe3, 28}, {0x0fffffe4, 28}, {0x0fffffe5, 28},
+            {0x0fffffe6, 28}, {0x0fffffe7, 28}, {0x0fffffe8, 28}, {0x00ffffea, 24}, {0x3ffffffc, 30}, {0x0fffffe9, 28},
+            {0x0fffffea, 28}, {0x3ffffffd, 30}, {0x0fffffeb, 28}, {0x0fffffec, 28}, {0x0fffffed, 28}, {0x0fffffee, 28},
+            {0x0fffffef, 28}, {0x0ffffff0, 28}, {0x0ffffff1, 28}, {0x0ffffff2, 28}, {0x3ffffffe, 30}, {0x0ffffff3, 28},
+            {0x0ffffff4, 28}, {0x0ffffff5, 28}, {0x0ffffff6, 28}, {0x0ffffff7, 28}, {0x0ffffff8, 28}, {0x0ffffff9, 28},
+            {0x0ffffffa, 28}, {0x0ffffffb, 28}, {0x00000014, 6}, {0x000003f8, 10}, {0x000003f9, 10}, {0x00000ffa, 12},
+            {0x00001ff9, 13}, {0x00000015, 6}, {0x000000f8, 8}, {0x000007fa, 11}, {0x000003fa, 10}, {0x000003fb, 10},
+            {0x000000f9, 8}, {0x000007fb, 11}, {0x000000fa, 8}, {0x00000016, 6}, {0x00000017, 6}, {0x00000018, 6},
+            {0x00000000, 5}, {0x00000001, 5}, {0x00000002, 5}, {0x00000019, 6}, {0x0000001a, 6}, {0x0000001b, 6},
+            {0x0000001c, 6}, {0x0000001d, 6}, {0x0000001e, 6}, {0x0000001f, 6}, {0x0000005c, 7}, {0x000000fb, 8},
+            {0x00007ffc, 15}, {0x00000020, 6}, {0x00000ffb, 12}, {0x000003fc, 10}, {0x00001ffa, 13}, {0x00000021, 6},
+            {0x0000005d, 7}, {0x0000005e, 7}, {0x0000005f, 7}, {0x00000060, 7}, {0x00000061, 7}, {0x00000062, 7},
+            {0x00000063, 7}, {0x00000064, 7}, {0x00000065, 7}, {0x00000066, 7}, {0x00000067, 7}, {0x00000068, 7},
+            {0x00000069, 7}, {0x0000006a, 7}, {0x0000006b, 7}, {0x0000006c, 7}, {0x0000006d, 7}, {0x0000006e, 7},
+            {0x0000006f, 7}, {0x00000070, 7}, {0x00000071, 7}, {0x00000072, 7}, {0x000000fc, 8}, {0x00000073, 7},
+            {0x000000fd, 8}, {0x00001ffb, 13}, {0x0007fff0, 19}, {0x00001ffc, 13}, {0x00003ffc, 14}, {0x00000022, 6},
+            {0x00007ffd, 15}, {0x00000003, 5}, {0x00000023, 6}, {0x00000004, 5}, {0x00000024, 6}, {0x00000005, 5},
+            {0x00000025, 6}, {0x00000026, 6}, {0x00000027, 6}, {0x00000006, 5}, {0x00000074, 7}, {0x00000075, 7},
+            {0x00000028, 6}, {0x00000029, 6}, {0x0000002a, 6}, {0x00000007, 5}, {0x0000002b, 6}, {0x00000076, 7},
+            {0x0000002c, 6}, {0x00000008, 5}, {0x00000009, 5}, {0x0000002d, 6}, {0x00000077, 7}, {0x00000078, 7},
+            {0x00000079, 7}, {0x0000007a, 7}, {0x0000007b, 7}, {0x00007ffe, 15}, {0x000007fc, 11}, {0x00003ffd, 14},
+            {0x00001ffd, 13}, {0x0ffffffc, 28}, {0x000fffe6, 20}, {0x003fffd2, 22}, {0x000fffe7, 20}, {0x000fffe8, 20},
+            {0x003fffd3, 22}, {0x003fffd4, 22}, {0x003fffd5, 22}, {0x007fffd9, 23}, {0x003fffd6, 22}, {0x007fffda, 23},
+            {0x007fffdb, 23}, {0x007fffdc, 23}, {0x007fffdd, 23}, {0x007fffde, 23}, {0x00ffffeb, 24}, {0x007fffdf, 23},
+            {0x00ffffec, 24}, {0x00ffffed, 24}, {0x003fffd7, 22}, {0x007fffe0, 23}, {0x00ffffee, 24}, {0x007fffe1, 23},
+            {0x007fffe2, 23}, {0x007fffe3, 23}, {0x007fffe4, 23}, {0x001fffdc, 21}, {0x003fffd8, 22}, {0x007fffe5, 23},
+            {0x003fffd9, 22}, {0x007fffe6, 23}, {0x007fffe7, 23}, {0x00ffffef, 24}, {0x003fffda, 22}, {0x001fffdd, 21},
+            {0x000fffe9, 20}, {0x003fffdb, 22}, {0x003fffdc, 22}, {0x007fffe8, 23}, {0x007fffe9, 23}, {0x001fffde, 21},
+            {0x007fffea, 23}, {0x003fffdd, 22}, {0x003fffde, 22}, {0x00fffff0, 24}, {0x001fffdf, 21}, {0x003fffdf, 22},
+            {0x007fffeb, 23}, {0x007fffec, 23}, {0x001fffe0, 21}, {0x001fffe1, 21}, {0x003fffe0, 22}, {0x001fffe2, 21},
+            {0x007fffed, 23}, {0x003fffe1, 22}, {0x007fffee, 23}, {0x007fffef, 23}, {0x000fffea, 20}, {0x003fffe2, 22},
+            {0x003fffe3, 22}, {0x003fffe4, 22}, {0x007ffff0, 23}, {0x003fffe5, 22}, {0x003fffe6, 22}, {0x007ffff1, 23},
+            {0x03ffffe0, 26}, {0x03ffffe1, 26}, {0x000fffeb, 20}, {0x0007fff1, 19}, {0x003fffe7, 22}, {0x007ffff2, 23},
+            {0x003fffe8, 22}, {0x01ffffec, 25}, {0x03ffffe2, 26}, {0x03ffffe3, 26}, {0x03ffffe4, 26}, {0x07ffffde, 27},
+            {0x07ffffdf, 27}, {0x03ffffe5, 26}, {0x00fffff1, 24}, {0x01ffffed, 25}, {0x0007fff2, 19}, {0x001fffe3, 21},
+            {0x03ffffe6, 26}, {0x07ffffe0, 27}, {0x07ffffe1, 27}, {0x03ffffe7, 26}, {0x07ffffe2, 27}, {0x00fffff2, 24},
+            {0x001fffe4, 21}, {0x001fffe5, 21}, {0x03ffffe8, 26}, {0x03ffffe9, 26}, {0x0ffffffd, 28}, {0x07ffffe3, 27},
+            {0x07ffffe4, 27}, {0x07ffffe5, 27}, {0x000fffec, 20}, {0x00fffff3, 24}, {0x000fffed, 20}, {0x001fffe6, 21},
+            {0x003fffe9, 22}, {0x001fffe7, 21}, {0x001fffe8, 21}, {0x007ffff3, 23}, {0x003fffea, 22}, {0x003fffeb, 22},
+            {0x01ffffee, 25}, {0x01ffffef, 25}, {0x00fffff4, 24}, {0x00fffff5, 24}, {0x03ffffea, 26}, {0x007ffff4, 23},
+            {0x03ffffeb, 26}, {0x07ffffe6, 27}, {0x03ffffec, 26}, {0x03ffffed, 26}, {0x07ffffe7, 27}, {0x07ffffe8, 27},
+            {0x07ffffe9, 27}, {0x07ffffea, 27}, {0x07ffffeb, 27}, {0x0ffffffe, 28}, {0x07ffffec, 27}, {0x07ffffed, 27},
+            {0x07ffffee, 27}, {0x07ffffef, 27}, {0x07fffff0, 27}, {0x03ffffee, 26}, {0x3fffffff, 30},
+        }};
+
+        constexpr uint16_t HUFFMAN_EOS = 256;
+
+        /**
+         * @brief Huffman decoding as a state machine consuming four bits per step.
+         *
+         * A state is an inner node of the code tree, the root being state 0. Every code is at least five bits
+         * long, so one step completes at most one symbol.
+         */
+        struct HuffmanTable {
+            enum Flags : uint8_t {
+                SYMBOL = 0x1,///< The step completed `symbol`.
+                FAIL = 0x2,  ///< The bits lead nowhere or to EOS.
+                ACCEPT = 0x4,///< Input may end after this step: the bits since the last symbol are at most 7 ones.
+            };
+
+            struct Step {
+                uint8_t state;
+                uint8_t flags;
+                uint8_t symbol;
+            };
+
+            std::array<std::array<Step, 16>, 256> steps{};
+
+            HuffmanTable() {
+                struct Node {
+                    int16_t child[2]{-1, -1};
+                    int16_t symbol{-1};
+                };
+                std::vector<Node> nodes(1);
+                for (uint16_t symbol = 0; symbol < HUFFMAN_CODES.size(); ++symbol) {
+                    const HuffmanCode code = HUFFMAN_CODES[symbol];
+                    size_t node = 0;
+                    for (int bit = code.bits - 1; bit >= 0; --bit) {
+                        const int b = (code.code >> bit) & 1;
+                        if (nodes[node].child[b] < 0) {
+                            nodes[node].child[b] = static_cast<int16_t>(nodes.size());
+                            nodes.emplace_back();
+                        }
+                        node = static_cast<size_t>(nodes[node].child[b]);
+                    }
+                    nodes[node].symbol = static_cast<int16_t>(symbol);
+                }
+
+                // number the inner nodes; 257 leaves make exactly 256 of them
+                std::vector<int16_t> state_of(nodes.size(), -1);
+                std::vector<size_t> node_of;
+                for (size_t node = 0; node < nodes.size(); ++node) {
+                    if (nodes[node].symbol >= 0) continue;
+                    state_of[node] = static_cast<int16_t>(node_of.size());
+                    node_of.push_back(node);
+                }
+                std::vector<bool> accepting(node_of.size(), false);
+                for (size_t node = 0, depth = 0; depth < 8; ++depth, node = static_cast<size_t>(nodes[node].child[1])) {
+                    accepting[static_cast<size_t>(state_of[node])] = true;
+                }
+
+                for (size_t state = 0; state < node_of.size(); ++state) {
+                    for (uint8_t nibble = 0; nibble < 16; ++nibble) {
+                        Step &step = this->steps[state][nibble];
+                        size_t node = node_of[state];
+                        for (int bit = 3; bit >= 0; --bit) {
+                            const int16_t next = nodes[node].child[(nibble >> bit) & 1];
+                            if (next < 0 || nodes[static_cast<size_t>(next)].symbol == HUFFMAN_EOS) {
+                                step.flags = FAIL;
+                                break;
+                            }
+                            node = static_cast<size_t>(next);
+                            if (nodes[node].symbol >= 0) {
+                                step.flags |= SYMBOL;
+                                step.symbol = static_cast<uint8_t>(nodes[node].symbol);
+                                node = 0;
+                            }
+                        }
+                        if (step.flags & FAIL) continue;
+                        step.state = static_cast<uint8_t>(state_of[node]);
+                        if (accepting[step.state]) step.flags |= ACCEPT;
+                    }
+                }
+            }
+        };
+
+        const HuffmanTable &huffman_table() {
+            static const HuffmanTable table;
+            return table;
+        }
+
+        /**
+         * @brief Static index of the pseudo-header @p name, 0 for other names.
+         */
+        size_t pseudoIndex(std::string_view name) {
+            if (name == ":authority") return 1;
+            if (name == ":method") return 2;
+            if (name == ":path") return 4;
+            if (name == ":scheme") return 6;
+            if (name == ":status") return 8;
+            return 0;
+        }
+
+        /**
+         * @brief First static index of every HeaderEnum name, 0 for names the table does not have.
+         */
+        const std::vector<uint8_t> &static_index_by_header() {
+            static const std::vector<uint8_t> index = [] {
+                std::vector<uint8_t> index(std::size(header_enum_to_string_lower), 0);
+                for (size_t i = STATIC_TABLE.size(); i > 0; --i) {
+                    if (STATIC_TABLE[i - 1].header) index[static_cast<size_t>(*STATIC_TABLE[i - 1].header)] = static_cast<uint8_t>(i);
+                }
+                return index;
+            }();
+            return index;
+        }
+
+    }// namespace
+
+    void hpack::encodeInteger(std::string &out, uint8_t flags, uint8_t prefix_bits, uint64_t value) {
+        const uint64_t max_prefix = (1u << prefix_bits) - 1;
+        if (value < max_prefix) {
+            out.push_back(static_cast<char>(flags | value));
+            return;
+        }
+        out.push_back(static_cast<char>(flags | max_prefix));
+        value -= max_prefix;
+        while (value >= 128) {
+            out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    bool hpack::decodeInteger(std::string_view in, size_t &pos, uint8_t prefix_bits, uint64_t &value) {
+        if (pos >= in.size()) return false;
+        const uint64_t max_prefix = (1u << prefix_bits) - 1;
+        value = static_cast<uint8_t>(in[pos++]) & max_prefix;
+        if (value < max_prefix) return true;
+        for (unsigned shift = 0; pos < in.size(); shift += 7) {
+            const uint8_t byte = static_cast<uint8_t>(in[pos++]);
+            value += static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (value > UINT32_MAX) return false;
+            if (!(byte & 0x80)) return true;
+            if (shift > 28) return false;
+        }
+        return false;
+    }
+
+    bool hpack::huffmanDecode(std::string_view in, std::string &out) {
+        const auto &steps = huffman_table().steps;
+        uint8_t state = 0;
+        uint8_t flags = HuffmanTable::ACCEPT;
+        auto advance = [&](uint8_t nibble) {
+            const HuffmanTable::Step &step = steps[state][nibble];
+            if (step.flags & HuffmanTable::SYMBOL) out.push_back(static_cast<char>(step.symbol));
+            state = step.state;
+            flags = step.flags;
+            return !(step.flags & HuffmanTable::FAIL);
+        };
+        out.reserve(out.size() + in.size() * 8 / 5);
+        for (char c: in) {
+            const uint8_t byte = static_cast<uint8_t>(c);
+            if (!advance(byte >> 4) || !advance(byte & 0xf)) return false;
+        }
+        return flags & HuffmanTable::ACCEPT;
+    }
+
+    size_t hpack::huffmanLength(std::string_view in) {
+        size_t bits = 0;
+        for (char c: in) bits += HUFFMAN_CODES[static_cast<uint8_t>(c)].bits;
+        return (bits + 7) / 8;
+    }
+
+    void hpack::huffmanEncode(std::string_view in, std::string &out) {
+        uint64_t buffer = 0;
+        unsigned pending = 0;
+        for (char c: in) {
+            const HuffmanCode code = HUFFMAN_CODES[static_cast<uint8_t>(c)];
+            buffer = (buffer << code.bits) | code.code;
+            pending += code.bits;
+            while (pending >= 8) {
+                pending -= 8;
+                out.push_back(static_cast<char>(buffer >> pending));
+            }
+        }
+        if (pending > 0) {
+            // the most significant bits of EOS, all ones
+            out.push_back(static_cast<char>((buffer << (8 - pending)) | (0xff >> pending)));
+        }
+    }
+
+    void hpack::encodeString(std::string &out, std::string_view in, uint8_t flags, uint8_t prefix_bits) {
+        const uint8_t huffman_flag = static_cast<uint8_t>(1u << prefix_bits);
+        const size_t huffman = huffmanLength(in);
+        if (huffman < in.size()) {
+            encodeInteger(out, flags | huffman_flag, prefix_bits, huffman);
+            huffmanEncode(in, out);
+        } else {
+            encodeInteger(out, flags, prefix_bits, in.size());
+            out.append(in);
+        }
+    }
+
+    bool hpack::decodeString(std::string_view in, size_t &pos, uint8_t prefix_bits, std::string &out) {
+        out.clear();
+        if (pos >= in.size()) return false;
+        const bool huffman = static_cast<uint8_t>(in[pos]) & (1u << prefix_bits);
+        uint64_t length = 0;
+        if (!decodeInteger(in, pos, prefix_bits, length) || length > in.size() - pos) return false;
+        const std::string_view raw = in.substr(pos, length);
+        pos += length;
+        if (!huffman) {
+            out.assign(raw);
+            return true;
+        }
+        return huffmanDecode(raw, out);
+    }
+
+    std::optional<HeaderEnum> hpack::lookupHeader(std::string_view name) {
+        const HeaderInfo *info = HTTPHeaderLookup::lookupHeader(name.data(), static_cast<unsigned int>(name.size()));
+        if (!info) return std::nullopt;
+        return info->id;
+    }
+
+    hpack::Indexing hpack::indexing(std::optional<HeaderEnum> header, std::string_view name, std::string_view value) {
+        if (!header) {
+            // a path is rarely requested twice on one connection
+            return name == ":path" ? Indexing::WITHOUT : Indexing::INCREMENTAL;
+        }
+        switch (*header) {
+            case HeaderEnum::Authorization:
+            case HeaderEnum::Proxy_Authorization:
+            case HeaderEnum::Set_Cookie:
+                return Indexing::NEVER;
+            case HeaderEnum::Cookie:
+                // short cookies can be guessed one compressed request at a time
+                return value.size() < 20 ? Indexing::NEVER : Indexing::INCREMENTAL;
+            case HeaderEnum::Age:
+            case HeaderEnum::Content_Length:
+            case HeaderEnum::Content_Range:
+            case HeaderEnum::Etag:
+            case HeaderEnum::If_Modified_Since:
+            case HeaderEnum::If_None_Match:
+            case HeaderEnum::Last_Modified:
+            case HeaderEnum::Location:
+                return Indexing::WITHOUT;
+            default:
+                return Indexing::INCREMENTAL;
+        }
+    }
+
+    const hpack::StaticEntry &hpack::staticEntry(size_t index) {
+        return STATIC_TABLE[index - 1];
+    }
+
+    size_t hpack::staticIndex(HeaderEnum header) {
+        const auto &index = static_index_by_header();
+        const auto i = static_cast<size_t>(header);
+        return i < index.size() ? index[i] : 0;
+    }
+
+    size_t hpack::staticIndex(std::string_view name) {
+        if (name.starts_with(':')) return pseudoIndex(name);
+        if (const auto header = lookupHeader(name)) return staticIndex(*header);
+        if (name == "accept-charset") return 15;
+        if (name == "vary") return 59;
+        if (name == "via") return 60;
+        return 0;
+    }
+
+    hpack::DynamicTable::DynamicTable(size_t max_capacity)
+        : capacity_(max_capacity), max_capacity_(max_capacity) {
+        this->slots_.resize(std::max<size_t>(max_capacity / HPACK_ENTRY_OVERHEAD, 1));
+    }
+
+    const hpack::DynamicTable::Entry *hpack::DynamicTable::at(size_t index) const {
+        if (index >= this->count_) return nullptr;
+        return &this->slots_[this->slot(index)];
+    }
+
+    void hpack::DynamicTable::evict(size_t capacity) {
+        while (this->size_ > capacity && this->count_ > 0) {
+            Entry &oldest = this->slots_[this->slot(this->count_ - 1)];
+            this->size_ -= oldest.field.size() + HPACK_ENTRY_OVERHEAD;
+            --this->count_;
+            // keep the storage for the next entry in this slot, unless it is unusually large
+            if (oldest.field.capacity() > 256) std::string().swap(oldest.field);
+        }
+    }
+
+    void hpack::DynamicTable::insert(std::string_view name, std::string_view value, std::optional<HeaderEnum> header) {
+        const size_t entry_size = name.size() + value.size() + HPACK_ENTRY_OVERHEAD;
+        if (entry_size > this->capacity_) {
+            this->evict(0);
+            return;
+        }
+        this->evict(this->capacity_ - entry_size);
+        const size_t next = (this->head_ + 1) % this->slots_.size();
+        Entry &entry = this->slots_[next];
+        entry.field.assign(name);
+        entry.field.append(value);
+        entry.name_size = name.size();
+        entry.header = header;
+        this->head_ = next;
+        ++this->count_;
+        this->size_ += entry_size;
+    }
+
+    void hpack::DynamicTable::setCapacity(size_t capacity) {
+        this->capacity_ = std::min(capacity, this->max_capacity_);
+        this->evict(this->capacity_);
+    }
+
+    void hpack::DynamicTable::setMaxCapacity(size_t max_capacity) {
+        this->max_capacity_ = max_capacity;
+        this->setCapacity(this->capacity_);
+        const size_t slots = std::max<size_t>(max_capacity / HPACK_ENTRY_OVERHEAD, 1);
+        if (slots == this->slots_.size()) return;
+        // lay the remaining entries out again, newest in the last used slot
+        std::vector<Entry> resized(slots);
+        for (size_t i = 0; i < this->count_; ++i) {
+            resized[this->count_ - 1 - i] = std::move(this->slots_[this->slot(i)]);
+        }
+        this->slots_ = std::move(resized);
+        this->head_ = this->count_ == 0 ? 0 : this->count_ - 1;
+    }
+
+    ptrdiff_t hpack::DynamicTable::find(std::string_view name, std::string_view value, bool &exact) const {
+        ptrdiff_t name_match = -1;
+        for (size_t i = 0; i < this->count_; ++i) {
+            const Entry &entry = this->slots_[this->slot(i)];
+            if (entry.name() != name) continue;
+            if (entry.value() == value) {
+                exact = true;
+                return static_cast<ptrdiff_t>(i);
+            }
+            if (name_match < 0) name_match = static_cast<ptrdiff_t>(i);
+        }
+        exact = false;
+        return name_match;
+    }
+
+    HPACKDecoder::HPACKDecoder(size_t max_table_size) : table_(max_table_size) {}
+
+    void HPACKDecoder::setMaxTableSize(size_t size) {
+        this->table_.setMaxCapacity(size);
+    }
+
+    template<class OnField>
+    std::expected<void, usub::server::utils::error::ParseError> HPACKDecoder::decodeBlock(std::string_view block, OnField &&on_field) {
+        using usub::server::utils::error::crit;
+        bool fields_seen = false;
+        for (size_t pos = 0; pos < block.size();) {
+            const uint8_t first = static_cast<uint8_t>(block[pos]);
+            std::string_view name;
+            std::string_view value;
+            std::optional<HeaderEnum> header;
+            uint64_t index = 0;
+
+            // the name (and value) of an index, from either table
+            auto lookup = [&](uint64_t i) {
+                if (i == 0) return false;
+                if (i <= HPACK_STATIC_TABLE_SIZE) {
+                    const hpack::StaticEntry &entry = STATIC_TABLE[i - 1];
+                    name = entry.name;
+                    value = entry.value;
+                    header = entry.header;
+                    return true;
+                }
+                const hpack::DynamicTable::Entry *entry = this->table_.at(i - HPACK_STATIC_TABLE_SIZE - 1);
+                if (!entry) return false;
+                name = entry->name();
+                value = entry->value();
+                header = entry->header;
+                return true;
+            };
+
+            if (first & 0x80) {
+                // indexed field
+                if (!hpack::decodeInteger(block, pos, 7, index) || !lookup(index)) return crit("HPACK: invalid index");
+            } else if ((first & 0xe0) == 0x20) {
+                // dynamic table size update, only before the first field of a block
+                uint64_t size = 0;
+                if (fields_seen || !hpack::decodeInteger(block, pos, 5, size) || size > this->table_.maxCapacity())
+                    return crit("HPACK: invalid table size update");
+                this->table_.setCapacity(static_cast<size_t>(size));
+                continue;
+            } else {
+                // literal, with incremental indexing (01), without indexing (0000) or never indexed (0001)
+                const bool indexing = (first & 0xc0) == 0x40;
+                if (!hpack::decodeInteger(block, pos, indexing ? 6 : 4, index)) return crit("HPACK: truncated field");
+                if (index == 0) {
+                    if (!hpack::decodeString(block, pos, 7, this->name_)) return crit("HPACK: invalid name");
+                    name = this->name_;
+                    header = hpack::lookupHeader(name);
+                } else {
+                    if (!lookup(index)) return crit("HPACK: invalid index");
+                    // inserting may evict the entry the name comes from
+                    this->name_.assign(name);
+                    name = this->name_;
+                }
+                if (!hpack::decodeString(block, pos, 7, this->value_)) return crit("HPACK: invalid value");
+                value = this->value_;
+                if (indexing) this->table_.insert(name, value, header);
+            }
+            fields_seen = true;
+            if (!on_field(name, value, header)) return {};
+        }
+        return {};
+    }
+
+    std::expected<void, usub::server::utils::error::ParseError>
+    HPACKDecoder::decode(std::string_view block, const FieldCallback &field) {
+        return this->decodeBlock(block, [&](std::string_view name, std::string_view value, std::optional<HeaderEnum>) {
+            return field(name, value);
+        });
+    }
+
+    std::expected<void, usub::server::utils::error::ParseError>
+    HPACKDecoder::decode(std::string_view block, usub::server::protocols::http::Headers &headers, const FieldCallback &pseudo) {
+        return this->decodeBlock(block, [&](std::string_view name, std::string_view value, std::optional<HeaderEnum> header) {
+            if (!header && name.starts_with(':')) return pseudo ? pseudo(name, value) : true;
+            // known names are stored by HeaderEnum, whatever the case they arrived in
+            std::string key(header ? std::string_view(header_enum_to_string_lower[static_cast<size_t>(*header)]) : name);
+            (void) headers.addHeader<usub::server::protocols::http::Request>(std::move(key), std::string(value));
+            return true;
+        });
+    }
+
+    HPACKEncoder::HPACKEncoder(size_t max_table_size)
+        : table_(max_table_size), limit_(max_table_size) {
+        // the peer allows HPACK_DEFAULT_TABLE_SIZE until its SETTINGS say otherwise; a smaller limit is announced
+        this->table_.setCapacity(std::min(max_table_size, HPACK_DEFAULT_TABLE_SIZE));
+        this->smallest_update_ = this->table_.capacity();
+        this->size_update_ = this->table_.capacity() != HPACK_DEFAULT_TABLE_SIZE;
+    }
+
+    void HPACKEncoder::setMaxTableSize(size_t size) {
+        const size_t capacity = std::min(size, this->limit_);
+        if (capacity == this->table_.capacity()) return;
+        this->table_.setCapacity(capacity);
+        this->smallest_update_ = std::min(this->smallest_update_, capacity);
+        this->size_update_ = true;
+    }
+
+    void HPACKEncoder::begin(std::string &out) {
+        if (!this->size_update_) return;
+        // a table that shrank and grew again since the last block needs both sizes (RFC 7541, 4.2)
+        if (this->smallest_update_ < this->table_.capacity()) hpack::encodeInteger(out, 0x20, 5, this->smallest_update_);
+        hpack::encodeInteger(out, 0x20, 5, this->table_.capacity());
+        this->smallest_update_ = this->table_.capacity();
+        this->size_update_ = false;
+    }
+
+    void HPACKEncoder::encode(std::string &out, std::string_view name, std::string_view value) {
+        const std::optional<HeaderEnum> header = name.starts_with(':') ? std::nullopt : hpack::lookupHeader(name);
+        size_t name_index = header ? hpack::staticIndex(*header) : hpack::staticIndex(name);
+        if (name_index > 0) {
+            // entries of one name are adjacent in the static table
+            for (size_t i = name_index; i <= HPACK_STATIC_TABLE_SIZE && STATIC_TABLE[i - 1].name == name; ++i) {
+                if (STATIC_TABLE[i - 1].value == value) {
+                    hpack::encodeInteger(out, 0x80, 7, i);
+                    return;
+                }
+            }
+        }
+
+        const hpack::Indexing mode = hpack::indexing(header, name, value);
+        if (mode != hpack::Indexing::NEVER) {
+            bool exact = false;
+            const ptrdiff_t found = this->table_.find(name, value, exact);
+            if (exact) {
+                hpack::encodeInteger(out, 0x80, 7, HPACK_STATIC_TABLE_SIZE + 1 + static_cast<size_t>(found));
+                return;
+            }
+            if (found >= 0 && name_index == 0) name_index = HPACK_STATIC_TABLE_SIZE + 1 + static_cast<size_t>(found);
+        }
+
+        // an entry taking most of the table would only push out the others
+        const size_t entry_size = name.size() + value.size() + HPACK_ENTRY_OVERHEAD;
+        if (mode == hpack::Indexing::INCREMENTAL && entry_size <= this->table_.capacity() * 3 / 4) {
+            hpack::encodeInteger(out, 0x40, 6, name_index);
+            if (name_index == 0) hpack::encodeString(out, name);
+            hpack::encodeString(out, value);
+            this->table_.insert(name, value, header);
+            return;
+        }
+        hpack::encodeInteger(out, mode == hpack::Indexing::NEVER ? 0x10 : 0x00, 4, name_index);
+        if (name_index == 0) hpack::encodeString(out, name);
+        hpack::encodeString(out, value);
+    }
+
+}// namespace usub::server::component
@@ -1,3 +1,642 @@
 //
 // Created by kirill on 12/22/24.
 //
+
+#include "Components/Compression/QPACK.h"
+
+#include <algorithm>
+#include <array>
+
+#include "Protocols/HTTP/Headers.h"
+
+namespace usub::server::component {
+
+    namespace {
+        const std::array<hpack::StaticEntry, QPACK_STATIC_TABLE_SIZE> STATIC_TABLE{{
+                {":authority", "", std::nullopt},
+                {":path", "/", std::nullopt},
+                {"age", "0", HeaderEnum::Age},
+                {"content-disposition", "", HeaderEnum::Content_Disposition},
+                {"content-length", "0", HeaderEnum::Content_Length},
+                {"cookie", "", HeaderEnum::Cookie},
+                {"date", "", HeaderEnum::Date},
+                {"etag", "", HeaderEnum::Etag},
+                {"if-modified-since", "", HeaderEnum::If_Modified_Since},
+                {"if-none-match", "", HeaderEnum::If_None_Match},
+                {"last-modified", "", HeaderEnum::Last_Modified},
+                {"link", "", HeaderEnum::Link},
+                {"location", "", HeaderEnum::Location},
+                {"referer", "", HeaderEnum::Referer},
+                {"set-cookie", "", HeaderEnum::Set_Cookie},
+                {":method", "CONNECT", std::nullopt},
+                {":method", "DELETE", std::nullopt},
+                {":method", "GET", std::nullopt},
+                {":method", "HEAD", std::nullopt},
+                {":method", "OPTIONS", std::nullopt},
+                {":method", "POST", std::nullopt},
+                {":method", "PUT", std::nullopt},
+                {":scheme", "http", std::nullopt},
+                {":scheme", "https", std::nullopt},
+                {":status", "103", std::nullopt},
+                {":status", "200", std::nullopt},
+                {":status", "304", std::nullopt},
+                {":status", "404", std::nullopt},
+                {":status", "503", std::nullopt},
+                {"accept", "*/*", HeaderEnum::Accept},
+                {"accept", "application/dns-message", HeaderEnum::Accept},
+                {"accept-encoding", "gzip, deflate, br", HeaderEnum::Accept_Encoding},
+                {"accept-ranges", "bytes", HeaderEnum::Accept_Ranges},
+                {"access-control-allow-headers", "cache-control", HeaderEnum::Access_Control_Allow_Headers},
+                {"access-control-allow-headers", "content-type", HeaderEnum::Access_Control_Allow_Headers},
+                {"access-control-allow-origin", "*", HeaderEnum::Access_Control_Allow_Origin},
+                {"cache-control", "max-age=0", HeaderEnum::Cache_Control},
+                {"cache-control", "max-age=2592000", HeaderEnum::Cache_Control},
+                {"cache-control", "max-age=604800", HeaderEnum::Cache_Control},
+                {"cache-control", "no-cache", HeaderEnum::Cache_Control},
+                {"cache-control", "no-store", HeaderEnum::Cache_Control},
+                {"cache-control", "public, max-age=31536000", HeaderEnum::Cache_Control},
+                {"content-encoding", "br", HeaderEnum::Content_Encoding},
+                {"content-encoding", "gzip", HeaderEnum::Content_Encoding},
+                {"content-type", "application/dns-message", HeaderEnum::Content_Type},
+                {"content-type", "application/javascript", HeaderEnum::Content_Type},
+                {"content-type", "application/json", HeaderEnum::Content_Type},
+                {"content-type", "application/x-www-form-urlencoded", HeaderEnum::Content_Type},
+                {"content-type", "image/gif", HeaderEnum::Content_Type},
+                {"content-type", "image/jpeg", HeaderEnum::Content_Type},
+                {"content-type", "image/png", HeaderEnum::Content_Type},
+                {"content-type", "text/css", HeaderEnum::Content_Type},
+                {"content-type", "text/html; charset=utf-8", HeaderEnum::Content_Type},
+                {"content-type", "text/plain", HeaderEnum::Content_Type},
+                {"content-type", "text/plain;charset=utf-8", HeaderEnum::Content_Type},
+                {"range", "bytes=0-", HeaderEnum::Range},
+                {"strict-transport-security", "max-age=31536000", HeaderEnum::Strict_Transport_Security},
+                {"strict-transport-security", "max-age=31536000; includesubdomains", HeaderEnum::Strict_Transport_Security},
+                {"strict-transport-security", "max-age=31536000; includesubdomains; preload", HeaderEnum::Strict_Transport_Security},
+                {"vary", "accept-encoding", std::nullopt},
+                {"vary", "origin", std::nullopt},
+                {"x-content-type-options", "nosniff", HeaderEnum::X_Content_Type_Options},
+                {"x-xss-protection", "1; mode=block", HeaderEnum::X_XSS_Protection},
+                {":status", "100", std::nullopt},
+                {":status", "204", std::nullopt},
+                {":status", "206", std::nullopt},
+                {":status", "302", std::nullopt},
+                {":status", "400", std::nullopt},
+                {":status", "403", std::nullopt},
+                {":status", "421", std::nullopt},
+                {":status", "425", std::nullopt},
+                {":status", "500", std::nullopt},
+                {"accept-language", "", HeaderEnum::Accept_Language},
+                {"access-control-allow-credentials", "FALSE", HeaderEnum::Access_Control_Allow_Credentials},
+                {"access-control-allow-credentials", "TRUE", HeaderEnum::Access_Control_Allow_Credentials},
+                {"access-control-allow-headers", "*", HeaderEnum::Access_Control_Allow_Headers},
+                {"access-control-allow-methods", "get", HeaderEnum::Access_Control_Allow_Methods},
+                {"access-control-allow-methods", "get, post, options", HeaderEnum::Access_Control_Allow_Methods},
+                {"access-control-allow-methods", "options", HeaderEnum::Access_Control_Allow_Methods},
+                {"access-control-expose-headers", "content-length", HeaderEnum::Access_Control_Expose_Headers},
+                {"access-control-request-headers", "content-type", HeaderEnum::Access_Control_Request_Headers},
+                {"access-control-request-method", "get", HeaderEnum::Access_Control_Request_Method},
+                {"access-control-request-method", "post", HeaderEnum::Access_Control_Request_Method},
+                {"alt-svc", "clear", HeaderEnum::Alt_Svc},
+                {"authorization", "", HeaderEnum::Authorization},
+                {"content-security-policy", "script-src 'none'; object-src 'none'; base-uri 'none'", HeaderEnum::Content_Security_Policy},
+                {"early-data", "1", HeaderEnum::Early_Data},
+                {"expect-ct", "", HeaderEnum::Expect_CT},
+                {"forwarded", "", HeaderEnum::Forwarded},
+                {"if-range", "", HeaderEnum::If_Range},
+                {"origin", "", HeaderEnum::Origin},
+                {"purpose", "prefetch", std::nullopt},
+                {"server", "", HeaderEnum::Server},
+                {"timing-allow-origin", "*", std::nullopt},
+                {"upgrade-insecure-requests", "1", HeaderEnum::Upgrade_Insecure_Requests},
+                {"user-agent", "", HeaderEnum::User_Agent},
+                {"x-forwarded-for", "", HeaderEnum::X_Forwarded_For},
+                {"x-frame-options", "deny", HeaderEnum::X_Frame_Options},
+                {"x-frame-options", "sameorigin", HeaderEnum::X_Frame_Options},
+        }};
+
+        /**
+         * @brief Static indices of every name, in table order; QPACK does not keep entries of a name adjacent.
+         */
+        const std::unordered_map<std::string_view, std::vector<uint8_t>> &static_index_by_name() {
+            static const std::unordered_map<std::string_view, std::vector<uint8_t>> index = [] {
+                std::unordered_map<std::string_view, std::vector<uint8_t>> index;
+                for (size_t i = 0; i < STATIC_TABLE.size(); ++i) index[STATIC_TABLE[i].name].push_back(static_cast<uint8_t>(i));
+                return index;
+            }();
+            return index;
+        }
+
+        enum class Read {
+            OK,
+            PARTIAL,///< The input ends inside the item.
+            INVALID,
+        };
+
+        /// Integers longer than this overflow 32 bits, so a longer one cut short is invalid rather than partial.
+        constexpr size_t MAX_INTEGER_BYTES = 5;
+
+        Read readInteger(std::string_view in, size_t &pos, uint8_t prefix_bits, uint64_t &value) {
+            size_t next = pos;
+            if (hpack::decodeInteger(in, next, prefix_bits, value)) {
+                pos = next;
+                return Read::OK;
+            }
+            return next == in.size() && next - pos <= MAX_INTEGER_BYTES ? Read::PARTIAL : Read::INVALID;
+        }
+
+        /**
+         * @brief Reads a string literal whose length has a @p prefix_bits prefix, at most @p limit bytes on the wire.
+         */
+        Read readString(std::string_view in, size_t &pos, uint8_t prefix_bits, size_t limit, std::string &out) {
+            if (pos >= in.size()) return Read::PARTIAL;
+            const bool huffman = static_cast<uint8_t>(in[pos]) & (1u << prefix_bits);
+            size_t next = pos;
+            uint64_t length = 0;
+            if (const Read read = readInteger(in, next, prefix_bits, length); read != Read::OK) return read;
+            if (length > limit) return Read::INVALID;
+            if (length > in.size() - next) return Read::PARTIAL;
+            out.clear();
+            const std::string_view raw = in.substr(next, length);
+            if (!huffman) {
+                out.assign(raw);
+            } else if (!hpack::huffmanDecode(raw, out)) {
+                return Read::INVALID;
+            }
+            pos = next + length;
+            return Read::OK;
+        }
+
+        std::unexpected<usub::server::utils::error::ParseError> fail(std::string message) {
+            return std::unexpected(usub::server::utils::error::ParseError{usub::server::utils::error::ErrorSeverity::Critical,
+                                                                          std::move(message)});
+        }
+    }// namespace
+
+    const hpack::StaticEntry &qpack::staticEntry(size_t index) {
+        return STATIC_TABLE[index];
+    }
+
+    ptrdiff_t qpack::staticFind(std::string_view name, std::string_view value, bool &exact) {
+        exact = false;
+        const auto &index = static_index_by_name();
+        const auto it = index.find(name);
+        if (it == index.end()) return -1;
+        for (uint8_t i: it->second) {
+            if (STATIC_TABLE[i].value == value) {
+                exact = true;
+                return i;
+            }
+        }
+        return it->second.front();
+    }
+
+    uint64_t qpack::encodeInsertCount(uint64_t required_insert_count, size_t max_table_capacity) {
+        if (required_insert_count == 0) return 0;
+        const uint64_t max_entries = max_table_capacity / HPACK_ENTRY_OVERHEAD;
+        return required_insert_count % (2 * max_entries) + 1;
+    }
+
+    bool qpack::decodeInsertCount(uint64_t encoded, size_t max_table_capacity, uint64_t total_inserts, uint64_t &required_insert_count) {
+        required_insert_count = 0;
+        if (encoded == 0) return true;
+        const uint64_t max_entries = max_table_capacity / HPACK_ENTRY_OVERHEAD;
+        const uint64_t full_range = 2 * max_entries;
+        if (encoded > full_range) return false;
+        const uint64_t max_value = total_inserts + max_entries;
+        const uint64_t max_wrapped = max_value / full_range * full_range;
+        required_insert_count = max_wrapped + encoded - 1;
+        if (required_insert_count > max_value) {
+            if (required_insert_count <= full_range) return false;
+            required_insert_count -= full_range;
+        }
+        return required_insert_count != 0;
+    }
+
+    QPACKDecoder::QPACKDecoder(size_t max_table_capacity, size_t max_blocked_streams)
+        : table_(max_table_capacity), max_table_capacity_(max_table_capacity), max_blocked_streams_(max_blocked_streams) {
+        // the encoder starts without a dynamic table (RFC 9204, 3.2.3)
+        this->table_.setCapacity(0);
+    }
+
+    const hpack::DynamicTable::Entry *QPACKDecoder::entry(uint64_t index) const {
+        if (index >= this->insert_count_) return nullptr;
+        return this->table_.at(static_cast<size_t>(this->insert_count_ - 1 - index));
+    }
+
+    std::expected<void, usub::server::utils::error::ParseError> QPACKDecoder::onEncoderStream(std::string_view data) {
+        std::string_view in = data;
+        if (!this->encoder_input_.empty()) {
+            this->encoder_input_.append(data);
+            in = this->encoder_input_;
+        }
+
+        size_t pos = 0;
+        while (pos < in.size()) {
+            const uint8_t first = static_cast<uint8_t>(in[pos]);
+            size_t next = pos;
+            uint64_t index = 0;
+            Read read = Read::OK;
+            // no string can be longer than the table it goes into
+            const size_t limit = this->table_.capacity();
+
+            if (first & 0x80) {
+                // insert with name reference, T (0x40) set for the static table
+                read = readInteger(in, next, 6, index);
+                if (read == Read::OK) {
+                    if (first & 0x40) {
+                        if (index >= QPACK_STATIC_TABLE_SIZE) return fail("QPACK: invalid static index");
+                        this->name_.assign(STATIC_TABLE[index].name);
+                    } else {
+                        const auto *referenced = index < this->insert_count_ ? this->entry(this->insert_count_ - 1 - index) : nullptr;
+                        if (!referenced) return fail("QPACK: invalid dynamic index");
+                        this->name_.assign(referenced->name());
+                    }
+                    read = readString(in, next, 7, limit, this->value_);
+                }
+            } else if (first & 0x40) {
+                // insert with literal name
+                read = readString(in, next, 5, limit, this->name_);
+                if (read == Read::OK) read = readString(in, next, 7, limit, this->value_);
+            } else if (first & 0x20) {
+                // set dynamic table capacity
+                read = readInteger(in, next, 5, index);
+                if (read == Read::OK) {
+                    if (index > this->max_table_capacity_) return fail("QPACK: table capacity above the limit");
+                    this->table_.setCapacity(static_cast<size_t>(index));
+                    pos = next;
+                    continue;
+                }
+            } else {
+                // duplicate
+                read = readInteger(in, next, 5, index);
+                if (read == Read::OK) {
+                    const auto *duplicated = index < this->insert_count_ ? this->entry(this->insert_count_ - 1 - index) : nullptr;
+                    if (!duplicated) return fail("QPACK: invalid dynamic index");
+                    this->name_.assign(duplicated->name());
+                    this->value_.assign(duplicated->value());
+                }
+            }
+
+            if (read == Read::INVALID) return fail("QPACK: invalid encoder instruction");
+            if (read == Read::PARTIAL) break;
+            if (this->name_.size() + this->value_.size() + HPACK_ENTRY_OVERHEAD > this->table_.capacity())
+                return fail("QPACK: entry larger than the table");
+            this->table_.insert(this->name_, this->value_, this->name_.starts_with(':') ? std::nullopt : hpack::lookupHeader(this->name_));
+            ++this->insert_count_;
+            pos = next;
+        }
+
+        // keep the incomplete instruction for the next call
+        if (in.data() == this->encoder_input_.data()) {
+            this->encoder_input_.erase(0, pos);
+        } else {
+            this->encoder_input_.assign(in.substr(pos));
+        }
+        return {};
+    }
+
+    template<class OnField>
+    std::expected<bool, usub::server::utils::error::ParseError>
+    QPACKDecoder::decodeSection(uint64_t stream_id, std::string_view section, OnField &&on_field) {
+        size_t pos = 0;
+        uint64_t encoded = 0;
+        uint64_t required_insert_count = 0;
+        uint64_t delta = 0;
+        if (readInteger(section, pos, 8, encoded) != Read::OK ||
+            !qpack::decodeInsertCount(encoded, this->max_table_capacity_, this->insert_count_, required_insert_count))
+            return fail("QPACK: invalid required insert count");
+        if (pos >= section.size()) return fail("QPACK: truncated section prefix");
+        const bool negative = static_cast<uint8_t>(section[pos]) & 0x80;
+        if (readInteger(section, pos, 7, delta) != Read::OK) return fail("QPACK: truncated section prefix");
+        if (negative && delta >= required_insert_count) return fail("QPACK: invalid base");
+        const uint64_t base = negative ? required_insert_count - delta - 1 : required_insert_count + delta;
+
+        if (required_insert_count > this->insert_count_) {
+            if (!this->blocked_.contains(stream_id) && this->blockedStreams() >= this->max_blocked_streams_)
+                return fail("QPACK: too many blocked streams");
+            this->blocked_[stream_id] = required_insert_count;
+            return false;
+        }
+        this->blocked_.erase(stream_id);
+
+        // the entry with absolute index @p index, which the section must have counted in its Required Insert Count
+        auto dynamic = [&](uint64_t index) -> const hpack::DynamicTable::Entry * {
+            return index < required_insert_count ? this->entry(index) : nullptr;
+        };
+
+        bool stopped = false;
+        while (pos < section.size() && !stopped) {
+            const uint8_t first = static_cast<uint8_t>(section[pos]);
+            uint64_t index = 0;
+            std::string_view name;
+            std::string_view value;
+            std::optional<HeaderEnum> header;
+            const hpack::DynamicTable::Entry *found = nullptr;
+
+            if (first & 0x80) {
+                // indexed field line, T (0x40) set for the static table
+                if (readInteger(section, pos, 6, index) != Read::OK) return fail("QPACK: truncated field line");
+                if (first & 0x40) {
+                    if (index >= QPACK_STATIC_TABLE_SIZE) return fail("QPACK: invalid static index");
+                    name = STATIC_TABLE[index].name;
+                    value = STATIC_TABLE[index].value;
+                    header = STATIC_TABLE[index].header;
+                } else {
+                    if (index >= base || !(found = dynamic(base - 1 - index))) return fail("QPACK: invalid dynamic index");
+                }
+            } else if ((first & 0xf0) == 0x10) {
+                // indexed field line with post-base index
+                if (readInteger(section, pos, 4, index) != Read::OK || !(found = dynamic(base + index)))
+                    return fail("QPACK: invalid dynamic index");
+            } else {
+                if (first & 0x40) {
+                    // literal field line with name reference, T (0x10) set for the static table
+                    if (readInteger(section, pos, 4, index) != Read::OK) return fail("QPACK: truncated field line");
+                    if (first & 0x10) {
+                        if (index >= QPACK_STATIC_TABLE_SIZE) return fail("QPACK: invalid static index");
+                        name = STATIC_TABLE[index].name;
+                        header = STATIC_TABLE[index].header;
+                    } else {
+                        const hpack::DynamicTable::Entry *named = index < base ? dynamic(base - 1 - index) : nullptr;
+                        if (!named) return fail("QPACK: invalid dynamic index");
+                        name = named->name();
+                        header = named->header;
+                    }
+                } else if (first & 0x20) {
+                    // literal field line with literal name
+                    if (readString(section, pos, 3, section.size(), this->name_) != Read::OK) return fail("QPACK: invalid name");
+                    name = this->name_;
+                    header = name.starts_with(':') ? std::nullopt : hpack::lookupHeader(name);
+                } else {
+                    // literal field line with post-base name reference
+                    if (readInteger(section, pos, 3, index) != Read::OK) return fail("QPACK: truncated field line");
+                    const hpack::DynamicTable::Entry *named = dynamic(base + index);
+                    if (!named) return fail("QPACK: invalid dynamic index");
+                    name = named->name();
+                    header = named->header;
+                }
+                if (readString(section, pos, 7, section.size(), this->value_) != Read::OK) return fail("QPACK: invalid value");
+                value = this->value_;
+            }
+            if (found) {
+                name = found->name();
+                value = found->value();
+                header = found->header;
+            }
+            stopped = !on_field(name, value, header);
+        }
+
+        if (required_insert_count > 0) {
+            hpack::encodeInteger(this->decoder_stream_, 0x80, 7, stream_id);
+            this->known_received_count_ = std::max(this->known_received_count_, required_insert_count);
+        }
+        return true;
+    }
+
+    std::expected<bool, usub::server::utils::error::ParseError>
+    QPACKDecoder::decode(uint64_t stream_id, std::string_view section, const FieldCallback &field) {
+        return this->decodeSection(stream_id, section, [&](std::string_view name, std::string_view value, std::optional<HeaderEnum>) {
+            return field(name, value);
+        });
+    }
+
+    std::expected<bool, usub::server::utils::error::ParseError>
+    QPACKDecoder::decode(uint64_t stream_id, std::string_view section, usub::server::protocols::http::Headers &headers,
+                         const FieldCallback &pseudo) {
+        return this->decodeSection(stream_id, section, [&](std::string_view name, std::string_view value, std::optional<HeaderEnum> header) {
+            if (!header && name.starts_with(':')) return pseudo ? pseudo(name, value) : true;
+            // known names are stored by HeaderEnum, whatever the case they arrived in
+            std::string key(header ? std::string_view(header_enum_to_string_lower[static_cast<size_t>(*header)]) : name);
+            (void) headers.addHeader<usub::server::protocols::http::Request>(std::move(key), std::string(value));
+            return true;
+        });
+    }
+
+    size_t QPACKDecoder::blockedStreams() const {
+        // streams the encoder stream has caught up with wait only for the caller
+        return static_cast<size_t>(std::count_if(this->blocked_.begin(), this->blocked_.end(), [&](const auto &blocked) {
+            return blocked.second > this->insert_count_;
+        }));
+    }
+
+    std::vector<uint64_t> QPACKDecoder::unblockedStreams() {
+        std::vector<uint64_t> streams;
+        for (auto it = this->blocked_.begin(); it != this->blocked_.end();) {
+            if (it->second <= this->insert_count_) {
+                streams.push_back(it->first);
+                it = this->blocked_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        return streams;
+    }
+
+    void QPACKDecoder::cancelStream(uint64_t stream_id) {
+        this->blocked_.erase(stream_id);
+        // without a dynamic table the encoder has nothing to release
+        if (this->max_table_capacity_ > 0) hpack::encodeInteger(this->decoder_stream_, 0x40, 6, stream_id);
+    }
+
+    std::string QPACKDecoder::takeDecoderStream() {
+        if (this->insert_count_ > this->known_received_count_) {
+            hpack::encodeInteger(this->decoder_stream_, 0x00, 6, this->insert_count_ - this->known_received_count_);
+            this->known_received_count_ = this->insert_count_;
+        }
+        return std::exchange(this->decoder_stream_, {});
+    }
+
+    QPACKEncoder::QPACKEncoder(size_t max_table_capacity) : table_(max_table_capacity), limit_(max_table_capacity) {
+        this->table_.setCapacity(0);
+    }
+
+    void QPACKEncoder::setPeerSettings(size_t max_table_capacity, size_t max_blocked_streams) {
+        this->peer_max_capacity_ = max_table_capacity;
+        this->max_blocked_streams_ = max_blocked_streams;
+        const size_t capacity = std::min(max_table_capacity, this->limit_);
+        if (capacity == this->table_.capacity()) return;
+        this->table_.setCapacity(capacity);
+        hpack::encodeInteger(this->encoder_stream_, 0x20, 5, capacity);
+    }
+
+    bool QPACKEncoder::isBlocked(uint64_t stream_id) const {
+        const auto it = this->unacknowledged_.find(stream_id);
+        if (it == this->unacknowledged_.end()) return false;
+        return std::any_of(it->second.begin(), it->second.end(), [&](const Section &section) {
+            return section.required_insert_count > this->known_received_count_;
+        });
+    }
+
+    size_t QPACKEncoder::blockedStreams() const {
+        size_t blocked = 0;
+        for (const auto &[stream_id, sections]: this->unacknowledged_) blocked += this->isBlocked(stream_id);
+        return blocked;
+    }
+
+    bool QPACKEncoder::reference(uint64_t index) {
+        if (index >= this->known_received_count_ && this->section_.required_insert_count <= this->known_received_count_ &&
+            !this->isBlocked(this->stream_id_) && this->blockedStreams() >= this->max_blocked_streams_)
+            return false;
+        this->section_.required_insert_count = std::max(this->section_.required_insert_count, index + 1);
+        this->section_.min_reference = std::min(this->section_.min_reference, index);
+        return true;
+    }
+
+    ptrdiff_t QPACKEncoder::evictions(size_t entry_size) const {
+        if (entry_size > this->table_.capacity()) return -1;
+        uint64_t min_reference = this->section_.min_reference;
+        for (const auto &[stream_id, sections]: this->unacknowledged_) {
+            for (const Section &section: sections) min_reference = std::min(min_reference, section.min_reference);
+        }
+        size_t size = this->table_.size();
+        ptrdiff_t evicted = 0;
+        while (size + entry_size > this->table_.capacity()) {
+            const size_t oldest = this->table_.count() - 1 - static_cast<size_t>(evicted);
+            if (this->insert_count_ - 1 - oldest >= min_reference) return -1;
+            size -= this->table_.at(oldest)->field.size() + HPACK_ENTRY_OVERHEAD;
+            ++evicted;
+        }
+        return evicted;
+    }
+
+    void QPACKEncoder::emitIndexed(uint64_t index) {
+        if (index < this->base_) {
+            hpack::encodeInteger(this->lines_, 0x80, 6, this->base_ - 1 - index);
+        } else {
+            hpack::encodeInteger(this->lines_, 0x10, 4, index - this->base_);
+        }
+    }
+
+    void QPACKEncoder::begin(uint64_t stream_id) {
+        this->stream_id_ = stream_id;
+        this->base_ = this->insert_count_;
+        this->section_ = {0, UINT64_MAX};
+        this->lines_.clear();
+    }
+
+    void QPACKEncoder::encode(std::string_view name, std::string_view value) {
+        bool exact = false;
+        const ptrdiff_t static_index = qpack::staticFind(name, value, exact);
+        if (exact) {
+            hpack::encodeInteger(this->lines_, 0xc0, 6, static_cast<uint64_t>(static_index));
+            return;
+        }
+
+        const std::optional<HeaderEnum> header = name.starts_with(':') ? std::nullopt : hpack::lookupHeader(name);
+        const hpack::Indexing mode = hpack::indexing(header, name, value);
+        ptrdiff_t name_entry = -1;///< Absolute index of a dynamic entry with the name.
+        if (mode != hpack::Indexing::NEVER) {
+            bool dynamic_exact = false;
+            const ptrdiff_t found = this->table_.find(name, value, dynamic_exact);
+            if (found >= 0) {
+                const uint64_t index = this->insert_count_ - 1 - static_cast<uint64_t>(found);
+                if (dynamic_exact && this->reference(index)) {
+                    this->emitIndexed(index);
+                    return;
+                }
+                if (!dynamic_exact) name_entry = static_cast<ptrdiff_t>(index);
+            }
+        }
+
+        // an entry taking most of the table would only push out the others
+        const size_t entry_size = name.size() + value.size() + HPACK_ENTRY_OVERHEAD;
+        const ptrdiff_t evicted = mode == hpack::Indexing::INCREMENTAL && entry_size <= this->table_.capacity() * 3 / 4
+                                          ? this->evictions(entry_size)
+                                          : -1;
+        if (evicted >= 0) {
+            const uint64_t oldest = this->insert_count_ - this->table_.count() + static_cast<uint64_t>(evicted);
+            if (static_index >= 0) {
+                hpack::encodeInteger(this->encoder_stream_, 0xc0, 6, static_cast<uint64_t>(static_index));
+            } else if (name_entry >= 0 && static_cast<uint64_t>(name_entry) >= oldest) {
+                // relative to the insert count, and not evicted by this very insert
+                hpack::encodeInteger(this->encoder_stream_, 0x80, 6, this->insert_count_ - 1 - static_cast<uint64_t>(name_entry));
+            } else {
+                hpack::encodeString(this->encoder_stream_, name, 0x40, 5);
+            }
+            hpack::encodeString(this->encoder_stream_, value);
+            this->table_.insert(name, value, header);
+            ++this->insert_count_;
+            if (name_entry >= 0 && static_cast<uint64_t>(name_entry) < oldest) name_entry = -1;
+            // referencing the new entry blocks the stream until the decoder has it
+            if (this->reference(this->insert_count_ - 1)) {
+                this->emitIndexed(this->insert_count_ - 1);
+                return;
+            }
+        }
+
+        // literal, N (never indexed) keeps intermediaries from indexing it
+        const bool never = mode == hpack::Indexing::NEVER;
+        if (static_index >= 0) {
+            hpack::encodeInteger(this->lines_, 0x50 | (never ? 0x20 : 0x00), 4, static_cast<uint64_t>(static_index));
+        } else if (name_entry >= 0 && this->reference(static_cast<uint64_t>(name_entry))) {
+            const auto index = static_cast<uint64_t>(name_entry);
+            if (index < this->base_) {
+                hpack::encodeInteger(this->lines_, 0x40 | (never ? 0x20 : 0x00), 4, this->base_ - 1 - index);
+            } else {
+                hpack::encodeInteger(this->lines_, never ? 0x08 : 0x00, 3, index - this->base_);
+            }
+        } else {
+            hpack::encodeString(this->lines_, name, 0x20 | (never ? 0x10 : 0x00), 3);
+        }
+        hpack::encodeString(this->lines_, value);
+    }
+
+    void QPACKEncoder::end(std::string &out) {
+        const uint64_t required_insert_count = this->section_.required_insert_count;
+        hpack::encodeInteger(out, 0x00, 8, qpack::encodeInsertCount(required_insert_count, this->peer_max_capacity_));
+        if (required_insert_count == 0) {
+            out.push_back(0);
+        } else if (this->base_ >= required_insert_count) {
+            hpack::encodeInteger(out, 0x00, 7, this->base_ - required_insert_count);
+        } else {
+            hpack::encodeInteger(out, 0x80, 7, required_insert_count - this->base_ - 1);
+        }
+        out.append(this->lines_);
+        if (required_insert_count > 0) this->unacknowledged_[this->stream_id_].push_back(this->section_);
+        this->lines_.clear();
+    }
+
+    std::expected<void, usub::server::utils::error::ParseError> QPACKEncoder::onDecoderStream(std::string_view data) {
+        std::string_view in = data;
+        if (!this->decoder_input_.empty()) {
+            this->decoder_input_.append(data);
+            in = this->decoder_input_;
+        }
+
+        size_t pos = 0;
+        while (pos < in.size()) {
+            const uint8_t first = static_cast<uint8_t>(in[pos]);
+            size_t next = pos;
+            uint64_t value = 0;
+            const Read read = readInteger(in, next, (first & 0x80) ? 7 : 6, value);
+            if (read == Read::INVALID) return fail("QPACK: invalid decoder instruction");
+            if (read == Read::PARTIAL) break;
+
+            if (first & 0x80) {
+                // section acknowledgment, for the oldest unacknowledged section of the stream
+                const auto it = this->unacknowledged_.find(value);
+                if (it == this->unacknowledged_.end()) return fail("QPACK: acknowledged section does not exist");
+                this->known_received_count_ = std::max(this->known_received_count_, it->second.front().required_insert_count);
+                it->second.pop_front();
+                if (it->second.empty()) this->unacknowledged_.erase(it);
+            } else if (first & 0x40) {
+                // stream cancellation
+                this->unacknowledged_.erase(value);
+            } else {
+                // insert count increment
+                if (value == 0 || value > this->insert_count_ - this->known_received_count_)
+                    return fail("QPACK: invalid insert count increment");
+                this->known_received_count_ += value;
+            }
+            pos = next;
+        }
+
+        if (in.data() == this->decoder_input_.data()) {
+            this->decoder_input_.erase(0, pos);
+        } else {
+            this->decoder_input_.assign(in.substr(pos));
+        }
+        return {};
+    }
+
+}// namespace usub::server::component
@@ -1,5 +1,14 @@
 #include "Components/URL/QueryParams.h"
 
+#include <memory>
+
+usub::server::component::url::QueryParams::QueryParams(std::pmr::memory_resource *resource)
+    : query_params_map_(resource) {}
+
+usub::server::component::url::QueryParams::QueryParams(QueryParams &&other)
+    : query_params_string_(std::move(other.query_params_string_)),
+      query_params_map_(std::move(other.query_params_map_), std::pmr::get_default_resource()) {}
+
 void usub::server::component::url::QueryParams::addQueryParam(std::string_view key, std::string_view value) {
     this->query_params_map_[usub::server::component::PercentEncoded::decode(key)].push_back(usub::server::component::PercentEncoded::decode(value));
 }
@@ -35,3 +44,14 @@ usub::server::component::url::QueryParams::const_iterator usub::server::componen
 
 usub::server::component::url::QueryParams::const_iterator usub::server::component::url::QueryParams::cbegin() const { return query_params_map_.cbegin(); }
 usub::server::component::url::QueryParams::const_iterator usub::server::component::url::QueryParams::cend() const { return query_params_map_.cend(); }
+
+void usub::server::component::url::QueryParams::clear() {
+    this->query_params_string_.clear();
+    this->query_params_map_.clear();
+}
+
+void usub::server::component::url::QueryParams::setMemoryResource(std::pmr::memory_resource *resource) {
+    this->query_params_string_.clear();
+    std::destroy_at(&this->query_params_map_);
+    std::construct_at(&this->query_params_map_, resource);
+}
@@ -20,6 +20,14 @@ std::string &usub::server::component::URN::getFragment() {
     return this->fragment_;
 }
 
+void usub::server::component::URN::clear() {
+    this->scheme_.clear();
+    this->authority_.clear();
+    this->path_.clear();
+    this->query_.clear();
+    this->fragment_.clear();
+}
+
 std::string usub::server::component::URN::string() const {
     return PercentEncoded::decode(this->path_) + PercentEncoded::decode(this->query_.string()) /* + this->fragment_*/;
 }
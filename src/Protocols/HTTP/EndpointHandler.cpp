@@ -4,7 +4,8 @@ namespace usub::server::protocols::http {
 
     void HTTPEndpointHandler::parsePathPattern(const std::string &pathPattern,
                                                std::regex &outRegex,
-                                               std::vector<std::string> &outParamNames) const {
+                                               std::vector<std::string> &outParamNames,
+                                               std::string &outSource) const {
         std::string regexPattern = "^";// Start anchor
         size_t position = 0;
         const std::string specialChars = ".^$+?()[]\\|";
@@ -70,6 +71,7 @@ namespace usub::server::protocols::http {
         //    regexPattern += "(?:\\?.*)?$"; // Non-capturing group for query parameters
 
         std::cout << "Generated Regex Pattern: " << regexPattern << std::endl;// For debugging
+        outSource = regexPattern;
 
         // Compile the regex with ECMAScript syntax
         try {
@@ -120,7 +122,10 @@ namespace usub::server::protocols::http {
     Route &HTTPEndpointHandler::addHandler(const std::set<std::string> &method, const std::string &pathPattern, std::function<FunctionType> function) {
         std::regex pathRegex;
         std::vector<std::string> paramNames;
-        parsePathPattern(pathPattern, pathRegex, paramNames);
+        std::string source;
+        parsePathPattern(pathPattern, pathRegex, paramNames, source);
+        this->frozen_ = false;
+        this->route_patterns_.push_back(std::move(source));
         method.contains("*") ? this->routes_.emplace_back(method, pathRegex, paramNames, function, true)
                              : this->routes_.emplace_back(method, pathRegex, paramNames, function);
         return this->routes_.back();
@@ -130,7 +135,10 @@ namespace usub::server::protocols::http {
     Route &HTTPEndpointHandler::addHandler(std::string_view &method, const std::string &pathPattern, std::function<FunctionType> function) {
         std::regex pathRegex;
         std::vector<std::string> paramNames;
-        parsePathPattern(pathPattern, pathRegex, paramNames);
+        std::string source;
+        parsePathPattern(pathPattern, pathRegex, paramNames, source);
+        this->frozen_ = false;
+        this->route_patterns_.push_back(std::move(source));
         std::set<std::string> method_set{method.data()};
         method == "*" ? this->routes_.emplace_back(method_set, pathRegex, paramNames, function, true)
                       : this->routes_.emplace_back(method_set, pathRegex, paramNames, function);
@@ -153,33 +161,98 @@ namespace usub::server::protocols::http {
 
     std::optional<std::pair<Route *, bool>> HTTPEndpointHandler::match(Request &request) {
         // Check if the route exists for plain string routes
-        if (!this->plainstring_routes_.empty() && this->plainstring_routes_.contains(request.getURL())) {
-            auto route = this->plainstring_routes_[request.getURL()];
-            if (route.accept_all_methods || route.allowed_method_tokenns.contains(request.getRequestMethod())) {
-                return std::make_pair(&route, true);// Route found and method allowed
+        if (!this->plainstring_routes_.empty()) {
+            if (auto it = this->plainstring_routes_.find(request.getURL()); it != this->plainstring_routes_.end()) {
+                Route &route = it->second;
+                if (route.allows(request.getMethod())) {
+                    return std::make_pair(&route, true);// Route found and method allowed
+                }
+                return std::make_pair(&route, false);// Route found but method not allowed
             }
-            return std::make_pair(&route, false);// Route found but method not allowed
         }
 
-        // Check for routes with regular expressions
-        for (auto &route: this->routes_) {
-            if (!route.accept_all_methods && !route.allowed_method_tokenns.contains(request.getRequestMethod())) {
-                continue;// Skip routes where the method is not allowed
+        const std::string &fullURL = request.getURL();
+        const Method method = request.getMethod();
+        auto methodAllowed = [&](const Route &route) {
+            return route.allows(method);
+        };
+
+        if (!this->frozen_) {
+            // Check for routes with regular expressions
+            for (auto &route: this->routes_) {
+                if (!methodAllowed(route)) {
+                    continue;// Skip routes where the method is not allowed
+                }
+
+                std::smatch matchResult;
+                if (std::regex_match(fullURL, matchResult, route.pathRegex)) {
+                    // Extract parameters as views into the URL
+                    request.uri_params.clear();
+                    for (size_t i = 0; i < route.param_names.size(); ++i) {
+                        if (i + 1 < matchResult.size()) {
+                            request.uri_params.push(route.param_names[i],
+                                                    std::string_view(fullURL).substr(matchResult.position(i + 1), matchResult.length(i + 1)));
+                        }
+                    }
+                    return std::make_pair(&route, true);// Route matched and method allowed
+                }
             }
+            return std::nullopt;// No route matched
+        }
 
+        // One pass of the automaton yields every route matching the path, in registration order
+        size_t winner = this->routes_.size();
+        for (uint32_t id: this->automaton_.matches(fullURL)) {
+            if (methodAllowed(this->routes_[id])) {
+                winner = id;
+                break;
+            }
+        }
+
+        // Routes the automaton could not compile, only those registered before the winner can take precedence
+        for (uint32_t id: this->fallback_routes_) {
+            if (id >= winner) break;
+            Route &route = this->routes_[id];
             std::smatch matchResult;
-            std::string fullURL = request.getURL();
-            if (std::regex_match(fullURL, matchResult, route.pathRegex)) {
-                // Extract parameters and store them in the Request object
-                for (size_t i = 0; i < route.param_names.size(); ++i) {
-                    if (i + 1 < matchResult.size()) {
-                        request.uri_params[route.param_names[i]] = matchResult[i + 1];
-                    }
+            if (!methodAllowed(route) || !std::regex_match(fullURL, matchResult, route.pathRegex)) continue;
+
+            request.uri_params.clear();
+            for (size_t i = 0; i < route.param_names.size() && i + 1 < matchResult.size(); ++i) {
+                request.uri_params.push(route.param_names[i],
+                                        std::string_view(fullURL).substr(matchResult.position(i + 1), matchResult.length(i + 1)));
+            }
+            return std::make_pair(&route, true);
+        }
+
+        if (winner == this->routes_.size()) return std::nullopt;// No route matched
+
+        Route &route = this->routes_[winner];
+        std::span<const size_t> offsets;
+        request.uri_params.clear();
+        if (!route.param_names.empty() && this->automaton_.captures(static_cast<uint32_t>(winner), fullURL, offsets)) {
+            for (size_t i = 0; i < route.param_names.size() && 2 * i + 1 < offsets.size(); ++i) {
+                if (offsets[2 * i] == RouteAutomaton::NO_OFFSET) {
+                    request.uri_params.push(route.param_names[i], std::string_view{});
+                    continue;
                 }
-                return std::make_pair(&route, true);// Route matched and method allowed
+                request.uri_params.push(route.param_names[i],
+                                        std::string_view(fullURL).substr(offsets[2 * i], offsets[2 * i + 1] - offsets[2 * i]));
+            }
+        }
+        return std::make_pair(&route, true);// Route matched and method allowed
+    }
+
+
+    void HTTPEndpointHandler::freeze() {
+        this->automaton_ = RouteAutomaton{};
+        this->fallback_routes_.clear();
+        for (uint32_t id = 0; id < this->routes_.size(); ++id) {
+            if (!this->automaton_.add(this->route_patterns_[id], id)) {
+                this->fallback_routes_.push_back(id);
             }
         }
-        return std::nullopt;// No route matched
+        this->automaton_.compile();
+        this->frozen_ = true;
     }
 
 
@@ -1,12 +1,30 @@
 #include "Protocols/HTTP/Headers.h"
 #include "Protocols/HTTP/header_lookup.h"
 
+#include <memory>
+
+usub::server::protocols::http::Headers::Headers(std::pmr::memory_resource *resource)
+    : known_headers_map_(resource), unknown_headers_map_(resource) {}
+
+usub::server::protocols::http::Headers::Headers(Headers &&other)
+    : known_headers_map_(std::move(other.known_headers_map_), std::pmr::get_default_resource()),
+      unknown_headers_map_(std::move(other.unknown_headers_map_), std::pmr::get_default_resource()) {}
+
 usub::server::protocols::http::Headers &usub::server::protocols::http::Headers::clear() {
     this->known_headers_map_.clear();
     this->unknown_headers_map_.clear();
     return *this;
 }
 
+usub::server::protocols::http::Headers &usub::server::protocols::http::Headers::setMemoryResource(std::pmr::memory_resource *resource) {
+    // pmr containers never propagate their allocator on assignment, so rebinding means rebuilding
+    std::destroy_at(&this->known_headers_map_);
+    std::construct_at(&this->known_headers_map_, resource);
+    std::destroy_at(&this->unknown_headers_map_);
+    std::construct_at(&this->unknown_headers_map_, resource);
+    return *this;
+}
+
 bool usub::server::protocols::http::Headers::contains(std::string_view key) const {
     auto lookup = HTTPHeaderLookup::lookupHeader(key.data(), key.size());
     if (lookup) [[likely]] {
@@ -60,6 +60,7 @@ const usub::server::component::url::QueryParams &usub::server::protocols::http::
 }
 
 std::string &usub::server::protocols::http::Request::getRequestMethod() {
+    this->method_interned_ = false;// the caller may change the token
     return this->method_token_;
 }
 
@@ -67,6 +68,14 @@ const std::string &usub::server::protocols::http::Request::getRequestMethod() co
     return this->method_token_;
 }
 
+usub::server::protocols::http::Method usub::server::protocols::http::Request::getMethod() {
+    if (!this->method_interned_) {
+        this->method_ = methods::lookup(this->method_token_);
+        this->method_interned_ = true;
+    }
+    return this->method_;
+}
+
 usub::server::protocols::http::REQUEST_STATE &usub::server::protocols::http::Request::getState() {
     return this->state_;
 }
@@ -114,26 +123,50 @@ std::string::const_iterator usub::server::protocols::http::Request::parseHTTP1_1
     return rv;
 }
 
+namespace {
+    /**
+     * @brief Returns the first position in [first, last) for which @p pred fails.
+     *
+     * Used by the parser to find the end of a token run, so each run is appended to its
+     * destination in one go instead of character by character.
+     */
+    template<class Pred>
+    inline const char *scanRun(const char *first, const char *last, Pred pred) {
+        while (first != last && pred(*first)) ++first;
+        return first;
+    }
+
+    inline void appendLower(std::string &dst, const char *first, const char *last) {
+        const size_t old_size = dst.size();
+        dst.append(first, last);
+        for (auto it = dst.begin() + old_size; it != dst.end(); ++it) {
+            if (*it >= 'A' && *it <= 'Z') *it = static_cast<char>(*it | 0x20);
+        }
+    }
+}// namespace
+
 std::string::const_iterator
 usub::server::protocols::http::Request::parseHTTP1_X(const std::string &request,
                                                      std::string::const_iterator start_pos) {
+    const char *start = (start_pos == std::string::const_iterator()) ? nullptr : request.data() + (start_pos - request.begin());
+    const char *rv = this->parseHTTP1_X(std::string_view{request}, start);
+    if (!rv) return {};
+    return request.begin() + (rv - request.data());
+}
+
+const char *usub::server::protocols::http::Request::parseHTTP1_X(std::string_view request, const char *start_pos) {
     if (request.empty()) {
         this->state_ = REQUEST_STATE::BAD_REQUEST;
-        return {};
+        return nullptr;
     }
-    if (this->state_ == REQUEST_STATE::BAD_REQUEST) return {};
+    if (this->state_ == REQUEST_STATE::BAD_REQUEST) return nullptr;
     else if (this->state_ == REQUEST_STATE::FINISHED)
         this->clear();
 
-    auto c = (start_pos == std::string::const_iterator()) ? request.begin() : start_pos;
-
-
-    // Local vars have better perfomance, so we cache the most used, TODO!
-    std::pair<std::string, std::string> &data_value_pair_cached = this->data_value_pair_;
-    REQUEST_STATE &state_cached = this->state_;
-    size_t &line_size_cached = this->line_size_;
+    const char *const end = request.data() + request.size();
+    const char *c = start_pos ? start_pos : request.data();
 
-    for (c; c != request.end();) {
+    while (c != end) {
         if (this->line_size_ >= 8192 && this->state_ < REQUEST_STATE::DATA_CONTENT_LENGTH) {
             if (this->state_ == REQUEST_STATE::METHOD || this->state_ == REQUEST_STATE::PATH || this->state_ == REQUEST_STATE::VERSION) {
                 this->state_ = REQUEST_STATE::URI_TOO_LONG;
@@ -149,57 +182,57 @@ usub::server::protocols::http::Request::parseHTTP1_X(const std::string &request,
             return c;
         }
         switch (this->state_) {
-            case REQUEST_STATE::METHOD:
-                for (c; c != request.end() && this->state_ == REQUEST_STATE::METHOD; ++c, this->line_size_++) {
-                    if (usub::utils::isTchar(*c)) [[likely]] {
-                        this->method_token_ += *c;// Append character
-                    } else if (*c == ' ') {
-                        if (this->method_token_.empty()) {
-                            this->state_ = REQUEST_STATE::BAD_REQUEST;
-                            break;
-                        }
-                        this->state_ = REQUEST_STATE::TARGET_START;
-                    } else [[unlikely]] {
-                        this->state_ = REQUEST_STATE::BAD_REQUEST;
-                        return c;
-                    }
+            case REQUEST_STATE::METHOD: {
+                const char *run = c;
+                c = scanRun(c, end, [](char ch) { return usub::utils::isTchar(ch); });
+                this->method_token_.append(run, c);
+                this->line_size_ += c - run;
+                if (c == end) break;// method continues in the next read
+                if (*c != ' ' || this->method_token_.empty()) [[unlikely]] {
+                    this->state_ = REQUEST_STATE::BAD_REQUEST;
+                    return c;
                 }
+                ++c, ++this->line_size_;
+                this->method_ = methods::lookup(this->method_token_);
+                this->method_interned_ = true;
+                this->state_ = REQUEST_STATE::TARGET_START;
+            }
+                [[fallthrough]];
             case REQUEST_STATE::TARGET_START:
+                if (c == end) break;
                 if (*c == '/') [[likely]] {
                     this->state_ = REQUEST_STATE::ORIGIN_FORM;
                 } else if (*c == '*') [[unlikely]] {
                     // not ready yet
                     this->state_ = REQUEST_STATE::BAD_REQUEST;
                     return c;
-                    this->urn_.getPath().push_back('*');
-                    this->state_ = REQUEST_STATE::ASTERISK_FORM;
-                    c++;
                 } else if (isalpha(*c)) {// Check for scheme (e.g., "http://")
                                          // not ready yet
                     this->state_ = REQUEST_STATE::BAD_REQUEST;
                     return c;
-                    this->state_ = REQUEST_STATE::ABSOLUTE_FORM_SCHEME;
                 } else [[unlikely]] {
                     // not ready yet
                     this->state_ = REQUEST_STATE::BAD_REQUEST;
                     return c;
-                    this->state_ = REQUEST_STATE::AUTHORITY_FORM;
                 }
                 break;
             case REQUEST_STATE::ORIGIN_FORM: {
-                std::string &url = this->urn_.getPath();
-                for (c; c != request.end() && this->state_ == REQUEST_STATE::ORIGIN_FORM && this->line_size_ <= this->max_uri_size_; ++c, this->line_size_++) {
-                    if (component::URN::isPathChar(*c)) [[likely]] {
-                        url.push_back(*c);
-                    } else if (*c == '?') [[likely]] {
-                        this->state_ = REQUEST_STATE::QUERY_KEY;
-                    } else if (*c == ' ') [[likely]] {
-                        this->state_ = REQUEST_STATE::VERSION;
-                    } else [[unlikely]] {
-                        this->state_ = REQUEST_STATE::BAD_REQUEST;
-                        return c;
-                    }
+                if (this->line_size_ > this->max_uri_size_) break;
+                const char *limit = c + std::min<size_t>(end - c, this->max_uri_size_ - this->line_size_ + 1);
+                const char *run = c;
+                c = scanRun(c, limit, [](char ch) { return component::URN::isPathChar(ch); });
+                this->urn_.getPath().append(run, c);
+                this->line_size_ += c - run;
+                if (c == limit) break;
+                if (*c == '?') [[likely]] {
+                    this->state_ = REQUEST_STATE::QUERY_KEY;
+                } else if (*c == ' ') [[likely]] {
+                    this->state_ = REQUEST_STATE::VERSION;
+                } else [[unlikely]] {
+                    this->state_ = REQUEST_STATE::BAD_REQUEST;
+                    return c;
                 }
+                ++c, ++this->line_size_;
                 break;
             }
             case REQUEST_STATE::ASTERISK_FORM:
@@ -212,49 +245,43 @@ usub::server::protocols::http::Request::parseHTTP1_X(const std::string &request,
                 c++;
                 break;
             case REQUEST_STATE::QUERY_KEY: {
-                std::string &query_params_string = this->urn_.getQueryParams().string();
-                for (c; c != request.end() && this->state_ == REQUEST_STATE::QUERY_KEY; ++c, ++this->line_size_) {
-                    if (component::URN::isQueryChar(*c)) [[likely]] {
-                        query_params_string.push_back(*c);
-                        if (*c != '=') [[likely]] {
-                            this->data_value_pair_.first.push_back(*c);
-                        } else if (*c == '&') [[unlikely]] {
-                            this->state_ = REQUEST_STATE::BAD_REQUEST;
-                            return c;
-                        } else {
-                            this->state_ = REQUEST_STATE::QUERY_VALUE;
-                        }
-                    } else [[unlikely]] {
-                        this->state_ = REQUEST_STATE::BAD_REQUEST;
-                        return c;
-                    }
+                const char *run = c;
+                c = scanRun(c, end, [](char ch) { return ch != '=' && component::URN::isQueryChar(ch); });
+                this->urn_.getQueryParams().string().append(run, c);
+                this->data_value_pair_.first.append(run, c);
+                this->line_size_ += c - run;
+                if (c == end) break;
+                if (*c != '=') [[unlikely]] {
+                    this->state_ = REQUEST_STATE::BAD_REQUEST;
+                    return c;
                 }
+                this->urn_.getQueryParams().string().push_back('=');
+                this->state_ = REQUEST_STATE::QUERY_VALUE;
+                ++c, ++this->line_size_;
                 break;
             }
             case REQUEST_STATE::QUERY_VALUE: {
                 usub::server::component::url::QueryParams &query_params = this->urn_.getQueryParams();
                 std::string &query_params_string = query_params.string();
-                for (c; c != request.end() && this->state_ == REQUEST_STATE::QUERY_VALUE; ++c, this->line_size_++) {
-                    if (component::URN::isQueryChar(*c)) [[likely]] {
-                        query_params_string.push_back(*c);
-                        if (*c != '&') [[likely]] {
-                            this->data_value_pair_.second.push_back(*c);
-                        } else {
-                            query_params.addQueryParam(std::move(this->data_value_pair_.first), std::move(this->data_value_pair_.second));
-                            this->data_value_pair_.first.clear();
-                            this->data_value_pair_.second.clear();
-                            this->state_ = REQUEST_STATE::QUERY_KEY;
-                        }
-                    } else if (*c == ' ') [[likely]] {
-                        query_params.addQueryParam(std::move(this->data_value_pair_.first), std::move(this->data_value_pair_.second));
-                        this->data_value_pair_.first.clear();
-                        this->data_value_pair_.second.clear();
-                        this->state_ = REQUEST_STATE::VERSION;
-                    } else [[unlikely]] {
-                        this->state_ = REQUEST_STATE::BAD_REQUEST;
-                        return c;
-                    }
+                const char *run = c;
+                c = scanRun(c, end, [](char ch) { return ch != '&' && component::URN::isQueryChar(ch); });
+                query_params_string.append(run, c);
+                this->data_value_pair_.second.append(run, c);
+                this->line_size_ += c - run;
+                if (c == end) break;
+                if (*c == '&') [[likely]] {
+                    query_params_string.push_back('&');
+                    this->state_ = REQUEST_STATE::QUERY_KEY;
+                } else if (*c == ' ') [[likely]] {
+                    this->state_ = REQUEST_STATE::VERSION;
+                } else [[unlikely]] {
+                    this->state_ = REQUEST_STATE::BAD_REQUEST;
+                    return c;
                 }
+                query_params.addQueryParam(std::move(this->data_value_pair_.first), std::move(this->data_value_pair_.second));
+                this->data_value_pair_.first.clear();
+                this->data_value_pair_.second.clear();
+                ++c, ++this->line_size_;
                 break;
             }
             // this is unused, since it's never transfered to server still usefull to have
@@ -275,7 +302,7 @@ usub::server::protocols::http::Request::parseHTTP1_X(const std::string &request,
                 break;
             }
             case REQUEST_STATE::VERSION:
-                for (c; c != request.end() && this->state_ == REQUEST_STATE::VERSION; ++c, ++this->line_size_) {
+                for (; c != end && this->state_ == REQUEST_STATE::VERSION; ++c, ++this->line_size_) {
                     switch (*c) {
                         case ' ':
                             this->state_ = REQUEST_STATE::BAD_REQUEST;
@@ -306,7 +333,6 @@ usub::server::protocols::http::Request::parseHTTP1_X(const std::string &request,
                             this->line_size_ = 0;
                             this->state_ = REQUEST_STATE::PRE_HEADERS;
                             return c;
-                            break;
                         default:
                             if (this->line_size_ > this->max_uri_size_) [[unlikely]] {
                                 this->state_ = REQUEST_STATE::BAD_REQUEST;
@@ -322,8 +348,18 @@ usub::server::protocols::http::Request::parseHTTP1_X(const std::string &request,
                 this->carriage_return = false;
                 c++;
                 this->state_ = REQUEST_STATE::HEADERS_KEY;
+                [[fallthrough]];
             case REQUEST_STATE::HEADERS_KEY:
-                for (c; c != request.end() && this->state_ == REQUEST_STATE::HEADERS_KEY && this->line_size_ <= this->max_headers_size_; ++c, ++this->line_size_) {
+                while (c != end && this->state_ == REQUEST_STATE::HEADERS_KEY && this->line_size_ <= this->max_headers_size_) {
+                    if (!this->carriage_return) [[likely]] {
+                        // fast path: the whole field-name is appended (lowercased) in one step
+                        const char *limit = c + std::min<size_t>(end - c, this->max_headers_size_ - this->line_size_ + 1);
+                        const char *run = c;
+                        c = scanRun(c, limit, [](char ch) { return usub::utils::isTchar(ch); });
+                        appendLower(this->data_value_pair_.first, run, c);
+                        this->line_size_ += c - run;
+                        if (c == limit) break;
+                    }
                     switch (*c) {
                         case ' ':
                             this->state_ = REQUEST_STATE::BAD_REQUEST;
@@ -351,22 +387,24 @@ usub::server::protocols::http::Request::parseHTTP1_X(const std::string &request,
                             }
                             break;
                         default:
-                            if (this->carriage_return) [[unlikely]] {
-                                this->state_ = REQUEST_STATE::BAD_REQUEST;
-                                return c;
-                            }
-                            if (usub::utils::isTchar(*c)) [[likely]] {
-                                this->data_value_pair_.first.push_back(std::tolower(*c));
-                            } else [[unlikely]] {
-                                this->state_ = REQUEST_STATE::BAD_REQUEST;
-                                return c;
-                            }
-                            break;
+                            // either a tchar after a bare CR or a character that is not allowed in a field-name
+                            this->state_ = REQUEST_STATE::BAD_REQUEST;
+                            return c;
                     }
+                    ++c, ++this->line_size_;
                 }
                 break;
             case REQUEST_STATE::HEADERS_VALUE:
-                for (c; c != request.end() && this->state_ == REQUEST_STATE::HEADERS_VALUE && this->line_size_ <= this->max_headers_size_; ++c, ++this->line_size_) {
+                while (c != end && this->state_ == REQUEST_STATE::HEADERS_VALUE && this->line_size_ <= this->max_headers_size_) {
+                    if (!this->carriage_return) [[likely]] {
+                        // fast path: the whole field-value up to CR is appended in one step
+                        const char *limit = c + std::min<size_t>(end - c, this->max_headers_size_ - this->line_size_ + 1);
+                        const char *run = c;
+                        c = scanRun(c, limit, [](char ch) { return ch == ' ' || usub::utils::isVcharOrObsText(ch); });
+                        this->data_value_pair_.second.append(run, c);
+                        this->line_size_ += c - run;
+                        if (c == limit) break;
+                    }
                     switch (*c) {
                         case '\r':
                             if (!carriage_return) [[likely]] {
@@ -405,84 +443,74 @@ usub::server::protocols::http::Request::parseHTTP1_X(const std::string &request,
                             }
                             break;
                     }
+                    ++c, ++this->line_size_;
                 }
                 break;
             case REQUEST_STATE::HEADERS_PARSED: {
                 this->line_size_ = 0;
-                auto headers = this->headers_;
-                auto content_length = headers[usub::server::component::HeaderEnum::Content_Length].size() == 1 ? std::stoi(headers[usub::server::component::HeaderEnum::Content_Length][0]) : -1;
+                // by reference: copying the whole header table per request is not needed, but operator[] would
+                // insert missing keys, so look them up through contains() first
+                auto &headers = this->headers_;
+                const bool has_content_length = headers.contains(usub::server::component::HeaderEnum::Content_Length);
+                const bool has_transfer_encoding = headers.contains(usub::server::component::HeaderEnum::Transfer_Encoding);
+                auto content_length = has_content_length && headers[usub::server::component::HeaderEnum::Content_Length].size() == 1 ? std::stoi(headers[usub::server::component::HeaderEnum::Content_Length][0]) : -1;
                 if (content_length > 0) [[likely]] {
                     this->helper_.size_ = content_length;
                     this->state_ = REQUEST_STATE::DATA_CONTENT_LENGTH;
                 } else if (content_length == 0) [[unlikely]] {
                     this->helper_.size_ = 0;
                     this->state_ = REQUEST_STATE::FINISHED;
-                } else if (!headers[usub::server::component::HeaderEnum::Transfer_Encoding].empty()) [[likely]] {
+                } else if (has_transfer_encoding && !headers[usub::server::component::HeaderEnum::Transfer_Encoding].empty()) [[likely]] {
                     if (headers[usub::server::component::HeaderEnum::Transfer_Encoding].back() == "chunked") {
                         this->state_ = REQUEST_STATE::DATA_CHUNKED_SIZE;
                     } else {
                         this->state_ = REQUEST_STATE::UNSUPPORTED_MEDIA_TYPE;
                         return c;
                     }
-                } else if (this->method_token_ == "GET" || this->method_token_ == "HEAD") [[likely]] {
+                } else if (this->getMethod() == Method::GET || this->getMethod() == Method::HEAD) [[likely]] {
                     this->state_ = REQUEST_STATE::FINISHED;
                 } else {
                     this->state_ = REQUEST_STATE::LENGTH_REQUIRED;
                     return c;
                 }
-                // size_t amount_of_encodings = 0;
-                // auto& transfer_encoding = headers[usub::server::component::HeaderEnum::Transfer_Encoding]
-                // if (!headers.Transfer_Encoding.empty()) {
-                //     if (headers.Transfer_Encoding.size() != 1) {
-                //         amount_of_encodings += headers.Transfer_Encoding.size();
-                //         if (amount_of_encodings > 2) {
-                //             this->state_ = REQUEST_STATE::BAD_REQUEST;
-                //             return c;
-                //         }
-                //         DecoderChainFactory::instance().create(headers.Transfer_Encoding, this->encryptors_chain);
-                //     }
-                // }
-                // if (!headers.Content_Encoding.empty()) {
-                //     amount_of_encodings += headers.Content_Encoding.size();
-                //     if (amount_of_encodings > 2 + 2) {
-                //         this->state_ = REQUEST_STATE::BAD_REQUEST;
-                //         return c;
-                //     }
-                //     DecoderChainFactory::instance().create(headers.Content_Encoding, this->encryptors_chain);
-                // }
                 carriage_return = false;
                 c++;
                 break;
             }
-            case REQUEST_STATE::DATA_CONTENT_LENGTH:
-                for (c; c != request.end() && this->state_ == REQUEST_STATE::DATA_CONTENT_LENGTH && this->line_size_ <= this->max_data_size_; ++c, ++line_size_) {
-
-                    this->body_.push_back(*c);
-                    if (this->body_.size() == this->helper_.size_) {
-                        for (auto decompressor: this->encryptors_chain) {
-                            decompressor->decompress(this->body_);
-                            if (decompressor->getState() != 2) {
-                                this->state_ = REQUEST_STATE::BAD_REQUEST;
-                                return c;
-                            } else {
-                                this->state_ = REQUEST_STATE::FINISHED;
-                                return c;
-                            }
+            case REQUEST_STATE::DATA_CONTENT_LENGTH: {
+                if (this->line_size_ > static_cast<size_t>(this->max_data_size_)) {
+                    this->state_ = REQUEST_STATE::BAD_REQUEST;
+                    return c;
+                }
+                // the body is copied straight out of the read buffer, one append per read
+                const size_t take = std::min({this->helper_.size_ - this->body_.size(),
+                                              static_cast<size_t>(end - c),
+                                              static_cast<size_t>(this->max_data_size_) - this->line_size_ + 1});
+                this->body_.append(c, take);
+                c += take;
+                this->line_size_ += take;
+                if (this->body_.size() == this->helper_.size_) {
+                    for (auto decompressor: this->encryptors_chain) {
+                        decompressor->decompress(this->body_);
+                        if (decompressor->getState() != 2) {
+                            this->state_ = REQUEST_STATE::BAD_REQUEST;
+                            return c;
+                        } else {
+                            this->state_ = REQUEST_STATE::FINISHED;
+                            return c;
                         }
-                        this->state_ = REQUEST_STATE::FINISHED;
-                        return c;
-                    } else if (this->body_.size() > this->helper_.size_) {
-                        this->state_ = REQUEST_STATE::BAD_REQUEST;
-                        return c;
                     }
+                    this->state_ = REQUEST_STATE::FINISHED;
+                    return c;
                 }
-                if (this->line_size_ > this->max_data_size_) {
+                if (this->line_size_ > static_cast<size_t>(this->max_data_size_)) {
                     this->state_ = REQUEST_STATE::BAD_REQUEST;
                     return c;
                 }
                 break;
+            }
             case REQUEST_STATE::DATA_FRAGMENT:
-                for (c; c != request.end() && this->state_ == REQUEST_STATE::DATA_FRAGMENT && this->line_size_ <= this->max_data_size_; ++c, ++line_size_) {
+                for (; c != end && this->state_ == REQUEST_STATE::DATA_FRAGMENT && this->line_size_ <= this->max_data_size_; ++c, ++line_size_) {
                     if (*c == '\r') {
                         if (this->carriage_return) {
                             this->state_ = REQUEST_STATE::BAD_REQUEST;
@@ -505,9 +533,9 @@ usub::server::protocols::http::Request::parseHTTP1_X(const std::string &request,
                     this->state_ = REQUEST_STATE::BAD_REQUEST;
                     return c;
                 }
-
+                [[fallthrough]];
             case REQUEST_STATE::DATA_CHUNKED_SIZE:
-                for (c; c != request.end() && this->state_ == REQUEST_STATE::DATA_CHUNKED_SIZE && this->line_size_ <= this->max_data_size_; ++c, ++line_size_) {
+                for (; c != end && this->state_ == REQUEST_STATE::DATA_CHUNKED_SIZE && this->line_size_ <= this->max_data_size_; ++c, ++line_size_) {
                     switch (*c) {
                         case '\r':
                             if (carriage_return) {
@@ -555,33 +583,43 @@ usub::server::protocols::http::Request::parseHTTP1_X(const std::string &request,
                 }
 
                 break;
-            case REQUEST_STATE::DATA_CHUNKED:
-                for (c; c != request.end() && this->state_ == REQUEST_STATE::DATA_CHUNKED && this->line_size_ <= this->max_data_size_; ++c, ++line_size_) {
-                    this->data_value_pair_.first.push_back(*c);
-                    if (this->data_value_pair_.first.size() == this->helper_.size_) {
-                        for (auto decompressor: this->encryptors_chain) {
-                            decompressor->decompress(this->data_value_pair_.first);
-                            if (decompressor->getState() == 2) {
-                                this->state_ = REQUEST_STATE::DATA_FRAGMENT;
-                                return c;
-                            } else {
-                                this->state_ = REQUEST_STATE::DATA_CHUNKED_SIZE;
-                                return c;
-                            }
+            case REQUEST_STATE::DATA_CHUNKED: {
+                if (this->line_size_ > static_cast<size_t>(this->max_data_size_)) {
+                    this->state_ = REQUEST_STATE::BAD_REQUEST;
+                    return end;
+                }
+                std::string &chunk = this->data_value_pair_.first;
+                const size_t take = std::min({this->helper_.size_ - chunk.size(),
+                                              static_cast<size_t>(end - c),
+                                              static_cast<size_t>(this->max_data_size_) - this->line_size_ + 1});
+                chunk.append(c, take);
+                c += take;
+                this->line_size_ += take;
+                if (chunk.size() == this->helper_.size_) {
+                    for (auto decompressor: this->encryptors_chain) {
+                        decompressor->decompress(chunk);
+                        if (decompressor->getState() == 2) {
+                            this->state_ = REQUEST_STATE::DATA_FRAGMENT;
+                            return c - 1;
+                        } else {
+                            this->state_ = REQUEST_STATE::DATA_CHUNKED_SIZE;
+                            return c - 1;
                         }
-                        this->state_ = REQUEST_STATE::DATA_FRAGMENT;
-                        c++;
-                        return c;
                     }
+                    this->state_ = REQUEST_STATE::DATA_FRAGMENT;
+                    return c;
                 }
-                if (this->line_size_ > this->max_data_size_) {
+                if (this->line_size_ > static_cast<size_t>(this->max_data_size_)) {
                     this->state_ = REQUEST_STATE::BAD_REQUEST;
-                    c = request.end();
-                    return c;
+                    return end;
                 }
                 break;
+            }
+            case REQUEST_STATE::FINISHED:
+                // stop right after the message, anything left is the next pipelined request
+                return c;
             default:
-                c = request.end();
+                c = end;
                 break;
         }
     }
@@ -593,14 +631,23 @@ void usub::server::protocols::http::Request::clear() {
     this->newline = false;
     this->state_ = REQUEST_STATE::METHOD;
     this->method_token_.clear();
+    this->method_interned_ = false;
     this->body_.clear();
     this->headers_.clear();
-    this->urn_ = usub::server::component::URN();
+    this->urn_.clear();
+    this->uri_params.clear();
     // this->server_name_ = {};
     this->line_size_ = 0;
     this->state_ = REQUEST_STATE::METHOD;
     this->http_version_ = VERSION::NONE;
-    this->data_value_pair_ = {};
+    this->data_value_pair_.first.clear();
+    this->data_value_pair_.second.clear();
+}
+
+void usub::server::protocols::http::Request::setMemoryResource(std::pmr::memory_resource *resource) {
+    this->clear();
+    this->headers_.setMemoryResource(resource);
+    this->urn_.getQueryParams().setMemoryResource(resource);
 }
 
 bool usub::server::protocols::http::Response::isSent() {
@@ -741,6 +788,29 @@ usub::server::protocols::http::Response &usub::server::protocols::http::Response
     return *this;
 }
 
+size_t usub::server::protocols::http::Response::remainingBody() const {
+    return this->helper_.size_ > this->helper_.offset_ ? this->helper_.size_ - this->helper_.offset_ : 0;
+}
+
+size_t usub::server::protocols::http::Response::pullBody(std::string &out, size_t max) {
+    size_t produced = std::min(this->remainingBody(), max);
+    if (produced > 0 && this->helper_.buffer_) {
+        out.append(this->body_, this->helper_.offset_, produced);
+    } else if (produced > 0) {
+        const size_t used = out.size();
+        out.resize(used + produced);
+        const ssize_t n = pread(this->fd_, out.data() + used, produced, static_cast<off_t>(this->helper_.offset_));
+        produced = static_cast<size_t>(std::max<ssize_t>(n, 0));
+        out.resize(used + produced);
+        if (produced == 0) return 0;
+    }
+    this->helper_.offset_ += produced;
+    if (this->helper_.offset_ >= this->helper_.size_) {
+        this->state_ = RESPONSE_STATE::SENT;
+    }
+    return produced;
+}
+
 const std::unordered_map<std::string, std::string> usub::server::protocols::http::Response::code_status_map_{
         {"100", "Continue"},
         {"101", "Switching Protocols"},
@@ -797,48 +867,118 @@ const std::unordered_map<std::string, std::string> usub::server::protocols::http
         {"505", "HTTP Version Not Supported"},
         {"511", "Network Authentication Required"}};
 
+namespace {
+    constexpr std::string_view CHUNK_END_AND_LAST_CHUNK = "\r\n0\r\n\r\n";
+    constexpr std::string_view LAST_CHUNK = CHUNK_END_AND_LAST_CHUNK.substr(2);
+
+    inline void pushSegment(std::vector<iovec> &iov, const char *data, size_t size) {
+        if (size == 0) return;
+        iov.push_back({const_cast<char *>(data), size});
+    }
+}// namespace
+
 std::string usub::server::protocols::http::Response::pull() {
+    std::vector<iovec> iov;
+    this->pullSegments(iov);
+
+    size_t total = 0;
+    for (const auto &segment: iov) total += segment.iov_len;
     std::string res;
-    if (this->helper_.add_metadata_) {
+    res.reserve(total);
+    for (const auto &segment: iov) res.append(static_cast<const char *>(segment.iov_base), segment.iov_len);
+    return res;
+}
+
+void usub::server::protocols::http::Response::pullSegments(std::vector<iovec> &iov, FileRange &file) {
+    file = {};
+    if (this->helper_.buffer_ || this->fd_ == -1) {
+        this->pullSegments(iov);
+        return;
+    }
+
+    // only the head goes through iov, the body is sent by the kernel straight from fd_
+    this->pullHead(iov);
+
+    const size_t remaining = this->helper_.size_ - this->helper_.offset_;
+    file.fd = this->fd_;
+    file.offset = static_cast<off_t>(this->helper_.offset_);
+    if (this->helper_.chunked_) {
+        file.size = std::min(remaining, this->helper_.max_write_size_);
+        if (file.size > 0) {
+            char hex_size[17];
+            const int n = std::snprintf(hex_size, sizeof(hex_size), "%zx", file.size);
+            this->chunk_head_.assign(hex_size, n);
+            this->chunk_head_.append("\r\n");
+            pushSegment(iov, this->chunk_head_.data(), this->chunk_head_.size());
+        }
+        this->helper_.offset_ += file.size;
+        if (this->helper_.offset_ == this->helper_.size_) {
+            file.trailer = file.size > 0 ? CHUNK_END_AND_LAST_CHUNK : LAST_CHUNK;
+        } else {
+            file.trailer = CHUNK_END_AND_LAST_CHUNK.substr(0, 2);
+        }
+    } else {
+        file.size = remaining;
+        this->helper_.offset_ += file.size;
+    }
+    if (this->helper_.size_ == this->helper_.offset_) {
+        this->state_ = RESPONSE_STATE::SENT;
+    }
+}
 
-        res.reserve(100 + this->headers_.size());
+void usub::server::protocols::http::Response::pullHead(std::vector<iovec> &iov) {
+    if (this->helper_.add_metadata_) {
+        std::string &head = this->head_;
+        head.clear();
+        head.reserve(100 + this->headers_.size());
 
         switch (this->http_version_) {
             case VERSION::HTTP_1_0:
-                res.append("HTTP/1.0 ");
+                head.append("HTTP/1.0 ");
                 break;
             case VERSION::HTTP_1_1:
-                res.append("HTTP/1.1 ");
+                head.append("HTTP/1.1 ");
                 break;
             default:
                 std::cerr << "HTTP/0.9 is not supported" << std::endl;
-                res.append("HTTP/1.0 ");
+                head.append("HTTP/1.0 ");
                 break;
         }
 
-        res.append(this->status_code_);
-        res.append(" ");
-        res.append(this->status_message_);
-        res.append("\r\n");
-        res.append(this->headers_.string());
-        res.append("\r\n");
+        head.append(this->status_code_);
+        head.append(" ");
+        head.append(this->status_message_);
+        head.append("\r\n");
+        this->headers_.serialize(head);
+        head.append("\r\n");
         this->helper_.add_metadata_ = false;
+        pushSegment(iov, head.data(), head.size());
     }
+}
 
+void usub::server::protocols::http::Response::pullSegments(std::vector<iovec> &iov) {
+    this->pullHead(iov);
 
     if (this->helper_.buffer_) {
+        this->helper_.offset_ += this->body_.size();
         if (this->helper_.chunked_) {
-            this->helper_.offset_ += this->body_.size();
-            res.append(std::to_string(this->body_.size()));
-            res.append("\r\n");
-            res.append(this->body_);
-            res.append("\r\n");
-            res.append("0\r\n\r\n");
+            if (!this->body_.empty()) {
+                char hex_size[17];
+                const int n = std::snprintf(hex_size, sizeof(hex_size), "%zx", this->body_.size());
+                this->chunk_head_.assign(hex_size, n);
+                this->chunk_head_.append("\r\n");
+                pushSegment(iov, this->chunk_head_.data(), this->chunk_head_.size());
+                pushSegment(iov, this->body_.data(), this->body_.size());
+                pushSegment(iov, CHUNK_END_AND_LAST_CHUNK.data(), CHUNK_END_AND_LAST_CHUNK.size());
+            } else {
+                pushSegment(iov, LAST_CHUNK.data(), LAST_CHUNK.size());
+            }
         } else {
-            this->helper_.offset_ += this->body_.size();
-            res.append(this->body_);
+            pushSegment(iov, this->body_.data(), this->body_.size());
         }
     } else {
+        std::string &res = this->file_chunk_;
+        res.clear();
         size_t current_write = 0;
         if (this->helper_.chunked_) {
             const size_t bufferSize = this->helper_.chunk_size_;
@@ -858,28 +998,24 @@ std::string usub::server::protocols::http::Response::pull() {
                 }
             }
             if (this->helper_.size_ == this->helper_.offset_) {
-                res.append("0\r\n\r\n");
+                res.append(LAST_CHUNK);
             }
         } else {
-            const size_t bufferSize = 4096;// Use a buffer size of 4 KB
-            std::vector<char> buffer(bufferSize);
-
+            // read straight into the reused chunk buffer, no intermediate 4 KB copy
+            const size_t want = this->helper_.max_write_size_;
+            res.resize(want);
             ssize_t bytesRead;
-            while ((bytesRead = read(this->fd_, buffer.data(), buffer.size())) > 0) {
+            while (current_write < want && (bytesRead = read(this->fd_, res.data() + current_write, want - current_write)) > 0) {
                 this->helper_.offset_ += bytesRead;
                 current_write += bytesRead;
-                res.append(buffer.data(), bytesRead);
-                if (current_write >= this->helper_.max_write_size_) {
-                    break;
-                }
             }
+            res.resize(current_write);
         }
+        pushSegment(iov, res.data(), res.size());
     }
     if (this->helper_.size_ == this->helper_.offset_) {
         this->state_ = RESPONSE_STATE::SENT;
     }
-
-    return res;
 }
 
 std::string usub::server::protocols::http::Response::string() const {
@@ -969,7 +1105,8 @@ void usub::server::protocols::http::Response::clear() {
     this->state_ = RESPONSE_STATE::SENDING;
     this->headers_.clear();
     this->body_.clear();
-    this->data_value_pair_ = {};
+    this->data_value_pair_.first.clear();
+    this->data_value_pair_.second.clear();
     this->helper_ = {};
     if (this->fd_ != -1) {
         close(fd_);
@@ -979,6 +1116,11 @@ void usub::server::protocols::http::Response::clear() {
     //    this->http_version_ = NONE;
 }
 
+void usub::server::protocols::http::Response::setMemoryResource(std::pmr::memory_resource *resource) {
+    this->clear();
+    this->headers_.setMemoryResource(resource);
+}
+
 //usub::uvent::task::Awaitable<void> usub::server::protocols::http::Response::send_coro() {
 //        ssize_t wrsize = co_await *this->socket_->async_write(reinterpret_cast<uint8_t *>(const_cast<char *>(str.data())), str.size());
 //        if (wrsize <= 0) {
@@ -1037,6 +1179,8 @@ usub::uvent::task::Awaitable<bool> usub::server::protocols::http::Request::parse
                             this->state_ = REQUEST_STATE::BAD_REQUEST;
                             break;
                         }
+                        this->method_ = methods::lookup(this->method_token_);
+                        this->method_interned_ = true;
                         this->state_ = REQUEST_STATE::TARGET_START;
                     } else [[unlikely]] {
                         this->state_ = REQUEST_STATE::BAD_REQUEST;
@@ -1312,7 +1456,7 @@ usub::uvent::task::Awaitable<bool> usub::server::protocols::http::Request::parse
                         this->state_ = REQUEST_STATE::UNSUPPORTED_MEDIA_TYPE;
                         co_return true;
                     }
-                } else if (this->method_token_ == "GET" || this->method_token_ == "HEAD") [[likely]] {
+                } else if (this->getMethod() == Method::GET || this->getMethod() == Method::HEAD) [[likely]] {
                     this->state_ = REQUEST_STATE::FINISHED;
                 } else {
                     this->state_ = REQUEST_STATE::LENGTH_REQUIRED;
@@ -1480,6 +1624,33 @@ void usub::server::protocols::http::Request::setUri(const std::string &uri) {//
     this->urn_.getPath() = uri;
 }
 
+bool usub::server::protocols::http::Request::setTarget(std::string_view target) {
+    if (target.empty() || target.front() != '/') return false;
+    const size_t query_start = target.find('?');
+    const std::string_view path = target.substr(0, query_start);
+    if (std::find_if_not(path.begin(), path.end(), component::URN::isPathChar) != path.end()) return false;
+    this->urn_.getPath().assign(path);
+    if (query_start == std::string_view::npos) return true;
+
+    std::string_view query = target.substr(query_start + 1);
+    if (std::find_if_not(query.begin(), query.end(), component::URN::isQueryChar) != query.end()) return false;
+    usub::server::component::url::QueryParams &query_params = this->urn_.getQueryParams();
+    query_params.string().assign(query);
+    while (!query.empty()) {
+        const std::string_view pair = query.substr(0, query.find('&'));
+        query.remove_prefix(std::min(pair.size() + 1, query.size()));
+        const size_t eq = pair.find('=');
+        if (eq == std::string_view::npos) return false;// same as the HTTP/1 parser, a key needs a value
+        query_params.addQueryParam(pair.substr(0, eq), pair.substr(eq + 1));
+    }
+    return true;
+}
+
+usub::server::protocols::http::Request &usub::server::protocols::http::Request::appendBody(std::string_view data) {
+    this->body_.append(data);
+    return *this;
+}
+
 usub::server::protocols::http::Request &usub::server::protocols::http::Request::setBody(const std::string &data, const std::string &content_type) {
     this->body_ = data;
     this->helper_.offset_ = 0;
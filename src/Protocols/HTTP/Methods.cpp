@@ -0,0 +1,74 @@
+#include "Protocols/HTTP/Methods.h"
+
+#include <atomic>
+#include <mutex>
+
+namespace usub::server::protocols::http {
+
+    namespace {
+        /// Extension methods in interning order; entries are written before the count that publishes them.
+        struct ExtensionTable {
+            std::array<std::string, methods::max_extensions> names;
+            std::atomic<size_t> count{0};
+            std::mutex mutex;
+        };
+
+        ExtensionTable &extensions() {
+            static ExtensionTable table;
+            return table;
+        }
+
+        Method findExtension(const ExtensionTable &table, std::string_view token) {
+            const size_t count = table.count.load(std::memory_order_acquire);
+            for (size_t i = 0; i < count; ++i) {
+                if (table.names[i] == token) return static_cast<Method>(methods::standard_methods.size() + i);
+            }
+            return Method::UNKNOWN;
+        }
+    }// namespace
+
+    Method methods::lookup(std::string_view token) {
+        const Method method = standard(token);
+        if (method != Method::UNKNOWN) return method;
+        return findExtension(extensions(), token);
+    }
+
+    Method methods::intern(std::string_view token) {
+        const Method method = lookup(token);
+        if (method != Method::UNKNOWN || token.empty()) return method;
+
+        ExtensionTable &table = extensions();
+        std::lock_guard lock(table.mutex);
+        if (const Method found = findExtension(table, token); found != Method::UNKNOWN) return found;
+        const size_t count = table.count.load(std::memory_order_relaxed);
+        if (count == max_extensions) {
+            throw std::runtime_error("Too many extension methods, cannot intern: " + std::string(token));
+        }
+        table.names[count] = token;
+        table.count.store(count + 1, std::memory_order_release);
+        return static_cast<Method>(standard_methods.size() + count);
+    }
+
+    std::string_view methods::name(Method method) {
+        const size_t index = static_cast<size_t>(method);
+        if (index < standard_methods.size()) return standard_methods[index];
+        const ExtensionTable &table = extensions();
+        if (method != Method::UNKNOWN && index - standard_methods.size() < table.count.load(std::memory_order_acquire)) {
+            return table.names[index - standard_methods.size()];
+        }
+        return {};
+    }
+
+    std::string MethodSet::allowHeader() const {
+        std::string header;
+        for (size_t i = 0; i < static_cast<size_t>(Method::UNKNOWN); ++i) {
+            if (!(this->mask_ & (uint64_t{1} << i))) continue;
+            const std::string_view method = methods::name(static_cast<Method>(i));
+            if (method.empty()) continue;
+            if (!header.empty()) header += ", ";
+            header += method;
+        }
+        return header;
+    }
+
+}// namespace usub::server::protocols::http
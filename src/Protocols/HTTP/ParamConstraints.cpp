@@ -0,0 +1,85 @@
+#include "Protocols/HTTP/ParamConstraints.h"
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <utility>
+
+namespace usub::server::protocols::http {
+
+    namespace {
+        /// Patterns a native matcher handles exactly, so constraints written as a regex skip std::regex.
+        constexpr std::array<std::pair<std::string_view, ParamKind>, 10> known_patterns{{
+                {R"([^/]+)", ParamKind::ANY},
+                {R"([0-9]+)", ParamKind::UINT},
+                {R"(\d+)", ParamKind::UINT},
+                {R"(-?[0-9]+)", ParamKind::INT},
+                {R"(-?\d+)", ParamKind::INT},
+                {R"([0-9a-fA-F]+)", ParamKind::HEX},
+                {R"([a-fA-F0-9]+)", ParamKind::HEX},
+                {R"([-a-zA-Z0-9_]+)", ParamKind::SLUG},
+                {R"([0-9a-fA-F]{8}-[0-9a-fA-F]{4}-[0-9a-fA-F]{4}-[0-9a-fA-F]{4}-[0-9a-fA-F]{12})", ParamKind::UUID},
+                {R"([a-fA-F0-9]{8}-[a-fA-F0-9]{4}-[a-fA-F0-9]{4}-[a-fA-F0-9]{4}-[a-fA-F0-9]{12})", ParamKind::UUID},
+        }};
+
+        ParamKind patternKind(std::string_view pattern) {
+            for (const auto &[known, kind]: known_patterns) {
+                if (known == pattern) return kind;
+            }
+            return ParamKind::REGEX;
+        }
+    }// namespace
+
+    param_constraint constraints::one_of(std::initializer_list<std::string_view> literals) {
+        static const std::string_view specials = R"(.^$|()[]{}*+?\)";
+        param_constraint constraint{"(?:", "Must be one of: ", ParamKind::ONE_OF};
+        for (std::string_view literal: literals) {
+            if (!constraint.literals.empty()) {
+                constraint.pattern += '|';
+                constraint.description += ", ";
+            }
+            for (char c: literal) {
+                if (specials.find(c) != std::string_view::npos) constraint.pattern += '\\';
+                constraint.pattern += c;
+            }
+            constraint.description += literal;
+            constraint.literals.emplace_back(literal);
+        }
+        constraint.pattern += ')';
+        return constraint;
+    }
+
+    param_constraint constraints::length(size_t min_length, size_t max_length) {
+        param_constraint constraint{"[^/]{" + std::to_string(min_length) + "," + std::to_string(max_length) + "}",
+                                    "Must be " + std::to_string(min_length) + " to " + std::to_string(max_length) + " characters long",
+                                    ParamKind::LENGTH};
+        constraint.min_length = min_length;
+        constraint.max_length = max_length;
+        return constraint;
+    }
+
+    const param_constraint *constraints::named(std::string_view type) {
+        if (type == "int") return &integer;
+        if (type == "uint") return &unsigned_integer;
+        if (type == "uuid") return &uuid;
+        if (type == "hex") return &hex;
+        if (type == "slug") return &slug;
+        return nullptr;
+    }
+
+    ParamMatcher::ParamMatcher(const param_constraint &constraint)
+        : kind_(constraint.kind == ParamKind::REGEX ? patternKind(constraint.pattern) : constraint.kind),
+          literals_(constraint.literals),
+          min_length_(constraint.min_length),
+          max_length_(constraint.max_length) {
+        if (this->kind_ == ParamKind::REGEX) {
+            this->regex_.emplace(constraint.pattern, std::regex::ECMAScript | std::regex::optimize);
+        }
+        std::sort(this->literals_.begin(), this->literals_.end());
+    }
+
+    bool ParamMatcher::isLiteral(std::string_view segment) const {
+        return std::binary_search(this->literals_.begin(), this->literals_.end(), segment, std::less<>{});
+    }
+
+}// namespace usub::server::protocols::http
@@ -3,6 +3,30 @@
 
 namespace usub::server::protocols::http {
 
+    namespace {
+        /// Reads the next non-empty segment of @p path at @p pos into @p segment and moves @p pos past it.
+        bool nextSegment(std::string_view path, std::size_t &pos, std::string_view &segment) {
+            while (pos < path.size() && path[pos] == '/') ++pos;
+            if (pos == path.size()) return false;
+            const std::size_t end = std::min(path.find('/', pos), path.size());
+            segment = path.substr(pos, end - pos);
+            pos = end;
+            return true;
+        }
+
+        /// Everything from @p segment to the end of @p path, without the trailing slashes.
+        std::string_view wildcardTail(std::string_view path, std::string_view segment) {
+            std::string_view tail = path.substr(segment.data() - path.data());
+            while (!tail.empty() && tail.back() == '/') tail.remove_suffix(1);
+            return tail;
+        }
+
+        std::string paramError(const ParamEdge &edge) {
+            return edge.constraint ? edge.constraint->description
+                                   : ("Invalid value for parameter: " + edge.name);
+        }
+    }// namespace
+
     size_t RadixRouter::findMatchingBrace(const std::string &pathPattern, size_t start) const {
         std::stack<char> braceStack;
         for (size_t i = start; i < pathPattern.size(); ++i) {
@@ -32,23 +56,6 @@ namespace usub::server::protocols::http {
         return false;
     }
 
-    std::vector<std::string> RadixRouter::splitPath(const std::string &path) {
-        std::vector<std::string> parts;
-        parts.reserve(8);
-        std::string token;
-        std::stringstream ss(path);
-
-        if (!path.empty() && path[0] == '/') {
-            ss.get();// skip first '/'
-        }
-
-        while (std::getline(ss, token, '/')) {
-            if (!token.empty()) parts.push_back(token);
-        }
-
-        return parts;
-    }
-
     std::vector<RadixRouter::Segment>
     RadixRouter::parseSegments(const std::string &pattern, std::vector<std::string> &param_names) const {
         std::vector<RadixRouter::Segment> segs;
@@ -110,12 +117,15 @@ namespace usub::server::protocols::http {
                 constraint = it->second;
             }
 
+            if (!constraint) {
+                constraint = seg.re.empty() ? &default_constraint : constraints::named(seg.re);
+            }
+
             if (constraint) {
                 seg.re = constraint->pattern;
                 seg.constraint = *constraint;
-            } else if (seg.re.empty()) {
-                seg.re = default_constraint.pattern;
-                seg.constraint = default_constraint;
+            } else {
+                seg.constraint = param_constraint{seg.re, "Invalid value for parameter: " + seg.name};
             }
         }
     }
@@ -151,7 +161,7 @@ namespace usub::server::protocols::http {
 
             ParamEdge edge;
             edge.name = cur.name;
-            edge.regex = std::regex(cur.re);
+            edge.matcher = ParamMatcher(*cur.constraint);
             edge.child = std::make_unique<RadixNode>();
             edge.constraint = cur.constraint;
             // edge.pattern_str = cur.re;
@@ -171,6 +181,8 @@ namespace usub::server::protocols::http {
                                  const std::string &pattern,
                                  std::function<FunctionType> handler,
                                  const std::unordered_map<std::string_view, const param_constraint *> &constraints) {
+        this->frozen_ = false;
+
         std::vector<std::string> param_names;
         std::vector<Segment> segs = parseSegments(pattern, param_names);
 
@@ -233,18 +245,17 @@ namespace usub::server::protocols::http {
 
     std::optional<std::pair<Route *, bool>>
     RadixRouter::match(Request &request, std::string *error_description) {
-        const std::string path = request.getURL();
+        const std::string_view path = request.getURL();
+        request.uri_params.clear();
 
-        std::vector<std::string> segs = splitPath(path);
         Route *routePtr = nullptr;
-        if (!matchIter(root_.get(), segs, request, routePtr, error_description) || !routePtr) {
+        const bool found = this->frozen_ ? matchFlat(0, path, 0, request, routePtr, error_description)
+                                         : matchDFS(root_.get(), path, 0, request, routePtr, error_description);
+        if (!found || !routePtr) {
             return std::nullopt;
         }
 
-        bool methodOk = routePtr->accept_all_methods ||
-                        routePtr->allowed_method_tokenns.contains(request.getRequestMethod());
-
-        return std::make_pair(routePtr, methodOk);
+        return std::make_pair(routePtr, routePtr->allows(request.getMethod()));
     }
 
     MiddlewareChain &RadixRouter::addMiddleware(MiddlewarePhase phase,
@@ -356,17 +367,60 @@ namespace usub::server::protocols::http {
         return addRoute(method, pathPattern, std::move(function), constraints);
     }
 
+    void RadixRouter::freeze() {
+        this->nodes_.clear();
+        this->literals_.clear();
+        this->params_.clear();
+        flatten(root_.get());
+        this->frozen_ = true;
+    }
+
+    uint32_t RadixRouter::flatten(const RadixNode *node) {
+        const auto index = static_cast<uint32_t>(this->nodes_.size());
+        this->nodes_.emplace_back();
+
+        // Edges of a node are contiguous, so they are laid out before any child adds its own.
+        FlatNode flat;
+        flat.route = node->route.get();
+        flat.trailing_slash = node->trailing_slash;
+        flat.literals_begin = static_cast<uint32_t>(this->literals_.size());
+        for (const auto &[label, child]: node->literal) this->literals_.push_back({label, NO_NODE});
+        flat.literals_end = static_cast<uint32_t>(this->literals_.size());
+        std::sort(this->literals_.begin() + flat.literals_begin, this->literals_.begin() + flat.literals_end,
+                  [](const FlatLiteral &a, const FlatLiteral &b) { return a.label < b.label; });
+        flat.params_begin = static_cast<uint32_t>(this->params_.size());
+        for (const ParamEdge &edge: node->param) this->params_.push_back({&edge, NO_NODE});
+        flat.params_end = static_cast<uint32_t>(this->params_.size());
+
+        for (uint32_t i = flat.literals_begin; i < flat.literals_end; ++i) {
+            const uint32_t child = flatten(node->literal.find(this->literals_[i].label)->second.get());
+            this->literals_[i].child = child;
+        }
+        for (uint32_t i = flat.params_begin; i < flat.params_end; ++i) {
+            const uint32_t child = flatten(this->params_[i].edge->child.get());
+            this->params_[i].child = child;
+        }
+        if (node->wildcard) {
+            flat.wildcard = flatten(node->wildcard.get());
+            flat.wildcard_name = node->wildcard_name;
+        }
+
+        this->nodes_[index] = flat;
+        return index;
+    }
+
     // ---- Рекурсивный поиск с бэктрекингом ----------------------------------
 
     bool RadixRouter::matchDFS(RadixNode *node,
-                               const std::vector<std::string> &segs,
-                               std::size_t idx,
+                               std::string_view path,
+                               std::size_t pos,
                                Request &req,
                                Route *&out,
                                std::string *last_error) {
-        if (idx == segs.size()) {
+        std::string_view cur;
+        if (!nextSegment(path, pos, cur)) {
             if (node->route) {
-                const bool req_has_trailing = !req.getURL().empty() && req.getURL().back() == '/';
+                const bool req_has_trailing = !path.empty() && path.back() == '/';
                 if (node->trailing_slash == req_has_trailing) {
                     out = node->route.get();
                     return true;
@@ -375,66 +429,87 @@ namespace usub::server::protocols::http {
             return false;
         }
 
-        const std::string &cur = segs[idx];
-
         // 1) Литерал
         if (auto lit = node->literal.find(cur); lit != node->literal.end()) {
-            if (matchDFS(lit->second.get(), segs, idx + 1, req, out, last_error)) {
+            if (matchDFS(lit->second.get(), path, pos, req, out, last_error)) {
                 return true;
             }
         }
 
         // 2) Параметры — пробуем все подходящие, БЭКТРЕКИНГ
-        std::string local_error;
+        const std::size_t mark = req.uri_params.size();
+        const ParamEdge *failed = nullptr;
         for (ParamEdge &edge: node->param) {
-            if (edge.regex && std::regex_match(cur, *edge.regex)) {
-                // save old value if present
-                auto prev_it = req.uri_params.find(edge.name);
-                std::optional<std::string> prev_value;
-                if (prev_it != req.uri_params.end()) prev_value = prev_it->second;
-
-                req.uri_params[edge.name] = cur;
-
-                if (matchDFS(edge.child.get(), segs, idx + 1, req, out, last_error)) {
+            if (edge.matcher(cur)) {
+                req.uri_params.push(edge.name, cur);
+                if (matchDFS(edge.child.get(), path, pos, req, out, last_error)) {
                     return true;
                 }
-
-                // backtrack
-                if (prev_value) req.uri_params[edge.name] = *prev_value;
-                else
-                    req.uri_params.erase(edge.name);
-            } else if (last_error) {
-                local_error = edge.constraint ? edge.constraint->description
-                                              : ("Invalid value for parameter: " + edge.name);
+                req.uri_params.truncate(mark);
+            } else {
+                failed = &edge;
             }
         }
 
-        // 3) Wildcard — съедаем хвост
-        if (node->wildcard) {
-            std::string tail;
-            for (std::size_t i = idx; i < segs.size(); ++i) {
-                tail += '/' + segs[i];
-            }
-            if (!tail.empty()) tail.erase(0, 1);
-            req.uri_params[node->wildcard_name] = tail;
-            // Разрешаем матчить дальше: wildcard-узел помечается route только в конце
-            if (matchDFS(node->wildcard.get(), segs, segs.size(), req, out, last_error)) {
-                return true;
-            }
-            // backtrack wildcard param
-            req.uri_params.erase(node->wildcard_name);
+        // 3) Wildcard — съедаем хвост, слэш в конце не важен
+        if (node->wildcard && node->wildcard->route) {
+            req.uri_params.push(node->wildcard_name, wildcardTail(path, cur));
+            out = node->wildcard->route.get();
+            return true;
         }
 
-        if (last_error && !local_error.empty()) *last_error = local_error;
+        if (last_error && failed) *last_error = paramError(*failed);
         return false;
     }
 
-    bool RadixRouter::matchIter(RadixNode *node,
-                                const std::vector<std::string> &segs,
+    bool RadixRouter::matchFlat(uint32_t index,
+                                std::string_view path,
+                                std::size_t pos,
                                 Request &req,
                                 Route *&out,
-                                std::string *last_error) {
-        return matchDFS(node, segs, 0, req, out, last_error);
+                                std::string *last_error) const {
+        const FlatNode &node = this->nodes_[index];
+
+        std::string_view cur;
+        if (!nextSegment(path, pos, cur)) {
+            const bool req_has_trailing = !path.empty() && path.back() == '/';
+            if (node.route && node.trailing_slash == req_has_trailing) {
+                out = node.route;
+                return true;
+            }
+            return false;
+        }
+
+        const auto literals_end = this->literals_.begin() + node.literals_end;
+        auto lit = std::lower_bound(this->literals_.begin() + node.literals_begin, literals_end, cur,
+                                    [](const FlatLiteral &literal, std::string_view label) { return literal.label < label; });
+        if (lit != literals_end && lit->label == cur && matchFlat(lit->child, path, pos, req, out, last_error)) {
+            return true;
+        }
+
+        const std::size_t mark = req.uri_params.size();
+        const ParamEdge *failed = nullptr;
+        for (uint32_t i = node.params_begin; i < node.params_end; ++i) {
+            const FlatParam &param = this->params_[i];
+            if (param.edge->matcher(cur)) {
+                req.uri_params.push(param.edge->name, cur);
+                if (matchFlat(param.child, path, pos, req, out, last_error)) {
+                    return true;
+                }
+                req.uri_params.truncate(mark);
+            } else {
+                failed = param.edge;
+            }
+        }
+
+        if (node.wildcard != NO_NODE && this->nodes_[node.wildcard].route) {
+            req.uri_params.push(node.wildcard_name, wildcardTail(path, cur));
+            out = this->nodes_[node.wildcard].route;
+            return true;
+        }
+
+        if (last_error && failed) *last_error = paramError(*failed);
+        return false;
     }
 
     // ---- Отладочный дамп ----------------------------------------------------
@@ -0,0 +1,635 @@
+#include "Protocols/HTTP/RouteAutomaton.h"
+
+#include <algorithm>
+#include <map>
+#include <optional>
+
+namespace usub::server::protocols::http {
+
+    namespace {
+        constexpr size_t UNBOUNDED = SIZE_MAX;
+        /// Most copies a counted quantifier may expand to.
+        constexpr size_t MAX_REPEAT = 256;
+
+        std::bitset<256> rangeSet(unsigned char first, unsigned char last) {
+            std::bitset<256> set;
+            for (unsigned c = first; c <= last; ++c) set.set(c);
+            return set;
+        }
+
+        std::bitset<256> digitSet() { return rangeSet('0', '9'); }
+
+        std::bitset<256> wordSet() { return rangeSet('a', 'z') | rangeSet('A', 'Z') | digitSet() | rangeSet('_', '_'); }
+
+        std::bitset<256> spaceSet() {
+            std::bitset<256> set;
+            for (char c: std::string_view(" \t\n\r\f\v")) set.set(static_cast<unsigned char>(c));
+            return set;
+        }
+
+        std::optional<unsigned> hexValue(char c) {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return std::nullopt;
+        }
+
+        /// Per-thread buffers, so matching allocates only while they grow.
+        struct Scratch {
+            std::vector<uint32_t> states;
+            std::vector<uint32_t> next;
+            std::vector<uint32_t> marks;
+            std::vector<uint32_t> stack;
+            std::vector<uint32_t> ids;
+            std::vector<size_t> caps;     ///< Capture slots of each thread in states.
+            std::vector<size_t> next_caps;///< Capture slots of each thread in next.
+            std::vector<size_t> work;
+            std::vector<size_t> result;
+            uint32_t mark{0};
+
+            uint32_t nextMark(size_t program_size) {
+                if (this->marks.size() < program_size) this->marks.resize(program_size, 0);
+                if (++this->mark == 0) {
+                    std::fill(this->marks.begin(), this->marks.end(), 0);
+                    this->mark = 1;
+                }
+                return this->mark;
+            }
+        };
+
+        Scratch &scratch() {
+            thread_local Scratch buffers;
+            return buffers;
+        }
+    }// namespace
+
+    struct RouteAutomaton::Node {
+        enum Kind {
+            EMPTY,
+            SET,
+            CONCAT,
+            ALT,
+            REPEAT,
+            GROUP,
+        } kind{EMPTY};
+        uint32_t set{0};
+        std::vector<Node> children;
+        size_t min{0};
+        size_t max{0};
+        bool greedy{true};
+        size_t group{0};///< 1-based, 0 for a non-capturing group.
+    };
+
+    class RouteAutomaton::Parser {
+    public:
+        Parser(RouteAutomaton &automaton, std::string_view pattern) : automaton_(automaton), in_(pattern) {}
+
+        std::optional<Node> parse() {
+            if (this->peek('^')) ++this->pos_;
+            std::optional<Node> node = this->alternation();
+            if (node && this->peek('$') && this->pos_ + 1 == this->in_.size()) ++this->pos_;
+            if (!node || this->pos_ != this->in_.size()) return std::nullopt;
+            return node;
+        }
+
+        size_t groups() const { return this->groups_; }
+
+    private:
+        bool peek(char c) const { return this->pos_ < this->in_.size() && this->in_[this->pos_] == c; }
+
+        bool atEnd() const {
+            return this->pos_ == this->in_.size() || this->peek('|') || this->peek(')') ||
+                   (this->peek('$') && this->pos_ + 1 == this->in_.size());
+        }
+
+        Node set(const std::bitset<256> &bits) {
+            Node node;
+            node.kind = Node::SET;
+            node.set = this->automaton_.addSet(bits);
+            return node;
+        }
+
+        std::optional<Node> alternation() {
+            Node alt;
+            alt.kind = Node::ALT;
+            do {
+                if (!alt.children.empty()) ++this->pos_;
+                std::optional<Node> branch = this->concatenation();
+                if (!branch) return std::nullopt;
+                alt.children.push_back(std::move(*branch));
+            } while (this->peek('|'));
+            if (alt.children.size() == 1) return std::move(alt.children.front());
+            return alt;
+        }
+
+        std::optional<Node> concatenation() {
+            Node concat;
+            concat.kind = Node::CONCAT;
+            while (!this->atEnd()) {
+                std::optional<Node> item = this->repetition();
+                if (!item) return std::nullopt;
+                concat.children.push_back(std::move(*item));
+            }
+            if (concat.children.empty()) return Node{};
+            if (concat.children.size() == 1) return std::move(concat.children.front());
+            return concat;
+        }
+
+        bool number(size_t &value) {
+            const size_t start = this->pos_;
+            value = 0;
+            while (this->pos_ < this->in_.size() && this->in_[this->pos_] >= '0' && this->in_[this->pos_] <= '9') {
+                value = value * 10 + (this->in_[this->pos_++] - '0');
+                if (value > MAX_REPEAT) return false;
+            }
+            return this->pos_ != start;
+        }
+
+        std::optional<Node> repetition() {
+            std::optional<Node> atom = this->atom();
+            if (!atom || this->pos_ == this->in_.size()) return atom;
+
+            size_t min = 0;
+            size_t max = 0;
+            switch (this->in_[this->pos_]) {
+                case '*':
+                    max = UNBOUNDED;
+                    break;
+                case '+':
+                    min = 1;
+                    max = UNBOUNDED;
+                    break;
+                case '?':
+                    max = 1;
+                    break;
+                case '{':
+                    ++this->pos_;
+                    if (!this->number(min)) return std::nullopt;
+                    max = min;
+                    if (this->peek(',')) {
+                        ++this->pos_;
+                        max = this->peek('}') ? UNBOUNDED : 0;
+                        if (max != UNBOUNDED && (!this->number(max) || max < min)) return std::nullopt;
+                    }
+                    if (!this->peek('}')) return std::nullopt;
+                    break;
+                default:
+                    return atom;
+            }
+            ++this->pos_;
+
+            Node repeat;
+            repeat.kind = Node::REPEAT;
+            repeat.min = min;
+            repeat.max = max;
+            if (this->peek('?')) {
+                repeat.greedy = false;
+                ++this->pos_;
+            }
+            if (this->pos_ < this->in_.size() && std::string_view("*+?{").find(this->in_[this->pos_]) != std::string_view::npos) {
+                return std::nullopt;// a quantified quantifier is an error in ECMAScript
+            }
+            repeat.children.push_back(std::move(*atom));
+            return repeat;
+        }
+
+        std::optional<Node> atom() {
+            const char c = this->in_[this->pos_++];
+            switch (c) {
+                case '(': {
+                    Node group;
+                    group.kind = Node::GROUP;
+                    if (this->peek('?')) {
+                        if (this->pos_ + 1 >= this->in_.size() || this->in_[this->pos_ + 1] != ':') return std::nullopt;// lookaround
+                        this->pos_ += 2;
+                    } else {
+                        group.group = ++this->groups_;
+                    }
+                    std::optional<Node> body = this->alternation();
+                    if (!body || !this->peek(')')) return std::nullopt;
+                    ++this->pos_;
+                    group.children.push_back(std::move(*body));
+                    return group;
+                }
+                case '[':
+                    return this->characterClass();
+                case '.': {
+                    std::bitset<256> any;
+                    any.set();
+                    any.reset('\n');
+                    any.reset('\r');
+                    return this->set(any);
+                }
+                case '\\': {
+                    std::bitset<256> bits;
+                    if (!this->escape(bits, false)) return std::nullopt;
+                    return this->set(bits);
+                }
+                case '^':
+                case '$':
+                case '*':
+                case '+':
+                case '?':
+                case '{':
+                    return std::nullopt;
+                default: {
+                    std::bitset<256> bits;
+                    bits.set(static_cast<unsigned char>(c));
+                    return this->set(bits);
+                }
+            }
+        }
+
+        /// Reads the escape after a '\\' into @p bits; false for an escape the automaton does not support.
+        bool escape(std::bitset<256> &bits, bool in_class) {
+            if (this->pos_ == this->in_.size()) return false;
+            const char c = this->in_[this->pos_++];
+            switch (c) {
+                case 'd': bits |= digitSet(); return true;
+                case 'D': bits |= ~digitSet(); return true;
+                case 'w': bits |= wordSet(); return true;
+                case 'W': bits |= ~wordSet(); return true;
+                case 's': bits |= spaceSet(); return true;
+                case 'S': bits |= ~spaceSet(); return true;
+                case 't': bits.set('\t'); return true;
+                case 'n': bits.set('\n'); return true;
+                case 'r': bits.set('\r'); return true;
+                case 'f': bits.set('\f'); return true;
+                case 'v': bits.set('\v'); return true;
+                case '0': bits.set(0); return true;
+                case 'b':
+                    if (!in_class) return false;// word boundary
+                    bits.set('\b');
+                    return true;
+                case 'x':
+                case 'u': {
+                    const size_t digits = c == 'x' ? 2 : 4;
+                    if (this->pos_ + digits > this->in_.size()) return false;
+                    unsigned value = 0;
+                    for (size_t i = 0; i < digits; ++i) {
+                        std::optional<unsigned> digit = hexValue(this->in_[this->pos_++]);
+                        if (!digit) return false;
+                        value = value * 16 + *digit;
+                    }
+                    if (value > 0x7f) return false;// a code point std::regex<char> treats differently
+                    bits.set(value);
+                    return true;
+                }
+                default:
+                    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')) return false;
+                    bits.set(static_cast<unsigned char>(c));
+                    return true;
+            }
+        }
+
+        std::optional<Node> characterClass() {
+            std::bitset<256> bits;
+            const bool negated = this->peek('^');
+            if (negated) ++this->pos_;
+
+            while (!this->peek(']')) {
+                if (this->pos_ == this->in_.size()) return std::nullopt;
+
+                std::bitset<256> item;
+                unsigned first;
+                if (this->peek('\\')) {
+                    ++this->pos_;
+                    if (!this->escape(item, true)) return std::nullopt;
+                    if (item.count() != 1) {
+                        if (this->peek('-') && this->pos_ + 1 < this->in_.size() && this->in_[this->pos_ + 1] != ']') {
+                            return std::nullopt;// a class escape as a range end
+                        }
+                        bits |= item;
+                        continue;
+                    }
+                    first = 0;
+                    while (!item.test(first)) ++first;
+                } else {
+                    first = static_cast<unsigned char>(this->in_[this->pos_++]);
+                }
+
+                if (this->peek('-') && this->pos_ + 1 < this->in_.size() && this->in_[this->pos_ + 1] != ']') {
+                    ++this->pos_;
+                    unsigned last;
+                    if (this->peek('\\')) {
+                        ++this->pos_;
+                        std::bitset<256> end;
+                        if (!this->escape(end, true) || end.count() != 1) return std::nullopt;
+                        last = 0;
+                        while (!end.test(last)) ++last;
+                    } else {
+                        last = static_cast<unsigned char>(this->in_[this->pos_++]);
+                    }
+                    if (last < first) return std::nullopt;
+                    bits |= rangeSet(first, last);
+                } else {
+                    bits.set(first);
+                }
+            }
+            ++this->pos_;
+            return this->set(negated ? ~bits : bits);
+        }
+
+        RouteAutomaton &automaton_;
+        std::string_view in_;
+        size_t pos_{0};
+        size_t groups_{0};
+    };
+
+    uint32_t RouteAutomaton::addSet(const std::bitset<256> &set) {
+        auto [it, inserted] = this->set_index_.try_emplace(set, static_cast<uint32_t>(this->sets_.size()));
+        if (inserted) this->sets_.push_back(set);
+        return it->second;
+    }
+
+    uint32_t RouteAutomaton::emit(Inst inst) {
+        this->program_.push_back(inst);
+        return static_cast<uint32_t>(this->program_.size() - 1);
+    }
+
+    uint32_t RouteAutomaton::emit(const Node &node, uint32_t next) {
+        switch (node.kind) {
+            case Node::EMPTY:
+                return next;
+            case Node::SET:
+                return this->emit(Inst{Inst::BYTE, next, 0, node.set});
+            case Node::CONCAT:
+                for (auto it = node.children.rbegin(); it != node.children.rend(); ++it) next = this->emit(*it, next);
+                return next;
+            case Node::ALT: {
+                uint32_t entry = this->emit(node.children.back(), next);
+                for (size_t i = node.children.size() - 1; i-- > 0;) {
+                    const uint32_t branch = this->emit(node.children[i], next);
+                    entry = this->emit(Inst{Inst::SPLIT, branch, entry, 0});
+                }
+                return entry;
+            }
+            case Node::GROUP: {
+                if (node.group == 0) return this->emit(node.children.front(), next);
+                const auto slot = static_cast<uint32_t>(2 * (node.group - 1));
+                const uint32_t close = this->emit(Inst{Inst::SAVE, next, 0, slot + 1});
+                const uint32_t body = this->emit(node.children.front(), close);
+                return this->emit(Inst{Inst::SAVE, body, 0, slot});
+            }
+            case Node::REPEAT: {
+                const Node &child = node.children.front();
+                uint32_t tail = next;
+                if (node.max == UNBOUNDED) {
+                    const uint32_t loop = this->emit(Inst{Inst::SPLIT});
+                    const uint32_t body = this->emit(child, loop);
+                    this->program_[loop].out = node.greedy ? body : next;
+                    this->program_[loop].out1 = node.greedy ? next : body;
+                    tail = loop;
+                } else {
+                    for (size_t i = node.min; i < node.max; ++i) {
+                        const uint32_t body = this->emit(child, tail);
+                        tail = node.greedy ? this->emit(Inst{Inst::SPLIT, body, tail, 0})
+                                           : this->emit(Inst{Inst::SPLIT, tail, body, 0});
+                    }
+                }
+                for (size_t i = 0; i < node.min; ++i) tail = this->emit(child, tail);
+                return tail;
+            }
+        }
+        return next;
+    }
+
+    bool RouteAutomaton::add(std::string_view pattern, uint32_t id) {
+        Parser parser(*this, pattern);
+        std::optional<Node> node = parser.parse();
+        if (!node) return false;
+
+        const size_t program_size = this->program_.size();
+        const uint32_t match = this->emit(Inst{Inst::MATCH, 0, 0, id});
+        const uint32_t start = this->emit(*node, match);
+        if (this->program_.size() - program_size > (1u << 20)) {
+            this->program_.resize(program_size);
+            return false;
+        }
+
+        this->patterns_.push_back({id, start, parser.groups()});
+        this->dfa_.clear();
+        this->accepts_.clear();
+        return true;
+    }
+
+    const RouteAutomaton::Pattern *RouteAutomaton::find(uint32_t id) const {
+        auto it = std::lower_bound(this->patterns_.begin(), this->patterns_.end(), id,
+                                   [](const Pattern &pattern, uint32_t value) { return pattern.id < value; });
+        return it != this->patterns_.end() && it->id == id ? &*it : nullptr;
+    }
+
+    size_t RouteAutomaton::groups(uint32_t id) const {
+        const Pattern *pattern = this->find(id);
+        return pattern ? pattern->groups : 0;
+    }
+
+    void RouteAutomaton::closure(uint32_t pc, std::vector<uint32_t> &states, std::vector<uint32_t> &marks, uint32_t mark) const {
+        std::vector<uint32_t> &stack = scratch().stack;
+        const size_t bottom = stack.size();
+        stack.push_back(pc);
+        while (stack.size() > bottom) {
+            const uint32_t at = stack.back();
+            stack.pop_back();
+            if (marks[at] == mark) continue;
+            marks[at] = mark;
+
+            const Inst &inst = this->program_[at];
+            switch (inst.op) {
+                case Inst::SPLIT:
+                    stack.push_back(inst.out1);
+                    stack.push_back(inst.out);
+                    break;
+                case Inst::SAVE:
+                    stack.push_back(inst.out);
+                    break;
+                case Inst::BYTE:
+                case Inst::MATCH:
+                    states.push_back(at);
+                    break;
+            }
+        }
+    }
+
+    void RouteAutomaton::compile() {
+        this->dfa_.clear();
+        this->accepts_.clear();
+        if (this->patterns_.empty()) return;
+
+        // Bytes belonging to the same sets behave the same, the DFA only needs one column for them.
+        std::map<std::vector<bool>, uint8_t> signatures;
+        std::vector<unsigned char> representatives;
+        this->classes_.assign(256, 0);
+        for (unsigned b = 0; b < 256; ++b) {
+            std::vector<bool> signature(this->sets_.size());
+            for (size_t i = 0; i < this->sets_.size(); ++i) signature[i] = this->sets_[i].test(b);
+            auto [it, inserted] = signatures.try_emplace(std::move(signature), static_cast<uint8_t>(representatives.size()));
+            if (inserted) representatives.push_back(static_cast<unsigned char>(b));
+            this->classes_[b] = it->second;
+        }
+        this->class_count_ = representatives.size();
+
+        std::vector<uint32_t> marks(this->program_.size(), 0);
+        uint32_t mark = 0;
+        std::map<std::vector<uint32_t>, int32_t> ids;
+        std::vector<std::vector<uint32_t>> states;
+
+        auto intern = [&](std::vector<uint32_t> &&set) -> int32_t {
+            if (set.empty()) return -1;
+            std::sort(set.begin(), set.end());
+            auto it = ids.find(set);
+            if (it != ids.end()) return it->second;
+            if (states.size() == MAX_DFA_STATES) return -2;
+
+            const auto id = static_cast<int32_t>(states.size());
+            std::vector<uint32_t> accepts;
+            for (uint32_t pc: set) {
+                if (this->program_[pc].op == Inst::MATCH) accepts.push_back(this->program_[pc].arg);
+            }
+            std::sort(accepts.begin(), accepts.end());
+            this->accepts_.push_back(std::move(accepts));
+            ids.emplace(set, id);
+            states.push_back(std::move(set));
+            return id;
+        };
+
+        std::vector<uint32_t> start;
+        ++mark;
+        for (const Pattern &pattern: this->patterns_) this->closure(pattern.start, start, marks, mark);
+        intern(std::move(start));
+
+        std::vector<int32_t> table;
+        for (size_t state = 0; state < states.size(); ++state) {
+            for (size_t cls = 0; cls < this->class_count_; ++cls) {
+                const unsigned char byte = representatives[cls];
+                std::vector<uint32_t> next;
+                ++mark;
+                for (uint32_t pc: states[state]) {
+                    const Inst &inst = this->program_[pc];
+                    if (inst.op == Inst::BYTE && this->sets_[inst.arg].test(byte)) this->closure(inst.out, next, marks, mark);
+                }
+                const int32_t target = intern(std::move(next));
+                if (target == -2) {
+                    this->accepts_.clear();// too many states, simulate the NFA instead
+                    return;
+                }
+                table.push_back(target);
+            }
+        }
+        this->dfa_ = std::move(table);
+    }
+
+    std::span<const uint32_t> RouteAutomaton::matches(std::string_view input) const {
+        if (this->patterns_.empty()) return {};
+        if (this->dfa_.empty()) return this->simulate(input);
+
+        int32_t state = 0;
+        for (char c: input) {
+            state = this->dfa_[state * this->class_count_ + this->classes_[static_cast<unsigned char>(c)]];
+            if (state < 0) return {};
+        }
+        return this->accepts_[state];
+    }
+
+    std::span<const uint32_t> RouteAutomaton::simulate(std::string_view input) const {
+        Scratch &buffers = scratch();
+        std::vector<uint32_t> &current = buffers.states;
+        std::vector<uint32_t> &next = buffers.next;
+
+        current.clear();
+        uint32_t mark = buffers.nextMark(this->program_.size());
+        for (const Pattern &pattern: this->patterns_) this->closure(pattern.start, current, buffers.marks, mark);
+
+        for (char c: input) {
+            next.clear();
+            mark = buffers.nextMark(this->program_.size());
+            for (uint32_t pc: current) {
+                const Inst &inst = this->program_[pc];
+                if (inst.op == Inst::BYTE && this->sets_[inst.arg].test(static_cast<unsigned char>(c))) {
+                    this->closure(inst.out, next, buffers.marks, mark);
+                }
+            }
+            current.swap(next);
+            if (current.empty()) return {};
+        }
+
+        std::vector<uint32_t> &ids = buffers.ids;
+        ids.clear();
+        for (uint32_t pc: current) {
+            if (this->program_[pc].op == Inst::MATCH) ids.push_back(this->program_[pc].arg);
+        }
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    }
+
+    bool RouteAutomaton::captures(uint32_t id, std::string_view input, std::span<const size_t> &offsets) const {
+        const Pattern *pattern = this->find(id);
+        if (!pattern) return false;
+
+        // Pike VM: threads advance together in priority order, the first to reach MATCH at the end wins.
+        struct Vm {
+            const RouteAutomaton &automaton;
+            Scratch &buffers;
+            size_t slots;
+
+            void add(std::vector<uint32_t> &threads, std::vector<size_t> &caps, uint32_t pc, size_t pos, uint32_t mark) {
+                if (this->buffers.marks[pc] == mark) return;
+                this->buffers.marks[pc] = mark;
+
+                const Inst &inst = this->automaton.program_[pc];
+                switch (inst.op) {
+                    case Inst::SPLIT:
+                        this->add(threads, caps, inst.out, pos, mark);
+                        this->add(threads, caps, inst.out1, pos, mark);
+                        break;
+                    case Inst::SAVE: {
+                        const size_t previous = this->buffers.work[inst.arg];
+                        this->buffers.work[inst.arg] = pos;
+                        this->add(threads, caps, inst.out, pos, mark);
+                        this->buffers.work[inst.arg] = previous;
+                        break;
+                    }
+                    case Inst::BYTE:
+                    case Inst::MATCH:
+                        threads.push_back(pc);
+                        caps.insert(caps.end(), this->buffers.work.begin(), this->buffers.work.end());
+                        break;
+                }
+            }
+        };
+
+        Scratch &buffers = scratch();
+        Vm vm{*this, buffers, 2 * pattern->groups};
+        std::vector<uint32_t> &current = buffers.states;
+        std::vector<uint32_t> &next = buffers.next;
+
+        current.clear();
+        buffers.caps.clear();
+        buffers.work.assign(vm.slots, NO_OFFSET);
+        vm.add(current, buffers.caps, pattern->start, 0, buffers.nextMark(this->program_.size()));
+
+        for (size_t pos = 0; pos < input.size() && !current.empty(); ++pos) {
+            next.clear();
+            buffers.next_caps.clear();
+            const uint32_t mark = buffers.nextMark(this->program_.size());
+            const auto byte = static_cast<unsigned char>(input[pos]);
+            for (size_t i = 0; i < current.size(); ++i) {
+                const Inst &inst = this->program_[current[i]];
+                if (inst.op != Inst::BYTE || !this->sets_[inst.arg].test(byte)) continue;
+                std::copy_n(buffers.caps.begin() + i * vm.slots, vm.slots, buffers.work.begin());
+                vm.add(next, buffers.next_caps, inst.out, pos + 1, mark);
+            }
+            current.swap(next);
+            buffers.caps.swap(buffers.next_caps);
+        }
+
+        for (size_t i = 0; i < current.size(); ++i) {
+            if (this->program_[current[i]].op != Inst::MATCH) continue;
+            buffers.result.assign(buffers.caps.begin() + i * vm.slots, buffers.caps.begin() + (i + 1) * vm.slots);
+            offsets = buffers.result;
+            return true;
+        }
+        return false;
+    }
+
+}// namespace usub::server::protocols::http
@@ -2,19 +2,35 @@
 
 namespace usub::server::protocols::http {
 
+    namespace {
+        MethodSet internMethods(const std::set<std::string> &tokens) {
+            MethodSet set;
+            for (const std::string &method: tokens) {
+                if (method == "*") return MethodSet::all();
+                set.add(methods::intern(method));
+            }
+            return set;
+        }
+    }// namespace
+
     Route::Route(const std::set<std::string> &methods,
                  const std::regex regex,
                  const std::vector<std::string> &params,
                  std::function<FunctionType> handler,
                  bool accept_all)
-        : param_names(params)
+        : Route(internMethods(methods), regex, params, std::move(handler), accept_all || methods.contains("*")) {}
+
+    Route::Route(MethodSet methods,
+                 const std::regex regex,
+                 const std::vector<std::string> &params,
+                 std::function<FunctionType> handler,
+                 bool accept_all)
+        : accept_all_methods(accept_all)
+        , allowed_methods(accept_all ? MethodSet::all() : methods)
+        , param_names(params)
         , handler(handler)
         {
             pathRegex = std::regex(regex);
-            if (accept_all) {
-                this->accept_all_methods = accept_all;
-            }
-            this->allowed_method_tokenns = std::move(methods);
         }
 
     Route &Route::addMiddleware(MiddlewarePhase phase, std::function<MiddlewareFunctionType> middleware) {
@@ -22,4 +38,9 @@ namespace usub::server::protocols::http {
         return *this;
     }
 
+    Route &Route::acceptEarlyData(bool accept) {
+        this->accept_early_data = accept;
+        return *this;
+    }
+
 }
@@ -50,8 +50,8 @@ bool responseMiddle(const usub::server::protocols::http::Request &request, usub:
 
 void handlerFunction(usub::server::protocols::http::Request &request, usub::server::protocols::http::Response &response) {
     std::string res = "Endpoint DATA: " + request.getBody() + "\nWith uri params numeric: " +
-                      request.uri_params["numeric"] + "\nAnd word: " + request.uri_params["word"] +
-                      "\nAnd anything: " + request.uri_params["anything"] + "\nURI is: " + request.getFullURL() + "\n";
+                      std::string(request.uri_params["numeric"]) + "\nAnd word: " + std::string(request.uri_params["word"]) +
+                      "\nAnd anything: " + std::string(request.uri_params["anything"]) + "\nURI is: " + request.getFullURL() + "\n";
     response.setStatus(200).setMessage("OK").addHeader("Content-Type", "text/html").setBody("Hello World! How are you");
     // std::cout << res << std::endl;
     return;
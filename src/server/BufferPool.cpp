@@ -0,0 +1,75 @@
+#include "server/BufferPool.h"
+
+#include <algorithm>
+#include <utility>
+
+usub::server::net::BufferLease::BufferLease(BufferLease &&other) noexcept
+    : pool_(std::exchange(other.pool_, nullptr)),
+      size_class_(other.size_class_),
+      capacity_(std::exchange(other.capacity_, 0)),
+      buffer_(std::move(other.buffer_)) {}
+
+usub::server::net::BufferLease &usub::server::net::BufferLease::operator=(BufferLease &&other) noexcept {
+    if (this != &other) {
+        this->reset();
+        this->pool_ = std::exchange(other.pool_, nullptr);
+        this->size_class_ = other.size_class_;
+        this->capacity_ = std::exchange(other.capacity_, 0);
+        this->buffer_ = std::move(other.buffer_);
+    }
+    return *this;
+}
+
+usub::server::net::BufferLease::~BufferLease() {
+    this->reset();
+}
+
+void usub::server::net::BufferLease::reset() {
+    if (this->pool_ && this->buffer_) {
+        this->pool_->release(this->size_class_, std::move(this->buffer_));
+    }
+    this->buffer_.reset();
+    this->pool_ = nullptr;
+    this->capacity_ = 0;
+}
+
+usub::server::net::BufferLease usub::server::net::BufferPool::acquire(size_t size) {
+    const auto it = std::lower_bound(SIZE_CLASSES.begin(), SIZE_CLASSES.end(), size);
+    const size_t size_class = it == SIZE_CLASSES.end() ? SIZE_CLASSES.size() - 1 : static_cast<size_t>(it - SIZE_CLASSES.begin());
+    const size_t capacity = SIZE_CLASSES[size_class];
+
+    auto &free = this->free_[size_class];
+    std::unique_ptr<usub::uvent::utils::DynamicBuffer> buffer;
+    if (!free.empty()) [[likely]] {
+        buffer = std::move(free.back());
+        free.pop_back();
+    } else {
+        buffer = std::make_unique<usub::uvent::utils::DynamicBuffer>();
+        buffer->reserve(capacity);
+    }
+    buffer->clear();
+    return BufferLease{this, size_class, std::move(buffer), capacity};
+}
+
+void usub::server::net::BufferPool::release(size_t size_class, std::unique_ptr<usub::uvent::utils::DynamicBuffer> buffer) {
+    auto &free = this->free_[size_class];
+    if (free.size() * SIZE_CLASSES[size_class] < MAX_CACHED_BYTES) {
+        free.push_back(std::move(buffer));
+    }
+}
+
+usub::server::net::BufferPool &usub::server::net::BufferPool::local() {
+    // never destroyed: a lease held by a coroutine frame may be returned after the thread's storage is gone
+    thread_local BufferPool *pool = new BufferPool();
+    return *pool;
+}
+
+void usub::server::net::ReadSizer::observe(size_t requested, size_t received) {
+    constexpr size_t smallest = BufferPool::SIZE_CLASSES.front();
+    constexpr size_t largest = BufferPool::SIZE_CLASSES.back();
+    if (received >= requested) {
+        this->expected_ = std::min(requested * 2, largest);
+    } else {
+        this->expected_ = std::clamp(std::max(received, this->expected_ - this->expected_ / 4), smallest, largest);
+    }
+}
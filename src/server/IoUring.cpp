@@ -0,0 +1,535 @@
+#include "server/IoUring.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace {
+    int ioUringSetup(unsigned entries, io_uring_params *params) {
+        return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    int ioUringEnter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+        return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+    }
+
+    int ioUringRegister(int fd, unsigned opcode, const void *arg, unsigned nr_args) {
+        return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+    }
+
+    void *mapRing(int fd, size_t size, off_t offset) {
+        void *ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+        if (ptr == MAP_FAILED) throw std::system_error(errno, std::generic_category(), "io_uring mmap");
+        return ptr;
+    }
+
+    template<class T>
+    T *at(void *base, uint32_t offset) {
+        return reinterpret_cast<T *>(static_cast<char *>(base) + offset);
+    }
+
+    /// Drops @p n sent bytes from the front of iov[idx..], returns the new first unsent index.
+    size_t advance(std::vector<iovec> &iov, size_t idx, size_t n) {
+        while (n > 0 && idx < iov.size()) {
+            if (n >= iov[idx].iov_len) {
+                n -= iov[idx].iov_len;
+                ++idx;
+            } else {
+                iov[idx].iov_base = static_cast<char *>(iov[idx].iov_base) + n;
+                iov[idx].iov_len -= n;
+                n = 0;
+            }
+        }
+        return idx;
+    }
+
+    /// Pipe capacity asked for splice-based file sends, the kernel may grant less.
+    constexpr int SPLICE_PIPE_SIZE = 256 * 1024;
+}// namespace
+
+usub::server::net::IoUring::IoUring(unsigned entries) {
+    io_uring_params params{};
+    params.flags = IORING_SETUP_CLAMP;
+    this->fd_ = ioUringSetup(entries, &params);
+    if (this->fd_ < 0) throw std::system_error(errno, std::generic_category(), "io_uring_setup");
+
+    try {
+        this->sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        this->cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            this->sq_size_ = this->cq_size_ = std::max(this->sq_size_, this->cq_size_);
+        }
+        this->sq_ptr_ = mapRing(this->fd_, this->sq_size_, IORING_OFF_SQ_RING);
+        this->cq_ptr_ = (params.features & IORING_FEAT_SINGLE_MMAP) ? this->sq_ptr_ : mapRing(this->fd_, this->cq_size_, IORING_OFF_CQ_RING);
+        this->sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        this->sqes_ = static_cast<io_uring_sqe *>(mapRing(this->fd_, this->sqes_size_, IORING_OFF_SQES));
+    } catch (...) {
+        this->unmap();
+        throw;
+    }
+
+    this->sq_head_ = at<unsigned>(this->sq_ptr_, params.sq_off.head);
+    this->sq_tail_ = at<unsigned>(this->sq_ptr_, params.sq_off.tail);
+    this->sq_mask_ = at<unsigned>(this->sq_ptr_, params.sq_off.ring_mask);
+    this->sq_array_ = at<unsigned>(this->sq_ptr_, params.sq_off.array);
+    this->sq_entries_ = params.sq_entries;
+    this->sqe_tail_ = *this->sq_tail_;
+
+    this->cq_head_ = at<unsigned>(this->cq_ptr_, params.cq_off.head);
+    this->cq_tail_ = at<unsigned>(this->cq_ptr_, params.cq_off.tail);
+    this->cq_mask_ = at<unsigned>(this->cq_ptr_, params.cq_off.ring_mask);
+    this->cqes_ = at<io_uring_cqe>(this->cq_ptr_, params.cq_off.cqes);
+}
+
+usub::server::net::IoUring::~IoUring() {
+    this->unmap();
+}
+
+void usub::server::net::IoUring::unmap() {
+    if (this->sqes_) ::munmap(this->sqes_, this->sqes_size_);
+    if (this->cq_ptr_ && this->cq_ptr_ != this->sq_ptr_) ::munmap(this->cq_ptr_, this->cq_size_);
+    if (this->sq_ptr_) ::munmap(this->sq_ptr_, this->sq_size_);
+    if (this->fd_ >= 0) ::close(this->fd_);
+    this->sqes_ = nullptr;
+    this->cq_ptr_ = this->sq_ptr_ = nullptr;
+    this->fd_ = -1;
+}
+
+io_uring_sqe *usub::server::net::IoUring::sqe() {
+    io_uring_sqe *sqe = nullptr;
+    return this->sqes(&sqe, 1) ? sqe : nullptr;
+}
+
+bool usub::server::net::IoUring::sqes(io_uring_sqe **out, unsigned count) {
+    const auto room = [this] {
+        return this->sq_entries_ - (this->sqe_tail_ - __atomic_load_n(this->sq_head_, __ATOMIC_ACQUIRE));
+    };
+    if (room() < count) {
+        // every SQE queued so far is filled, so they can go out before the new ones are handed over
+        this->submit();
+        if (room() < count) [[unlikely]] return false;
+    }
+    for (unsigned i = 0; i < count; ++i) {
+        const unsigned index = this->sqe_tail_ & *this->sq_mask_;
+        out[i] = &this->sqes_[index];
+        std::memset(out[i], 0, sizeof(*out[i]));
+        this->sq_array_[index] = index;
+        ++this->sqe_tail_;
+    }
+    return true;
+}
+
+int usub::server::net::IoUring::submit() {
+    const unsigned to_submit = this->sqe_tail_ - *this->sq_tail_;
+    if (to_submit == 0) return 0;
+    __atomic_store_n(this->sq_tail_, this->sqe_tail_, __ATOMIC_RELEASE);
+    for (;;) {
+        const int ret = ioUringEnter(this->fd_, to_submit, 0, 0);
+        if (ret >= 0) return ret;
+        if (errno == EINTR) continue;
+        return -errno;
+    }
+}
+
+void usub::server::net::IoUring::registerEventFd(int event_fd) {
+    if (ioUringRegister(this->fd_, IORING_REGISTER_EVENTFD, &event_fd, 1) < 0) {
+        throw std::system_error(errno, std::generic_category(), "IORING_REGISTER_EVENTFD");
+    }
+}
+
+usub::server::net::ProvidedBuffers::ProvidedBuffers(IoUring &ring, uint16_t group, uint16_t count, uint32_t buffer_size)
+    : ring_(ring), group_(group), count_(count), buffer_size_(buffer_size) {
+    this->ring_size_ = size_t{count} * sizeof(io_uring_buf);
+    void *ring_mem = ::mmap(nullptr, this->ring_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring_mem == MAP_FAILED) throw std::system_error(errno, std::generic_category(), "mmap provided buffer ring");
+    this->buf_ring_ = static_cast<io_uring_buf_ring *>(ring_mem);
+
+    void *memory = ::mmap(nullptr, size_t{count} * buffer_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        const int err = errno;
+        ::munmap(ring_mem, this->ring_size_);
+        throw std::system_error(err, std::generic_category(), "mmap provided buffers");
+    }
+    this->memory_ = static_cast<char *>(memory);
+
+    io_uring_buf_reg reg{};
+    reg.ring_addr = reinterpret_cast<uint64_t>(ring_mem);
+    reg.ring_entries = count;
+    reg.bgid = group;
+    if (ioUringRegister(ring.fd(), IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        const int err = errno;
+        ::munmap(this->memory_, size_t{count} * buffer_size);
+        ::munmap(ring_mem, this->ring_size_);
+        throw std::system_error(err, std::generic_category(), "IORING_REGISTER_PBUF_RING");
+    }
+
+    for (uint16_t bid = 0; bid < count; ++bid) {
+        this->recycle(bid);
+    }
+}
+
+usub::server::net::ProvidedBuffers::~ProvidedBuffers() {
+    io_uring_buf_reg reg{};
+    reg.bgid = this->group_;
+    ioUringRegister(this->ring_.fd(), IORING_UNREGISTER_PBUF_RING, &reg, 1);
+    ::munmap(this->memory_, size_t{this->count_} * this->buffer_size_);
+    ::munmap(this->buf_ring_, this->ring_size_);
+}
+
+void usub::server::net::ProvidedBuffers::recycle(uint16_t bid) {
+    // entries are indexed by hand: C++ places io_uring_buf_ring::bufs behind the empty member of
+    // __DECLARE_FLEX_ARRAY on some kernel headers, 8 bytes off the layout the kernel reads
+    io_uring_buf &buf = reinterpret_cast<io_uring_buf *>(this->buf_ring_)[this->tail_ & (this->count_ - 1)];
+    buf.addr = reinterpret_cast<uint64_t>(this->data(bid));
+    buf.len = this->buffer_size_;
+    buf.bid = bid;
+    ++this->tail_;
+    __atomic_store_n(&this->buf_ring_->tail, this->tail_, __ATOMIC_RELEASE);
+}
+
+void usub::server::net::prepMultishotAccept(io_uring_sqe *sqe, int listen_fd, uint64_t user_data) {
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = listen_fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe->user_data = user_data;
+}
+
+void usub::server::net::prepRecvMultishot(io_uring_sqe *sqe, int fd, uint16_t buffer_group, uint64_t user_data) {
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = buffer_group;
+    sqe->user_data = user_data;
+}
+
+void usub::server::net::prepSendmsg(io_uring_sqe *sqe, int fd, const msghdr *msg, uint64_t user_data) {
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(msg);
+    sqe->len = 1;
+    // without MSG_WAITALL a short send completes successfully and would let linked splices overtake it
+    sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+    sqe->user_data = user_data;
+}
+
+void usub::server::net::prepSplice(io_uring_sqe *sqe, int fd_in, int64_t off_in, int fd_out, uint32_t len, uint64_t user_data) {
+    sqe->opcode = IORING_OP_SPLICE;
+    sqe->fd = fd_out;
+    sqe->off = static_cast<uint64_t>(-1);
+    sqe->splice_fd_in = fd_in;
+    sqe->splice_off_in = static_cast<uint64_t>(off_in);
+    sqe->len = len;
+    sqe->user_data = user_data;
+}
+
+void usub::server::net::prepCancelFd(io_uring_sqe *sqe, int fd, uint64_t user_data) {
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = fd;
+    sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+    sqe->user_data = user_data;
+}
+
+usub::server::net::IoUringLoop::IoUringLoop(unsigned entries, uint16_t buffer_count, uint32_t buffer_size)
+    : ring_(entries), buffers_(ring_, 0, buffer_count, buffer_size) {
+    this->event_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (this->event_fd_ < 0) throw std::system_error(errno, std::generic_category(), "eventfd");
+    this->ring_.registerEventFd(this->event_fd_);
+}
+
+usub::server::net::IoUringLoop::~IoUringLoop() {
+    // the eventfd is owned by the uvent socket the driver waits on
+}
+
+void usub::server::net::IoUringLoop::startAccept(int listen_fd) {
+    this->listen_fd_ = listen_fd;
+    this->armAccept();
+    this->flush();
+}
+
+const std::vector<int> &usub::server::net::IoUringLoop::dispatch() {
+    this->accepted_.clear();
+    this->dispatching_ = true;
+    this->ring_.forEachCompletion([this](const io_uring_cqe &cqe) { this->handle(cqe); });
+
+    // resumed connections queue their sends, they all go out with the submit below
+    for (size_t i = 0; i < this->runnable_.size(); ++i) {
+        this->runnable_[i].resume();
+    }
+    this->runnable_.clear();
+    this->dispatching_ = false;
+    this->ring_.submit();
+    if ((!this->accept_armed_ && this->listen_fd_ >= 0) || !this->unarmed_.empty() || !this->uncancelled_.empty()) {
+        // the ring was full when these had to be queued, the submit above made room
+        if (!this->accept_armed_ && this->listen_fd_ >= 0) this->armAccept();
+        for (UringConnection *conn: std::exchange(this->unarmed_, {})) {
+            this->armRecv(*conn);
+        }
+        for (UringConnection *conn: std::exchange(this->uncancelled_, {})) {
+            this->cancelRecv(*conn);
+        }
+        this->ring_.submit();
+    }
+    return this->accepted_;
+}
+
+usub::server::net::UringConnection &usub::server::net::IoUringLoop::open(int fd) {
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    auto *conn = new UringConnection();
+    conn->fd = fd;
+    this->armRecv(*conn);
+    this->flush();
+    return *conn;
+}
+
+void usub::server::net::IoUringLoop::finish(UringConnection &conn) {
+    conn.finished = true;
+    conn.waiter = {};
+    for (auto [bid, len]: conn.received) {
+        this->recycle(bid);
+    }
+    conn.received.clear();
+    std::erase(this->starved_, &conn);
+    std::erase(this->unarmed_, &conn);
+    if (conn.recv_armed) {
+        this->cancelRecv(conn);
+        this->flush();
+    }
+    this->release(conn);
+}
+
+void usub::server::net::IoUringLoop::recycle(uint16_t bid) {
+    this->buffers_.recycle(bid);
+    if (!this->starved_.empty()) {
+        // receives stopped for lack of buffers restart now that one is free again
+        auto starved = std::move(this->starved_);
+        this->starved_.clear();
+        for (UringConnection *conn: starved) {
+            this->armRecv(*conn);
+        }
+        this->flush();
+    }
+}
+
+usub::uvent::task::Awaitable<bool> usub::server::net::IoUringLoop::sendAll(UringConnection &conn, std::vector<iovec> &segments) {
+    size_t idx = 0;
+    while (idx < segments.size()) {
+        io_uring_sqe *sqe = nullptr;
+        if (!this->opSqes(conn, &sqe, 1)) co_return false;
+        conn.msg = {};
+        conn.msg.msg_iov = segments.data() + idx;
+        conn.msg.msg_iovlen = std::min<size_t>(segments.size() - idx, IOV_MAX);
+        prepSendmsg(sqe, conn.fd, &conn.msg, reinterpret_cast<uint64_t>(&conn) | OP);
+        conn.ops_left = 1;
+        this->flush();
+        co_await OpAwaiter{conn};
+
+        const int sent = conn.results[0];
+        if (sent <= 0) co_return false;
+        idx = advance(segments, idx, static_cast<size_t>(sent));
+    }
+    segments.clear();
+    co_return true;
+}
+
+usub::uvent::task::Awaitable<bool> usub::server::net::IoUringLoop::sendFile(UringConnection &conn, std::vector<iovec> &segments, protocols::http::FileRange range) {
+    if (range.size > 0 && !this->ensurePipe(conn)) co_return false;
+    size_t idx = 0;
+
+    while (idx < segments.size() || range.size > 0 || conn.in_pipe > 0) {
+        const bool send_head = idx < segments.size();
+        // the file may only be linked behind a head that sends every remaining segment
+        const bool head_only = send_head && segments.size() - idx > IOV_MAX;
+        // bytes left in the pipe by a short splice go out before the pipe is refilled
+        const bool drain_only = !head_only && conn.in_pipe > 0;
+        const bool fill = !head_only && !drain_only && range.size > 0;
+        const unsigned count = (send_head ? 1 : 0) + (drain_only ? 1 : 0) + (fill ? 2 : 0);
+
+        // the chain is reserved as a whole and filled before anything can submit it
+        io_uring_sqe *sqes[3]{};
+        if (!this->opSqes(conn, sqes, count)) co_return false;
+        const uint64_t base = reinterpret_cast<uint64_t>(&conn);
+        unsigned slot = 0;
+        int head_slot = -1, fill_slot = -1, drain_slot = -1;
+        if (send_head) {
+            conn.msg = {};
+            conn.msg.msg_iov = segments.data() + idx;
+            conn.msg.msg_iovlen = std::min<size_t>(segments.size() - idx, IOV_MAX);
+            prepSendmsg(sqes[slot], conn.fd, &conn.msg, base | (OP + slot));
+            head_slot = static_cast<int>(slot++);
+        }
+        if (drain_only) {
+            prepSplice(sqes[slot], conn.pipe_r, -1, conn.fd, static_cast<uint32_t>(conn.in_pipe), base | (OP + slot));
+            drain_slot = static_cast<int>(slot++);
+        } else if (fill) {
+            const auto chunk = static_cast<uint32_t>(std::min(range.size, conn.pipe_size));
+            prepSplice(sqes[slot], range.fd, range.offset, conn.pipe_w, chunk, base | (OP + slot));
+            fill_slot = static_cast<int>(slot++);
+            prepSplice(sqes[slot], conn.pipe_r, -1, conn.fd, chunk, base | (OP + slot));
+            drain_slot = static_cast<int>(slot++);
+        }
+        for (unsigned i = 0; i + 1 < count; ++i) {
+            sqes[i]->flags |= IOSQE_IO_LINK;
+        }
+        conn.ops_left = count;
+        this->flush();
+        co_await OpAwaiter{conn};
+
+        // a short result breaks the chain, the following links complete with -ECANCELED and are redone
+        if (head_slot >= 0) {
+            const int sent = conn.results[head_slot];
+            if (sent <= 0) co_return false;
+            idx = advance(segments, idx, static_cast<size_t>(sent));
+        }
+        if (fill_slot >= 0) {
+            const int filled = conn.results[fill_slot];
+            if (filled == -ECANCELED) continue;
+            if (filled <= 0) co_return false;// file is shorter than announced
+            range.offset += filled;
+            range.size -= static_cast<size_t>(filled);
+            conn.in_pipe += static_cast<size_t>(filled);
+        }
+        if (drain_slot >= 0) {
+            const int drained = conn.results[drain_slot];
+            if (drained > 0) {
+                conn.in_pipe -= static_cast<size_t>(drained);
+            } else if (drained != -ECANCELED) {
+                co_return false;
+            }
+        }
+    }
+    segments.clear();
+    co_return true;
+}
+
+void usub::server::net::IoUringLoop::handle(const io_uring_cqe &cqe) {
+    const uint64_t tag = cqe.user_data & TAG_MASK;
+    // every SQE of the loop carries a tag, an untagged completion belongs to no connection
+    if (tag == 0) return;
+    if (tag == ACCEPT) {
+        if (cqe.res >= 0) this->accepted_.push_back(cqe.res);
+        if (!(cqe.flags & IORING_CQE_F_MORE)) {
+            // the kernel ended the multishot accept (e.g. EMFILE), start it again
+            this->accept_armed_ = false;
+            this->armAccept();
+        }
+        return;
+    }
+
+    auto *conn = reinterpret_cast<UringConnection *>(cqe.user_data & ~TAG_MASK);
+    if (tag == RECV) {
+        if (cqe.flags & IORING_CQE_F_BUFFER) {
+            const auto bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            if (cqe.res > 0 && !conn->finished) {
+                conn->received.emplace_back(bid, static_cast<uint32_t>(cqe.res));
+            } else {
+                this->buffers_.recycle(bid);
+            }
+        }
+        if (cqe.res == 0 || (cqe.res < 0 && cqe.res != -ENOBUFS)) {
+            conn->eof = true;
+        }
+        if (!(cqe.flags & IORING_CQE_F_MORE)) {
+            conn->recv_armed = false;
+            --conn->inflight;
+            if (!conn->finished && !conn->eof) {
+                if (cqe.res == -ENOBUFS) {
+                    this->starved_.push_back(conn);
+                } else {
+                    this->armRecv(*conn);
+                }
+            }
+        }
+        if (!conn->waiting_op) this->wake(*conn);
+    } else if (tag >= OP && tag < CANCEL) {
+        conn->results[tag - OP] = cqe.res;
+        --conn->inflight;
+        if (--conn->ops_left == 0 && conn->waiting_op) this->wake(*conn);
+    } else {
+        --conn->inflight;
+    }
+    this->release(*conn);
+}
+
+void usub::server::net::IoUringLoop::armAccept() {
+    io_uring_sqe *sqe = this->ring_.sqe();
+    if (!sqe) return;
+    prepMultishotAccept(sqe, this->listen_fd_, ACCEPT);
+    this->accept_armed_ = true;
+}
+
+void usub::server::net::IoUringLoop::armRecv(UringConnection &conn) {
+    io_uring_sqe *sqe = this->ring_.sqe();
+    if (!sqe) {
+        // the connection keeps waiting, dispatch() arms it once the ring has room
+        this->unarmed_.push_back(&conn);
+        return;
+    }
+    prepRecvMultishot(sqe, conn.fd, this->buffers_.group(), reinterpret_cast<uint64_t>(&conn) | RECV);
+    conn.recv_armed = true;
+    ++conn.inflight;
+}
+
+void usub::server::net::IoUringLoop::cancelRecv(UringConnection &conn) {
+    // the receive may have ended on its own while the cancel waited for room
+    if (!conn.recv_armed) return;
+    io_uring_sqe *sqe = this->ring_.sqe();
+    if (!sqe) {
+        this->uncancelled_.push_back(&conn);
+        return;
+    }
+    prepCancelFd(sqe, conn.fd, reinterpret_cast<uint64_t>(&conn) | CANCEL);
+    ++conn.inflight;
+}
+
+void usub::server::net::IoUringLoop::wake(UringConnection &conn) {
+    if (!conn.waiter) return;
+    const bool ready = conn.waiting_op ? conn.ops_left == 0 : (!conn.received.empty() || conn.eof);
+    if (ready) this->runnable_.push_back(std::exchange(conn.waiter, {}));
+}
+
+void usub::server::net::IoUringLoop::release(UringConnection &conn) {
+    if (!conn.finished || conn.inflight > 0) return;
+    std::erase(this->uncancelled_, &conn);
+    ::close(conn.fd);
+    if (conn.pipe_r >= 0) ::close(conn.pipe_r);
+    if (conn.pipe_w >= 0) ::close(conn.pipe_w);
+    delete &conn;
+}
+
+void usub::server::net::IoUringLoop::flush() {
+    // inside dispatch() everything is submitted at once when the pass ends
+    if (!this->dispatching_) this->ring_.submit();
+}
+
+bool usub::server::net::IoUringLoop::ensurePipe(UringConnection &conn) {
+    if (conn.pipe_r >= 0) return true;
+    int fds[2];
+    if (::pipe2(fds, O_CLOEXEC) < 0) return false;
+    conn.pipe_r = fds[0];
+    conn.pipe_w = fds[1];
+    ::fcntl(conn.pipe_w, F_SETPIPE_SZ, SPLICE_PIPE_SIZE);
+    const int size = ::fcntl(conn.pipe_w, F_GETPIPE_SZ);
+    conn.pipe_size = size > 0 ? static_cast<size_t>(size) : 64 * 1024;
+    return true;
+}
+
+bool usub::server::net::IoUringLoop::opSqes(UringConnection &conn, io_uring_sqe **sqes, unsigned count) {
+    if (!this->ring_.sqes(sqes, count)) return false;
+    conn.inflight += count;
+    for (unsigned i = 0; i < count; ++i) {
+        conn.results[i] = 0;
+    }
+    return true;
+}
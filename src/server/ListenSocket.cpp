@@ -0,0 +1,71 @@
+#include "server/ListenSocket.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace {
+    [[noreturn]] void throwErrno(int fd, const char *what) {
+        const int err = errno;
+        if (fd >= 0) ::close(fd);
+        throw std::system_error(err, std::generic_category(), what);
+    }
+}// namespace
+
+int usub::server::net::openReusePortListener(const std::string &ip_addr, int port, int backlog, int ipv) {
+    const int family = ipv == 1 ? AF_INET6 : AF_INET;
+    const int fd = ::socket(family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) throwErrno(-1, "socket");
+
+    int one = 1;
+    if (::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) < 0) throwErrno(fd, "setsockopt(SO_REUSEADDR)");
+    if (::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) < 0) throwErrno(fd, "setsockopt(SO_REUSEPORT)");
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    if (family == AF_INET6) {
+        sockaddr_in6 addr{};
+        addr.sin6_family = AF_INET6;
+        addr.sin6_port = htons(static_cast<uint16_t>(port));
+        if (ip_addr.empty() || ip_addr == "0.0.0.0" || ip_addr == "::") {
+            addr.sin6_addr = in6addr_any;
+        } else if (::inet_pton(AF_INET6, ip_addr.c_str(), &addr.sin6_addr) != 1) {
+            ::close(fd);
+            throw std::system_error(EINVAL, std::generic_category(), "inet_pton: " + ip_addr);
+        }
+        if (::bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) throwErrno(fd, "bind");
+    } else {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        if (ip_addr.empty()) {
+            addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        } else if (::inet_pton(AF_INET, ip_addr.c_str(), &addr.sin_addr) != 1) {
+            ::close(fd);
+            throw std::system_error(EINVAL, std::generic_category(), "inet_pton: " + ip_addr);
+        }
+        if (::bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) throwErrno(fd, "bind");
+    }
+
+    if (::listen(fd, backlog) < 0) throwErrno(fd, "listen");
+    return fd;
+}
+
+int usub::server::net::tryAccept(int listen_fd) {
+    for (;;) {
+        const int fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd >= 0) [[likely]] {
+            int one = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            return fd;
+        }
+        if (errno == EINTR) continue;
+        // ECONNABORTED: the peer gave up while queued, the next entry may still be valid
+        if (errno == ECONNABORTED) continue;
+        return -1;
+    }
+}
@@ -0,0 +1,43 @@
+#include "server/SendFile.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <sys/sendfile.h>
+#include <unistd.h>
+
+usub::uvent::task::Awaitable<ssize_t> usub::server::net::async_sendfile(usub::uvent::net::TCPClientSocket &socket, int in_fd, off_t offset, size_t count) {
+    const int out_fd = socket.get_raw_header()->fd;
+    ssize_t total = 0;
+
+    while (count > 0) {
+        const ssize_t sent = ::sendfile(out_fd, in_fd, &offset, count);
+        if (sent > 0) [[likely]] {
+            total += sent;
+            count -= static_cast<size_t>(sent);
+            continue;
+        }
+        if (sent == 0) break;// file is shorter than announced
+        if (errno == EINTR) continue;
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            co_return total > 0 ? total : -1;
+        }
+
+        // Send buffer is full. The socket only exposes readiness through its own I/O calls, so push one page
+        // with async_write(): it waits for writability and the next sendfile() starts on a drained buffer.
+        std::array<uint8_t, 4096> page{};
+        const ssize_t rdsz = ::pread(in_fd, page.data(), std::min(page.size(), count), offset);
+        if (rdsz <= 0) {
+            co_return total > 0 ? total : -1;
+        }
+        const ssize_t wrsz = co_await socket.async_write(page.data(), static_cast<size_t>(rdsz));
+        if (wrsz <= 0) {
+            co_return total > 0 ? total : -1;
+        }
+        total += wrsz;
+        offset += wrsz;
+        count -= static_cast<size_t>(wrsz);
+    }
+    co_return total;
+}
@@ -0,0 +1,141 @@
+#include "server/TimerWheel.h"
+
+#include <algorithm>
+#include <sys/socket.h>
+#include <uvent/system/SystemContext.h>
+
+usub::server::net::Deadline::~Deadline() {
+    if (this->wheel_) this->wheel_->cancel(*this);
+}
+
+usub::server::net::TimerWheel::TimerWheel() : origin_(std::chrono::steady_clock::now()) {}
+
+usub::server::net::TimerWheel::~TimerWheel() {
+    // connections that outlive the thread's wheel must not unlink from it later
+    auto detach = [](TimerLink &head) {
+        while (head.next != &head) {
+            Deadline &deadline = static_cast<Deadline &>(*head.next);
+            unlink(deadline);
+            deadline.wheel_ = nullptr;
+        }
+    };
+    std::for_each(this->root_.begin(), this->root_.end(), detach);
+    for (auto &level: this->levels_) {
+        std::for_each(level.begin(), level.end(), detach);
+    }
+}
+
+void usub::server::net::TimerWheel::arm(Deadline &deadline, std::chrono::milliseconds timeout) {
+    if (timeout <= std::chrono::milliseconds::zero()) {
+        this->cancel(deadline);
+        return;
+    }
+    if (deadline.wheel_) {
+        unlink(deadline);
+        --deadline.wheel_->size_;
+    }
+    const uint64_t ticks = (static_cast<uint64_t>(timeout.count()) + TICK.count() - 1) / TICK.count();
+    deadline.expires_ = this->now_tick_ + std::min(ticks, MAX_TICKS);
+    deadline.wheel_ = this;
+    ++this->size_;
+    this->link(deadline);
+}
+
+void usub::server::net::TimerWheel::cancel(Deadline &deadline) {
+    if (!deadline.wheel_) return;
+    unlink(deadline);
+    --deadline.wheel_->size_;
+    deadline.wheel_ = nullptr;
+}
+
+size_t usub::server::net::TimerWheel::advance(std::chrono::steady_clock::time_point now) {
+    if (now < this->origin_) return 0;
+    const auto target = static_cast<uint64_t>((now - this->origin_) / TICK);
+    size_t expired = 0;
+
+    for (; this->now_tick_ <= target; ++this->now_tick_) {
+        const size_t index = this->now_tick_ & (ROOT_SIZE - 1);
+        if (index == 0) {
+            // the root wrapped, pull the next range down from the upper levels
+            for (unsigned level = 0; level < LEVELS - 1; ++level) {
+                const size_t level_index = (this->now_tick_ >> (ROOT_BITS + level * LEVEL_BITS)) & (LEVEL_SIZE - 1);
+                this->cascade(level);
+                if (level_index != 0) break;
+            }
+        }
+
+        TimerLink &head = this->root_[index];
+        while (head.next != &head) {
+            Deadline &deadline = static_cast<Deadline &>(*head.next);
+            unlink(deadline);
+            deadline.wheel_ = nullptr;
+            --this->size_;
+            ++expired;
+            // wakes the pending read/write with EOF/EPIPE, the connection coroutine closes the socket itself
+            ::shutdown(deadline.fd_, SHUT_RDWR);
+        }
+    }
+    return expired;
+}
+
+usub::server::net::TimerWheel &usub::server::net::TimerWheel::local() {
+    thread_local TimerWheel wheel;
+    return wheel;
+}
+
+void usub::server::net::TimerWheel::link(Deadline &deadline) {
+    const uint64_t expires = deadline.expires_;
+    const uint64_t delta = expires > this->now_tick_ ? expires - this->now_tick_ : 0;
+
+    TimerLink *head;
+    if (delta < ROOT_SIZE) {
+        head = &this->root_[std::max(expires, this->now_tick_) & (ROOT_SIZE - 1)];
+    } else {
+        unsigned level = 0;
+        while (level < LEVELS - 2 && delta >= (uint64_t{1} << (ROOT_BITS + (level + 1) * LEVEL_BITS))) {
+            ++level;
+        }
+        head = &this->levels_[level][(expires >> (ROOT_BITS + level * LEVEL_BITS)) & (LEVEL_SIZE - 1)];
+    }
+
+    TimerLink &node = deadline;
+    node.prev = head->prev;
+    node.next = head;
+    head->prev->next = &node;
+    head->prev = &node;
+}
+
+void usub::server::net::TimerWheel::unlink(Deadline &deadline) {
+    TimerLink &node = deadline;
+    node.prev->next = node.next;
+    node.next->prev = node.prev;
+    node.prev = &node;
+    node.next = &node;
+}
+
+void usub::server::net::TimerWheel::cascade(unsigned level) {
+    const size_t index = (this->now_tick_ >> (ROOT_BITS + level * LEVEL_BITS)) & (LEVEL_SIZE - 1);
+    TimerLink &head = this->levels_[level][index];
+    // detach the whole slot first, link() may put entries back into this level
+    TimerLink pending;
+    if (head.next == &head) return;
+    pending.next = head.next;
+    pending.prev = head.prev;
+    pending.next->prev = &pending;
+    pending.prev->next = &pending;
+    head.next = head.prev = &head;
+
+    while (pending.next != &pending) {
+        Deadline &deadline = static_cast<Deadline &>(*pending.next);
+        unlink(deadline);
+        this->link(deadline);
+    }
+}
+
+usub::uvent::task::Awaitable<void> usub::server::net::runTimerWheel() {
+    TimerWheel &wheel = TimerWheel::local();
+    for (;;) {
+        co_await usub::uvent::system::this_coroutine::sleep_for(TimerWheel::TICK);
+        wheel.advance(std::chrono::steady_clock::now());
+    }
+}
@@ -0,0 +1,53 @@
+#include "server/VectoredWrite.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+
+namespace {
+    /// Drops @p n written bytes from the front of iov[idx..], returns the new first unwritten index.
+    size_t advance(std::vector<iovec> &iov, size_t idx, size_t n) {
+        while (n > 0 && idx < iov.size()) {
+            if (n >= iov[idx].iov_len) {
+                n -= iov[idx].iov_len;
+                ++idx;
+            } else {
+                iov[idx].iov_base = static_cast<char *>(iov[idx].iov_base) + n;
+                iov[idx].iov_len -= n;
+                n = 0;
+            }
+        }
+        while (idx < iov.size() && iov[idx].iov_len == 0) ++idx;
+        return idx;
+    }
+}// namespace
+
+usub::uvent::task::Awaitable<ssize_t> usub::server::net::async_writev(usub::uvent::net::TCPClientSocket &socket, std::vector<iovec> &iov) {
+    const int fd = socket.get_raw_header()->fd;
+    ssize_t total = 0;
+    size_t idx = advance(iov, 0, 0);
+
+    while (idx < iov.size()) {
+        const int count = static_cast<int>(std::min<size_t>(iov.size() - idx, IOV_MAX));
+        const ssize_t written = ::writev(fd, iov.data() + idx, count);
+        if (written > 0) [[likely]] {
+            total += written;
+            idx = advance(iov, idx, static_cast<size_t>(written));
+            continue;
+        }
+        if (written < 0 && errno == EINTR) continue;
+        if (written < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            co_return total > 0 ? total : -1;
+        }
+
+        // send buffer is full: let the reactor wait for writability
+        ssize_t wrsz = co_await socket.async_write(static_cast<uint8_t *>(iov[idx].iov_base), iov[idx].iov_len);
+        if (wrsz <= 0) {
+            co_return total > 0 ? total : -1;
+        }
+        total += wrsz;
+        idx = advance(iov, idx, static_cast<size_t>(wrsz));
+    }
+    co_return total;
+}
@@ -0,0 +1,95 @@
+#include "server/WorkerPool.h"
+
+#include <chrono>
+#include <memory>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <utility>
+
+#include <uvent/Uvent.h>
+
+usub::server::net::WorkerPool::WorkerPool(size_t threads, size_t capacity) : capacity_(capacity) {
+    this->threads_.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        this->threads_.emplace_back([this] { this->run(); });
+    }
+}
+
+usub::server::net::WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard lock(this->mutex_);
+        this->stopping_ = true;
+    }
+    this->ready_.notify_all();
+    for (auto &thread: this->threads_) {
+        thread.join();
+    }
+}
+
+bool usub::server::net::WorkerPool::trySubmit(std::function<void()> job) {
+    {
+        std::lock_guard lock(this->mutex_);
+        if (this->threads_.empty() || this->queue_.size() >= this->capacity_) {
+            this->rejected_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        this->queue_.push_back(std::move(job));
+    }
+    this->ready_.notify_one();
+    return true;
+}
+
+void usub::server::net::WorkerPool::run() {
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock lock(this->mutex_);
+            this->ready_.wait(lock, [this] { return this->stopping_ || !this->queue_.empty(); });
+            if (this->queue_.empty()) return;
+            job = std::move(this->queue_.front());
+            this->queue_.pop_front();
+        }
+        job();
+    }
+}
+
+usub::server::net::WorkerChannel::WorkerChannel() : fd_(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+    // the eventfd is owned by the uvent socket the coroutine waits on
+    if (this->fd_ >= 0) this->events_.emplace(this->fd_);
+}
+
+usub::uvent::task::Awaitable<void> usub::server::net::WorkerChannel::run(WorkerPool &pool, std::function<void()> job) {
+    if (this->fd_ < 0) {
+        job();
+        co_return;
+    }
+    uint64_t stale;
+    // a wait cut short below can leave the previous job's signal behind
+    [[maybe_unused]] const ssize_t drained = ::read(this->fd_, &stale, sizeof(stale));
+
+    // shared with the worker, which sets it as the last thing it does for this job
+    auto done = std::make_shared<std::atomic<bool>>(false);
+    const int fd = this->fd_;
+    const bool queued = pool.trySubmit([&job, done, fd] {
+        job();
+        const uint64_t one = 1;
+        [[maybe_unused]] const ssize_t n = ::write(fd, &one, sizeof(one));
+        done->store(true, std::memory_order_release);
+    });
+    if (!queued) {
+        job();
+        co_return;
+    }
+
+    usub::uvent::utils::DynamicBuffer counter;
+    if (co_await this->events_->async_read(counter, sizeof(uint64_t)) > 0) {
+        // signalled: the worker is between its write and the store
+        while (!done->load(std::memory_order_acquire)) std::this_thread::yield();
+        co_return;
+    }
+    // the job still references this frame, keep waiting without the eventfd
+    while (!done->load(std::memory_order_acquire)) {
+        co_await usub::uvent::system::this_coroutine::sleep_for(std::chrono::milliseconds(1));
+    }
+    co_return;
+}
@@ -35,13 +35,85 @@ namespace usub::server::configuration {
                         config.key_file = table["key_file"].as_string()->get();
                     if (table.contains("cert_file"))
                         config.cert_file = table["cert_file"].as_string()->get();
-                    
+                    if (table.contains("accept_mode")) {
+                        const std::string mode = table["accept_mode"].as_string()->get();
+                        if (mode == "single")
+                            config.accept_mode = AcceptMode::SINGLE;
+                        else if (mode == "reuseport")
+                            config.accept_mode = AcceptMode::REUSE_PORT;
+                        else
+                            throw error::WrongConfig("Unknown listener accept_mode: " + mode);
+                    }
+                    if (table.contains("accept_batch")) {
+                        config.accept_batch = table["accept_batch"].as_integer()->get();
+                        if (config.accept_batch < 1) throw error::WrongConfig("listener accept_batch must be >= 1");
+                    }
+                    auto read_timeout = [&](const char *key, int &value) {
+                        if (!table.contains(key)) return;
+                        value = table[key].as_integer()->get();
+                        if (value < 0) throw error::WrongConfig(std::string("listener ") + key + " must be >= 0");
+                    };
+                    read_timeout("keep_alive_timeout", config.timeouts.keep_alive);
+                    read_timeout("header_timeout", config.timeouts.header);
+                    read_timeout("body_timeout", config.timeouts.body);
+                    read_timeout("write_timeout", config.timeouts.write);
+
                     listeners_.push_back(config);
                 }
             }
         } else {
             listeners_.emplace_back();
         }
+        if (res.contains("tls") && res.get_as<toml::table>("tls")) {
+            const auto &table = *res.get_as<toml::table>("tls");
+            auto read_integer = [&](const char *key, int &value, int min) {
+                if (!table.contains(key)) return;
+                value = table[key].as_integer()->get();
+                if (value < min) throw error::WrongConfig(std::string("tls ") + key + " must be >= " + std::to_string(min));
+            };
+            read_integer("session_cache_size", tls_sessions_.session_cache_size, 0);
+            read_integer("session_timeout", tls_sessions_.session_timeout, 1);
+            read_integer("ticket_key_rotation", tls_sessions_.ticket_key_rotation, 1);
+            read_integer("early_data_size", tls_sessions_.early_data_size, 1);
+            read_integer("early_data_replay_window", tls_sessions_.early_data_replay_window, 10);
+            read_integer("handshake_workers", tls_handshakes_.workers, 0);
+            read_integer("handshake_queue", tls_handshakes_.queue, 1);
+            read_integer("record_size", tls_records_.record_size, 0);
+            read_integer("record_boost_bytes", tls_records_.record_boost_bytes, 0);
+            read_integer("record_boost_time", tls_records_.record_boost_time, 0);
+            read_integer("record_idle_reset", tls_records_.record_idle_reset, 0);
+            read_integer("ocsp_refresh", tls_ocsp_.ocsp_refresh, 60);
+            read_integer("ocsp_retry", tls_ocsp_.ocsp_retry, 1);
+            read_integer("ocsp_timeout", tls_ocsp_.ocsp_timeout, 1);
+            if (tls_records_.record_size != 0 && (tls_records_.record_size < 512 || tls_records_.record_size > 16384))
+                throw error::WrongConfig("tls record_size must be 0 or between 512 and 16384");
+            if (table.contains("session_tickets"))
+                tls_sessions_.session_tickets = table["session_tickets"].as_boolean()->get();
+            if (table.contains("ticket_key_file"))
+                tls_sessions_.ticket_key_file = table["ticket_key_file"].as_string()->get();
+            if (table.contains("early_data"))
+                tls_sessions_.early_data = table["early_data"].as_boolean()->get();
+            if (table.contains("ocsp_stapling"))
+                tls_ocsp_.ocsp_stapling = table["ocsp_stapling"].as_boolean()->get();
+        }
+        if (res.contains("http2") && res.get_as<toml::table>("http2")) {
+            const auto &table = *res.get_as<toml::table>("http2");
+            auto read_integer = [&](const char *key, int &value, int min, int max) {
+                if (!table.contains(key)) return;
+                const int64_t read = table[key].as_integer()->get();
+                if (read < min || read > max)
+                    throw error::WrongConfig(std::string("http2 ") + key + " must be between " + std::to_string(min) + " and " + std::to_string(max));
+                value = static_cast<int>(read);
+            };
+            read_integer("max_concurrent_streams", http2_.max_concurrent_streams, 1, INT32_MAX);
+            read_integer("initial_window_size", http2_.initial_window_size, 65535, INT32_MAX);
+            read_integer("connection_window_size", http2_.connection_window_size, 65535, INT32_MAX);
+            read_integer("max_frame_size", http2_.max_frame_size, 16384, 16777215);
+            read_integer("max_header_list_size", http2_.max_header_list_size, 1, INT32_MAX);
+            read_integer("max_body_size", http2_.max_body_size, 0, INT32_MAX);
+            if (table.contains("enabled"))
+                http2_.enabled = table["enabled"].as_boolean()->get();
+        }
     }
 
     toml::node_view<toml::node> usub::server::configuration::ConfigReader::getKey(const std::string &key) {
@@ -103,12 +175,15 @@ namespace usub::server::configuration {
 
     std::vector<usub::server::configuration::Certificate> usub::server::configuration::ConfigReader::getCerts() {
         if (!this->res.contains("certs")) throw error::WrongConfig("No certificates were provided");
+        this->certs.clear();
         for (const auto &cert_node: *res["certs"].as_array()) {
             const auto &cert = *cert_node.as_table();
             std::string domain = cert["domain"].value_or("");
             std::string key_file = cert["key_file"].value_or("");
             std::string cert_file = cert["cert_file"].value_or("");
-            this->certs.emplace_back(domain, key_file, cert_file);
+            auto &entry = this->certs.emplace_back(domain, key_file, cert_file);
+            entry.ocsp_file = cert["ocsp_file"].value_or("");
+            entry.ocsp_responder = cert["ocsp_responder"].value_or("");
         }
         return this->certs;
     }
@@ -135,4 +210,24 @@ namespace usub::server::configuration {
     std::vector<ListenerConfig>& usub::server::configuration::ConfigReader::getListeners() {
         return listeners_;
     }
+
+    TLSSessionConfig &ConfigReader::getTLSSessions() {
+        return tls_sessions_;
+    }
+
+    TLSHandshakeConfig &ConfigReader::getTLSHandshakes() {
+        return tls_handshakes_;
+    }
+
+    TLSRecordConfig &ConfigReader::getTLSRecords() {
+        return tls_records_;
+    }
+
+    TLSOcspConfig &ConfigReader::getTLSOcsp() {
+        return tls_ocsp_;
+    }
+
+    HTTP2Config &ConfigReader::getHTTP2() {
+        return http2_;
+    }
 }// namespace usub::server::configuration
@@ -0,0 +1,240 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Components/Compression/HPACK.h"
+#include "Protocols/HTTP/Headers.h"
+
+using namespace usub::server::component;
+
+#define TEST_ASSERT(condition, message, expected, actual)   \
+    do {                                                    \
+        if (!(condition)) {                                 \
+            std::cerr << "Assertion failed: " << message    \
+                      << "\n    Expected: " << expected     \
+                      << "\n    Actual:   " << actual       \
+                      << "\n    at " << __FILE__            \
+                      << ":" << __LINE__ << std::endl;      \
+            std::exit(1);                                   \
+        }                                                   \
+    } while (0)
+
+using Fields = std::vector<std::pair<std::string, std::string>>;
+
+std::string unhex(std::string_view hex) {
+    std::string out;
+    for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+        out.push_back(static_cast<char>(std::stoi(std::string(hex.substr(i, 2)), nullptr, 16)));
+    }
+    return out;
+}
+
+std::string to_string(const Fields &fields) {
+    std::string out;
+    for (const auto &[name, value]: fields) out += name + ": " + value + "; ";
+    return out;
+}
+
+bool decode(HPACKDecoder &decoder, const std::string &block, Fields &fields) {
+    fields.clear();
+    return decoder
+            .decode(block, [&](std::string_view name, std::string_view value) {
+                fields.emplace_back(name, value);
+                return true;
+            })
+            .has_value();
+}
+
+// RFC 7541, C.1
+void test_integers() {
+    std::cout << "Testing integer representation..." << std::endl;
+    std::string out;
+    hpack::encodeInteger(out, 0, 5, 10);
+    TEST_ASSERT(out == unhex("0a"), "10 with a 5-bit prefix", "0a", out.size());
+    out.clear();
+    hpack::encodeInteger(out, 0, 5, 1337);
+    TEST_ASSERT(out == unhex("1f9a0a"), "1337 with a 5-bit prefix", "1f9a0a", out.size());
+
+    uint64_t value = 0;
+    size_t pos = 0;
+    TEST_ASSERT(hpack::decodeInteger(out, pos, 5, value) && value == 1337 && pos == 3, "decode 1337", 1337, value);
+    pos = 0;
+    TEST_ASSERT(!hpack::decodeInteger(unhex("1f9a"), pos, 5, value), "truncated integer is rejected", false, true);
+    std::cout << "Integer representation test passed" << std::endl;
+}
+
+// RFC 7541, C.3 and C.4: the same requests without and with Huffman coding
+void test_request_sequence(const char *title, const std::vector<std::string> &blocks) {
+    std::cout << "Testing " << title << "..." << std::endl;
+    const std::vector<Fields> expected = {
+            {{":method", "GET"}, {":scheme", "http"}, {":path", "/"}, {":authority", "www.example.com"}},
+            {{":method", "GET"}, {":scheme", "http"}, {":path", "/"}, {":authority", "www.example.com"}, {"cache-control", "no-cache"}},
+            {{":method", "GET"}, {":scheme", "https"}, {":path", "/index.html"}, {":authority", "www.example.com"}, {"custom-key", "custom-value"}},
+    };
+    const size_t table_sizes[] = {57, 110, 164};
+
+    HPACKDecoder decoder;
+    Fields fields;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        TEST_ASSERT(decode(decoder, unhex(blocks[i]), fields), "block decodes", "success", "error");
+        TEST_ASSERT(fields == expected[i], "decoded fields", to_string(expected[i]), to_string(fields));
+        TEST_ASSERT(decoder.tableSize() == table_sizes[i], "dynamic table size", table_sizes[i], decoder.tableSize());
+    }
+    std::cout << title << " test passed" << std::endl;
+}
+
+void test_huffman() {
+    std::cout << "Testing Huffman coding..." << std::endl;
+    std::string all;
+    for (int c = 0; c < 256; ++c) all.push_back(static_cast<char>(c));
+    const std::string samples[] = {"", "www.example.com", "no-cache", "Mon, 21 Oct 2013 20:13:21 GMT", all};
+    for (const std::string &sample: samples) {
+        std::string coded;
+        hpack::huffmanEncode(sample, coded);
+        TEST_ASSERT(coded.size() == hpack::huffmanLength(sample), "encoded length", hpack::huffmanLength(sample), coded.size());
+        std::string decoded;
+        TEST_ASSERT(hpack::huffmanDecode(coded, decoded) && decoded == sample, "round trip", sample.size(), decoded.size());
+    }
+    std::string coded;
+    hpack::huffmanEncode("www.example.com", coded);
+    TEST_ASSERT(coded == unhex("f1e3c2e5f23a6ba0ab90f4ff"), "RFC 7541 C.4.1 string", "f1e3c2e5f23a6ba0ab90f4ff", coded.size());
+    std::cout << "Huffman coding test passed" << std::endl;
+}
+
+void test_static_table() {
+    std::cout << "Testing static table..." << std::endl;
+    TEST_ASSERT(hpack::staticEntry(31).header == HeaderEnum::Content_Type, "content-type is keyed by HeaderEnum", "Content_Type", "other");
+    TEST_ASSERT(hpack::staticIndex(HeaderEnum::Content_Type) == 31, "index of content-type", 31, hpack::staticIndex(HeaderEnum::Content_Type));
+    TEST_ASSERT(hpack::staticIndex(":status") == 8, "index of :status", 8, hpack::staticIndex(":status"));
+    TEST_ASSERT(hpack::staticIndex("vary") == 59, "index of vary", 59, hpack::staticIndex("vary"));
+    TEST_ASSERT(hpack::staticIndex("x-custom") == 0, "unknown name", 0, hpack::staticIndex("x-custom"));
+    std::cout << "Static table test passed" << std::endl;
+}
+
+void test_dynamic_table() {
+    std::cout << "Testing dynamic table..." << std::endl;
+    hpack::DynamicTable table(128);// three entries of 40 bytes fit
+    for (int i = 0; i < 5; ++i) table.insert("name", "val" + std::to_string(i), std::nullopt);
+    TEST_ASSERT(table.count() == 3 && table.size() == 120, "eviction keeps the newest entries", 3, table.count());
+    TEST_ASSERT(table.at(0)->value() == "val4" && table.at(2)->value() == "val2", "newest first", "val4", table.at(0)->value());
+    TEST_ASSERT(table.at(3) == nullptr, "past the oldest entry", "nullptr", "entry");
+
+    bool exact = false;
+    TEST_ASSERT(table.find("name", "val3", exact) == 1 && exact, "exact match", 1, table.find("name", "val3", exact));
+    TEST_ASSERT(table.find("name", "other", exact) == 0 && !exact, "name match", 0, table.find("name", "other", exact));
+
+    table.setCapacity(50);
+    TEST_ASSERT(table.count() == 1 && table.at(0)->value() == "val4", "shrinking evicts the oldest", 1, table.count());
+    table.setMaxCapacity(4096);
+    table.setCapacity(4096);
+    for (int i = 0; i < 10; ++i) table.insert("name", "more" + std::to_string(i), std::nullopt);
+    TEST_ASSERT(table.count() == 11 && table.at(10)->value() == "val4", "entries survive a larger ring", 11, table.count());
+    table.insert("big", std::string(5000, 'x'), std::nullopt);
+    TEST_ASSERT(table.count() == 0 && table.size() == 0, "an entry larger than the table empties it", 0, table.count());
+    std::cout << "Dynamic table test passed" << std::endl;
+}
+
+void test_encoder_indexing() {
+    std::cout << "Testing encoder indexing..." << std::endl;
+    HPACKEncoder encoder;
+    HPACKDecoder decoder;
+    Fields decoded;
+    const Fields fields = {{":status", "200"}, {"content-type", "application/json"}, {"content-length", "42"}, {"set-cookie", "id=1"}, {"server", "usub"}};
+
+    std::string first;
+    encoder.begin(first);
+    for (const auto &[name, value]: fields) encoder.encode(first, name, value);
+    TEST_ASSERT(decode(decoder, first, decoded) && decoded == fields, "first block", to_string(fields), to_string(decoded));
+    TEST_ASSERT(first[0] == static_cast<char>(0x88), ":status 200 is a static index", "88", static_cast<int>(static_cast<uint8_t>(first[0])));
+
+    std::string second;
+    encoder.begin(second);
+    for (const auto &[name, value]: fields) encoder.encode(second, name, value);
+    TEST_ASSERT(decode(decoder, second, decoded) && decoded == fields, "second block", to_string(fields), to_string(decoded));
+    // content-type and server are indexed now; content-length and set-cookie are literals again
+    TEST_ASSERT(second.size() < first.size() / 2, "repeated fields shrink to indexes", first.size() / 2, second.size());
+    TEST_ASSERT(decoder.tableSize() == encoder.tableSize(), "tables stay in sync", encoder.tableSize(), decoder.tableSize());
+
+    // the peer shrinks the table, then allows it again
+    encoder.setMaxTableSize(0);
+    encoder.setMaxTableSize(4096);
+    std::string third;
+    encoder.begin(third);
+    encoder.encode(third, "server", "usub");
+    TEST_ASSERT(third.substr(0, 4) == unhex("203fe11f"), "both size updates are sent", "203fe11f", third.size());
+    TEST_ASSERT(decode(decoder, third, decoded) && decoded.size() == 1, "block after size updates", 1, decoded.size());
+    std::cout << "Encoder indexing test passed" << std::endl;
+}
+
+void test_decode_into_headers() {
+    std::cout << "Testing decoding into Headers..." << std::endl;
+    HPACKDecoder decoder;
+    usub::server::protocols::http::Headers headers;
+    Fields pseudo;
+    // RFC 7541 C.3.3 with its table, then a literal custom field
+    const std::string blocks[] = {"828684410f7777772e6578616d706c652e636f6d", "828684be58086e6f2d6361636865"};
+    for (const auto &block: blocks) {
+        TEST_ASSERT(decoder.decode(unhex(block), [](std::string_view, std::string_view) { return true; }).has_value(), "setup block", "success", "error");
+    }
+    const auto result = decoder.decode(unhex("828785bf400a637573746f6d2d6b65790c637573746f6d2d76616c7565"), headers,
+                                       [&](std::string_view name, std::string_view value) {
+                                           pseudo.emplace_back(name, value);
+                                           return true;
+                                       });
+    TEST_ASSERT(result.has_value(), "block decodes", "success", "error");
+    TEST_ASSERT(pseudo.size() == 4 && pseudo[2].second == "/index.html", "pseudo-headers go to the callback", 4, pseudo.size());
+    TEST_ASSERT(headers.contains("custom-key") && headers.at("custom-key").front() == "custom-value", "regular field is stored", "custom-value", headers.size());
+    std::cout << "Decoding into Headers test passed" << std::endl;
+}
+
+void test_encoder_round_trip() {
+    std::cout << "Testing encoder round trip..." << std::endl;
+    const Fields fields = {{":status", "200"}, {"content-type", "text/plain"}, {"x-custom", "value"}, {"set-cookie", "a=1"}, {"set-cookie", "b=2"}};
+    HPACKEncoder encoder(0);
+    std::string block;
+    encoder.begin(block);
+    for (const auto &[name, value]: fields) encoder.encode(block, name, value);
+
+    HPACKDecoder decoder;
+    Fields decoded;
+    TEST_ASSERT(decode(decoder, block, decoded), "encoded block decodes", "success", "error");
+    TEST_ASSERT(decoded == fields, "round trip", to_string(fields), to_string(decoded));
+    TEST_ASSERT(decoder.tableSize() == 0, "nothing is indexed without a table", 0, decoder.tableSize());
+    std::cout << "Encoder round trip test passed" << std::endl;
+}
+
+void test_malformed() {
+    std::cout << "Testing malformed blocks..." << std::endl;
+    HPACKDecoder decoder;
+    Fields fields;
+    TEST_ASSERT(!decode(decoder, unhex("be"), fields), "index beyond the tables", "error", "success");
+    TEST_ASSERT(!decode(decoder, unhex("400a637573746f6d2d6b6579"), fields), "string longer than the block", "error", "success");
+    // "a" is 00011 followed by five padding bits, which must be ones
+    TEST_ASSERT(!decode(decoder, unhex("0001618118"), fields), "Huffman padding of zeros", "error", "success");
+    TEST_ASSERT(!decode(decoder, unhex("3fe21f"), fields), "table size update above the limit", "error", "success");
+    TEST_ASSERT(!decode(decoder, unhex("823f00"), fields), "table size update after a field", "error", "success");
+    std::cout << "Malformed blocks test passed" << std::endl;
+}
+
+int main() {
+    test_integers();
+    test_request_sequence("requests without Huffman coding",
+                          {"828684410f7777772e6578616d706c652e636f6d",
+                           "828684be58086e6f2d6361636865",
+                           "828785bf400a637573746f6d2d6b65790c637573746f6d2d76616c7565"});
+    test_request_sequence("requests with Huffman coding",
+                          {"828684418cf1e3c2e5f23a6ba0ab90f4ff",
+                           "828684be5886a8eb10649cbf",
+                           "828785bf408825a849e95ba97d7f8925a849e95bb8e8b4bf"});
+    test_huffman();
+    test_static_table();
+    test_dynamic_table();
+    test_encoder_round_trip();
+    test_encoder_indexing();
+    test_decode_into_headers();
+    test_malformed();
+    std::cout << "All HPACK tests passed!" << std::endl;
+    return 0;
+}
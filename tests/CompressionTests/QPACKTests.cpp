@@ -0,0 +1,248 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Components/Compression/QPACK.h"
+#include "Protocols/HTTP/Headers.h"
+
+using namespace usub::server::component;
+
+#define TEST_ASSERT(condition, message, expected, actual)   \
+    do {                                                    \
+        if (!(condition)) {                                 \
+            std::cerr << "Assertion failed: " << message    \
+                      << "\n    Expected: " << expected     \
+                      << "\n    Actual:   " << actual       \
+                      << "\n    at " << __FILE__            \
+                      << ":" << __LINE__ << std::endl;      \
+            std::exit(1);                                   \
+        }                                                   \
+    } while (0)
+
+using Fields = std::vector<std::pair<std::string, std::string>>;
+
+std::string unhex(std::string_view hex) {
+    std::string out;
+    for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+        out.push_back(static_cast<char>(std::stoi(std::string(hex.substr(i, 2)), nullptr, 16)));
+    }
+    return out;
+}
+
+std::string hex(std::string_view bytes) {
+    static const char digits[] = "0123456789abcdef";
+    std::string out;
+    for (char c: bytes) {
+        out.push_back(digits[static_cast<uint8_t>(c) >> 4]);
+        out.push_back(digits[static_cast<uint8_t>(c) & 0xf]);
+    }
+    return out;
+}
+
+std::string to_string(const Fields &fields) {
+    std::string out;
+    for (const auto &[name, value]: fields) out += name + ": " + value + "; ";
+    return out;
+}
+
+// 1 when decoded, 0 when blocked, -1 on error
+int decode(QPACKDecoder &decoder, uint64_t stream_id, const std::string &section, Fields &fields) {
+    fields.clear();
+    const auto result = decoder.decode(stream_id, section, [&](std::string_view name, std::string_view value) {
+        fields.emplace_back(name, value);
+        return true;
+    });
+    if (!result) return -1;
+    return *result ? 1 : 0;
+}
+
+std::string encode(QPACKEncoder &encoder, uint64_t stream_id, const Fields &fields) {
+    std::string section;
+    encoder.begin(stream_id);
+    for (const auto &[name, value]: fields) encoder.encode(name, value);
+    encoder.end(section);
+    return section;
+}
+
+void test_static_table() {
+    std::cout << "Testing static table..." << std::endl;
+    bool exact = false;
+    TEST_ASSERT(qpack::staticFind(":status", "200", exact) == 25 && exact, "exact match", 25, qpack::staticFind(":status", "200", exact));
+    // :status entries are split in two groups in the QPACK table
+    TEST_ASSERT(qpack::staticFind(":status", "421", exact) == 69 && exact, "second group", 69, qpack::staticFind(":status", "421", exact));
+    TEST_ASSERT(qpack::staticFind(":status", "418", exact) == 24 && !exact, "name match", 24, qpack::staticFind(":status", "418", exact));
+    TEST_ASSERT(qpack::staticFind("x-custom", "", exact) == -1, "unknown name", -1, qpack::staticFind("x-custom", "", exact));
+    TEST_ASSERT(qpack::staticEntry(46).header == HeaderEnum::Content_Type && qpack::staticEntry(46).value == "application/json",
+                "entries carry their HeaderEnum", "content-type", qpack::staticEntry(46).name);
+
+    uint64_t decoded = 0;
+    for (uint64_t count: {0, 1, 5, 12, 13, 100}) {
+        const uint64_t encoded = qpack::encodeInsertCount(count, 220);
+        TEST_ASSERT(qpack::decodeInsertCount(encoded, 220, count, decoded) && decoded == count, "insert count round trip", count, decoded);
+    }
+    TEST_ASSERT(!qpack::decodeInsertCount(14, 220, 0, decoded), "encoded insert count beyond the range", "error", decoded);
+    std::cout << "Static table test passed" << std::endl;
+}
+
+// RFC 9204, Appendix B
+void test_examples() {
+    std::cout << "Testing RFC 9204 examples..." << std::endl;
+    QPACKDecoder decoder(220, 1);
+    Fields fields;
+
+    // B.1: literal field line with name reference, no dynamic table
+    TEST_ASSERT(decode(decoder, 0, unhex("0000510b2f696e6465782e68746d6c"), fields) == 1, "B.1 decodes", 1, "not decoded");
+    TEST_ASSERT(fields == Fields({{":path", "/index.html"}}), "B.1 fields", ":path: /index.html", to_string(fields));
+
+    // B.2: the section arrives before the inserts it references, which arrive in pieces
+    const std::string section4 = unhex("03811011");
+    TEST_ASSERT(decode(decoder, 4, section4, fields) == 0 && decoder.blockedStreams() == 1, "B.2 blocks", 0, decoder.blockedStreams());
+    const std::string inserts = unhex("3fbd01c00f7777772e6578616d706c652e636f6dc10c2f73616d706c652f70617468");
+    size_t start = 0;
+    for (size_t piece: {2u, 9u, 100u}) {
+        TEST_ASSERT(decoder.onEncoderStream(std::string_view(inserts).substr(start, piece)).has_value(), "encoder stream piece", "success", "error");
+        start += piece;
+    }
+    TEST_ASSERT(decoder.insertCount() == 2 && decoder.tableSize() == 106, "B.2 table", 106, decoder.tableSize());
+    TEST_ASSERT(decoder.unblockedStreams() == std::vector<uint64_t>{4}, "B.2 unblocks stream 4", 4, "other");
+    TEST_ASSERT(decode(decoder, 4, section4, fields) == 1, "B.2 decodes", 1, "not decoded");
+    TEST_ASSERT(fields == Fields({{":authority", "www.example.com"}, {":path", "/sample/path"}}), "B.2 fields",
+                ":authority, :path", to_string(fields));
+    TEST_ASSERT(hex(decoder.takeDecoderStream()) == "84", "B.2 section acknowledgment", "84", "other");
+
+    // B.3: speculative insert
+    TEST_ASSERT(decoder.onEncoderStream(unhex("4a637573746f6d2d6b65790c637573746f6d2d76616c7565")).has_value(), "B.3 insert", "success", "error");
+    TEST_ASSERT(decoder.tableSize() == 160, "B.3 table", 160, decoder.tableSize());
+    TEST_ASSERT(hex(decoder.takeDecoderStream()) == "01", "B.3 insert count increment", "01", "other");
+
+    // B.4: duplicate, then a section decoded into Headers
+    TEST_ASSERT(decoder.onEncoderStream(unhex("02")).has_value() && decoder.tableSize() == 217, "B.4 duplicate", 217, decoder.tableSize());
+    usub::server::protocols::http::Headers headers;
+    Fields pseudo;
+    const auto result = decoder.decode(8, unhex("050080c181"), headers, [&](std::string_view name, std::string_view value) {
+        pseudo.emplace_back(name, value);
+        return true;
+    });
+    TEST_ASSERT(result.has_value() && *result, "B.4 decodes", "decoded", "error");
+    TEST_ASSERT(pseudo == Fields({{":authority", "www.example.com"}, {":path", "/"}}), "B.4 pseudo-headers", ":authority, :path", to_string(pseudo));
+    TEST_ASSERT(headers.contains("custom-key") && headers.at("custom-key").front() == "custom-value", "B.4 field is stored", "custom-value", headers.size());
+    TEST_ASSERT(hex(decoder.takeDecoderStream()) == "88", "B.4 section acknowledgment", "88", "other");
+
+    // B.5: insert that evicts the oldest entry
+    TEST_ASSERT(decoder.onEncoderStream(unhex("810d637573746f6d2d76616c756532")).has_value(), "B.5 insert", "success", "error");
+    TEST_ASSERT(decoder.insertCount() == 5 && decoder.tableSize() == 215, "B.5 table", 215, decoder.tableSize());
+    decoder.cancelStream(8);
+    TEST_ASSERT(hex(decoder.takeDecoderStream()) == "4801", "B.5 stream cancellation and increment", "4801", "other");
+    std::cout << "RFC 9204 examples test passed" << std::endl;
+}
+
+void test_encoder_round_trip() {
+    std::cout << "Testing encoder round trip..." << std::endl;
+    QPACKEncoder encoder;
+    QPACKDecoder decoder(4096, 0);
+    encoder.setPeerSettings(4096, 0);
+    const Fields fields = {{":method", "GET"}, {":scheme", "https"}, {":path", "/api/items"}, {":authority", "example.com"},
+                           {"user-agent", "test/1.0"}, {"accept", "*/*"}, {"authorization", "Bearer xyz"}, {"x-custom", "hello"}};
+
+    // nothing the decoder has not acknowledged is referenced while no stream may block
+    const std::string first = encode(encoder, 0, fields);
+    TEST_ASSERT(first.substr(0, 2) == std::string(2, '\0'), "first section does not block", "0000", hex(first.substr(0, 2)));
+    TEST_ASSERT(decoder.onEncoderStream(encoder.takeEncoderStream()).has_value(), "encoder stream decodes", "success", "error");
+    Fields decoded;
+    TEST_ASSERT(decode(decoder, 0, first, decoded) == 1 && decoded == fields, "first section", to_string(fields), to_string(decoded));
+    // :path values rarely repeat and credentials are never indexed
+    TEST_ASSERT(decoder.insertCount() == 3, "indexed fields", 3, decoder.insertCount());
+    TEST_ASSERT(encoder.onDecoderStream(decoder.takeDecoderStream()).has_value(), "decoder stream decodes", "success", "error");
+
+    const std::string second = encode(encoder, 4, fields);
+    TEST_ASSERT(second.size() < first.size(), "acknowledged entries are indexed", first.size(), second.size());
+    TEST_ASSERT(encoder.takeEncoderStream().empty(), "no further inserts", "empty", "inserts");
+    TEST_ASSERT(decode(decoder, 4, second, decoded) == 1 && decoded == fields, "second section", to_string(fields), to_string(decoded));
+    TEST_ASSERT(encoder.onDecoderStream(decoder.takeDecoderStream()).has_value(), "acknowledgment decodes", "success", "error");
+    std::cout << "Encoder round trip test passed" << std::endl;
+}
+
+void test_blocked_streams() {
+    std::cout << "Testing blocked streams..." << std::endl;
+    QPACKEncoder encoder;
+    QPACKDecoder decoder(4096, 1);
+    encoder.setPeerSettings(4096, 1);
+
+    const std::string section0 = encode(encoder, 0, {{"x-a", "1"}});
+    TEST_ASSERT(encoder.blockedStreams() == 1, "first stream may block", 1, encoder.blockedStreams());
+    // a second stream would be one too many, so its new entry is sent as a literal
+    const std::string section4 = encode(encoder, 4, {{"x-b", "2"}});
+    TEST_ASSERT(encoder.blockedStreams() == 1 && encoder.insertCount() == 2, "second stream does not block", 1, encoder.blockedStreams());
+
+    Fields decoded;
+    TEST_ASSERT(decode(decoder, 0, section0, decoded) == 0, "first section waits for the encoder stream", 0, "decoded");
+    TEST_ASSERT(decode(decoder, 4, section4, decoded) == 1 && decoded == Fields({{"x-b", "2"}}), "second section decodes", "x-b: 2", to_string(decoded));
+    TEST_ASSERT(decoder.onEncoderStream(encoder.takeEncoderStream()).has_value(), "encoder stream decodes", "success", "error");
+    TEST_ASSERT(decoder.unblockedStreams() == std::vector<uint64_t>{0}, "stream 0 unblocks", 0, "other");
+    TEST_ASSERT(decode(decoder, 0, section0, decoded) == 1 && decoded == Fields({{"x-a", "1"}}), "first section decodes", "x-a: 1", to_string(decoded));
+    TEST_ASSERT(encoder.onDecoderStream(decoder.takeDecoderStream()).has_value(), "decoder stream decodes", "success", "error");
+    TEST_ASSERT(encoder.blockedStreams() == 0, "acknowledged stream is no longer blocked", 0, encoder.blockedStreams());
+
+    // a stream beyond the limit blocks the decoder for good
+    QPACKDecoder strict(4096, 0);
+    TEST_ASSERT(decode(strict, 0, section0, decoded) == -1, "blocked stream above the limit", -1, "accepted");
+    std::cout << "Blocked streams test passed" << std::endl;
+}
+
+void test_eviction() {
+    std::cout << "Testing eviction of referenced entries..." << std::endl;
+    QPACKEncoder encoder(100);
+    QPACKDecoder decoder(100, 10);
+    encoder.setPeerSettings(100, 10);
+    const std::string value(30, 'v');// entries of 67 bytes, one fits
+
+    const std::string section0 = encode(encoder, 0, {{"x-one", value}});
+    TEST_ASSERT(encoder.insertCount() == 1, "first entry is inserted", 1, encoder.insertCount());
+    // inserting would evict the entry stream 0 still references
+    const std::string section4 = encode(encoder, 4, {{"x-two", value}});
+    TEST_ASSERT(encoder.insertCount() == 1, "referenced entry is kept", 1, encoder.insertCount());
+
+    Fields decoded;
+    TEST_ASSERT(decoder.onEncoderStream(encoder.takeEncoderStream()).has_value(), "encoder stream decodes", "success", "error");
+    TEST_ASSERT(decode(decoder, 0, section0, decoded) == 1 && decode(decoder, 4, section4, decoded) == 1, "sections decode", 1, "error");
+    TEST_ASSERT(encoder.onDecoderStream(decoder.takeDecoderStream()).has_value(), "decoder stream decodes", "success", "error");
+
+    const std::string section8 = encode(encoder, 8, {{"x-two", value}});
+    TEST_ASSERT(encoder.insertCount() == 2 && encoder.tableSize() == 67, "acknowledged entry is evicted", 2, encoder.insertCount());
+    TEST_ASSERT(decoder.onEncoderStream(encoder.takeEncoderStream()).has_value(), "eviction decodes", "success", "error");
+    TEST_ASSERT(decode(decoder, 8, section8, decoded) == 1 && decoded == Fields({{"x-two", value}}), "section after eviction", "x-two", to_string(decoded));
+    TEST_ASSERT(decoder.tableSize() == 67, "decoder evicted too", 67, decoder.tableSize());
+    std::cout << "Eviction test passed" << std::endl;
+}
+
+void test_malformed() {
+    std::cout << "Testing malformed input..." << std::endl;
+    QPACKDecoder decoder(220, 0);
+    Fields fields;
+    TEST_ASSERT(decode(decoder, 0, unhex("0e00"), fields) == -1, "insert count beyond the range", -1, "accepted");
+    TEST_ASSERT(decode(decoder, 0, unhex("0000ff24"), fields) == -1, "static index beyond the table", -1, "accepted");
+    TEST_ASSERT(decode(decoder, 0, unhex("000081"), fields) == -1, "dynamic index without entries", -1, "accepted");
+    TEST_ASSERT(decode(decoder, 0, unhex("00"), fields) == -1, "truncated prefix", -1, "accepted");
+
+    TEST_ASSERT(!QPACKDecoder(220).onEncoderStream(unhex("3fbe01")), "capacity above the limit", "error", "success");
+    TEST_ASSERT(!QPACKDecoder(220).onEncoderStream(unhex("3fbd018000")), "insert referencing no entry", "error", "success");
+    TEST_ASSERT(!QPACKDecoder(64).onEncoderStream(unhex("3f21416128") + std::string(40, 'x')), "entry larger than the table", "error", "success");
+    TEST_ASSERT(QPACKDecoder(220).onEncoderStream(unhex("3fbd01c00f77")).has_value(), "incomplete insert waits", "success", "error");
+
+    TEST_ASSERT(!QPACKEncoder().onDecoderStream(unhex("84")), "acknowledgment of no section", "error", "success");
+    TEST_ASSERT(!QPACKEncoder().onDecoderStream(unhex("01")), "increment beyond the inserts", "error", "success");
+    std::cout << "Malformed input test passed" << std::endl;
+}
+
+int main() {
+    test_static_table();
+    test_examples();
+    test_encoder_round_trip();
+    test_blocked_streams();
+    test_eviction();
+    test_malformed();
+    std::cout << "All QPACK tests passed!" << std::endl;
+    return 0;
+}
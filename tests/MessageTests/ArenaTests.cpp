@@ -0,0 +1,63 @@
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <memory_resource>
+#include <string>
+#include <utility>
+
+#include "Protocols/HTTP/Message.h"
+
+#define TEST_ASSERT(condition, message, expected, actual)       \
+    do {                                                        \
+        if (!(condition)) {                                     \
+            std::cerr << "Assertion failed: " << message       \
+                      << "\n    Expected: " << expected        \
+                      << "\n    Actual:   " << actual          \
+                      << "\n    at " << __FILE__               \
+                      << ":" << __LINE__ << std::endl;         \
+            std::exit(1);                                       \
+        }                                                       \
+    } while (0)
+
+using namespace usub::server::protocols::http;
+using usub::server::component::url::QueryParams;
+
+int main() {
+    // the arena of a connection, without an upstream so every map node has to come from the block
+    alignas(std::max_align_t) std::array<std::byte, 16 * 1024> block;
+    std::pmr::monotonic_buffer_resource arena{block.data(), block.size(), std::pmr::null_memory_resource()};
+
+    Request request;
+    request.setMemoryResource(&arena);
+    request.addHeader("Host", "example.com");
+    request.addHeader("X-Request-Id", "42");
+    request.getQueryParams().addQueryParam("q", "unet");
+
+    Headers moved = std::move(request.getHeaders());
+    Headers copied = moved;
+    QueryParams moved_query = std::move(request.getQueryParams());
+
+    // the exchange is answered: the connection rebinds the maps and drops the arena
+    request.setMemoryResource(&arena);
+    arena.release();
+    std::memset(block.data(), 0xAB, block.size());
+
+    TEST_ASSERT(moved.contains("Host") && moved.at("Host").front() == "example.com",
+                "moved known header survives the arena", "example.com", "garbage");
+    TEST_ASSERT(moved.contains("X-Request-Id") && moved.at("X-Request-Id").front() == "42",
+                "moved unknown header survives the arena", "42", "garbage");
+    TEST_ASSERT(copied.contains("X-Request-Id") && copied.at("X-Request-Id").front() == "42",
+                "copied header survives the arena", "42", "garbage");
+    TEST_ASSERT(moved_query.contains("q") && moved_query.at("q").front() == "unet",
+                "moved query parameter survives the arena", "unet", "garbage");
+
+    // the request keeps working on the released arena
+    request.addHeader("X-Next", "1");
+    TEST_ASSERT(request.getHeaders().contains("X-Next"), "request reuses the arena", true, false);
+    moved.addHeader<Request>(std::string("X-Later"), std::string("2"));
+    TEST_ASSERT(moved.contains("X-Later"), "moved headers grow on the default resource", true, false);
+
+    std::cout << "All arena tests passed\n";
+    return 0;
+}
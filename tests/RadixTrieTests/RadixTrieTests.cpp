@@ -132,6 +132,113 @@ int main() {
                     "match(/ts) must fail", false, router.match(b).has_value());
     }
 
+    {
+        RadixRouter router;
+        param_constraint digits{ R"([0-9]+)", "" };
+        router.addHandler({"GET"}, "/users/{id}/posts/{post}", nullptr, {{"id",&digits}});
+        router.addHandler({"GET"}, "/users/{name}/profile",    nullptr, {});
+        router.addHandler({"GET"}, "/assets/*",                nullptr, {});
+        router.freeze();
+
+        TEST_ASSERT(router.frozen(), "freeze() must freeze", true, router.frozen());
+
+        auto a = makeRequest("GET", "/users/42/posts/7");
+        TEST_ASSERT(router.match(a).has_value(),
+                    "frozen match(/users/42/posts/7) must succeed", true, router.match(a).has_value());
+        TEST_ASSERT(a.uri_params.size() == 2 && a.uri_params["id"] == "42" && a.uri_params["post"] == "7",
+                    "params of /users/42/posts/7", "id=42 post=7", a.uri_params.size());
+        TEST_ASSERT(a.uri_params["id"].data() == a.getURL().data() + 7,
+                    "params must view the URL", "a view", "a copy");
+
+        // {id} takes "42" first, the walk backtracks to {name}
+        auto b = makeRequest("GET", "/users/42/profile");
+        TEST_ASSERT(router.match(b).has_value(),
+                    "frozen match(/users/42/profile) must succeed", true, router.match(b).has_value());
+        TEST_ASSERT(b.uri_params.size() == 1 && b.uri_params["name"] == "42" && !b.uri_params.contains("id"),
+                    "backtracking drops {id}", "name=42", b.uri_params.size());
+
+        auto c = makeRequest("GET", "/assets/css/site.css/");
+        TEST_ASSERT(router.match(c).has_value(),
+                    "frozen match(/assets/css/site.css/) must succeed", true, router.match(c).has_value());
+        TEST_ASSERT(c.uri_params["*"] == "css/site.css",
+                    "wildcard tail", "css/site.css", c.uri_params["*"]);
+
+        auto d = makeRequest("GET", "/users/x/posts/7");
+        std::string error;
+        TEST_ASSERT(!router.match(d, &error).has_value(),
+                    "frozen match(/users/x/posts/7) must fail", false, true);
+
+        router.addHandler({"GET"}, "/health", nullptr, {});
+        auto e = makeRequest("GET", "/health");
+        TEST_ASSERT(!router.frozen() && router.match(e).has_value(),
+                    "addHandler() after freeze() must unfreeze", true, router.frozen());
+    }
+
+    {
+        static_assert(constraints::isInt("-42") && !constraints::isInt("-") && !constraints::isInt("4a"));
+        static_assert(constraints::isUint("0042") && !constraints::isUint("-1") && !constraints::isUint(""));
+        static_assert(constraints::isUuid("123e4567-E89B-12d3-a456-426614174000"));
+        static_assert(!constraints::isUuid("123e4567-e89b-12d3-a456-42661417400g"));
+        static_assert(constraints::isHex("DeadBeef") && !constraints::isHex("0x1"));
+        static_assert(constraints::isSlug("hello-world_2") && !constraints::isSlug("a.b"));
+
+        RadixRouter router;
+        const param_constraint status = constraints::one_of({"open", "closed"});
+        const param_constraint code = constraints::length(2, 4);
+        param_constraint word{ R"([a-z]{3})", "Three letters" };
+        router.addHandler({"GET"}, "/orders/{id:int}",           nullptr, {});
+        router.addHandler({"GET"}, "/tickets/{status}",          nullptr, {{"status",&status}});
+        router.addHandler({"GET"}, "/codes/{code}",              nullptr, {{"code",&code}});
+        router.addHandler({"GET"}, "/objects/{id}",              nullptr, {{"id",&constraints::uuid}});
+        router.addHandler({"GET"}, "/words/{w}",                 nullptr, {{"w",&word}});
+
+        const char *good[] = {"/orders/-7", "/tickets/closed", "/codes/ab", "/codes/abcd",
+                              "/objects/123e4567-e89b-12d3-a456-426614174000", "/words/abc"};
+        const char *bad[] = {"/orders/7x", "/tickets/pending", "/codes/a", "/codes/abcde",
+                             "/objects/123e4567", "/words/abcd"};
+        for (const char *path: good) {
+            auto req = makeRequest("GET", path);
+            TEST_ASSERT(router.match(req).has_value(), "typed match must succeed", path, "no match");
+        }
+        for (const char *path: bad) {
+            auto req = makeRequest("GET", path);
+            TEST_ASSERT(!router.match(req).has_value(), "typed match must fail", path, "a match");
+        }
+
+        auto bad_status = makeRequest("GET", "/tickets/pending");
+        std::string error;
+        router.match(bad_status, &error);
+        TEST_ASSERT(error == "Must be one of: open, closed",
+                    "constraint description", "Must be one of: open, closed", error);
+    }
+
+    {
+        static_assert(methods::standard("DELETE") == Method::DELETE && methods::standard("get") == Method::UNKNOWN);
+        static_assert(MethodSet::parse("GET,HEAD").contains(Method::HEAD) && !MethodSet::parse("GET").contains(Method::POST));
+
+        RadixRouter router;
+        router.addHandler({"GET", "PROPFIND"}, "/dav", nullptr, {});
+        router.addHandler({"*"},              "/any", nullptr, {});
+
+        auto a = makeRequest("PROPFIND", "/dav");
+        TEST_ASSERT(a.getMethod() == methods::lookup("PROPFIND") && a.getMethod() != Method::UNKNOWN,
+                    "PROPFIND is interned", "an extension method", "UNKNOWN");
+        TEST_ASSERT(router.match(a) && router.match(a)->second,
+                    "PROPFIND /dav is allowed", true, false);
+
+        auto b = makeRequest("POST", "/dav");
+        auto match = router.match(b);
+        TEST_ASSERT(match && !match->second, "POST /dav is not allowed", false, true);
+        TEST_ASSERT(match->first->allowed_methods.allowHeader() == "GET, PROPFIND",
+                    "Allow of /dav", "GET, PROPFIND", match->first->allowed_methods.allowHeader());
+
+        auto c = makeRequest("BREW", "/any");
+        TEST_ASSERT(c.getMethod() == Method::UNKNOWN && router.match(c)->second,
+                    "\"*\" accepts unknown methods", true, false);
+        c.getRequestMethod() = "GET";
+        TEST_ASSERT(c.getMethod() == Method::GET, "changing the token re-interns", "GET", methods::name(c.getMethod()));
+    }
+
     {
         RadixRouter router;
         param_constraint digits{ R"([0-9]+)", "" };
@@ -0,0 +1,102 @@
+#include <iostream>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "Protocols/HTTP/RouteAutomaton.h"
+
+#define TEST_ASSERT(condition, message, expected, actual)       \
+    do {                                                        \
+        if (!(condition)) {                                     \
+            std::cerr << "Assertion failed: " << message       \
+                      << "\n    Expected: " << expected        \
+                      << "\n    Actual:   " << actual          \
+                      << "\n    at " << __FILE__               \
+                      << ":" << __LINE__ << std::endl;         \
+            std::exit(1);                                       \
+        }                                                       \
+    } while (0)
+
+using usub::server::protocols::http::RouteAutomaton;
+
+// Matches and captures must be exactly those of std::regex_match.
+void compareWithRegex(const RouteAutomaton &automaton, const std::vector<std::string> &patterns, const std::string &path) {
+    std::vector<uint32_t> expected;
+    for (uint32_t id = 0; id < patterns.size(); ++id) {
+        std::smatch match;
+        const std::regex regex(patterns[id], std::regex::ECMAScript);
+        if (!std::regex_match(path, match, regex)) continue;
+        expected.push_back(id);
+
+        std::span<const size_t> offsets;
+        TEST_ASSERT(automaton.captures(id, path, offsets), "captures() of " + patterns[id], path, "no match");
+        TEST_ASSERT(offsets.size() == 2 * (match.size() - 1), "group count of " + patterns[id], match.size() - 1, offsets.size() / 2);
+        for (size_t group = 1; group < match.size(); ++group) {
+            const size_t start = match[group].matched ? match.position(group) : RouteAutomaton::NO_OFFSET;
+            const size_t end = match[group].matched ? start + match.length(group) : RouteAutomaton::NO_OFFSET;
+            TEST_ASSERT(offsets[2 * group - 2] == start && offsets[2 * group - 1] == end,
+                        "group " + std::to_string(group) + " of " + patterns[id] + " on " + path,
+                        std::to_string(start) + ".." + std::to_string(end),
+                        std::to_string(offsets[2 * group - 2]) + ".." + std::to_string(offsets[2 * group - 1]));
+        }
+    }
+
+    std::span<const uint32_t> actual = automaton.matches(path);
+    TEST_ASSERT(std::vector<uint32_t>(actual.begin(), actual.end()) == expected,
+                "matches() of " + path, expected.size(), actual.size());
+}
+
+int main() {
+    const std::vector<std::string> patterns = {
+            R"(^/users/([^/]+)$)",
+            R"(^/users/(\d+)/posts/([a-z0-9-]+))",
+            R"(^/files/(.*))",
+            R"(^/files/(.*?)(\.tar\.gz|\.zip)?)",
+            R"(^/v(1|2)/items(?:/([0-9a-fA-F]{4,8}))?/?)",
+            R"(^/search(?:\+|%20)([^/]+))",
+            R"(^/a(b*)(b))",
+            R"(^/x((a)|b)+)",
+            R"(^/users/me)",
+            R"(^/[\w.-]+\.(css|js))",
+            R"(^/(a|ab)(c|bcd)(d*))",
+            R"(^/\x41[^\d\s]{0,2})",
+    };
+    const std::vector<std::string> paths = {
+            "/users/42", "/users/me", "/users/", "/users/42/posts/hello-world", "/users/x/posts/hello",
+            "/files/", "/files/a/b.tar.gz", "/files/a.zip", "/v1/items", "/v2/items/beef/", "/v2/items/be",
+            "/v3/items", "/search+term", "/search%20term", "/abbb", "/ab", "/xabab", "/xa", "/site.min.css",
+            "/main.js", "/.css", "/abcd", "/abcdd", "/A", "/Axy", "/A1", "", "/",
+    };
+
+    RouteAutomaton automaton;
+    for (uint32_t id = 0; id < patterns.size(); ++id) {
+        TEST_ASSERT(automaton.add(patterns[id], id), "add() must accept " + patterns[id], true, false);
+    }
+
+    for (const std::string &path: paths) compareWithRegex(automaton, patterns, path);// NFA simulation
+    automaton.compile();
+    TEST_ASSERT(automaton.hasDfa(), "compile() must build the DFA", true, automaton.hasDfa());
+    for (const std::string &path: paths) compareWithRegex(automaton, patterns, path);
+
+    {
+        RouteAutomaton unsupported;
+        TEST_ASSERT(!unsupported.add(R"(^/(a)\1)", 0), "backreferences are refused", false, true);
+        TEST_ASSERT(!unsupported.add(R"(^/(?=a)a)", 1), "lookaheads are refused", false, true);
+        TEST_ASSERT(!unsupported.add(R"(^/a\b)", 2), "word boundaries are refused", false, true);
+        TEST_ASSERT(!unsupported.add(R"(^/a$b)", 3), "inner anchors are refused", false, true);
+        TEST_ASSERT(unsupported.empty(), "refused patterns are not added", true, unsupported.empty());
+    }
+
+    {
+        // Too many DFA states for the cap: the NFA simulation takes over.
+        RouteAutomaton large;
+        TEST_ASSERT(large.add(R"(^/(?:[ab]*a[ab]{12}))", 0), "add()", true, false);
+        large.compile();
+        TEST_ASSERT(!large.hasDfa(), "the DFA must be dropped", false, large.hasDfa());
+        TEST_ASSERT(large.matches("/bbabbbbbbbbbbbb").size() == 1, "NFA match", 1, 0);
+        TEST_ASSERT(large.matches("/bbbbbbbbbbbbbb").empty(), "NFA mismatch", 0, 1);
+    }
+
+    std::cout << "All RouteAutomaton tests passed\n";
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include <iostream>
+#include <string>
+
+#include "Protocols/HTTP/StaticRouter.h"
+
+#define TEST_ASSERT(condition, message, expected, actual)       \
+    do {                                                        \
+        if (!(condition)) {                                     \
+            std::cerr << "Assertion failed: " << message       \
+                      << "\n    Expected: " << expected        \
+                      << "\n    Actual:   " << actual          \
+                      << "\n    at " << __FILE__               \
+                      << ":" << __LINE__ << std::endl;         \
+            std::exit(1);                                       \
+        }                                                       \
+    } while (0)
+
+using namespace usub::server::protocols::http;
+
+usub::uvent::task::Awaitable<void> getUser(Request &, Response &) { co_return; }
+usub::uvent::task::Awaitable<void> getMe(Request &, Response &) { co_return; }
+usub::uvent::task::Awaitable<void> postFile(Request &, Response &) { co_return; }
+usub::uvent::task::Awaitable<void> anything(Request &, Response &) { co_return; }
+
+using Router = StaticRouter<
+        StaticRoute<"GET", "/users/me", &getMe>,
+        StaticRoute<"GET,HEAD", "/users/{id:int}", &getUser>,
+        StaticRoute<"GET", "/objects/{id:uuid}/", &getUser>,
+        StaticRoute<"POST", "/files/{bucket:slug}/*", &postFile>,
+        StaticRoute<"*", "/any/{name}", &anything>>;
+
+static_assert(StaticRoute<"GET,HEAD", "/x", &getMe>::allowed_methods == MethodSet{}.add(Method::GET).add(Method::HEAD));
+static_assert(StaticRoute<"GET", "/a/{b:hex}/*", &getMe>::parsed.segments.size() == 3);
+
+// filled in place: Request has no move constructor, and its implicit copy is deprecated
+void setRequest(Request &req, const std::string &method, const std::string &path) {
+    req.getRequestMethod() = method;
+    req.getURL() = path;
+}
+
+int main() {
+    Router router;
+
+    {
+        Request req;
+        setRequest(req, "GET", "/users/me");
+        auto match = router.match(req);
+        TEST_ASSERT(match && match->second && match->first == &router.route<0>(), "/users/me takes the first route", 0, "another");
+    }
+    {
+        Request req;
+        setRequest(req, "HEAD", "/users/-42");
+        auto match = router.match(req);
+        TEST_ASSERT(match && match->second && match->first == &router.route<"/users/{id:int}">(), "/users/-42", 1, "another");
+        TEST_ASSERT(req.uri_params["id"] == "-42" && req.uri_params["id"].data() == req.getURL().data() + 7,
+                    "{id} views the URL", "-42", req.uri_params["id"]);
+    }
+    {
+        Request req;
+        setRequest(req, "GET", "/users/bob");
+        TEST_ASSERT(!router.match(req), "/users/bob is not an int", "no match", "a match");
+    }
+    {
+        Request req;
+        setRequest(req, "DELETE", "/users/1");
+        auto match = router.match(req);
+        TEST_ASSERT(match && !match->second, "DELETE /users/1 is not allowed", false, true);
+        TEST_ASSERT(match->first->allowed_methods.allowHeader() == "GET, HEAD",
+                    "Allow of /users/{id:int}", "GET, HEAD", match->first->allowed_methods.allowHeader());
+    }
+    {
+        Request good;
+        setRequest(good, "GET", "/objects/123e4567-e89b-12d3-a456-426614174000/");
+        Request no_slash;
+        setRequest(no_slash, "GET", "/objects/123e4567-e89b-12d3-a456-426614174000");
+        TEST_ASSERT(router.match(good), "uuid with the trailing slash", "a match", "none");
+        TEST_ASSERT(!router.match(no_slash), "uuid without the trailing slash", "no match", "a match");
+    }
+    {
+        Request req;
+        setRequest(req, "POST", "/files/my-bucket/a/b.txt/");
+        auto match = router.match(req);
+        TEST_ASSERT(match && match->second, "POST /files/my-bucket/a/b.txt/", "a match", "none");
+        TEST_ASSERT(req.uri_params["bucket"] == "my-bucket" && req.uri_params["*"] == "a/b.txt",
+                    "wildcard tail", "a/b.txt", req.uri_params["*"]);
+        Request empty;
+        setRequest(empty, "POST", "/files/my-bucket");
+        TEST_ASSERT(!router.match(empty), "a wildcard needs a segment", "no match", "a match");
+    }
+    {
+        Request req;
+        setRequest(req, "PURGE", "/any/thing");
+        auto match = router.match(req);
+        TEST_ASSERT(match && match->second && req.uri_params["name"] == "thing", "\"*\" takes any method", "a match", "none");
+        TEST_ASSERT(match->first->function == &anything, "the handler is a plain function pointer", "anything", "another");
+    }
+
+    std::cout << "All StaticRouter tests passed\n";
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include "server/BufferPool.h"
+
+#define TEST_ASSERT(condition, message, expected, actual)       \
+    do {                                                        \
+        if (!(condition)) {                                     \
+            std::cerr << "Assertion failed: " << message       \
+                      << "\n    Expected: " << expected        \
+                      << "\n    Actual:   " << actual          \
+                      << "\n    at " << __FILE__               \
+                      << ":" << __LINE__ << std::endl;         \
+            std::exit(1);                                       \
+        }                                                       \
+    } while (0)
+
+using namespace usub::server::net;
+
+int main() {
+    constexpr auto &classes = BufferPool::SIZE_CLASSES;
+
+    {
+        BufferPool pool;
+        TEST_ASSERT(pool.acquire(1).capacity() == classes[0], "smallest class", classes[0], pool.acquire(1).capacity());
+        TEST_ASSERT(pool.acquire(classes[0]).capacity() == classes[0], "exact fit", classes[0], pool.acquire(classes[0]).capacity());
+        TEST_ASSERT(pool.acquire(classes[0] + 1).capacity() == classes[1], "next class up", classes[1], pool.acquire(classes[0] + 1).capacity());
+        TEST_ASSERT(pool.acquire(classes.back() * 4).capacity() == classes.back(), "oversized requests get the largest class",
+                    classes.back(), pool.acquire(classes.back() * 4).capacity());
+    }
+
+    {
+        BufferPool pool;
+        BufferLease lease = pool.acquire(1);
+        const auto *buffer = &lease.buffer();
+        lease.buffer().append(reinterpret_cast<const uint8_t *>("abc"), 3);
+        TEST_ASSERT(pool.cached(0) == 0, "a leased buffer is not cached", 0, pool.cached(0));
+
+        BufferLease moved = std::move(lease);
+        TEST_ASSERT(!lease && moved && pool.cached(0) == 0, "a moved lease does not return the buffer", 0, pool.cached(0));
+        moved.reset();
+        TEST_ASSERT(!moved && pool.cached(0) == 1, "reset returns the buffer", 1, pool.cached(0));
+
+        BufferLease again = pool.acquire(100);
+        TEST_ASSERT(&again.buffer() == buffer && pool.cached(0) == 0, "a returned buffer is reused", "the same buffer", "a new one");
+        TEST_ASSERT(again.buffer().size() == 0, "a reused buffer comes back empty", 0, again.buffer().size());
+    }
+
+    {
+        // each class caches at most MAX_CACHED_BYTES of free buffers, the rest is freed
+        BufferPool pool;
+        const size_t cap = BufferPool::MAX_CACHED_BYTES / classes.back();
+        std::vector<BufferLease> leases;
+        for (size_t i = 0; i < cap + 8; ++i) {
+            leases.push_back(pool.acquire(classes.back()));
+        }
+        leases.clear();
+        TEST_ASSERT(pool.cached(classes.size() - 1) == cap, "largest class capped", cap, pool.cached(classes.size() - 1));
+        TEST_ASSERT(pool.cached(0) == 0, "other classes untouched", 0, pool.cached(0));
+    }
+
+    {
+        ReadSizer sizer;
+        TEST_ASSERT(sizer.next() == classes[0], "starts at the smallest class", classes[0], sizer.next());
+
+        // reads that fill their buffer double the next one, up to the largest class
+        size_t expected = classes[0];
+        while (expected < classes.back()) {
+            sizer.observe(sizer.next(), sizer.next());
+            expected *= 2;
+            TEST_ASSERT(sizer.next() == expected, "a full read doubles", expected, sizer.next());
+        }
+        sizer.observe(sizer.next(), sizer.next());
+        TEST_ASSERT(sizer.next() == classes.back(), "growth stops at the largest class", classes.back(), sizer.next());
+
+        // short reads decay by a quarter at a time, never below the smallest class
+        sizer.observe(sizer.next(), 100);
+        TEST_ASSERT(sizer.next() == classes.back() - classes.back() / 4, "a short read decays", classes.back() - classes.back() / 4, sizer.next());
+        for (int i = 0; i < 32; ++i) {
+            sizer.observe(sizer.next(), 100);
+        }
+        TEST_ASSERT(sizer.next() == classes[0], "decay stops at the smallest class", classes[0], sizer.next());
+
+        // a short but large read keeps its size
+        sizer.observe(classes.back(), classes[2]);
+        TEST_ASSERT(sizer.next() == classes[2], "a large short read sets the size", classes[2], sizer.next());
+    }
+
+    std::cout << "All BufferPool tests passed\n";
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "utils/ssl/EarlyData.h"
+
+#define TEST_ASSERT(condition, message, expected, actual)       \
+    do {                                                        \
+        if (!(condition)) {                                     \
+            std::cerr << "Assertion failed: " << message       \
+                      << "\n    Expected: " << expected        \
+                      << "\n    Actual:   " << actual          \
+                      << "\n    at " << __FILE__               \
+                      << ":" << __LINE__ << std::endl;         \
+            std::exit(1);                                       \
+        }                                                       \
+    } while (0)
+
+using namespace usub::utils::ssl;
+using std::chrono::seconds;
+
+namespace {
+    struct Random {
+        unsigned char bytes[SSL3_RANDOM_SIZE]{};
+    };
+
+    /// A ClientHello random whose first 8 bytes, which pick the shard, hold @p key.
+    Random randomOf(uint64_t key) {
+        Random random;
+        std::memcpy(random.bytes, &key, sizeof(key));
+        random.bytes[SSL3_RANDOM_SIZE - 1] = 0x5A;
+        return random;
+    }
+}// namespace
+
+int main() {
+    const auto now = std::chrono::steady_clock::now();
+
+    {
+        ReplayWindow replay(seconds(10));
+        const Random a = randomOf(1), b = randomOf(2);
+        TEST_ASSERT(replay.firstSeen(a.bytes, now), "a new ClientHello is accepted", true, false);
+        TEST_ASSERT(!replay.firstSeen(a.bytes, now), "a replayed ClientHello is refused", false, true);
+        TEST_ASSERT(replay.firstSeen(b.bytes, now), "another ClientHello is accepted", true, false);
+    }
+
+    {
+        // a random is remembered for the rest of its window and the whole next one
+        ReplayWindow replay(seconds(10));
+        const Random a = randomOf(3);
+        TEST_ASSERT(replay.firstSeen(a.bytes, now), "accepted", true, false);
+        TEST_ASSERT(!replay.firstSeen(a.bytes, now + seconds(10)), "refused in the next window", false, true);
+        TEST_ASSERT(replay.firstSeen(a.bytes, now + seconds(20)), "forgotten two windows later", true, false);
+
+        const Random b = randomOf(4);
+        TEST_ASSERT(replay.firstSeen(b.bytes, now + seconds(30)), "accepted", true, false);
+        TEST_ASSERT(replay.firstSeen(b.bytes, now + seconds(50)), "forgotten after a skipped window", true, false);
+    }
+
+    {
+        // a full shard refuses early data instead of accepting it unchecked, until its window turns
+        ReplayWindow replay(seconds(10));
+        for (uint64_t i = 0; i < REPLAY_WINDOW_SHARD_CAPACITY; ++i) {
+            const Random random = randomOf(i * REPLAY_WINDOW_SHARDS);
+            TEST_ASSERT(replay.firstSeen(random.bytes, now), "accepted while the shard has room", true, i);
+        }
+        const Random overflow = randomOf(REPLAY_WINDOW_SHARD_CAPACITY * REPLAY_WINDOW_SHARDS);
+        TEST_ASSERT(!replay.firstSeen(overflow.bytes, now), "a full shard refuses", false, true);
+        const Random other_shard = randomOf(1);
+        TEST_ASSERT(replay.firstSeen(other_shard.bytes, now), "other shards still accept", true, false);
+        TEST_ASSERT(replay.firstSeen(overflow.bytes, now + seconds(10)), "the shard accepts again in the next window", true, false);
+        const Random first = randomOf(0);
+        TEST_ASSERT(!replay.firstSeen(first.bytes, now + seconds(10)), "while still refusing the previous window's", false, true);
+    }
+
+    std::cout << "All early data tests passed\n";
+    return 0;
+}
@@ -0,0 +1,460 @@
+#include <chrono>
+#include <coroutine>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <uvent/Uvent.h>
+
+#include "Protocols/HTTP/HTTP2.h"
+#include "Protocols/HTTP/StaticRouter.h"
+
+#define TEST_ASSERT(condition, message, expected, actual)       \
+    do {                                                        \
+        if (!(condition)) {                                     \
+            std::cerr << "Assertion failed: " << message       \
+                      << "\n    Expected: " << expected        \
+                      << "\n    Actual:   " << actual          \
+                      << "\n    at " << __FILE__               \
+                      << ":" << __LINE__ << std::endl;         \
+            std::exit(1);                                       \
+        }                                                       \
+    } while (0)
+
+using namespace usub::server::protocols::http;
+using usub::server::configuration::HTTP2Config;
+using usub::uvent::task::Awaitable;
+
+namespace {
+    /// Holds handlers until released.
+    struct Gate {
+        struct Wait {
+            Gate &gate;
+            bool await_ready() const noexcept { return gate.open; }
+            void await_suspend(std::coroutine_handle<> handle) { gate.waiters.push_back(handle); }
+            void await_resume() const noexcept {}
+        };
+
+        Wait wait() { return Wait{*this}; }
+
+        void release() {
+            this->open = true;
+            for (const auto waiters = std::exchange(this->waiters, {}); auto handle: waiters) handle.resume();
+        }
+
+        std::vector<std::coroutine_handle<>> waiters;
+        bool open{false};
+    };
+
+    Gate slow_gate;
+    constexpr size_t BIG_BODY = 100000;
+
+    Awaitable<void> fast(Request &, Response &response) {
+        response.setStatus(200);
+        response.setBody("fast");
+        co_return;
+    }
+
+    Awaitable<void> slow(Request &, Response &response) {
+        co_await slow_gate.wait();
+        response.setStatus(200);
+        response.setBody("slow");
+    }
+
+    Awaitable<void> big(Request &, Response &response) {
+        response.setStatus(200);
+        response.setBody(std::string(BIG_BODY, 'b'));
+        co_return;
+    }
+
+    Awaitable<void> upload(Request &, Response &response) {
+        response.setStatus(204);
+        co_return;
+    }
+
+    using Router = StaticRouter<
+            StaticRoute<"GET", "/fast", &fast>,
+            StaticRoute<"GET", "/slow", &slow>,
+            StaticRoute<"GET", "/big", &big>,
+            StaticRoute<"POST", "/upload", &upload>>;
+
+    struct Frame {
+        http2::FrameType type;
+        uint8_t flags;
+        uint32_t stream_id;
+        std::string payload;
+
+        http2::ErrorCode error() const {
+            // RST_STREAM carries the code first, GOAWAY after the last stream id
+            const size_t at = this->type == http2::FrameType::GOAWAY ? 4 : 0;
+            return static_cast<http2::ErrorCode>(http2::readUint32(this->payload.data() + at));
+        }
+    };
+
+    std::string frame(http2::FrameType type, uint8_t flags, uint32_t stream_id, std::string_view payload = {}) {
+        std::string out;
+        http2::appendFrameHeader(out, payload.size(), type, flags, stream_id);
+        out.append(payload);
+        return out;
+    }
+
+    /**
+     * @brief The client side of one connection: feeds bytes to an HTTP2 object and parses what it writes.
+     */
+    struct Peer {
+        explicit Peer(const HTTP2Config &config)
+            : http2(std::make_shared<Router>(), config, [this](std::string_view out) { return this->write(out); }) {}
+
+        Awaitable<bool> write(std::string_view out) {
+            this->wire.append(out);
+            co_return true;
+        }
+
+        /// Feeds @p data, lets the started handlers run, then flushes.
+        Awaitable<bool> send(std::string_view data) {
+            const bool open = this->http2.readCallback(data);
+            co_await usub::uvent::system::this_coroutine::sleep_for(std::chrono::milliseconds(1));
+            co_await this->http2.flush();
+            co_return open;
+        }
+
+        /// The frames written since the last call; response header blocks are decoded into status.
+        std::vector<Frame> frames() {
+            std::vector<Frame> out;
+            size_t pos = 0;
+            while (this->wire.size() - pos >= http2::FRAME_HEADER_SIZE) {
+                const auto *header = reinterpret_cast<const uint8_t *>(this->wire.data() + pos);
+                const size_t length = (static_cast<size_t>(header[0]) << 16) | (static_cast<size_t>(header[1]) << 8) | header[2];
+                Frame frame{static_cast<http2::FrameType>(header[3]), header[4],
+                            http2::readUint32(this->wire.data() + pos + 5) & 0x7fffffff,
+                            this->wire.substr(pos + http2::FRAME_HEADER_SIZE, length)};
+                if (frame.type == http2::FrameType::HEADERS) {
+                    const auto decoded = this->decoder.decode(frame.payload, [&](std::string_view name, std::string_view value) {
+                        if (name == ":status") this->status[frame.stream_id] = std::string(value);
+                        return true;
+                    });
+                    TEST_ASSERT(decoded.has_value(), "response header block decodes", "ok", "error");
+                }
+                out.push_back(std::move(frame));
+                pos += http2::FRAME_HEADER_SIZE + length;
+            }
+            TEST_ASSERT(pos == this->wire.size(), "only whole frames are written", this->wire.size(), pos);
+            this->wire.clear();
+            return out;
+        }
+
+        std::string request(uint32_t stream_id, std::string_view method, std::string_view path, bool end_stream = true) {
+            return frame(http2::FrameType::HEADERS, http2::END_HEADERS | (end_stream ? http2::END_STREAM : 0), stream_id,
+                         this->block(method, path));
+        }
+
+        std::string block(std::string_view method, std::string_view path) {
+            std::string block;
+            this->encoder.begin(block);
+            this->encoder.encode(block, ":method", method);
+            this->encoder.encode(block, ":scheme", "http");
+            this->encoder.encode(block, ":path", path);
+            this->encoder.encode(block, ":authority", "localhost");
+            return block;
+        }
+
+        std::string wire;
+        std::map<uint32_t, std::string> status;
+        usub::server::component::HPACKEncoder encoder;
+        usub::server::component::HPACKDecoder decoder;
+        HTTP2<Router> http2;
+    };
+
+    std::string code(uint32_t value) {
+        std::string out;
+        http2::appendUint32(out, value);
+        return out;
+    }
+
+    /// The preface and an empty SETTINGS, or one setting.
+    std::string preface(std::string_view settings = {}) {
+        return std::string(http2::PREFACE) + frame(http2::FrameType::SETTINGS, 0, 0, settings);
+    }
+
+    size_t count(const std::vector<Frame> &frames, http2::FrameType type, uint32_t stream_id) {
+        size_t n = 0;
+        for (const Frame &f: frames) n += f.type == type && f.stream_id == stream_id;
+        return n;
+    }
+
+    const Frame *find(const std::vector<Frame> &frames, http2::FrameType type, uint32_t stream_id) {
+        for (const Frame &f: frames) {
+            if (f.type == type && f.stream_id == stream_id) return &f;
+        }
+        return nullptr;
+    }
+
+    Awaitable<void> prefaceAndSettings() {
+        // `P` and `PR` may still start a POST, PUT or PATCH
+        TEST_ASSERT(http2::mayBePreface("P") && !http2::isPreface("P"), "undecided on P", true, false);
+        TEST_ASSERT(http2::mayBePreface("PR") && !http2::isPreface("PR"), "undecided on PR", true, false);
+        TEST_ASSERT(!http2::mayBePreface("PO") && !http2::isPreface("POST / HTTP/1.1"), "POST is HTTP/1", false, true);
+        TEST_ASSERT(!http2::mayBePreface("PRI") && http2::isPreface("PRI"), "PRI is the preface", true, false);
+        TEST_ASSERT(!http2::mayBePreface("GET") && !http2::isPreface("G"), "GET is HTTP/1", false, true);
+
+        HTTP2Config config{};
+        Peer peer(config);
+        // the preface may arrive split anywhere
+        const std::string first = preface();
+        TEST_ASSERT(co_await peer.send(std::string_view(first).substr(0, 5)), "partial preface accepted", true, false);
+        TEST_ASSERT(co_await peer.send(std::string_view(first).substr(5)), "rest of the preface accepted", true, false);
+        auto frames = peer.frames();
+        TEST_ASSERT(frames.size() == 3, "SETTINGS, WINDOW_UPDATE, SETTINGS ACK", 3, frames.size());
+        TEST_ASSERT(frames[0].type == http2::FrameType::SETTINGS && frames[0].flags == 0 && frames[0].payload.size() == 24,
+                    "server SETTINGS first", 24, frames[0].payload.size());
+        TEST_ASSERT(frames[1].type == http2::FrameType::WINDOW_UPDATE && frames[1].stream_id == 0 &&
+                            http2::readUint32(frames[1].payload.data()) == config.connection_window_size - http2::DEFAULT_WINDOW_SIZE,
+                    "connection window raised", config.connection_window_size - http2::DEFAULT_WINDOW_SIZE,
+                    http2::readUint32(frames[1].payload.data()));
+        TEST_ASSERT(frames[2].type == http2::FrameType::SETTINGS && frames[2].flags == http2::ACK && frames[2].payload.empty(),
+                    "client SETTINGS acknowledged", "ACK", static_cast<int>(frames[2].flags));
+
+        // an ACK of the server's SETTINGS is not answered, a PING is
+        TEST_ASSERT(co_await peer.send(frame(http2::FrameType::SETTINGS, http2::ACK, 0) +
+                                       frame(http2::FrameType::PING, 0, 0, "12345678")),
+                    "ACK and PING accepted", true, false);
+        frames = peer.frames();
+        TEST_ASSERT(frames.size() == 1 && frames[0].type == http2::FrameType::PING && frames[0].flags == http2::ACK &&
+                            frames[0].payload == "12345678",
+                    "PING echoed", "PING ACK", frames.size());
+
+        TEST_ASSERT(co_await peer.send(peer.request(1, "GET", "/fast")), "request accepted", true, false);
+        frames = peer.frames();
+        TEST_ASSERT(peer.status[1] == "200", "request answered", "200", peer.status[1]);
+        const Frame *data = find(frames, http2::FrameType::DATA, 1);
+        TEST_ASSERT(data && data->payload == "fast" && (data->flags & http2::END_STREAM), "body ends the stream", "fast",
+                    (data ? data->payload : "none"));
+        TEST_ASSERT(peer.http2.idle(), "no stream left open", true, false);
+        co_await peer.http2.drain();
+
+        Peer bad(config);
+        TEST_ASSERT(!co_await bad.send("GET / HTTP/1.1\r\n\r\n"), "a wrong preface fails the connection", false, true);
+        frames = bad.frames();
+        TEST_ASSERT(!frames.empty() && frames.back().type == http2::FrameType::GOAWAY &&
+                            frames.back().error() == http2::ErrorCode::PROTOCOL_ERROR,
+                    "wrong preface", "GOAWAY PROTOCOL_ERROR", frames.size());
+        TEST_ASSERT(bad.http2.finished(), "connection finished", true, false);
+        co_await bad.http2.drain();
+    }
+
+    Awaitable<void> concurrencyLimit() {
+        HTTP2Config config{};
+        config.max_concurrent_streams = 2;
+        Peer peer(config);
+        co_await peer.send(preface());
+        peer.frames();
+
+        TEST_ASSERT(co_await peer.send(peer.request(1, "GET", "/slow") + peer.request(3, "GET", "/slow") +
+                                       peer.request(5, "GET", "/fast")),
+                    "requests accepted", true, false);
+        auto frames = peer.frames();
+        TEST_ASSERT(peer.http2.running(), "slow handlers running", true, false);
+        const Frame *refused = find(frames, http2::FrameType::RST_STREAM, 5);
+        TEST_ASSERT(refused && refused->error() == http2::ErrorCode::REFUSED_STREAM, "third stream refused", "REFUSED_STREAM",
+                    (refused ? static_cast<uint32_t>(refused->error()) : 0));
+
+        // resetting the streams does not stop their handlers, which still count against the limit
+        TEST_ASSERT(co_await peer.send(frame(http2::FrameType::RST_STREAM, 0, 1, code(0x8)) +
+                                       frame(http2::FrameType::RST_STREAM, 0, 3, code(0x8)) + peer.request(7, "GET", "/fast")),
+                    "resets accepted", true, false);
+        frames = peer.frames();
+        refused = find(frames, http2::FrameType::RST_STREAM, 7);
+        TEST_ASSERT(refused && refused->error() == http2::ErrorCode::REFUSED_STREAM, "refused while reset handlers run",
+                    "REFUSED_STREAM", (refused ? static_cast<uint32_t>(refused->error()) : 0));
+        TEST_ASSERT(peer.http2.idle() && peer.http2.running(), "no stream open, handlers still running", true, false);
+
+        slow_gate.release();
+        co_await peer.http2.flush();
+        frames = peer.frames();
+        TEST_ASSERT(count(frames, http2::FrameType::HEADERS, 1) == 0 && count(frames, http2::FrameType::HEADERS, 3) == 0,
+                    "reset streams are not answered", 0, frames.size());
+        TEST_ASSERT(!peer.http2.running(), "handlers finished", false, true);
+
+        TEST_ASSERT(co_await peer.send(peer.request(9, "GET", "/fast")), "request accepted", true, false);
+        peer.frames();
+        TEST_ASSERT(peer.status[9] == "200", "served once the handlers returned", "200", peer.status[9]);
+        co_await peer.http2.drain();
+        slow_gate = Gate{};
+    }
+
+    Awaitable<void> resetBudget() {
+        Peer peer(HTTP2Config{});
+        co_await peer.send(preface());
+        peer.frames();
+
+        uint32_t stream_id = 1;
+        auto open_and_reset = [&](size_t n) {
+            std::string out;
+            for (size_t i = 0; i < n; ++i, stream_id += 2) {
+                out += peer.request(stream_id, "GET", "/fast");
+                out += frame(http2::FrameType::RST_STREAM, 0, stream_id, code(0x8));
+            }
+            return out;
+        };
+        TEST_ASSERT(co_await peer.send(open_and_reset(http2::RESET_BUDGET)), "resets within the budget accepted", true, false);
+        auto frames = peer.frames();
+        TEST_ASSERT(frames.empty(), "nothing answered", 0, frames.size());
+
+        // every response earns one more reset
+        TEST_ASSERT(co_await peer.send(peer.request(stream_id, "GET", "/fast")), "request accepted", true, false);
+        peer.frames();
+        TEST_ASSERT(peer.status[stream_id] == "200", "request answered", "200", peer.status[stream_id]);
+        stream_id += 2;
+        TEST_ASSERT(co_await peer.send(open_and_reset(1)), "earned reset accepted", true, false);
+        peer.frames();
+
+        TEST_ASSERT(!co_await peer.send(open_and_reset(1)), "a reset past the budget fails the connection", false, true);
+        frames = peer.frames();
+        TEST_ASSERT(!frames.empty() && frames.back().type == http2::FrameType::GOAWAY &&
+                            frames.back().error() == http2::ErrorCode::ENHANCE_YOUR_CALM,
+                    "rapid reset", "GOAWAY ENHANCE_YOUR_CALM", frames.size());
+        co_await peer.http2.drain();
+    }
+
+    Awaitable<void> oversizedData() {
+        HTTP2Config config{};
+        config.max_frame_size = 131072;
+        {
+            // over the stream window: the stream is reset
+            Peer peer(config);
+            co_await peer.send(preface());
+            peer.frames();
+            const std::string body(static_cast<size_t>(config.initial_window_size) + 1, 'd');
+            TEST_ASSERT(co_await peer.send(peer.request(1, "POST", "/upload", false) +
+                                           frame(http2::FrameType::DATA, http2::END_STREAM, 1, body)),
+                        "stream error keeps the connection", true, false);
+            const auto frames = peer.frames();
+            const Frame *reset = find(frames, http2::FrameType::RST_STREAM, 1);
+            TEST_ASSERT(reset && reset->error() == http2::ErrorCode::FLOW_CONTROL_ERROR, "stream window exceeded",
+                        "FLOW_CONTROL_ERROR", (reset ? static_cast<uint32_t>(reset->error()) : 0));
+            TEST_ASSERT(!peer.http2.running() && peer.http2.idle(), "handler not run", true, false);
+            co_await peer.http2.drain();
+        }
+        {
+            // over the connection window: the connection fails
+            config.connection_window_size = http2::DEFAULT_WINDOW_SIZE;
+            Peer peer(config);
+            co_await peer.send(preface());
+            peer.frames();
+            const std::string body(http2::DEFAULT_WINDOW_SIZE + 1, 'd');
+            TEST_ASSERT(!co_await peer.send(peer.request(1, "POST", "/upload", false) +
+                                            frame(http2::FrameType::DATA, http2::END_STREAM, 1, body)),
+                        "connection error", false, true);
+            const auto frames = peer.frames();
+            TEST_ASSERT(!frames.empty() && frames.back().type == http2::FrameType::GOAWAY &&
+                                frames.back().error() == http2::ErrorCode::FLOW_CONTROL_ERROR,
+                        "connection window exceeded", "GOAWAY FLOW_CONTROL_ERROR", frames.size());
+            co_await peer.http2.drain();
+        }
+    }
+
+    Awaitable<void> continuation() {
+        HTTP2Config config{};
+        config.max_header_list_size = 1024;
+        Peer peer(config);
+        co_await peer.send(preface());
+        peer.frames();
+
+        // a block split over CONTINUATION frames is assembled
+        const std::string block = peer.block("GET", "/fast");
+        const std::string split = frame(http2::FrameType::HEADERS, http2::END_STREAM, 1, std::string_view(block).substr(0, 3)) +
+                                  frame(http2::FrameType::CONTINUATION, 0, 1, std::string_view(block).substr(3, 2)) +
+                                  frame(http2::FrameType::CONTINUATION, http2::END_HEADERS, 1, std::string_view(block).substr(5));
+        TEST_ASSERT(co_await peer.send(split), "split block accepted", true, false);
+        peer.frames();
+        TEST_ASSERT(peer.status[1] == "200", "split request answered", "200", peer.status[1]);
+
+        // past maxHeaderBlock(), here one max_frame_size, it is not buffered further
+        const std::string filler(static_cast<size_t>(config.max_frame_size), '\0');
+        TEST_ASSERT(!co_await peer.send(frame(http2::FrameType::HEADERS, http2::END_STREAM, 3, filler) +
+                                        frame(http2::FrameType::CONTINUATION, 0, 3, "x")),
+                    "oversized block fails the connection", false, true);
+        const auto frames = peer.frames();
+        TEST_ASSERT(!frames.empty() && frames.back().type == http2::FrameType::GOAWAY &&
+                            frames.back().error() == http2::ErrorCode::ENHANCE_YOUR_CALM,
+                    "header block too large", "GOAWAY ENHANCE_YOUR_CALM", frames.size());
+        co_await peer.http2.drain();
+    }
+
+    Awaitable<void> interleavedData() {
+        Peer peer(HTTP2Config{});
+        // stream windows start closed, so both responses wait for their WINDOW_UPDATE
+        std::string settings;
+        settings.push_back(0);
+        settings.push_back(static_cast<char>(http2::Setting::INITIAL_WINDOW_SIZE));
+        http2::appendUint32(settings, 0);
+        co_await peer.send(preface(settings));
+        peer.frames();
+
+        co_await peer.send(peer.request(1, "GET", "/big") + peer.request(3, "GET", "/big"));
+        auto frames = peer.frames();
+        TEST_ASSERT(peer.status[1] == "200" && peer.status[3] == "200", "both answered", "200", peer.status[1] + peer.status[3]);
+        TEST_ASSERT(count(frames, http2::FrameType::DATA, 1) + count(frames, http2::FrameType::DATA, 3) == 0,
+                    "no DATA without stream window", 0, frames.size());
+
+        co_await peer.send(frame(http2::FrameType::WINDOW_UPDATE, 0, 1, code(BIG_BODY)) +
+                           frame(http2::FrameType::WINDOW_UPDATE, 0, 3, code(BIG_BODY)));
+        std::map<uint32_t, size_t> sent;
+        std::vector<uint32_t> order;
+        for (const Frame &f: peer.frames()) {
+            if (f.type != http2::FrameType::DATA) continue;
+            sent[f.stream_id] += f.payload.size();
+            order.push_back(f.stream_id);
+            TEST_ASSERT(f.payload.size() <= http2::DEFAULT_FRAME_SIZE, "frames fit the peer's max frame size",
+                        http2::DEFAULT_FRAME_SIZE, f.payload.size());
+        }
+        TEST_ASSERT(sent[1] + sent[3] == http2::DEFAULT_WINDOW_SIZE, "connection window used up", http2::DEFAULT_WINDOW_SIZE,
+                    sent[1] + sent[3]);
+        for (size_t i = 1; i < order.size(); ++i) {
+            TEST_ASSERT(order[i] != order[i - 1], "streams take turns", "alternating", order[i]);
+        }
+
+        // the rest follows the connection WINDOW_UPDATE, still taking turns while both have data
+        co_await peer.send(frame(http2::FrameType::WINDOW_UPDATE, 0, 0, code(2 * BIG_BODY)));
+        std::map<uint32_t, bool> ended;
+        order.clear();
+        for (const Frame &f: peer.frames()) {
+            if (f.type != http2::FrameType::DATA) continue;
+            TEST_ASSERT(!ended[f.stream_id], "nothing after END_STREAM", false, true);
+            sent[f.stream_id] += f.payload.size();
+            ended[f.stream_id] = f.flags & http2::END_STREAM;
+            order.push_back(f.stream_id);
+        }
+        TEST_ASSERT(sent[1] == BIG_BODY && sent[3] == BIG_BODY, "bodies complete", BIG_BODY, std::to_string(sent[1]) + "/" + std::to_string(sent[3]));
+        TEST_ASSERT(ended[1] && ended[3], "both streams ended", true, false);
+        for (size_t i = 1; i < order.size(); ++i) {
+            TEST_ASSERT(order[i] != order[i - 1], "streams take turns", "alternating", order[i]);
+        }
+        TEST_ASSERT(peer.http2.idle(), "no stream left open", true, false);
+        co_await peer.http2.drain();
+    }
+
+    usub::Uvent *uvent = nullptr;
+
+    Awaitable<void> runTests() {
+        co_await prefaceAndSettings();
+        co_await concurrencyLimit();
+        co_await resetBudget();
+        co_await oversizedData();
+        co_await continuation();
+        co_await interleavedData();
+        std::cout << "HTTP2 tests passed" << std::endl;
+        uvent->stop();
+    }
+}// namespace
+
+int main() {
+    usub::Uvent loop(1);
+    uvent = &loop;
+    usub::uvent::system::co_spawn(runTests());
+    loop.run();
+    return 0;
+}
@@ -0,0 +1,142 @@
+#include <arpa/inet.h>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <system_error>
+#include <unistd.h>
+#include <vector>
+
+#include "server/IoUring.h"
+
+#define TEST_ASSERT(condition, message, expected, actual)       \
+    do {                                                        \
+        if (!(condition)) {                                     \
+            std::cerr << "Assertion failed: " << message       \
+                      << "\n    Expected: " << expected        \
+                      << "\n    Actual:   " << actual          \
+                      << "\n    at " << __FILE__               \
+                      << ":" << __LINE__ << std::endl;         \
+            std::exit(1);                                       \
+        }                                                       \
+    } while (0)
+
+using namespace usub::server::net;
+
+namespace {
+    void prepNop(io_uring_sqe *sqe, uint64_t user_data) {
+        sqe->opcode = IORING_OP_NOP;
+        sqe->user_data = user_data;
+    }
+
+    std::vector<uint64_t> reap(IoUring &ring) {
+        std::vector<uint64_t> seen;
+        ring.forEachCompletion([&](const io_uring_cqe &cqe) { seen.push_back(cqe.user_data); });
+        return seen;
+    }
+
+    /// Waits until the loop's eventfd is signalled, then dispatches; false on timeout.
+    bool dispatchOnce(IoUringLoop &loop, std::vector<int> *accepted = nullptr) {
+        pollfd pfd{loop.eventFd(), POLLIN, 0};
+        if (::poll(&pfd, 1, 2000) != 1) return false;
+        uint64_t counter;
+        [[maybe_unused]] auto ignored = ::read(loop.eventFd(), &counter, sizeof(counter));
+        const std::vector<int> &fds = loop.dispatch();
+        if (accepted) accepted->insert(accepted->end(), fds.begin(), fds.end());
+        return true;
+    }
+
+    int connectTo(const sockaddr_in &addr) {
+        const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0 || ::connect(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) < 0) {
+            throw std::system_error(errno, std::generic_category(), "connect to loopback");
+        }
+        return fd;
+    }
+
+    int listenLoopback(sockaddr_in &addr) {
+        const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (fd < 0 || ::bind(fd, reinterpret_cast<sockaddr *>(&addr), len) < 0 || ::listen(fd, 16) < 0 ||
+            ::getsockname(fd, reinterpret_cast<sockaddr *>(&addr), &len) < 0) {
+            throw std::system_error(errno, std::generic_category(), "listen on loopback");
+        }
+        return fd;
+    }
+}// namespace
+
+int main() {
+    try {
+        IoUring probe(4);
+    } catch (const std::system_error &e) {
+        std::cout << "io_uring unavailable (" << e.what() << "), IoUring tests skipped\n";
+        return 0;
+    }
+
+    {
+        IoUring ring(4);
+        io_uring_sqe *sqes[5]{};
+        TEST_ASSERT(!ring.sqes(sqes, 5), "a chain longer than the ring is refused", false, true);
+        TEST_ASSERT(ring.submit() == 0, "a refused chain reserves nothing", 0, "queued SQEs");
+
+        // two filled SQEs leave room for two: the chain of three makes them go out first, then fits whole
+        prepNop(ring.sqe(), 1);
+        prepNop(ring.sqe(), 2);
+        TEST_ASSERT(ring.sqes(sqes, 3), "a chain fits once the queue was submitted", true, false);
+        const std::vector<uint64_t> early = reap(ring);
+        TEST_ASSERT(early == (std::vector<uint64_t>{1, 2}), "only the filled SQEs were submitted", 2, early.size());
+
+        for (unsigned i = 0; i < 3; ++i) {
+            prepNop(sqes[i], 3 + i);
+            if (i < 2) sqes[i]->flags |= IOSQE_IO_LINK;
+        }
+        TEST_ASSERT(ring.submit() == 3, "the chain goes out in one submit", 3, "fewer");
+        const std::vector<uint64_t> chain = reap(ring);
+        TEST_ASSERT(chain == (std::vector<uint64_t>{3, 4, 5}), "the chain completes in order, no untagged SQE",
+                    3, chain.size());
+    }
+
+    {
+        // accept and receive through the loop, then finish the connection with its receive still armed
+        IoUringLoop loop(8, 4, 4096);
+        sockaddr_in addr{};
+        const int listen_fd = listenLoopback(addr);
+        loop.startAccept(listen_fd);
+
+        std::vector<int> fds;
+        const int client = connectTo(addr);
+        TEST_ASSERT(dispatchOnce(loop, &fds) && fds.size() == 1, "first connection accepted", 1, fds.size());
+        const int other = connectTo(addr);
+        TEST_ASSERT(dispatchOnce(loop, &fds) && fds.size() == 2, "the multishot accept stays armed", 2, fds.size());
+        TEST_ASSERT(loop.dispatch().empty(), "accepted descriptors are returned once", 0, "more");
+        ::close(fds[1]);
+        ::close(other);
+
+        UringConnection &conn = loop.open(fds[0]);
+        const std::string request = "GET / HTTP/1.1\r\n\r\n";
+        TEST_ASSERT(::write(client, request.data(), request.size()) == static_cast<ssize_t>(request.size()), "write", request.size(), "short");
+        TEST_ASSERT(dispatchOnce(loop), "receive completes", "a completion", "timeout");
+        TEST_ASSERT(conn.received.size() == 1 && !conn.eof, "one chunk received", 1, conn.received.size());
+        const auto [bid, len] = conn.received.front();
+        conn.received.pop_front();
+        TEST_ASSERT(loop.data(bid, len) == request, "received bytes", request, loop.data(bid, len));
+        loop.recycle(bid);
+
+        loop.finish(conn);
+        TEST_ASSERT(dispatchOnce(loop), "the receive is cancelled", "a completion", "timeout");
+        char byte;
+        TEST_ASSERT(::read(client, &byte, 1) == 0, "the connection is closed once the kernel released it", 0, "data or error");
+
+        ::close(client);
+        ::close(listen_fd);
+    }
+
+    std::cout << "All IoUring tests passed\n";
+    return 0;
+}
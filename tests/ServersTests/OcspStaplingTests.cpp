@@ -0,0 +1,220 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <unistd.h>
+
+#include <openssl/evp.h>
+#include <openssl/ocsp.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+
+#include "utils/ssl/OcspStapling.h"
+
+#define TEST_ASSERT(condition, message, expected, actual)       \
+    do {                                                        \
+        if (!(condition)) {                                     \
+            std::cerr << "Assertion failed: " << message       \
+                      << "\n    Expected: " << expected        \
+                      << "\n    Actual:   " << actual          \
+                      << "\n    at " << __FILE__               \
+                      << ":" << __LINE__ << std::endl;         \
+            std::exit(1);                                       \
+        }                                                       \
+    } while (0)
+
+using namespace usub::utils::ssl;
+using std::chrono::hours;
+using std::chrono::seconds;
+
+namespace {
+    struct Identity {
+        EVP_PKEY *key{nullptr};
+        X509 *cert{nullptr};
+    };
+
+    /// A certificate for @p name, signed by @p issuer or by itself when null.
+    Identity makeIdentity(const char *name, const Identity *issuer, long serial) {
+        Identity identity{EVP_EC_gen("P-256"), X509_new()};
+        X509_set_version(identity.cert, 2);
+        ASN1_INTEGER_set(X509_get_serialNumber(identity.cert), serial);
+        X509_gmtime_adj(X509_getm_notBefore(identity.cert), -3600);
+        X509_gmtime_adj(X509_getm_notAfter(identity.cert), 24 * 3600);
+        X509_NAME_add_entry_by_txt(X509_get_subject_name(identity.cert), "CN", MBSTRING_ASC,
+                                   reinterpret_cast<const unsigned char *>(name), -1, -1, 0);
+        X509_set_issuer_name(identity.cert, X509_get_subject_name(issuer ? issuer->cert : identity.cert));
+        X509_set_pubkey(identity.cert, identity.key);
+        X509_sign(identity.cert, issuer ? issuer->key : identity.key, EVP_sha256());
+        return identity;
+    }
+
+    void freeIdentity(Identity &identity) {
+        X509_free(identity.cert);
+        EVP_PKEY_free(identity.key);
+    }
+
+    /// A server context for @p leaf whose chain holds @p ca, as a certificate chain file would.
+    SSL_CTX *serverContext(const Identity &leaf, const Identity &ca) {
+        SSL_CTX *ctx = SSL_CTX_new(TLS_server_method());
+        SSL_CTX_use_certificate(ctx, leaf.cert);
+        SSL_CTX_use_PrivateKey(ctx, leaf.key);
+        SSL_CTX_add1_chain_cert(ctx, ca.cert);
+        return ctx;
+    }
+
+    /// A DER OCSP response reporting @p leaf good from @p this_update to @p next_update, signed by @p signer.
+    std::string makeResponse(const Identity &leaf, const Identity &ca, const Identity &signer, long this_update,
+                             long next_update) {
+        OCSP_BASICRESP *basic = OCSP_BASICRESP_new();
+        OCSP_CERTID *id = OCSP_cert_to_id(nullptr, leaf.cert, ca.cert);
+        ASN1_TIME *from = X509_gmtime_adj(nullptr, this_update);
+        ASN1_TIME *until = X509_gmtime_adj(nullptr, next_update);
+        OCSP_basic_add1_status(basic, id, V_OCSP_CERTSTATUS_GOOD, 0, nullptr, from, until);
+        OCSP_basic_sign(basic, signer.cert, signer.key, EVP_sha256(), nullptr, 0);
+        OCSP_RESPONSE *response = OCSP_response_create(OCSP_RESPONSE_STATUS_SUCCESSFUL, basic);
+
+        unsigned char *out = nullptr;
+        const int len = i2d_OCSP_RESPONSE(response, &out);
+        std::string der(reinterpret_cast<const char *>(out), static_cast<size_t>(len));
+        OPENSSL_free(out);
+        OCSP_RESPONSE_free(response);
+        ASN1_TIME_free(until);
+        ASN1_TIME_free(from);
+        OCSP_CERTID_free(id);
+        OCSP_BASICRESP_free(basic);
+        return der;
+    }
+
+    /// Runs a handshake against @p server_ctx over a BIO pair, returns the response stapled to it, if any.
+    std::optional<std::string> handshake(SSL_CTX *server_ctx, bool request_status) {
+        SSL_CTX *client_ctx = SSL_CTX_new(TLS_client_method());
+        SSL *client = SSL_new(client_ctx);
+        SSL *server = SSL_new(server_ctx);
+        BIO *client_bio = nullptr;
+        BIO *server_bio = nullptr;
+        BIO_new_bio_pair(&client_bio, 0, &server_bio, 0);
+        SSL_set_bio(client, client_bio, client_bio);
+        SSL_set_bio(server, server_bio, server_bio);
+        SSL_set_connect_state(client);
+        SSL_set_accept_state(server);
+        if (request_status) SSL_set_tlsext_status_type(client, TLSEXT_STATUSTYPE_ocsp);
+
+        bool client_done = false;
+        bool server_done = false;
+        for (int round = 0; round < 100 && !(client_done && server_done); ++round) {
+            if (!client_done) client_done = SSL_do_handshake(client) == 1;
+            if (!server_done) server_done = SSL_do_handshake(server) == 1;
+        }
+        TEST_ASSERT(client_done && server_done, "handshake completes", true, false);
+
+        std::optional<std::string> stapled;
+        const unsigned char *response = nullptr;
+        const long len = SSL_get_tlsext_status_ocsp_resp(client, &response);
+        if (response && len > 0) stapled.emplace(reinterpret_cast<const char *>(response), static_cast<size_t>(len));
+        SSL_free(server);
+        SSL_free(client);
+        SSL_CTX_free(client_ctx);
+        return stapled;
+    }
+
+    void expectStats(const OcspStapler &stapler, uint64_t stapled, uint64_t missing, uint64_t refreshed, uint64_t failed) {
+        const OcspStapler::Stats stats = stapler.stats();
+        TEST_ASSERT(stats.stapled == stapled, "stapled handshakes", stapled, stats.stapled);
+        TEST_ASSERT(stats.missing == missing, "handshakes without a response", missing, stats.missing);
+        TEST_ASSERT(stats.refreshed == refreshed, "accepted responses", refreshed, stats.refreshed);
+        TEST_ASSERT(stats.failed == failed, "rejected fetches", failed, stats.failed);
+    }
+}// namespace
+
+int main() {
+    Identity ca = makeIdentity("Test CA", nullptr, 1);
+    Identity other_ca = makeIdentity("Other CA", nullptr, 2);
+    Identity leaf = makeIdentity("localhost", &ca, 3);
+    // a retry this long keeps the refresh thread from fetching again while the test runs
+    const seconds refresh = hours(1);
+    const seconds retry = hours(1);
+
+    const std::string good = makeResponse(leaf, ca, ca, -3600, 24 * 3600);
+
+    {
+        // a response from the ocsp_file is loaded when the certificate is added and stapled from then on
+        const std::string path = "/tmp/unet_ocsp_" + std::to_string(::getpid()) + ".der";
+        std::ofstream(path, std::ios::binary) << good;
+        SSL_CTX *ctx = serverContext(leaf, ca);
+        OcspStapler stapler(refresh, retry, seconds(1));
+        TEST_ASSERT(stapler.add(ctx, "leaf.pem", path, ""), "certificate with an ocsp_file added", true, false);
+        expectStats(stapler, 0, 0, 1, 0);
+
+        const std::optional<std::string> stapled = handshake(ctx, true);
+        TEST_ASSERT(stapled && *stapled == good, "the file's response is stapled", good.size(), (stapled ? stapled->size() : 0));
+        TEST_ASSERT(!handshake(ctx, false), "nothing stapled when not asked for", "none", "a response");
+        expectStats(stapler, 1, 0, 1, 0);
+        std::remove(path.c_str());
+        SSL_CTX_free(ctx);
+    }
+
+    {
+        // a fetcher in place of the file gets the request and supplies the response
+        SSL_CTX *ctx = serverContext(leaf, ca);
+        OcspStapler stapler(refresh, retry, seconds(1));
+        OcspRequest seen;
+        stapler.setFetcher([&](const OcspRequest &request) -> std::optional<std::string> {
+            seen = request;
+            return good;
+        });
+        TEST_ASSERT(stapler.add(ctx, "leaf.pem", "fixture.der", ""), "added", true, false);
+        TEST_ASSERT(seen.cert_file == "leaf.pem" && seen.file == "fixture.der", "fetcher gets the entry", "fixture.der", seen.file);
+        TEST_ASSERT(!seen.der.empty(), "fetcher gets a DER request", "non-empty", 0);
+        TEST_ASSERT(handshake(ctx, true) == good, "fetched response stapled", good.size(), 0);
+        expectStats(stapler, 1, 0, 1, 0);
+        SSL_CTX_free(ctx);
+    }
+
+    const auto rejected = [&](const std::string &der, const char *what) {
+        SSL_CTX *ctx = serverContext(leaf, ca);
+        OcspStapler stapler(refresh, retry, seconds(1));
+        stapler.setFetcher([&](const OcspRequest &) -> std::optional<std::string> { return der; });
+        TEST_ASSERT(stapler.add(ctx, "leaf.pem", "fixture.der", ""), "added", true, false);
+        expectStats(stapler, 0, 0, 0, 1);
+        TEST_ASSERT(!handshake(ctx, true), what, "nothing stapled", "a response");
+        expectStats(stapler, 0, 1, 0, 1);
+        SSL_CTX_free(ctx);
+    };
+    rejected(makeResponse(leaf, ca, other_ca, -3600, 24 * 3600), "a response signed by another issuer is rejected");
+    rejected(makeResponse(leaf, ca, ca, -2 * 24 * 3600, -24 * 3600), "an expired response is rejected");
+    rejected("not a response", "garbage is rejected");
+
+    {
+        // a fetch that returns nothing counts as failed as well
+        SSL_CTX *ctx = serverContext(leaf, ca);
+        OcspStapler stapler(refresh, retry, seconds(1));
+        stapler.setFetcher([](const OcspRequest &) -> std::optional<std::string> { return std::nullopt; });
+        TEST_ASSERT(stapler.add(ctx, "leaf.pem", "fixture.der", ""), "added", true, false);
+        TEST_ASSERT(!handshake(ctx, true), "nothing stapled", "none", "a response");
+        expectStats(stapler, 0, 1, 0, 1);
+        SSL_CTX_free(ctx);
+    }
+
+    {
+        // without the issuer in the chain, or anywhere to get responses from, the certificate is refused
+        SSL_CTX *ctx = SSL_CTX_new(TLS_server_method());
+        SSL_CTX_use_certificate(ctx, leaf.cert);
+        SSL_CTX_use_PrivateKey(ctx, leaf.key);
+        OcspStapler stapler(refresh, retry, seconds(1));
+        TEST_ASSERT(!stapler.add(ctx, "leaf.pem", "fixture.der", ""), "issuer missing from the chain", false, true);
+        SSL_CTX_free(ctx);
+
+        ctx = serverContext(leaf, ca);
+        TEST_ASSERT(!stapler.add(ctx, "leaf.pem", "", ""), "neither file nor responder", false, true);
+        SSL_CTX_free(ctx);
+    }
+
+    freeIdentity(leaf);
+    freeIdentity(other_ca);
+    freeIdentity(ca);
+    std::cout << "OCSP stapling tests passed" << std::endl;
+    return 0;
+}
@@ -1,6 +1,9 @@
 #ifdef USE_OPEN_SSL
 #include <Modules/StreamHandlers/OpenSSL.h>
 #endif
+#ifdef USE_IO_URING
+#include <Modules/StreamHandlers/IoUring.h>
+#endif
 
 #include "Protocols/HTTP/Message.h"
 #include "server/server.h"
@@ -20,6 +23,10 @@ using PlainServer = usub::server::ServerImpl<Handler, usub::server::PlainHTTPStr
 using RegexServer = PlainServer<usub::server::protocols::http::HTTPEndpointHandler>;
 using RadixServer = PlainServer<usub::server::protocols::http::RadixRouter>;
 
+#ifdef USE_IO_URING
+using IoUringServer = usub::server::ServerImpl<usub::server::protocols::http::RadixRouter, usub::server::IoUringHTTPStreamHandler>;
+#endif
+
 
 #ifdef USE_OPEN_SSL
 template<class Handler>
@@ -0,0 +1,209 @@
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "utils/ssl/SessionResumption.h"
+
+#define TEST_ASSERT(condition, message, expected, actual)       \
+    do {                                                        \
+        if (!(condition)) {                                     \
+            std::cerr << "Assertion failed: " << message       \
+                      << "\n    Expected: " << expected        \
+                      << "\n    Actual:   " << actual          \
+                      << "\n    at " << __FILE__               \
+                      << ":" << __LINE__ << std::endl;         \
+            std::exit(1);                                       \
+        }                                                       \
+    } while (0)
+
+using namespace usub::utils::ssl;
+
+namespace {
+    using Id = std::array<unsigned char, SSL_MAX_SSL_SESSION_ID_LENGTH>;
+
+    Id makeId(unsigned seed) {
+        Id id{};
+        for (size_t i = 0; i < id.size(); ++i) {
+            id[i] = static_cast<unsigned char>(seed >> (8 * (i % sizeof(seed))));
+        }
+        return id;
+    }
+
+    /// The cache's shard of @p id, computed the way SessionCache hashes ids.
+    size_t shardOf(const Id &id) {
+        uint64_t hash = std::hash<std::string_view>{}({reinterpret_cast<const char *>(id.data()), id.size()});
+        if (!hash) hash = 1;
+        return hash % SESSION_CACHE_SHARDS;
+    }
+
+    /// Ids that all fall into the shard of the first one.
+    std::vector<Id> sameShard(size_t count) {
+        std::vector<Id> ids{makeId(1)};
+        for (unsigned seed = 2; ids.size() < count; ++seed) {
+            const Id id = makeId(seed);
+            if (shardOf(id) == shardOf(ids.front())) ids.push_back(id);
+        }
+        return ids;
+    }
+
+    /// A TLS 1.2 suite, sessions without a cipher can not be encoded.
+    const SSL_CIPHER *sessionCipher() {
+        static SSL_CTX *ctx = SSL_CTX_new(TLS_method());
+        static SSL *ssl = SSL_new(ctx);
+        static const unsigned char suite[2]{0xC0, 0x2F};// ECDHE-RSA-AES128-GCM-SHA256
+        return SSL_CIPHER_find(ssl, suite);
+    }
+
+    SSL_SESSION *makeSession(const Id &id, int64_t time, long timeout) {
+        SSL_SESSION *session = SSL_SESSION_new();
+        SSL_SESSION_set1_id(session, id.data(), static_cast<unsigned int>(id.size()));
+        SSL_SESSION_set_protocol_version(session, TLS1_2_VERSION);
+        SSL_SESSION_set_cipher(session, sessionCipher());
+        const unsigned char master_key[48]{};
+        SSL_SESSION_set1_master_key(session, master_key, sizeof(master_key));
+        SSL_SESSION_set_time(session, static_cast<long>(time));
+        SSL_SESSION_set_timeout(session, timeout);
+        return session;
+    }
+
+    bool store(SessionCache &cache, const Id &id, int64_t time, long timeout) {
+        SSL_SESSION *session = makeSession(id, time, timeout);
+        const bool stored = cache.store(session);
+        SSL_SESSION_free(session);
+        return stored;
+    }
+
+    bool cached(SessionCache &cache, const Id &id) {
+        SSL_SESSION *session = cache.find(id.data(), id.size());
+        if (!session) return false;
+        unsigned int len = 0;
+        const unsigned char *found = SSL_SESSION_get_id(session, &len);
+        const bool same = len == id.size() && std::memcmp(found, id.data(), len) == 0;
+        SSL_SESSION_free(session);
+        return same;
+    }
+
+    std::string name(const TicketKeyRing::Key &key) {
+        return {reinterpret_cast<const char *>(key.name), sizeof(key.name)};
+    }
+}// namespace
+
+int main() {
+    const int64_t now = std::time(nullptr);
+
+    {
+        SessionCache cache(1024);
+        const Id id = makeId(7);
+        TEST_ASSERT(store(cache, id, now, 300) && cached(cache, id), "a stored session is found", true, false);
+        TEST_ASSERT(!cached(cache, makeId(8)), "an unknown id misses", false, true);
+        cache.erase(id.data(), id.size());
+        TEST_ASSERT(!cached(cache, id), "an erased session is gone", false, true);
+
+        const Id expired = makeId(9);
+        TEST_ASSERT(store(cache, expired, now - 100, 10) && !cached(cache, expired), "an expired session is not returned", false, true);
+
+        const SessionCache::Stats stats = cache.stats();
+        TEST_ASSERT(stats.hits == 1 && stats.misses == 3 && stats.stores == 2, "stats count hits, misses and stores", "1/3/2",
+                    std::to_string(stats.hits) + "/" + std::to_string(stats.misses) + "/" + std::to_string(stats.stores));
+    }
+
+    {
+        // one bucket per shard: a fifth session in a shard evicts the one closest to expiry
+        SessionCache cache(1);
+        const std::vector<Id> ids = sameShard(SESSION_CACHE_WAYS + 1);
+        const long timeouts[] = {400, 100, 300, 200};
+        for (size_t i = 0; i < SESSION_CACHE_WAYS; ++i) {
+            TEST_ASSERT(store(cache, ids[i], now, timeouts[i]), "stored", true, false);
+        }
+        TEST_ASSERT(store(cache, ids[0], now, 400), "storing the same id again", true, false);
+        for (size_t i = 0; i < SESSION_CACHE_WAYS; ++i) {
+            TEST_ASSERT(cached(cache, ids[i]), "a re-stored id replaces itself, not a neighbour", true, false);
+        }
+
+        TEST_ASSERT(store(cache, ids[SESSION_CACHE_WAYS], now, 500), "stored into a full bucket", true, false);
+        TEST_ASSERT(!cached(cache, ids[1]), "the session closest to expiry is evicted", false, true);
+        for (size_t i: {size_t{0}, size_t{2}, size_t{3}, SESSION_CACHE_WAYS}) {
+            TEST_ASSERT(cached(cache, ids[i]), "the other sessions stay", true, false);
+        }
+    }
+
+    {
+        TicketKeyRing ring(std::chrono::seconds(100));
+        TicketKeyRing::Key first{}, key{};
+        bool renew = true;
+        TEST_ASSERT(ring.current(first, now), "a current key", true, false);
+        TEST_ASSERT(ring.find(first.name, key, renew, now) && !renew && name(key) == name(first),
+                    "the current key is found without renewal", "found", "missing or renewed");
+
+        // one rotation later the old key still decrypts, and asks for the ticket to be reissued
+        const int64_t later = now + 100;
+        TicketKeyRing::Key second{};
+        TEST_ASSERT(ring.current(second, later) && second.generation == first.generation + 1, "rotated to the next generation",
+                    first.generation + 1, second.generation);
+        TEST_ASSERT(name(second) != name(first), "a rotation makes a new key", "a new name", "the old one");
+        TEST_ASSERT(ring.find(first.name, key, renew, later) && renew, "the previous generation is renewed", "renew", "not renewed");
+        TEST_ASSERT(ring.find(second.name, key, renew, later) && !renew, "the new key is not renewed", "found", "renewed");
+
+        TEST_ASSERT(!ring.find(first.name, key, renew, now + 200), "two generations back is expired", false, true);
+    }
+
+    {
+        // concurrent handshakes noticing a due rotation: one claims it, the others keep the old key meanwhile
+        TicketKeyRing ring(std::chrono::seconds(100));
+        TicketKeyRing::Key old{};
+        ring.current(old, now);
+        const int64_t due = now + 100;
+
+        constexpr size_t THREADS = 8;
+        std::vector<TicketKeyRing::Key> keys(THREADS);
+        std::atomic<size_t> ready{0};
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < THREADS; ++i) {
+            threads.emplace_back([&, i] {
+                ready.fetch_add(1);
+                while (ready.load() < THREADS) {}
+                ring.current(keys[i], due);
+            });
+        }
+        for (auto &thread: threads) {
+            thread.join();
+        }
+        TicketKeyRing::Key rotated{};
+        TEST_ASSERT(ring.current(rotated, due) && rotated.generation == old.generation + 1, "rotated once", old.generation + 1, rotated.generation);
+        for (const auto &key: keys) {
+            const bool old_key = key.generation == old.generation && name(key) == name(old);
+            const bool new_key = key.generation == rotated.generation && name(key) == name(rotated);
+            TEST_ASSERT(old_key || new_key, "every thread sees the old key or the single new one", "one of two keys", "a third key");
+        }
+    }
+
+    {
+        const std::string secret(32, 's');
+        TicketKeyRing a(std::chrono::seconds(100), secret), b(std::chrono::seconds(100), secret);
+        TicketKeyRing other(std::chrono::seconds(100), std::string(32, 'o'));
+        TicketKeyRing::Key ka{}, kb{}, ko{};
+        a.current(ka, now);
+        b.current(kb, now);
+        other.current(ko, now);
+        TEST_ASSERT(name(ka) == name(kb) && std::memcmp(ka.aes, kb.aes, sizeof(ka.aes)) == 0,
+                    "rings with the same secret derive the same keys", "equal keys", "different keys");
+        TEST_ASSERT(name(ka) != name(ko), "another secret derives other keys", "different keys", "equal keys");
+
+        // a ring that never issued the ticket, as after a restart, accepts and renews it a rotation later
+        TicketKeyRing::Key key{};
+        bool renew = false;
+        TicketKeyRing restarted(std::chrono::seconds(100), secret);
+        TEST_ASSERT(restarted.find(ka.name, key, renew, now + 100) && renew, "a ticket of the same secret is renewed",
+                    "renew", "missing");
+    }
+
+    std::cout << "All session resumption tests passed\n";
+    return 0;
+}
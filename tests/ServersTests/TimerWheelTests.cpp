@@ -0,0 +1,127 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+
+#include "server/TimerWheel.h"
+
+#define TEST_ASSERT(condition, message, expected, actual)       \
+    do {                                                        \
+        if (!(condition)) {                                     \
+            std::cerr << "Assertion failed: " << message       \
+                      << "\n    Expected: " << expected        \
+                      << "\n    Actual:   " << actual          \
+                      << "\n    at " << __FILE__               \
+                      << ":" << __LINE__ << std::endl;         \
+            std::exit(1);                                       \
+        }                                                       \
+    } while (0)
+
+using namespace usub::server::net;
+using std::chrono::milliseconds;
+
+namespace {
+    /// Drives a wheel by tick numbers; times fall in the middle of a tick so the wheel's start does not matter.
+    struct Clock {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        std::chrono::steady_clock::time_point at(uint64_t tick) const {
+            return start + TimerWheel::TICK * tick + TimerWheel::TICK / 2;
+        }
+    };
+
+    milliseconds ticks(uint64_t count) { return TimerWheel::TICK * count; }
+}// namespace
+
+int main() {
+    // deadlines hold no socket: the wheel's shutdown() on -1 fails harmlessly
+    {
+        TimerWheel wheel;
+        Clock clock;
+        Deadline a{-1}, b{-1}, c{-1};
+        wheel.arm(a, ticks(2));
+        wheel.arm(b, ticks(2) - milliseconds(1));// rounded up to 2 ticks
+        wheel.arm(c, ticks(2));
+        wheel.cancel(c);
+        TEST_ASSERT(wheel.size() == 2 && !c.armed(), "cancel unlinks", 2, wheel.size());
+
+        TEST_ASSERT(wheel.advance(clock.at(1)) == 0, "nothing due at tick 1", 0, "some");
+        const size_t expired = wheel.advance(clock.at(2));
+        TEST_ASSERT(expired == 2 && wheel.size() == 0, "both due at tick 2", 2, expired);
+        TEST_ASSERT(!a.armed() && !b.armed(), "expired deadlines are disarmed", false, true);
+    }
+
+    {
+        TimerWheel wheel;
+        Clock clock;
+        Deadline a{-1};
+        wheel.arm(a, ticks(5));
+        wheel.arm(a, ticks(10));
+        TEST_ASSERT(wheel.size() == 1, "re-arming keeps one entry", 1, wheel.size());
+        TEST_ASSERT(wheel.advance(clock.at(9)) == 0 && a.armed(), "re-armed deadline moved out", "armed", "expired");
+        TEST_ASSERT(wheel.advance(clock.at(10)) == 1, "re-armed deadline due at tick 10", 1, 0);
+
+        wheel.arm(a, milliseconds(0));
+        TEST_ASSERT(!a.armed() && wheel.size() == 0, "a zero timeout cancels", false, true);
+    }
+
+    {
+        // one deadline per level, each due right at and right after a level boundary
+        TimerWheel wheel;
+        Clock clock;
+        const uint64_t due[] = {255, 256, 257, 300, 16383, 16384, 16385, 1048575, 1048576, 1048700};
+        Deadline deadlines[] = {Deadline{-1}, Deadline{-1}, Deadline{-1}, Deadline{-1}, Deadline{-1},
+                                Deadline{-1}, Deadline{-1}, Deadline{-1}, Deadline{-1}, Deadline{-1}};
+        for (size_t i = 0; i < std::size(due); ++i) {
+            wheel.arm(deadlines[i], ticks(due[i]));
+        }
+        uint64_t tick = 0;
+        for (size_t i = 0; i < std::size(due); ++i) {
+            TEST_ASSERT(wheel.advance(clock.at(due[i] - 1)) == 0 && deadlines[i].armed(),
+                        "deadline not expired before its tick", due[i], tick);
+            TEST_ASSERT(wheel.advance(clock.at(due[i])) == 1 && !deadlines[i].armed(),
+                        "deadline expires at its tick", due[i], "another tick");
+            tick = due[i];
+        }
+        TEST_ASSERT(wheel.size() == 0, "every level drained", 0, wheel.size());
+    }
+
+    {
+        // armed after the wheel has run, so the cascade starts from a non-zero tick; tick 1000 is done, so
+        // the deadline counts from tick 1001 and may fire up to a tick late but never early
+        TimerWheel wheel;
+        Clock clock;
+        wheel.advance(clock.at(1000));
+        Deadline a{-1};
+        wheel.arm(a, ticks(20000));
+        TEST_ASSERT(wheel.advance(clock.at(21000)) == 0, "offset deadline not early", 0, 1);
+        TEST_ASSERT(wheel.advance(clock.at(21001)) == 1, "offset deadline on time", 1, 0);
+    }
+
+    {
+        // past the last level the deadline is clamped rather than wrapping around to fire early
+        TimerWheel wheel;
+        Clock clock;
+        Deadline a{-1};
+        wheel.arm(a, std::chrono::hours(24 * 365));
+        TEST_ASSERT(wheel.advance(clock.at(1 << 20)) == 0 && a.armed(), "clamped deadline stays armed", "armed", "expired");
+    }
+
+    {
+        Deadline outlives{-1};
+        {
+            TimerWheel wheel;
+            {
+                Deadline gone{-1};
+                wheel.arm(gone, ticks(3));
+                wheel.arm(outlives, ticks(3));
+                TEST_ASSERT(wheel.size() == 2, "two armed", 2, wheel.size());
+            }
+            TEST_ASSERT(wheel.size() == 1, "a destroyed deadline unlinks itself", 1, wheel.size());
+        }
+        TEST_ASSERT(!outlives.armed(), "a destroyed wheel detaches its deadlines", false, true);
+    }
+
+    std::cout << "All TimerWheel tests passed\n";
+    return 0;
+}